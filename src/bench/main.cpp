@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "crypto/internal/bits/substitute.hpp"
+#include "crypto/internal/parallel.hpp"
+#include "crypto/stream/algorithms/chacha20/chacha20.hpp"
+#include "crypto/stream/algorithms/rc4/encoder.hpp"
+#include "crypto/stream/algorithms/rc4/multi_encoder.hpp"
+#include "crypto/symmetric/algorithms/twofish/twofish.hpp"
+#include "crypto/symmetric/cipher_context.hpp"
+#include "crypto/symmetric/mac/macs.hpp"
+#include "crypto/symmetric/mode/modes.hpp"
+
+using namespace crypto;
+
+// Throughput of the block-cipher modes and MACs over a fixed buffer, and how
+// one context scales with the number of threads sharing it. ChaCha20 runs
+// once per vector backend as a stream-cipher reference; RC4 compares many
+// streams encoded one after another with the interleaved engine. The
+// bits::substitute rows compare the per-bit loop it used to run with the
+// word-at-a-time path and a prebuilt SubstitutionPlan.
+// usage: crypto_bench [size_mib] [threads]
+
+static double measure_mib_per_s(size_t bytes, const std::function<void()>& fn) {
+  fn(); // warm-up
+  size_t iterations = 0;
+  const auto start = std::chrono::steady_clock::now();
+  auto now = start;
+  do {
+    fn();
+    ++iterations;
+    now = std::chrono::steady_clock::now();
+  } while (now - start < std::chrono::milliseconds(500));
+  const double seconds = std::chrono::duration<double>(now - start).count();
+  return static_cast<double>(bytes * iterations) / (1024.0 * 1024.0) / seconds;
+}
+
+static void report(const std::string& name, double mib_s) {
+  std::cout << "  " << std::left << std::setw(14) << name << std::right
+            << std::setw(10) << std::fixed << std::setprecision(2) << mib_s
+            << " MiB/s\n";
+}
+
+// bits::substitute as it was: one shift and mask per input and output bit
+static Bytes substitute_bitwise(const Bytes& bits, const std::array<uint8_t, 256>& s_block,
+                                size_t in, size_t out) {
+  const size_t total = bits.size() * 8;
+  const size_t blocks = total / in;
+  const size_t rest = total % in;
+  Bytes result((blocks * out + rest + 7) / 8, 0);
+  size_t pos = 0;
+  for (size_t b = 0; b < blocks; ++b) {
+    uint8_t key = 0;
+    for (size_t k = 0; k < in; ++k) {
+      const size_t bit = b * in + k;
+      key = static_cast<uint8_t>(key << 1 | ((bits[bit / 8] >> (7 - bit % 8)) & 1));
+    }
+    const uint8_t value = s_block[key] & ((1 << out) - 1);
+    for (size_t k = 0; k < out; ++k, ++pos) {
+      result[pos / 8] |= ((value >> (out - 1 - k)) & 1) << (7 - pos % 8);
+    }
+  }
+  for (size_t bit = blocks * in; bit < total; ++bit, ++pos) {
+    result[pos / 8] |= ((bits[bit / 8] >> (7 - bit % 8)) & 1) << (7 - pos % 8);
+  }
+  return result;
+}
+
+static void bench_mode(const std::string& name, mode::SymmetricCipherMode& m,
+                       core::SymmetricCipher& cipher, const Bytes& input,
+                       size_t threads) {
+  Bytes output;
+  report(name, measure_mib_per_s(input.size(), [&]() {
+    m.encrypt(cipher, input, output, threads);
+  }));
+}
+
+// Aggregate throughput of n threads encrypting 64 KiB messages through one
+// shared context, the server pattern of one context per key.
+static double measure_shared_context(const SymmetricCipherContext& ctx, size_t n) {
+  const Bytes message(64 * 1024, 0x5C);
+  std::atomic<bool> stop{false};
+  std::vector<internal::CacheAligned<size_t>> counts(n);
+  std::vector<std::thread> callers;
+  for (size_t t = 0; t < n; ++t) {
+    callers.emplace_back([&, t]() {
+      Bytes output;
+      while (!stop.load(std::memory_order_relaxed)) {
+        ctx.encrypt(message, output);
+        ++counts[t].value;
+      }
+    });
+  }
+  const auto start = std::chrono::steady_clock::now();
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  stop = true;
+  for (auto& c : callers) c.join();
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  size_t total = 0;
+  for (const auto& count : counts) total += count.value;
+  return static_cast<double>(total * message.size()) / (1024.0 * 1024.0) / seconds;
+}
+
+int main(int argc, char** argv) {
+  const size_t size_mib = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1;
+  const size_t threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1;
+
+  const Bytes key(16, 0x2B);
+  Bytes input(size_mib * 1024 * 1024);
+  for (size_t i = 0; i < input.size(); ++i) input[i] = static_cast<Byte>(i * 131);
+
+  twofish::Twofish cipher;
+  cipher.set_encryption_key(key);
+  cipher.set_decryption_key(key);
+  twofish::Twofish tweak;
+  tweak.set_encryption_key(Bytes(16, 0x7E));
+
+  std::cout << "Twofish, " << size_mib << " MiB, " << threads << " thread(s)\n";
+
+  std::cout << "modes (encrypt):\n";
+  mode::ECB ecb;
+  mode::CBC cbc;
+  mode::CTR ctr;
+  mode::GCM gcm(Bytes(12, 0x01));
+  mode::OCB ocb(Bytes(12, 0x01));
+  mode::XTS xts(tweak);
+  bench_mode("ECB", ecb, cipher, input, threads);
+  bench_mode("CBC", cbc, cipher, input, threads);
+  bench_mode("CTR", ctr, cipher, input, threads);
+  bench_mode("GCM", gcm, cipher, input, threads);
+  bench_mode("OCB", ocb, cipher, input, threads);
+  bench_mode("XTS", xts, cipher, input, threads);
+
+  std::cout << "MACs:\n";
+  mac::CMAC cmac(cipher);
+  mac::PMAC pmac(cipher);
+  report("CMAC", measure_mib_per_s(input.size(), [&]() { (void)cmac.compute(input); }));
+  report("PMAC", measure_mib_per_s(input.size(), [&]() { (void)pmac.compute(input, threads); }));
+
+  std::cout << "shared context (CBC, callers):\n";
+  SymmetricCipherContext ctx(std::make_unique<twofish::Twofish>(),
+                             SymmetricEncryptionMode::CBC,
+                             SymmetricPaddingScheme::PKCS7);
+  ctx.set_encryption_key(key);
+  const size_t max_callers = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  for (size_t n = 1; n <= max_callers; n *= 2) {
+    report(std::to_string(n), measure_shared_context(ctx, n));
+  }
+
+  std::cout << "ChaCha20 (reference stream cipher):\n";
+  for (auto backend : {chacha20::ChaCha20::Backend::Scalar, chacha20::ChaCha20::Backend::SSE2,
+                       chacha20::ChaCha20::Backend::AVX2, chacha20::ChaCha20::Backend::AVX512}) {
+    if (!chacha20::ChaCha20::supported(backend)) continue;
+    static const char* const names[] = {"auto", "scalar", "SSE2", "AVX2", "AVX-512"};
+    chacha20::ChaCha20 chacha(Bytes(12, 0x01), 0, backend);
+    chacha.set_key(Bytes(32, 0x2B));
+    Bytes output(input.size());
+    report(names[static_cast<size_t>(backend)], measure_mib_per_s(input.size(), [&]() {
+      chacha.seek(0);
+      chacha.apply(input, output);
+    }));
+  }
+
+  std::cout << "RC4, 256 streams x 16 KiB:\n";
+  std::vector<std::vector<uint8_t>> rc4_keys(256);
+  for (size_t k = 0; k < rc4_keys.size(); ++k) rc4_keys[k].assign(16, static_cast<uint8_t>(k));
+  std::vector<std::vector<uint8_t>> rc4_buffers(rc4_keys.size(), std::vector<uint8_t>(16 * 1024));
+  const size_t rc4_bytes = rc4_keys.size() * rc4_buffers[0].size();
+  std::vector<rc4::Encoder> rc4_singles(rc4_keys.begin(), rc4_keys.end());
+  rc4::MultiEncoder rc4_multi(rc4_keys);
+  report("separate", measure_mib_per_s(rc4_bytes, [&]() {
+    for (size_t k = 0; k < rc4_singles.size(); ++k) rc4_singles[k].encode(rc4_buffers[k]);
+  }));
+  report("interleaved", measure_mib_per_s(rc4_bytes, [&]() {
+    rc4_multi.encode(rc4_buffers);
+  }));
+
+  std::cout << "bits::substitute, 1 MiB:\n";
+  const Bytes bits_input(input.begin(), input.begin() + std::min<size_t>(input.size(), 1 << 20));
+  std::array<uint8_t, 256> s_block{};
+  for (size_t i = 0; i < s_block.size(); ++i) s_block[i] = static_cast<uint8_t>(i * 167 + 13);
+  for (auto [in, out] : {std::pair<size_t, size_t>{4, 4}, {6, 4}, {8, 8}}) {
+    const std::string shape = std::to_string(in) + "/" + std::to_string(out);
+    const bits::SubstitutionPlan plan(s_block, in, out);
+    Bytes output(plan.output_size(bits_input.size()));
+    report(shape + " bitwise", measure_mib_per_s(bits_input.size(), [&]() {
+      output = substitute_bitwise(bits_input, s_block, in, out);
+    }));
+    report(shape + " words", measure_mib_per_s(bits_input.size(), [&]() {
+      output = bits::substitute(bits_input, s_block, in, out);
+    }));
+    output.resize(plan.output_size(bits_input.size()));
+    report(shape + " plan", measure_mib_per_s(bits_input.size(), [&]() {
+      plan.apply(bits_input, output);
+    }));
+  }
+
+  return 0;
+}
@@ -1,8 +1,8 @@
 #include "dh.hpp"
 
 #include <stdexcept>
-#include <gmp.h>
 
+#include "internal/random.hpp"
 #include "math/utils.hpp"
 
 namespace crypto::dh {
@@ -16,27 +16,7 @@ namespace crypto::dh {
       throw std::invalid_argument("DiffieHellman: g must be in [2, p-1]");
     }
 
-    gmp_randstate_t state;
-    gmp_randinit_mt(state);
-
-    unsigned long seed;
-    FILE* urandom = fopen("/dev/urandom", "rb");
-    if (!urandom) {
-      throw std::runtime_error("DiffieHellman: failed to open /dev/urandom");
-    }
-    if (fread(&seed, sizeof(seed), 1, urandom) != 1) {
-      fclose(urandom);
-      throw std::runtime_error("DiffieHellman: failed to read /dev/urandom");
-    }
-    fclose(urandom);
-
-    gmp_randseed_ui(state, seed);
-
-    mpz_class range = m_params.p - 2;
-    mpz_urandomm(m_private_key.get_mpz_t(), state, range.get_mpz_t());
-    m_private_key += 2;
-
-    gmp_randclear(state);
+    m_private_key = internal::random_below(m_params.p - 2) + 2;
   }
 
   mpz_class DiffieHellman::public_key() const {
@@ -1,8 +1,8 @@
 #include "key_generator.hpp"
 
-#include <random>
 #include <stdexcept>
 
+#include "internal/random.hpp"
 #include "math/utils.hpp"
 
 namespace crypto::rsa {
@@ -11,17 +11,15 @@ namespace crypto::rsa {
                              double min_prime_probability)
     : m_prime_test(std::move(prime_test)),
       m_prime_bits(prime_bits),
-      m_min_probability(min_prime_probability),
-      m_rng(gmp_randinit_default) {
+      m_min_probability(min_prime_probability) {
     if (prime_bits < 512) {
       throw std::invalid_argument("prime_bits must be at least 512");
     }
-    m_rng.seed(std::random_device{}());
   }
 
   mpz_class KeyGenerator::generate_prime() const {
     while (true) {
-      mpz_class candidate = m_rng.get_z_bits(m_prime_bits);
+      mpz_class candidate = internal::random_bits(m_prime_bits);
       mpz_setbit(candidate.get_mpz_t(), m_prime_bits - 1);
       mpz_setbit(candidate.get_mpz_t(), 0);
       if (m_prime_test->is_prime(candidate, m_min_probability)) {
@@ -34,7 +32,7 @@ namespace crypto::rsa {
     mpz_class threshold;
     mpz_ui_pow_ui(threshold.get_mpz_t(), 2, m_prime_bits / 2 - 1);
     while (true) {
-      mpz_class candidate = m_rng.get_z_bits(m_prime_bits);
+      mpz_class candidate = internal::random_bits(m_prime_bits);
       mpz_setbit(candidate.get_mpz_t(), m_prime_bits - 1);
       mpz_class diff = candidate > p ? candidate - p : p - candidate;
       if (diff <= threshold) {
@@ -46,7 +46,6 @@ namespace crypto::rsa {
     std::unique_ptr<math::IPrimeTest> m_prime_test;
     mp_bitcnt_t      m_prime_bits;
     double           m_min_probability;
-    mutable gmp_randclass m_rng;
   };
 
 }
@@ -0,0 +1,160 @@
+#ifndef CRYPTO_BITS_BIT_SPAN_HPP
+#define CRYPTO_BITS_BIT_SPAN_HPP
+
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+namespace crypto::bits {
+
+// Non-owning view of the first size() bits of caller memory, numbered from
+// the most significant bit of the first byte like the vector-based
+// functions. A view starts on a byte boundary and owns its whole last
+// byte: operations that write through a view clear the pad bits after
+// size(). get/set/read/write check their range and throw; operator[] and
+// the *_unchecked accessors do not, for hot loops that already know their
+// bounds. BitSpan writes through to the memory, BitView only reads.
+template <typename T> class BasicBitSpan {
+  static_assert(std::is_same_v<std::remove_const_t<T>, uint8_t>);
+
+public:
+  static constexpr bool is_mutable = !std::is_const_v<T>;
+
+  constexpr BasicBitSpan() = default;
+
+  constexpr BasicBitSpan(std::span<T> bytes)
+      : m_data(bytes.data()), m_bits(bytes.size() * 8) {}
+
+  BasicBitSpan(std::span<T> bytes, size_t n_bits)
+      : m_data(bytes.data()), m_bits(n_bits) {
+    if (n_bits > bytes.size() * 8) {
+      throw std::invalid_argument("BitSpan: n_bits exceeds the buffer");
+    }
+  }
+
+  // vectors, arrays and anything else std::span<T> accepts by reference
+  template <typename Range>
+    requires(!std::is_same_v<std::remove_cvref_t<Range>, BasicBitSpan> &&
+             std::constructible_from<std::span<T>, Range &>)
+  constexpr BasicBitSpan(Range &range) : BasicBitSpan(std::span<T>(range)) {}
+
+  // BitSpan -> BitView
+  template <typename U>
+    requires(std::is_const_v<T> && std::is_same_v<U, uint8_t>)
+  constexpr BasicBitSpan(BasicBitSpan<U> other)
+      : m_data(other.data()), m_bits(other.size()) {}
+
+  constexpr size_t size() const { return m_bits; }
+  constexpr bool empty() const { return m_bits == 0; }
+  constexpr T *data() const { return m_data; }
+  constexpr std::span<T> bytes() const { return {m_data, (m_bits + 7) / 8}; }
+
+  uint8_t operator[](size_t index) const {
+    return (m_data[index / 8] >> (7 - index % 8)) & 1;
+  }
+
+  uint8_t get(size_t index) const {
+    check(index, 1);
+    return (*this)[index];
+  }
+
+  void set_unchecked(size_t index, uint8_t val) const
+    requires is_mutable
+  {
+    const uint8_t bit = static_cast<uint8_t>(1u << (7 - index % 8));
+    m_data[index / 8] =
+        static_cast<uint8_t>((m_data[index / 8] & ~bit) | (val & 1 ? bit : 0));
+  }
+
+  void set(size_t index, uint8_t val) const
+    requires is_mutable
+  {
+    check(index, 1);
+    set_unchecked(index, val);
+  }
+
+  // count <= 64 bits starting at pos as a right-aligned value
+  uint64_t read_unchecked(size_t pos, size_t count) const {
+    uint64_t value = 0;
+    while (count > 0) {
+      const size_t offset = pos % 8;
+      const size_t take = std::min(count, 8 - offset);
+      const unsigned chunk =
+          (m_data[pos / 8] >> (8 - offset - take)) & ((1u << take) - 1);
+      value = value << take | chunk;
+      pos += take;
+      count -= take;
+    }
+    return value;
+  }
+
+  uint64_t read(size_t pos, size_t count) const {
+    check_word(pos, count);
+    return read_unchecked(pos, count);
+  }
+
+  // stores the low count bits of value at pos
+  void write_unchecked(size_t pos, size_t count, uint64_t value) const
+    requires is_mutable
+  {
+    while (count > 0) {
+      const size_t offset = pos % 8;
+      const size_t take = std::min(count, 8 - offset);
+      const size_t shift = 8 - offset - take;
+      const uint8_t mask = static_cast<uint8_t>(((1u << take) - 1) << shift);
+      const uint8_t chunk =
+          static_cast<uint8_t>(((value >> (count - take)) << shift) & mask);
+      m_data[pos / 8] = static_cast<uint8_t>((m_data[pos / 8] & ~mask) | chunk);
+      pos += take;
+      count -= take;
+    }
+  }
+
+  void write(size_t pos, size_t count, uint64_t value) const
+    requires is_mutable
+  {
+    check_word(pos, count);
+    write_unchecked(pos, count, value);
+  }
+
+  // zeroes bits [pos, size()) and the pad bits of the last byte
+  void clear_from(size_t pos) const
+    requires is_mutable
+  {
+    const size_t n_bytes = (m_bits + 7) / 8;
+    if (pos >= n_bytes * 8) {
+      return;
+    }
+    if (pos % 8 != 0) {
+      m_data[pos / 8] &= static_cast<uint8_t>(0xFF << (8 - pos % 8));
+      pos += 8 - pos % 8;
+    }
+    std::fill(m_data + pos / 8, m_data + n_bytes, 0);
+  }
+
+private:
+  void check(size_t pos, size_t count) const {
+    if (pos >= m_bits || count > m_bits - pos) {
+      throw std::invalid_argument("index out of bounds");
+    }
+  }
+
+  void check_word(size_t pos, size_t count) const {
+    if (count > 64 || pos > m_bits || count > m_bits - pos) {
+      throw std::invalid_argument("index out of bounds");
+    }
+  }
+
+  T *m_data = nullptr;
+  size_t m_bits = 0;
+};
+
+using BitSpan = BasicBitSpan<uint8_t>;
+using BitView = BasicBitSpan<const uint8_t>;
+
+} // namespace crypto::bits
+
+#endif // CRYPTO_BITS_BIT_SPAN_HPP
@@ -1,42 +1,207 @@
 #include "permute.hpp"
+#include <algorithm>
 #include <cstdint>
+#include <memory>
+#include <stdexcept>
 #include <vector>
 
 namespace crypto::bits {
 
-std::vector<uint8_t> permute(const std::vector<uint8_t> &bits,
-                             const std::vector<size_t> &p_block, BitOrder order,
-                             BitIndexBase index_base) {
-  if (p_block.empty())
-    return {};
+namespace {
 
-  size_t out_size = (p_block.size() + 7) / 8;
-  std::vector<uint8_t> out(out_size, 0);
+// source bit of p_block[i] in an input of total_bits bits, or a value
+// >= total_bits when it reads past the input
+size_t source_index(size_t index, size_t total_bits, BitOrder order,
+                    BitIndexBase index_base) {
+  if (index_base == BitIndexBase::One) {
+    index--;
+  }
+  if (order == BitOrder::LittleEndian) {
+    index = total_bits - 1 - index;
+  }
+  return index;
+}
 
-  bool index_base_one = index_base == BitIndexBase::One;
-  bool big_endian = order == BitOrder::BigEndian;
-  size_t total_bits = bits.size() * 8;
+// out already holds zeros in its first p_block.size() bits
+void permute_bitwise(BitView bits, BitSpan out,
+                     const std::vector<size_t> &p_block, BitOrder order,
+                     BitIndexBase index_base) {
+  const size_t total_bits = bits.size();
 
   for (size_t i = 0; i < p_block.size(); i++) {
-    size_t index = p_block[i];
-
-    if (index_base_one) {
-      index--;
+    const size_t index =
+        source_index(p_block[i], total_bits, order, index_base);
+    if (index < total_bits && bits[index]) {
+      out.set_unchecked(i, 1);
     }
+  }
+}
+
+// Plans whose tables would exceed 32 words per entry (64 KiB) are not
+// worth compiling for a cache that may see them once.
+constexpr size_t MAX_CACHED_TABLE_WORDS = 32;
+constexpr size_t PLAN_CACHE_SLOTS = 64;
 
-    if (!big_endian) {
-      index = total_bits - 1 - index;
+struct CachedPlan {
+  uint64_t fingerprint = 0;
+  std::vector<size_t> p_block;
+  size_t input_bytes = 0;
+  BitOrder order = BitOrder::BigEndian;
+  BitIndexBase index_base = BitIndexBase::Zero;
+  std::unique_ptr<PermutationPlan> plan;
+};
+
+uint64_t fingerprint(const std::vector<size_t> &p_block, size_t input_bytes,
+                     BitOrder order, BitIndexBase index_base) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  auto mix = [&h](uint64_t v) {
+    h ^= v;
+    h *= 0x100000001b3ULL;
+  };
+  mix(input_bytes);
+  mix(static_cast<uint64_t>(order) << 1 | static_cast<uint64_t>(index_base));
+  for (size_t index : p_block) {
+    mix(index);
+  }
+  return h;
+}
+
+const PermutationPlan &cached_plan(const std::vector<size_t> &p_block,
+                                   size_t input_bytes, BitOrder order,
+                                   BitIndexBase index_base) {
+  thread_local std::vector<CachedPlan> cache;
+  thread_local size_t next_slot = 0;
+
+  const uint64_t h = fingerprint(p_block, input_bytes, order, index_base);
+  for (const auto &entry : cache) {
+    if (entry.fingerprint == h && entry.input_bytes == input_bytes &&
+        entry.order == order && entry.index_base == index_base &&
+        entry.p_block == p_block) {
+      return *entry.plan;
     }
+  }
+
+  CachedPlan entry{h, p_block, input_bytes, order, index_base,
+                   std::make_unique<PermutationPlan>(p_block, input_bytes,
+                                                     order, index_base)};
+  if (cache.size() < PLAN_CACHE_SLOTS) {
+    cache.push_back(std::move(entry));
+    return *cache.back().plan;
+  }
+  auto &slot = cache[next_slot];
+  next_slot = (next_slot + 1) % PLAN_CACHE_SLOTS;
+  slot = std::move(entry);
+  return *slot.plan;
+}
+
+} // namespace
 
-    uint8_t val = 0;
+PermutationPlan::PermutationPlan(const std::vector<size_t> &p_block,
+                                 size_t input_bytes, BitOrder order,
+                                 BitIndexBase index_base)
+    : m_input_bytes(input_bytes), m_output_bits(p_block.size()),
+      m_words((p_block.size() + 63) / 64) {
+  const size_t total_bits = input_bytes * 8;
+
+  std::vector<bool> used(input_bytes, false);
+  for (size_t i = 0; i < p_block.size(); i++) {
+    const size_t index = source_index(p_block[i], total_bits, order, index_base);
     if (index < total_bits) {
-      val = (bits[index / 8] >> (7 - (index % 8))) & 1;
+      used[index / 8] = true;
+    }
+  }
+  std::vector<size_t> slot_of(input_bytes, 0);
+  for (size_t byte = 0; byte < input_bytes; byte++) {
+    if (used[byte]) {
+      slot_of[byte] = m_sources.size();
+      m_sources.push_back(static_cast<uint32_t>(byte));
     }
+  }
 
-    out[i / 8] |= val << (7 - (i % 8));
+  m_tables.assign(m_sources.size() * 256 * m_words, 0);
+  for (size_t i = 0; i < p_block.size(); i++) {
+    const size_t index = source_index(p_block[i], total_bits, order, index_base);
+    if (index >= total_bits) {
+      continue;
+    }
+    const size_t slot = slot_of[index / 8];
+    const uint8_t in_mask = static_cast<uint8_t>(1u << (7 - index % 8));
+    const uint64_t out_bit = uint64_t{1} << (63 - i % 64);
+    for (size_t v = 0; v < 256; v++) {
+      if (v & in_mask) {
+        m_tables[(slot * 256 + v) * m_words + i / 64] |= out_bit;
+      }
+    }
+  }
+}
+
+size_t PermutationPlan::input_size() const { return m_input_bytes; }
+
+size_t PermutationPlan::output_size() const { return (m_output_bits + 7) / 8; }
+
+size_t PermutationPlan::output_bits() const { return m_output_bits; }
+
+void PermutationPlan::apply(BitView in, BitSpan out) const {
+  if (in.size() != m_input_bytes * 8 || out.size() < m_output_bits) {
+    throw std::invalid_argument("PermutationPlan: buffer size mismatch");
   }
 
+  const uint8_t *src = in.data();
+  uint8_t *dst = out.data();
+  const uint64_t *tables = m_tables.data();
+  const size_t n_sources = m_sources.size();
+  const size_t n_bytes = output_size();
+
+  for (size_t w = 0; w < m_words; w++) {
+    uint64_t acc = 0;
+    for (size_t s = 0; s < n_sources; s++) {
+      acc |= tables[(s * 256 + src[m_sources[s]]) * m_words + w];
+    }
+    const size_t first = w * 8;
+    const size_t last = std::min(first + 8, n_bytes);
+    for (size_t b = first; b < last; b++) {
+      dst[b] = static_cast<uint8_t>(acc >> (56 - 8 * (b - first)));
+    }
+  }
+  out.clear_from(n_bytes * 8);
+}
+
+std::vector<uint8_t>
+PermutationPlan::apply(const std::vector<uint8_t> &in) const {
+  std::vector<uint8_t> out(output_size());
+  apply(in, out);
+  return out;
+}
+
+std::vector<uint8_t> permute(const std::vector<uint8_t> &bits,
+                             const std::vector<size_t> &p_block, BitOrder order,
+                             BitIndexBase index_base) {
+  if (p_block.empty())
+    return {};
+
+  std::vector<uint8_t> out((p_block.size() + 7) / 8);
+  permute(bits, out, p_block, order, index_base);
   return out;
 }
 
+void permute(BitView bits, BitSpan out, const std::vector<size_t> &p_block,
+             BitOrder order, BitIndexBase index_base) {
+  if (out.size() < p_block.size()) {
+    throw std::invalid_argument("permute: output view too small");
+  }
+  if (p_block.empty()) {
+    out.clear_from(0);
+    return;
+  }
+
+  const size_t words = (p_block.size() + 63) / 64;
+  const size_t input_bytes = bits.bytes().size();
+  if (bits.size() % 8 != 0 || input_bytes * words > MAX_CACHED_TABLE_WORDS) {
+    out.clear_from(0);
+    permute_bitwise(bits, out, p_block, order, index_base);
+    return;
+  }
+  cached_plan(p_block, input_bytes, order, index_base).apply(bits, out);
+}
+
 } // namespace crypto::bits
@@ -1,6 +1,8 @@
 #ifndef BITS_PERMUTATIONS_HPP
 #define BITS_PERMUTATIONS_HPP
 
+#include "bit_span.hpp"
+
 #include <cstdint>
 #include <vector>
 
@@ -15,10 +17,48 @@ enum class BitIndexBase {
   One,
 };
 
+// A p-block compiled for one input length. Every input byte that feeds the
+// output gets a 256-entry table holding its contribution to the output
+// words, so applying the plan is one lookup and OR per input byte and word
+// instead of one shift and mask per output bit. Indices past the input read
+// as zero, as in permute().
+class PermutationPlan {
+public:
+  PermutationPlan(const std::vector<size_t> &p_block, size_t input_bytes,
+                  BitOrder order, BitIndexBase index_base);
+
+  size_t input_size() const;
+  size_t output_size() const;
+  size_t output_bits() const;
+
+  // in must span input_size() bytes and out at least output_bits() bits;
+  // the rest of out is cleared. in and out may not overlap
+  void apply(BitView in, BitSpan out) const;
+  std::vector<uint8_t> apply(const std::vector<uint8_t> &in) const;
+
+private:
+  size_t m_input_bytes;
+  size_t m_output_bits;
+  size_t m_words;
+  // input bytes that reach the output, each owning 256 * m_words entries of
+  // m_tables; output bit i sits at bit 63 - i % 64 of word i / 64
+  std::vector<uint32_t> m_sources;
+  std::vector<uint64_t> m_tables;
+};
+
+// Plans for recently used p-blocks are kept per thread, keyed by content,
+// input length, order and base; large permutations fall back to the bitwise
+// loop.
 std::vector<uint8_t> permute(const std::vector<uint8_t> &bits,
                              const std::vector<size_t> &p_block, BitOrder order,
                              BitIndexBase index_base);
 
+// The input is bits.size() bits long; out must hold p_block.size() bits,
+// may not overlap bits, and is cleared past them. Byte-aligned inputs go
+// through the same plan cache.
+void permute(BitView bits, BitSpan out, const std::vector<size_t> &p_block,
+             BitOrder order, BitIndexBase index_base);
+
 } // namespace crypto::bits
 
 #endif
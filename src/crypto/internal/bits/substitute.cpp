@@ -1,99 +1,257 @@
 #include "substitute.hpp"
+#include <algorithm>
 #include <cstdint>
-#include <iostream>
 #include <stdexcept>
 
 namespace crypto::bits {
 
-std::vector<uint8_t> substitute(const std::vector<uint8_t> &bits,
-                                const std::array<uint8_t, 256> &s_block,
-                                size_t block_size_in, size_t block_size_out) {
-  if (block_size_in == 0) {
-    return bits;
-  }
-  if (block_size_out == 0) {
-    return {};
-  }
+namespace {
 
+void check_block_sizes(size_t block_size_in, size_t block_size_out) {
   constexpr size_t max_bits = 8;
   if (block_size_in > max_bits || block_size_out > max_bits) {
     throw std::invalid_argument(
         "Block size must be <= 8 bits for uint8_t S-box");
   }
+}
 
-  const auto total_bits_in = bits.size() * 8;
-  const auto total_blocks = total_bits_in / block_size_in;
-  const auto remaining_bits = total_bits_in % block_size_in;
-  const auto total_bits_out = total_blocks * block_size_out + remaining_bits;
-  const auto out_size = (total_bits_out + 7) / 8;
+size_t substituted_bits(size_t input_bits, size_t block_size_in,
+                        size_t block_size_out) {
+  if (block_size_in == 0) {
+    return input_bits;
+  }
+  if (block_size_out == 0) {
+    return 0;
+  }
+  const size_t total_blocks = input_bits / block_size_in;
+  const size_t remaining_bits = input_bits % block_size_in;
+  return total_blocks * block_size_out + remaining_bits;
+}
 
-  std::vector<uint8_t> result(out_size, 0);
-  auto out_bit_pos = 0;
+size_t substituted_size(size_t input_bytes, size_t block_size_in,
+                        size_t block_size_out) {
+  return (substituted_bits(input_bytes * 8, block_size_in, block_size_out) +
+          7) /
+         8;
+}
+
+// Streams the input through a 64-bit accumulator: whole bytes go in,
+// block_size_in-bit keys come out, and the S-box outputs are packed into
+// a second accumulator that is flushed a byte at a time. Bits left over
+// after the last whole block are copied through, and the last output byte
+// is zero-padded.
+void substitute_words(const std::array<uint8_t, 256> &s_block,
+                      size_t block_size_in, size_t block_size_out, BitView in,
+                      uint8_t *out) {
+  const uint64_t key_mask = (uint64_t{1} << block_size_in) - 1;
+  const uint64_t value_mask = (uint64_t{1} << block_size_out) - 1;
 
-  for (auto block = 0; block < total_blocks; ++block) {
-    uint8_t key = 0;
-    const auto base_bit = block * block_size_in;
-    for (auto b = 0; b < block_size_in; ++b) {
-      const auto byte_idx = (base_bit + b) / 8;
-      const auto bit_idx = 7 - ((base_bit + b) % 8);
+  uint64_t in_acc = 0;
+  size_t in_bits = 0;
+  uint64_t out_acc = 0;
+  size_t out_bits = 0;
+  size_t out_pos = 0;
 
-      key = (key << 1) | ((bits[byte_idx] >> bit_idx) & 1);
+  auto emit = [&](uint64_t value, size_t n) {
+    out_acc = out_acc << n | value;
+    out_bits += n;
+    while (out_bits >= 8) {
+      out_bits -= 8;
+      out[out_pos++] = static_cast<uint8_t>(out_acc >> out_bits);
     }
+  };
+  auto consume = [&](uint64_t value, size_t n) {
+    in_acc = in_acc << n | value;
+    in_bits += n;
+    while (in_bits >= block_size_in) {
+      in_bits -= block_size_in;
+      emit(s_block[(in_acc >> in_bits) & key_mask] & value_mask,
+           block_size_out);
+    }
+  };
+
+  const uint8_t *src = in.data();
+  const size_t whole_bytes = in.size() / 8;
+  for (size_t i = 0; i < whole_bytes; i++) {
+    consume(src[i], 8);
+  }
+  if (const size_t rest = in.size() % 8; rest > 0) {
+    consume(src[whole_bytes] >> (8 - rest), rest);
+  }
+  if (in_bits > 0) {
+    emit(in_acc & ((uint64_t{1} << in_bits) - 1), in_bits);
+  }
+  if (out_bits > 0) {
+    out[out_pos] = static_cast<uint8_t>(out_acc << (8 - out_bits));
+  }
+}
 
-    uint8_t output_bits = s_block[key] & ((1 << block_size_out) - 1);
+std::array<uint8_t, 256>
+table_from(const std::unordered_map<uint8_t, uint8_t> &s_block) {
+  std::array<uint8_t, 256> array_s{};
+  for (const auto &[key, value] : s_block) {
+    array_s[key] = value;
+  }
+  return array_s;
+}
 
-    for (auto b = 0; b < block_size_out; ++b) {
-      const auto out_byte_idx = out_bit_pos / 8;
-      const auto out_bit_idx = 7 - (out_bit_pos % 8);
+std::array<uint8_t, 256>
+table_from(const std::function<uint8_t(uint8_t)> &s_block) {
+  std::array<uint8_t, 256> array_s{};
+  for (auto i = 0; i < 256; ++i) {
+    array_s[i] = s_block(i);
+  }
+  return array_s;
+}
+
+} // namespace
+
+SubstitutionPlan::SubstitutionPlan(const std::array<uint8_t, 256> &s_block,
+                                   size_t block_size_in, size_t block_size_out)
+    : m_in(block_size_in), m_out(block_size_out) {
+  check_block_sizes(block_size_in, block_size_out);
 
-      const uint8_t bit_val = (output_bits >> (block_size_out - 1 - b)) & 1;
-      result[out_byte_idx] |= bit_val << out_bit_idx;
-      ++out_bit_pos;
+  const uint8_t value_mask =
+      static_cast<uint8_t>((1u << block_size_out) - 1);
+  for (size_t i = 0; i < 256; i++) {
+    m_table[i] = s_block[i] & value_mask;
+  }
+
+  if (m_in == 4 && m_out == 4) {
+    m_wide.resize(256);
+    for (size_t b = 0; b < 256; b++) {
+      m_wide[b] = static_cast<uint8_t>(m_table[b >> 4] << 4 | m_table[b & 0xF]);
+    }
+  } else if (m_in == 6 && m_out == 4) {
+    m_wide.resize(4096);
+    for (size_t x = 0; x < 4096; x++) {
+      m_wide[x] =
+          static_cast<uint8_t>(m_table[x >> 6] << 4 | m_table[x & 0x3F]);
     }
   }
+}
 
-  if (remaining_bits > 0) {
-    const auto base_bit = total_blocks * block_size_in;
-    for (auto b = 0; b < remaining_bits; ++b) {
-      const auto in_byte_idx = (base_bit + b) / 8;
-      const auto in_bit_idx = 7 - ((base_bit + b) % 8);
-      const auto bit_val = (bits[in_byte_idx] >> in_bit_idx) & 1;
+SubstitutionPlan::SubstitutionPlan(
+    const std::unordered_map<uint8_t, uint8_t> &s_block, size_t block_size_in,
+    size_t block_size_out)
+    : SubstitutionPlan(table_from(s_block), block_size_in, block_size_out) {}
 
-      const auto out_byte_idx = out_bit_pos / 8;
-      const auto out_bit_idx = 7 - (out_bit_pos % 8);
+SubstitutionPlan::SubstitutionPlan(
+    const std::function<uint8_t(uint8_t)> &s_block, size_t block_size_in,
+    size_t block_size_out)
+    : SubstitutionPlan(table_from(s_block), block_size_in, block_size_out) {}
 
-      result[out_byte_idx] |= bit_val << out_bit_idx;
-      ++out_bit_pos;
+size_t SubstitutionPlan::output_size(size_t input_bytes) const {
+  return substituted_size(input_bytes, m_in, m_out);
+}
+
+size_t SubstitutionPlan::output_bits(size_t input_bits) const {
+  return substituted_bits(input_bits, m_in, m_out);
+}
+
+void SubstitutionPlan::apply(BitView in, BitSpan out) const {
+  const size_t n_out = output_bits(in.size());
+  if (out.size() < n_out) {
+    throw std::invalid_argument("SubstitutionPlan: buffer size mismatch");
+  }
+  if (m_in == 0) {
+    std::copy(in.bytes().begin(), in.bytes().end(), out.data());
+    out.clear_from(n_out);
+    return;
+  }
+  if (m_out == 0) {
+    out.clear_from(0);
+    return;
+  }
+
+  const uint8_t *src = in.data();
+  uint8_t *dst = out.data();
+  const size_t n_bytes = in.size() / 8;
+  if (in.size() % 8 != 0) {
+    substitute_words(m_table, m_in, m_out, in, dst);
+  } else if (m_in == 8 && m_out == 8) {
+    for (size_t i = 0; i < n_bytes; i++) {
+      dst[i] = m_table[src[i]];
+    }
+  } else if (m_in == 4 && m_out == 4) {
+    for (size_t i = 0; i < n_bytes; i++) {
+      dst[i] = m_wide[src[i]];
+    }
+  } else if (m_in == 6 && m_out == 4) {
+    // 48 input bits, eight S-box lookups, 32 output bits per step
+    const size_t steps = n_bytes / 6;
+    for (size_t s = 0; s < steps; s++) {
+      const uint8_t *p = src + 6 * s;
+      const uint64_t x = uint64_t{p[0]} << 40 | uint64_t{p[1]} << 32 |
+                         uint64_t{p[2]} << 24 | uint64_t{p[3]} << 16 |
+                         uint64_t{p[4]} << 8 | p[5];
+      uint8_t *q = dst + 4 * s;
+      q[0] = m_wide[x >> 36];
+      q[1] = m_wide[(x >> 24) & 0xFFF];
+      q[2] = m_wide[(x >> 12) & 0xFFF];
+      q[3] = m_wide[x & 0xFFF];
     }
+    substitute_words(m_table, m_in, m_out,
+                     BitView(in.bytes().subspan(6 * steps)), dst + 4 * steps);
+  } else {
+    substitute_words(m_table, m_in, m_out, in, dst);
   }
+  out.clear_from(n_out);
+}
 
+std::vector<uint8_t>
+SubstitutionPlan::apply(const std::vector<uint8_t> &in) const {
+  std::vector<uint8_t> out(output_size(in.size()));
+  apply(in, out);
+  return out;
+}
+
+std::vector<uint8_t> substitute(const std::vector<uint8_t> &bits,
+                                const std::array<uint8_t, 256> &s_block,
+                                size_t block_size_in, size_t block_size_out) {
+  if (block_size_in == 0) {
+    return bits;
+  }
+  if (block_size_out == 0) {
+    return {};
+  }
+  check_block_sizes(block_size_in, block_size_out);
+
+  std::vector<uint8_t> result(
+      substituted_size(bits.size(), block_size_in, block_size_out));
+  substitute_words(s_block, block_size_in, block_size_out, bits,
+                   result.data());
   return result;
 }
 
+void substitute(BitView bits, BitSpan out,
+                const std::array<uint8_t, 256> &s_block, size_t block_size_in,
+                size_t block_size_out) {
+  check_block_sizes(block_size_in, block_size_out);
+  const size_t n_out =
+      substituted_bits(bits.size(), block_size_in, block_size_out);
+  if (out.size() < n_out) {
+    throw std::invalid_argument("substitute: output view too small");
+  }
+  if (block_size_in == 0) {
+    std::copy(bits.bytes().begin(), bits.bytes().end(), out.data());
+  } else if (block_size_out != 0) {
+    substitute_words(s_block, block_size_in, block_size_out, bits, out.data());
+  }
+  out.clear_from(n_out);
+}
+
 std::vector<uint8_t>
 substitute(const std::vector<uint8_t> &bits,
            const std::unordered_map<uint8_t, uint8_t> &s_block,
            size_t block_size_in, size_t block_size_out) {
-  std::array<uint8_t, 256> array_s{};
-  for (auto i = 0; i < 256; ++i) {
-    const auto it = s_block.find(i);
-    if (it != s_block.end()) {
-      array_s[i] = it->second;
-    } else {
-      array_s[i] = 0;
-    }
-  }
-  return substitute(bits, array_s, block_size_in, block_size_out);
+  return substitute(bits, table_from(s_block), block_size_in, block_size_out);
 }
 
 std::vector<uint8_t> substitute(const std::vector<uint8_t> &bits,
                                 const std::function<uint8_t(uint8_t)> &s_block,
                                 size_t block_size_in, size_t block_size_out) {
-  std::array<uint8_t, 256> array_s{};
-  for (auto i = 0; i < 256; ++i) {
-    array_s[i] = s_block(i);
-  }
-  return substitute(bits, array_s, block_size_in, block_size_out);
+  return substitute(bits, table_from(s_block), block_size_in, block_size_out);
 }
 
 } // namespace crypto::bits
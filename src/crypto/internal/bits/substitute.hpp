@@ -1,6 +1,8 @@
 #ifndef CRYPTO_BITS_SUBSTITUTE_HPP
 #define CRYPTO_BITS_SUBSTITUTE_HPP
 
+#include "bit_span.hpp"
+
 #include <array>
 #include <cstdint>
 #include <functional>
@@ -9,6 +11,39 @@
 
 namespace crypto::bits {
 
+// An S-box resolved once into a flat table, for callers that substitute
+// with the same S-box repeatedly. Besides the generic word-at-a-time path
+// it keeps a byte table for 4-in/4-out and 8-in/8-out boxes and a 12-bit
+// table turning two 6-bit inputs into one output byte for 6-in/4-out
+// boxes. The output layout matches substitute().
+class SubstitutionPlan {
+public:
+  SubstitutionPlan(const std::array<uint8_t, 256> &s_block,
+                   size_t block_size_in, size_t block_size_out);
+  SubstitutionPlan(const std::unordered_map<uint8_t, uint8_t> &s_block,
+                   size_t block_size_in, size_t block_size_out);
+  SubstitutionPlan(const std::function<uint8_t(uint8_t)> &s_block,
+                   size_t block_size_in, size_t block_size_out);
+
+  size_t output_size(size_t input_bytes) const;
+  size_t output_bits(size_t input_bits) const;
+
+  // out must hold output_bits(in.size()) bits and may not overlap in; the
+  // rest of out is cleared
+  void apply(BitView in, BitSpan out) const;
+  std::vector<uint8_t> apply(const std::vector<uint8_t> &in) const;
+
+private:
+  size_t m_in;
+  size_t m_out;
+  std::array<uint8_t, 256> m_table{};
+  // whole input byte to output byte (4/4 and 8/8), or two 6-bit inputs to
+  // one output byte (6/4)
+  std::vector<uint8_t> m_wide;
+};
+
+// The unordered_map and std::function overloads resolve the S-box into a
+// table on every call; build a SubstitutionPlan to do that once.
 std::vector<uint8_t> substitute(const std::vector<uint8_t> &bits,
                                 const std::array<uint8_t, 256> &s_block,
                                 size_t block_size_in, size_t block_size_out);
@@ -22,6 +57,12 @@ std::vector<uint8_t> substitute(const std::vector<uint8_t> &bits,
                                 const std::function<uint8_t(uint8_t)> &s_block,
                                 size_t block_size_in, size_t block_size_out);
 
+// Substitutes the bits.size() bits of the view into out, which must hold
+// the substituted bits; the rest of out is cleared.
+void substitute(BitView bits, BitSpan out,
+                const std::array<uint8_t, 256> &s_block, size_t block_size_in,
+                size_t block_size_out);
+
 } // namespace crypto::bits
 
 #endif // CRYPTO_BITS_SUBSTITUTE_HPP
@@ -1,111 +1,174 @@
 #include "utils.hpp"
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstdio>
 #include <stdexcept>
 
 namespace crypto::bits {
 
-std::vector<uint8_t> rotate_left(const std::vector<uint8_t> &bits,
-                                 size_t n_bits, size_t shift) {
-  if (bits.empty() || n_bits == 0)
-    return {};
+namespace {
 
-  shift %= n_bits;
-  if (shift == 0)
-    return bits;
+constexpr size_t WORD_BITS = 64;
 
-  std::vector<uint8_t> res;
-  res.resize(bits.size(), 0);
+// count <= 8 bits of src starting at bit pos, right-aligned
+uint8_t read_bits(const uint8_t *src, size_t pos, size_t count) {
+  const size_t byte = pos / 8;
+  const size_t offset = pos % 8;
+  unsigned window = static_cast<unsigned>(src[byte]) << 8;
+  if (offset + count > 8) {
+    window |= src[byte + 1];
+  }
+  return static_cast<uint8_t>((window >> (16 - offset - count)) &
+                              ((1u << count) - 1));
+}
 
-  for (auto i = 0; i < n_bits; i++) {
-    const auto new_pos = (i + n_bits - shift) % n_bits;
-    const auto src_byte = i / 8;
-    const auto src_bit = 7 - (i % 8);
-    const auto dst_byte = new_pos / 8;
-    const auto dst_bit = 7 - (new_pos % 8);
+// Copies count bits a destination byte at a time, funnelling each from at
+// most two source bytes. Overlapping ranges are fine when dst_pos <= src_pos.
+void copy_bits(const uint8_t *src, size_t src_pos, uint8_t *dst,
+               size_t dst_pos, size_t count) {
+  while (count > 0) {
+    const size_t offset = dst_pos % 8;
+    const size_t take = std::min<size_t>(count, 8 - offset);
+    const size_t shift = 8 - offset - take;
+    const uint8_t mask = static_cast<uint8_t>(((1u << take) - 1) << shift);
+    uint8_t &byte = dst[dst_pos / 8];
+    byte = static_cast<uint8_t>((byte & ~mask) |
+                                (read_bits(src, src_pos, take) << shift));
+    src_pos += take;
+    dst_pos += take;
+    count -= take;
+  }
+}
 
-    uint8_t bit_val = (bits[src_byte] >> (src_bit) & 1);
-    res[dst_byte] &= ~(1 << (dst_bit));
-    res[dst_byte] |= bit_val << (dst_bit);
+// zeroes everything after the first n_bits bits
+void clear_tail(std::span<uint8_t> bits, size_t n_bits) {
+  const size_t used = (n_bits + 7) / 8;
+  if (n_bits % 8 != 0) {
+    bits[used - 1] &= static_cast<uint8_t>(0xFF << (8 - n_bits % 8));
   }
+  std::fill(bits.begin() + used, bits.end(), 0);
+}
 
-  const auto extra_bits = res.size() * 8 - n_bits;
-  if (extra_bits > 0) {
-    res.back() &= 0xFF >> extra_bits;
+} // namespace
+
+uint64_t rotate_left(uint64_t value, size_t n_bits, size_t shift) {
+  if (n_bits > WORD_BITS) {
+    throw std::invalid_argument("rotate: n_bits must be <= 64 for a word");
+  }
+  if (n_bits == 0) {
+    return 0;
   }
+  const uint64_t mask =
+      n_bits == WORD_BITS ? ~uint64_t{0} : (uint64_t{1} << n_bits) - 1;
+  value &= mask;
+  shift %= n_bits;
+  if (shift == 0) {
+    return value;
+  }
+  return ((value << shift) | (value >> (n_bits - shift))) & mask;
+}
 
-  return res;
+uint64_t rotate_right(uint64_t value, size_t n_bits, size_t shift) {
+  if (n_bits == 0 || n_bits > WORD_BITS) {
+    return rotate_left(value, n_bits, 0);
+  }
+  return rotate_left(value, n_bits, n_bits - shift % n_bits);
 }
 
-std::vector<uint8_t> rotate_right(const std::vector<uint8_t> &bits,
-                                  size_t n_bits, size_t shift) {
+void rotate_left(std::span<uint8_t> bits, size_t n_bits, size_t shift) {
   if (bits.empty() || n_bits == 0)
-    return {};
+    return;
+  if (n_bits > bits.size() * 8) {
+    throw std::invalid_argument("rotate: n_bits exceeds input");
+  }
 
   shift %= n_bits;
   if (shift == 0)
-    return bits;
+    return;
+
+  if (n_bits <= WORD_BITS) {
+    store_word(rotate_left(load_word(bits, n_bits), n_bits, shift), n_bits,
+               bits);
+  } else {
+    // bits [shift, n) move to the front, the first shift bits wrap around
+    std::array<uint8_t, 64> stack_head{};
+    std::vector<uint8_t> heap_head;
+    uint8_t *head = stack_head.data();
+    if ((shift + 7) / 8 > stack_head.size()) {
+      heap_head.resize((shift + 7) / 8);
+      head = heap_head.data();
+    }
+    copy_bits(bits.data(), 0, head, 0, shift);
+    copy_bits(bits.data(), shift, bits.data(), 0, n_bits - shift);
+    copy_bits(head, 0, bits.data(), n_bits - shift, shift);
+  }
+  clear_tail(bits, n_bits);
+}
 
-  std::vector<uint8_t> res;
-  res.resize(bits.size(), 0);
+void rotate_right(std::span<uint8_t> bits, size_t n_bits, size_t shift) {
+  if (bits.empty() || n_bits == 0)
+    return;
+  rotate_left(bits, n_bits, n_bits - shift % n_bits);
+}
 
-  for (auto i = 0; i < n_bits; i++) {
-    const auto new_pos = (i + n_bits + shift) % n_bits;
-    const auto src_byte = i / 8;
-    const auto src_bit = 7 - (i % 8);
-    const auto dst_byte = new_pos / 8;
-    const auto dst_bit = 7 - (new_pos % 8);
+std::vector<uint8_t> rotate_left(const std::vector<uint8_t> &bits,
+                                 size_t n_bits, size_t shift) {
+  if (bits.empty() || n_bits == 0)
+    return {};
 
-    uint8_t bit_val = (bits[src_byte] >> (src_bit) & 1);
-    res[dst_byte] &= ~(1 << (dst_bit));
-    res[dst_byte] |= bit_val << (dst_bit);
-  }
+  std::vector<uint8_t> res(bits);
+  rotate_left(std::span<uint8_t>(res), n_bits, shift);
+  return res;
+}
 
-  const auto extra_bits = res.size() * 8 - n_bits;
-  if (extra_bits > 0) {
-    res.back() &= 0xFF >> extra_bits;
-  }
+std::vector<uint8_t> rotate_right(const std::vector<uint8_t> &bits,
+                                  size_t n_bits, size_t shift) {
+  if (bits.empty() || n_bits == 0)
+    return {};
 
+  std::vector<uint8_t> res(bits);
+  rotate_right(std::span<uint8_t>(res), n_bits, shift);
   return res;
 }
 
+uint64_t load_word(std::span<const uint8_t> bytes, size_t n_bits) {
+  const size_t n_bytes = (n_bits + 7) / 8;
+  if (n_bits > WORD_BITS || bytes.size() < n_bytes) {
+    throw std::invalid_argument("load_word: bad size");
+  }
+  uint64_t value = 0;
+  for (size_t i = 0; i < n_bytes; i++) {
+    value = value << 8 | bytes[i];
+  }
+  return n_bytes == 0 ? 0 : value >> (n_bytes * 8 - n_bits);
+}
+
+void store_word(uint64_t value, size_t n_bits, std::span<uint8_t> bytes) {
+  const size_t n_bytes = (n_bits + 7) / 8;
+  if (n_bits > WORD_BITS || bytes.size() < n_bytes) {
+    throw std::invalid_argument("store_word: bad size");
+  }
+  if (n_bits < WORD_BITS) {
+    value &= (uint64_t{1} << n_bits) - 1;
+  }
+  value <<= n_bytes * 8 - n_bits;
+  for (size_t i = n_bytes; i > 0; i--) {
+    bytes[i - 1] = static_cast<uint8_t>(value);
+    value >>= 8;
+  }
+}
+
 std::vector<uint8_t> apply_mask(const std::vector<uint8_t> &bits,
                                 const std::vector<uint8_t> &mask,
                                 size_t mask_bits, MaskType mask_type) {
-  auto const n_bits = bits.size() * 8;
-
-  if (mask_bits > n_bits) {
+  if (mask_bits > bits.size() * 8) {
     throw std::invalid_argument("Mask longer than bits array");
   }
 
   std::vector<uint8_t> result(bits);
-
-  for (auto i = 0; i < n_bits; i++) {
-    auto const byte_index = i / 8;
-    auto const bit_index = 7 - (i % 8);
-
-    uint8_t mask_bit = (mask[byte_index] >> bit_index) & 1;
-    uint8_t &bit_ref = result[byte_index];
-    uint8_t bit_mask = 1 << bit_index;
-
-    switch (mask_type) {
-    case MaskType::And:
-      if (mask_bit == 0) {
-        bit_ref &= ~bit_mask;
-      }
-      break;
-    case MaskType::Or:
-      if (mask_bit == 1) {
-        bit_ref |= bit_mask;
-      }
-      break;
-    case MaskType::Xor:
-      if (mask_bit == 1) {
-        bit_ref ^= bit_mask;
-      }
-      break;
-    }
-  }
+  apply_mask(result, BitView(std::span<const uint8_t>(mask), mask_bits),
+             mask_type);
   return result;
 }
 
@@ -114,37 +177,17 @@ std::vector<uint8_t> get_bits(const std::vector<uint8_t> &bits, size_t i,
   if (i > j) {
     return {};
   }
-
-  const size_t total_bits = bits.size() * 8;
-  if (j >= total_bits) {
+  if (j >= bits.size() * 8) {
     throw std::invalid_argument("index out of bounds");
   }
 
-  const auto bit_len = j - i + 1;
-  const auto out_bytes = (bit_len + 7) / 8;
-  std::vector<uint8_t> out(out_bytes, 0);
-
-  for (size_t k = i; k <= j; k++) {
-    uint8_t bit_val = get_bit(bits, k);
-    size_t out_index = k - i;
-    const auto dst_byte = out_index / 8;
-    const auto dst_bit = 7 - (out_index % 8);
-    out[dst_byte] |= bit_val << dst_bit;
-  }
-
+  std::vector<uint8_t> out((j - i + 1 + 7) / 8);
+  get_bits(bits, i, j, out);
   return out;
 }
 
 void swap_bits(std::vector<uint8_t> &bits, size_t i, size_t j) {
-  if (i == j || bits.empty()) {
-    return;
-  }
-
-  uint8_t bit_i = get_bit(bits, i);
-  uint8_t bit_j = get_bit(bits, j);
-
-  set_bit(bits, i, bit_j);
-  set_bit(bits, j, bit_i);
+  swap_bits(BitSpan(bits), i, j);
 }
 
 uint8_t get_bit(const std::vector<uint8_t> &bits, size_t index) {
@@ -168,4 +211,67 @@ void set_bit(std::vector<uint8_t> &bits, size_t index, uint8_t val) {
   bits[byte] |= (val & 1) << bit;
 }
 
+void rotate_left(BitSpan bits, size_t shift) {
+  rotate_left(bits.bytes(), bits.size(), shift);
+}
+
+void rotate_right(BitSpan bits, size_t shift) {
+  rotate_right(bits.bytes(), bits.size(), shift);
+}
+
+void apply_mask(BitSpan bits, BitView mask, MaskType mask_type) {
+  if (mask.size() > bits.size()) {
+    throw std::invalid_argument("Mask longer than bits array");
+  }
+
+  uint8_t *dst = bits.data();
+  const uint8_t *src = mask.data();
+  const size_t n_bytes = mask.bytes().size();
+  for (size_t b = 0; b < n_bytes; b++) {
+    // the bits of this byte that the mask covers
+    const size_t covered = std::min<size_t>(8, mask.size() - 8 * b);
+    const uint8_t cover = static_cast<uint8_t>(0xFF << (8 - covered));
+    const uint8_t m = src[b] & cover;
+    switch (mask_type) {
+    case MaskType::And:
+      dst[b] &= static_cast<uint8_t>(m | ~cover);
+      break;
+    case MaskType::Or:
+      dst[b] |= m;
+      break;
+    case MaskType::Xor:
+      dst[b] ^= m;
+      break;
+    }
+  }
+}
+
+void get_bits(BitView bits, size_t i, size_t j, BitSpan out) {
+  if (i > j) {
+    out.clear_from(0);
+    return;
+  }
+  if (j >= bits.size()) {
+    throw std::invalid_argument("index out of bounds");
+  }
+
+  const size_t bit_len = j - i + 1;
+  if (out.size() < bit_len) {
+    throw std::invalid_argument("get_bits: output view too small");
+  }
+  copy_bits(bits.data(), i, out.data(), 0, bit_len);
+  out.clear_from(bit_len);
+}
+
+void swap_bits(BitSpan bits, size_t i, size_t j) {
+  if (i == j || bits.empty()) {
+    return;
+  }
+
+  const uint8_t bit_i = bits.get(i);
+  const uint8_t bit_j = bits.get(j);
+  bits.set_unchecked(i, bit_j);
+  bits.set_unchecked(j, bit_i);
+}
+
 } // namespace crypto::bits
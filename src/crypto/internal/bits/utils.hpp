@@ -1,7 +1,10 @@
 #ifndef CRYPTO_BITS_UTILS_HPP
 #define CRYPTO_BITS_UTILS_HPP
 
+#include "bit_span.hpp"
+
 #include <cstdint>
+#include <span>
 #include <vector>
 
 namespace crypto::bits {
@@ -12,12 +15,33 @@ enum class MaskType {
   Xor,
 };
 
+// Rotations of the first n_bits bits; bits past n_bits come out zero.
+// Values of up to 64 bits are rotated in one word, longer ones a byte at a
+// time with funnel shifts.
 std::vector<uint8_t> rotate_left(const std::vector<uint8_t> &bits,
                                  size_t n_bits, size_t shift);
 
 std::vector<uint8_t> rotate_right(const std::vector<uint8_t> &bits,
                                   size_t n_bits, size_t shift);
 
+// in place over caller memory
+void rotate_left(std::span<uint8_t> bits, size_t n_bits, size_t shift);
+
+void rotate_right(std::span<uint8_t> bits, size_t n_bits, size_t shift);
+
+// right-aligned values of n_bits <= 64 bits
+uint64_t rotate_left(uint64_t value, size_t n_bits, size_t shift);
+
+uint64_t rotate_right(uint64_t value, size_t n_bits, size_t shift);
+
+// the first n_bits bits of bytes as a right-aligned value, and back; store
+// clears the pad bits of the last byte
+uint64_t load_word(std::span<const uint8_t> bytes, size_t n_bits);
+
+void store_word(uint64_t value, size_t n_bits, std::span<uint8_t> bytes);
+
+// combines the first mask_bits bits of bits with mask; later bits are left
+// alone and mask must hold at least mask_bits bits
 std::vector<uint8_t> apply_mask(const std::vector<uint8_t> &bits,
                                 const std::vector<uint8_t> &mask,
                                 size_t mask_bits, MaskType mask_type);
@@ -31,6 +55,22 @@ uint8_t get_bit(const std::vector<uint8_t> &bits, size_t index);
 
 void set_bit(std::vector<uint8_t> &bits, size_t index, uint8_t val);
 
+// View overloads. Results go to the start of out and the rest of out is
+// cleared, as the vector versions zero-pad; single bits are read and
+// written with BitView::get and BitSpan::set.
+void rotate_left(BitSpan bits, size_t shift);
+
+void rotate_right(BitSpan bits, size_t shift);
+
+// combines the first mask.size() bits of bits with mask; later bits are
+// left alone
+void apply_mask(BitSpan bits, BitView mask, MaskType mask_type);
+
+// bits i..j inclusive; out must hold j - i + 1 bits
+void get_bits(BitView bits, size_t i, size_t j, BitSpan out);
+
+void swap_bits(BitSpan bits, size_t i, size_t j);
+
 } // namespace crypto::bits
 
 #endif // !CRYPTO_BITS_UTILS_HPP
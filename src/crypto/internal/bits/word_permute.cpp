@@ -0,0 +1,263 @@
+#include "word_permute.hpp"
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CRYPTO_BITS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace crypto::bits {
+
+namespace {
+
+constexpr size_t WORD_BITS = 64;
+constexpr unsigned BENES_LEVELS = 6;
+constexpr unsigned BENES_STAGES = 2 * BENES_LEVELS - 1;
+
+// (source, target) bit positions, counted from the least significant bit
+struct Move {
+  unsigned source;
+  unsigned target;
+};
+
+#ifdef CRYPTO_BITS_X86
+__attribute__((target("bmi2"))) uint64_t
+gather_scatter(const uint64_t *extract, const uint64_t *deposit, size_t n,
+               uint64_t x) {
+  uint64_t out = 0;
+  for (size_t i = 0; i < n; i++) {
+    out |= _pdep_u64(_pext_u64(x, extract[i]), deposit[i]);
+  }
+  return out;
+}
+#endif
+
+// Looping algorithm for a Benes network over src.size() positions starting
+// at offset: output position p takes input position src[p]. The outer
+// switches of this level go to stage `level` and its mirror; the two halves
+// recurse one level deeper with half the swap distance.
+void route(const std::vector<uint8_t> &src, size_t offset, unsigned level,
+           std::array<uint64_t, BENES_STAGES> &masks) {
+  const size_t n = src.size();
+  if (n == 2) {
+    if (src[0] == 1) {
+      masks[level] |= uint64_t{1} << offset;
+    }
+    return;
+  }
+
+  const size_t d = n / 2;
+  auto partner = [d](size_t p) { return p < d ? p + d : p - d; };
+
+  std::vector<uint8_t> inverse(n);
+  for (size_t p = 0; p < n; p++) {
+    inverse[src[p]] = static_cast<uint8_t>(p);
+  }
+
+  // 0 routes an input through the upper subnetwork, 1 through the lower
+  std::vector<int8_t> side(n, -1);
+  for (size_t a = 0; a < d; a++) {
+    size_t v = a;
+    while (side[v] < 0) {
+      side[v] = 0;
+      const size_t u = partner(v);
+      side[u] = 1;
+      v = src[partner(inverse[u])];
+    }
+  }
+
+  std::vector<uint8_t> upper(d), lower(d);
+  for (size_t a = 0; a < d; a++) {
+    if (side[a] == 1) {
+      masks[level] |= uint64_t{1} << (offset + a);
+    }
+  }
+  for (size_t b = 0; b < d; b++) {
+    const size_t first = src[b];
+    const size_t second = src[b + d];
+    if (side[first] == 0) {
+      upper[b] = static_cast<uint8_t>(first % d);
+      lower[b] = static_cast<uint8_t>(second % d);
+    } else {
+      upper[b] = static_cast<uint8_t>(second % d);
+      lower[b] = static_cast<uint8_t>(first % d);
+      masks[BENES_STAGES - 1 - level] |= uint64_t{1} << (offset + b);
+    }
+  }
+
+  route(upper, offset, level + 1, masks);
+  route(lower, offset + d, level + 1, masks);
+}
+
+} // namespace
+
+WordPermutation::WordPermutation(const std::vector<size_t> &p_block,
+                                 size_t input_bits, BitOrder order,
+                                 BitIndexBase index_base, Backend backend)
+    : m_input_bits(input_bits), m_output_bits(p_block.size()),
+      m_backend(backend) {
+  if (input_bits > WORD_BITS || p_block.size() > WORD_BITS) {
+    throw std::invalid_argument(
+        "WordPermutation: input and output must fit in 64 bits");
+  }
+
+  std::vector<Move> moves;
+  for (size_t i = 0; i < p_block.size(); i++) {
+    size_t index = p_block[i];
+    if (index_base == BitIndexBase::One) {
+      index--;
+    }
+    if (order == BitOrder::LittleEndian) {
+      index = input_bits - 1 - index;
+    }
+    if (index < input_bits) {
+      moves.push_back({static_cast<unsigned>(input_bits - 1 - index),
+                       static_cast<unsigned>(m_output_bits - 1 - i)});
+    }
+  }
+
+  // shift and mask: one group per distinct distance
+  std::map<int, uint64_t> by_shift;
+  for (const auto &m : moves) {
+    by_shift[static_cast<int>(m.target) - static_cast<int>(m.source)] |=
+        uint64_t{1} << m.source;
+  }
+  for (const auto &[shift, mask] : by_shift) {
+    m_groups.push_back({mask, shift});
+  }
+
+  // PEXT/PDEP: first-fit split into chains whose sources rise with their
+  // targets
+  std::vector<Move> by_target = moves;
+  std::sort(by_target.begin(), by_target.end(),
+            [](const Move &a, const Move &b) { return a.target < b.target; });
+  std::vector<unsigned> chain_top;
+  for (const auto &m : by_target) {
+    size_t c = 0;
+    while (c < chain_top.size() && chain_top[c] >= m.source) {
+      c++;
+    }
+    if (c == chain_top.size()) {
+      chain_top.push_back(m.source);
+      m_extract.push_back(0);
+      m_deposit.push_back(0);
+    }
+    chain_top[c] = m.source;
+    m_extract[c] |= uint64_t{1} << m.source;
+    m_deposit[c] |= uint64_t{1} << m.target;
+  }
+
+  // Benes: only for bijections; positions above the value stay in place
+  bool bijection = input_bits == m_output_bits && moves.size() == input_bits;
+  std::vector<uint8_t> src(WORD_BITS);
+  for (size_t p = 0; p < WORD_BITS; p++) {
+    src[p] = static_cast<uint8_t>(p);
+  }
+  uint64_t seen = 0;
+  for (const auto &m : moves) {
+    bijection = bijection && !(seen >> m.source & 1);
+    seen |= uint64_t{1} << m.source;
+    src[m.target] = static_cast<uint8_t>(m.source);
+  }
+  if (bijection) {
+    std::array<uint64_t, BENES_STAGES> masks{};
+    route(src, 0, 0, masks);
+    for (unsigned s = 0; s < BENES_STAGES; s++) {
+      const unsigned level = s < BENES_LEVELS ? s : BENES_STAGES - 1 - s;
+      if (masks[s] != 0) {
+        m_stages.push_back({masks[s], static_cast<unsigned>(32 >> level)});
+      }
+    }
+  }
+
+  if (m_backend == Backend::Auto) {
+    // rough instruction counts per backend
+    const size_t shift_cost = 3 * m_groups.size();
+    const size_t bmi2_cost = 3 * m_extract.size();
+    const size_t benes_cost = 6 * m_stages.size();
+
+    m_backend = Backend::ShiftMask;
+    size_t best = shift_cost;
+    if (bijection && benes_cost < best) {
+      m_backend = Backend::Benes;
+      best = benes_cost;
+    }
+    if (supported(Backend::Bmi2) && bmi2_cost < best) {
+      m_backend = Backend::Bmi2;
+    }
+  }
+  if (!supported(m_backend)) {
+    throw std::invalid_argument(
+        "WordPermutation: backend is not supported on this CPU");
+  }
+  if (m_backend == Backend::Benes && !bijection) {
+    throw std::invalid_argument(
+        "WordPermutation: Benes backend needs a bijective p-block");
+  }
+}
+
+uint64_t WordPermutation::apply(uint64_t x) const {
+  switch (m_backend) {
+  case Backend::Bmi2:
+    return apply_bmi2(x);
+  case Backend::Benes:
+    return apply_benes(x);
+  default:
+    return apply_shift_mask(x);
+  }
+}
+
+uint64_t WordPermutation::apply_shift_mask(uint64_t x) const {
+  uint64_t out = 0;
+  for (const auto &g : m_groups) {
+    const uint64_t bits = x & g.mask;
+    out |= g.shift >= 0 ? bits << g.shift : bits >> -g.shift;
+  }
+  return out;
+}
+
+uint64_t WordPermutation::apply_benes(uint64_t x) const {
+  for (const auto &stage : m_stages) {
+    const uint64_t t = ((x >> stage.distance) ^ x) & stage.mask;
+    x ^= t ^ (t << stage.distance);
+  }
+  return x;
+}
+
+uint64_t WordPermutation::apply_bmi2(uint64_t x) const {
+#ifdef CRYPTO_BITS_X86
+  return gather_scatter(m_extract.data(), m_deposit.data(), m_extract.size(),
+                        x);
+#else
+  return apply_shift_mask(x);
+#endif
+}
+
+size_t WordPermutation::input_bits() const { return m_input_bits; }
+
+size_t WordPermutation::output_bits() const { return m_output_bits; }
+
+WordPermutation::Backend WordPermutation::backend() const { return m_backend; }
+
+bool WordPermutation::supported(Backend backend) {
+  switch (backend) {
+  case Backend::Auto:
+  case Backend::ShiftMask:
+  case Backend::Benes:
+    return true;
+#ifdef CRYPTO_BITS_X86
+  case Backend::Bmi2: {
+    static const bool bmi2 = __builtin_cpu_supports("bmi2");
+    return bmi2;
+  }
+#endif
+  default:
+    return false;
+  }
+}
+
+} // namespace crypto::bits
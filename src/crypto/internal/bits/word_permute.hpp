@@ -0,0 +1,74 @@
+#ifndef CRYPTO_BITS_WORD_PERMUTE_HPP
+#define CRYPTO_BITS_WORD_PERMUTE_HPP
+
+#include "permute.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace crypto::bits {
+
+// A p-block of at most 64 output bits over an input of at most 64 bits,
+// applied to a uint64_t. Values are right-aligned: bit 0 of the p-block
+// numbering (BigEndian) is the most significant of the input_bits low bits,
+// so load_word() of the bytes permute() takes gives the matching word.
+// LittleEndian indices count back from the last of the input_bits bits.
+//
+// The network is generated from the p-block when the object is built:
+//  - Bmi2 splits the mapping into order-preserving chains, each one PEXT
+//    gathering its source bits and one PDEP scattering them;
+//  - Benes routes a bijection through at most 11 delta swaps;
+//  - ShiftMask moves every group of bits that share a shift distance with
+//    one mask and shift.
+// Auto picks the cheapest backend this CPU supports for the p-block.
+class WordPermutation {
+public:
+  enum class Backend {
+    Auto,
+    ShiftMask,
+    Benes,
+    Bmi2,
+  };
+
+  WordPermutation(const std::vector<size_t> &p_block, size_t input_bits,
+                  BitOrder order, BitIndexBase index_base,
+                  Backend backend = Backend::Auto);
+
+  uint64_t apply(uint64_t x) const;
+
+  size_t input_bits() const;
+  size_t output_bits() const;
+  Backend backend() const;
+
+  // whether the CPU can run the backend; Benes is only usable for p-blocks
+  // that are bijections, which the constructor checks
+  static bool supported(Backend backend);
+
+private:
+  struct ShiftGroup {
+    uint64_t mask;
+    int shift; // positive moves bits up
+  };
+  struct SwapStage {
+    uint64_t mask;
+    unsigned distance;
+  };
+
+  uint64_t apply_shift_mask(uint64_t x) const;
+  uint64_t apply_benes(uint64_t x) const;
+  uint64_t apply_bmi2(uint64_t x) const;
+
+  size_t m_input_bits;
+  size_t m_output_bits;
+  Backend m_backend;
+  // chain i gathers the bits of m_extract[i] and scatters them to
+  // m_deposit[i]
+  std::vector<uint64_t> m_extract;
+  std::vector<uint64_t> m_deposit;
+  std::vector<ShiftGroup> m_groups;
+  std::vector<SwapStage> m_stages;
+};
+
+} // namespace crypto::bits
+
+#endif // CRYPTO_BITS_WORD_PERMUTE_HPP
@@ -1,4 +1,5 @@
 #include "feistel_network.hpp"
+#include "internal/secure_wipe.hpp"
 #include <algorithm>
 #include <stdexcept>
 
@@ -18,12 +19,23 @@ FeistelNetwork::FeistelNetwork(KeyExpansion &key_expansion,
   }
 }
 
+FeistelNetwork::~FeistelNetwork() {
+  wipe(m_enc_round_keys);
+  wipe(m_dec_round_keys);
+}
+
+void FeistelNetwork::wipe(RoundKeys &round_keys) {
+  for (auto &key : round_keys) internal::secure_wipe(key);
+}
+
 void FeistelNetwork::set_encryption_key(const Bytes &key) {
+  wipe(m_enc_round_keys);
   m_enc_round_keys = m_key_expansion.expand(key);
   validate_round_keys(m_enc_round_keys);
 }
 
 void FeistelNetwork::set_decryption_key(const Bytes &key) {
+  wipe(m_dec_round_keys);
   m_dec_round_keys = m_key_expansion.expand(key);
   validate_round_keys(m_dec_round_keys);
   std::reverse(m_dec_round_keys.begin(), m_dec_round_keys.end());
@@ -16,6 +16,7 @@ public:
   FeistelNetwork(KeyExpansion &key_expansion,
                  FeistelRoundFunction &round_function, size_t rounds,
                  size_t block_size);
+  ~FeistelNetwork() override;
 
   void set_encryption_key(const Bytes &key) override;
   void set_decryption_key(const Bytes &key) override;
@@ -29,6 +30,7 @@ private:
   Bytes process_block(const Bytes &block, const RoundKeys &round_keys) const;
 
   void validate_round_keys(const RoundKeys &round_keys) const;
+  static void wipe(RoundKeys &round_keys);
 
   const KeyExpansion &m_key_expansion;
   const FeistelRoundFunction &m_round_function;
@@ -0,0 +1,40 @@
+#ifndef CRYPTO_CORE_STREAM_CIPHER_HPP
+#define CRYPTO_CORE_STREAM_CIPHER_HPP
+
+#include "crypto/internal/bytes.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace crypto::core {
+
+// A keyed keystream generator. Unlike SymmetricCipher, producing output
+// advances the object's state, so one instance serves one stream on one
+// thread at a time; clone() gives an independent copy at the same position.
+class StreamCipher {
+public:
+  virtual ~StreamCipher() = default;
+
+  // keys the cipher and rewinds the keystream to its start
+  virtual void set_key(const Bytes &) = 0;
+
+  // writes the next out.size() keystream bytes
+  virtual void keystream(std::span<Byte> out) = 0;
+  // out = in ^ keystream; in and out have the same size and may alias
+  virtual void apply(std::span<const Byte> in, std::span<Byte> out) = 0;
+  // skips n keystream bytes
+  virtual void discard(uint64_t n) = 0;
+  // true if discard costs O(1) rather than O(n), so a stream can be split
+  // across threads by giving each a clone moved to its offset
+  virtual bool seekable() const { return false; }
+
+  // the full generator state, enough to resume the stream with restore
+  virtual Bytes snapshot() const = 0;
+  virtual void restore(const Bytes &) = 0;
+
+  virtual std::unique_ptr<StreamCipher> clone() const = 0;
+};
+} // namespace crypto::core
+
+#endif // !CRYPTO_CORE_STREAM_CIPHER_HPP
@@ -5,6 +5,8 @@
 
 namespace crypto::core {
 
+// Block operations only read the key schedule, so any number of threads may
+// call them at once; setting a key must not overlap with them.
 class SymmetricCipher {
 public:
   virtual ~SymmetricCipher() = default;
@@ -0,0 +1,584 @@
+#include "internal/file_pipeline.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define CRYPTO_HAVE_IO_URING 1
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace crypto::internal {
+  namespace {
+    // page-aligned, which O_DIRECT needs and registered buffers prefer
+    struct AlignedFree {
+      void operator()(Byte* p) const { std::free(p); }
+    };
+    using AlignedBuffer = std::unique_ptr<Byte, AlignedFree>;
+
+    AlignedBuffer allocate(size_t size) {
+      const size_t rounded = std::max(
+          (size + DIRECT_IO_ALIGNMENT - 1) / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT,
+          DIRECT_IO_ALIGNMENT);
+      auto* p = static_cast<Byte*>(std::aligned_alloc(DIRECT_IO_ALIGNMENT, rounded));
+      if (p == nullptr) throw std::bad_alloc();
+      return AlignedBuffer(p);
+    }
+
+    // Hands items between pipeline stages. Memory is bounded by the fixed
+    // set of buffer slots that travel through the channels, not by the
+    // channel itself.
+    template <typename T>
+    class Channel {
+    public:
+      void push(T item) {
+        {
+          std::lock_guard lock(m_mutex);
+          m_items.push(std::move(item));
+        }
+        m_cv.notify_one();
+      }
+
+      // blocks for the next item; nullopt once closed and drained
+      std::optional<T> pop() {
+        std::unique_lock lock(m_mutex);
+        m_cv.wait(lock, [&] { return !m_items.empty() || m_closed; });
+        if (m_items.empty()) return std::nullopt;
+        T item = std::move(m_items.front());
+        m_items.pop();
+        return item;
+      }
+
+      void close() {
+        {
+          std::lock_guard lock(m_mutex);
+          m_closed = true;
+        }
+        m_cv.notify_all();
+      }
+
+    private:
+      std::mutex m_mutex;
+      std::condition_variable m_cv;
+      std::queue<T> m_items;
+      bool m_closed = false;
+    };
+
+    struct Chunk {
+      size_t slot;
+      size_t len;
+      bool last;
+    };
+
+    void run_threads(const std::string& input_path, const std::string& output_path,
+                     const PipelineOptions& options, const ChunkTransform& transform) {
+      std::ifstream in(input_path, std::ios::binary);
+      if (!in) {
+        throw std::runtime_error("FilePipeline: cannot open file for reading: " + input_path);
+      }
+      std::ofstream out(output_path, std::ios::binary | std::ios::trunc);
+      if (!out) {
+        throw std::runtime_error("FilePipeline: cannot open file for writing: " + output_path);
+      }
+
+      const size_t depth = std::max<size_t>(options.depth, 2);
+      std::vector<AlignedBuffer> in_bufs, out_bufs;
+      Channel<size_t> free_in, free_out;
+      Channel<Chunk> filled, to_write;
+      for (size_t s = 0; s < depth; ++s) {
+        in_bufs.push_back(allocate(options.chunk_size));
+        out_bufs.push_back(allocate(options.output_capacity));
+        free_in.push(s);
+        free_out.push(s);
+      }
+
+      std::mutex error_mutex;
+      std::exception_ptr error;
+      auto fail = [&](std::exception_ptr e) {
+        {
+          std::lock_guard lock(error_mutex);
+          if (!error) error = e;
+        }
+        free_in.close();
+        free_out.close();
+        filled.close();
+        to_write.close();
+      };
+
+      std::thread reader([&] {
+        try {
+          for (bool last = false; !last;) {
+            auto slot = free_in.pop();
+            if (!slot) return;
+            in.read(reinterpret_cast<char*>(in_bufs[*slot].get()),
+                    static_cast<std::streamsize>(options.chunk_size));
+            const auto got = static_cast<size_t>(in.gcount());
+            if (in.bad()) {
+              throw std::runtime_error("FilePipeline: read error: " + input_path);
+            }
+            last = got < options.chunk_size ||
+                   in.peek() == std::ifstream::traits_type::eof();
+            filled.push({*slot, got, last});
+          }
+        } catch (...) {
+          fail(std::current_exception());
+        }
+      });
+
+      std::thread writer([&] {
+        try {
+          while (auto chunk = to_write.pop()) {
+            out.write(reinterpret_cast<const char*>(out_bufs[chunk->slot].get()),
+                      static_cast<std::streamsize>(chunk->len));
+            if (!out) {
+              throw std::runtime_error("FilePipeline: write error: " + output_path);
+            }
+            free_out.push(chunk->slot);
+            if (chunk->last) return;
+          }
+        } catch (...) {
+          fail(std::current_exception());
+        }
+      });
+
+      try {
+        while (auto chunk = filled.pop()) {
+          auto out_slot = free_out.pop();
+          if (!out_slot) break;
+          const size_t n = transform(
+              std::span<const Byte>(in_bufs[chunk->slot].get(), chunk->len),
+              std::span<Byte>(out_bufs[*out_slot].get(), options.output_capacity),
+              chunk->last);
+          free_in.push(chunk->slot);
+          to_write.push({*out_slot, n, chunk->last});
+          if (chunk->last) break;
+        }
+      } catch (...) {
+        fail(std::current_exception());
+      }
+
+      reader.join();
+      writer.join();
+      if (error) std::rethrow_exception(error);
+      out.close();
+      if (!out) {
+        throw std::runtime_error("FilePipeline: write error: " + output_path);
+      }
+    }
+
+#ifdef CRYPTO_HAVE_IO_URING
+    class FileDescriptor {
+    public:
+      explicit FileDescriptor(int fd) : m_fd(fd) {}
+      FileDescriptor(const FileDescriptor&) = delete;
+      FileDescriptor& operator=(const FileDescriptor&) = delete;
+      ~FileDescriptor() {
+        if (m_fd >= 0) ::close(m_fd);
+      }
+      int get() const { return m_fd; }
+
+    private:
+      int m_fd;
+    };
+
+    // An owned shared mapping of an io_uring region
+    class Mapping {
+    public:
+      Mapping() = default;
+      Mapping(int fd, size_t size, off_t offset) : m_size(size) {
+        void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, fd, offset);
+        if (p == MAP_FAILED) throw std::runtime_error("FilePipeline: cannot map io_uring");
+        m_data = p;
+      }
+      Mapping(Mapping&& other) noexcept
+          : m_data(std::exchange(other.m_data, nullptr)), m_size(other.m_size) {}
+      Mapping& operator=(Mapping&& other) noexcept {
+        if (this != &other) {
+          reset();
+          m_data = std::exchange(other.m_data, nullptr);
+          m_size = other.m_size;
+        }
+        return *this;
+      }
+      ~Mapping() { reset(); }
+
+      Byte* get() const { return static_cast<Byte*>(m_data); }
+
+    private:
+      void reset() {
+        if (m_data != nullptr) ::munmap(m_data, m_size);
+        m_data = nullptr;
+      }
+
+      void* m_data = nullptr;
+      size_t m_size = 0;
+    };
+
+    // Minimal io_uring wrapper over the raw syscalls: one submission and
+    // completion ring, fixed buffers, blocking waits. The descriptor and
+    // mappings are members, so a constructor that fails part way releases
+    // whatever it already set up.
+    class Ring {
+    public:
+      explicit Ring(unsigned entries) : m_fd(setup(entries, m_params)) {
+        if (m_fd.get() < 0) throw std::runtime_error("FilePipeline: io_uring_setup failed");
+        const io_uring_params& p = m_params;
+
+        size_t sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        size_t cq_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        const bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) sq_size = cq_size = std::max(sq_size, cq_size);
+
+        m_sq_map = Mapping(m_fd.get(), sq_size, IORING_OFF_SQ_RING);
+        if (!single) m_cq_map = Mapping(m_fd.get(), cq_size, IORING_OFF_CQ_RING);
+        m_sqes_map = Mapping(m_fd.get(), p.sq_entries * sizeof(io_uring_sqe), IORING_OFF_SQES);
+        m_sqes = reinterpret_cast<io_uring_sqe*>(m_sqes_map.get());
+
+        Byte* sq = m_sq_map.get();
+        m_sq_tail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        m_sq_mask = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        m_sq_array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        Byte* cq = single ? sq : m_cq_map.get();
+        m_cq_head = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        m_cq_tail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        m_cq_mask = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+      }
+
+      Ring(const Ring&) = delete;
+      Ring& operator=(const Ring&) = delete;
+
+      void register_buffers(const std::vector<iovec>& iovs) {
+        if (::syscall(__NR_io_uring_register, m_fd.get(), IORING_REGISTER_BUFFERS,
+                      iovs.data(), static_cast<unsigned>(iovs.size())) < 0) {
+          throw std::runtime_error("FilePipeline: cannot register io_uring buffers");
+        }
+      }
+
+      void submit(uint8_t opcode, int fd, Byte* addr, size_t len, uint64_t offset,
+                  uint16_t buf_index, uint64_t user_data) {
+        const unsigned tail = *m_sq_tail;
+        const unsigned idx = tail & m_sq_mask;
+        io_uring_sqe& sqe = m_sqes[idx];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = opcode;
+        sqe.fd = fd;
+        sqe.off = offset;
+        sqe.addr = reinterpret_cast<uint64_t>(addr);
+        sqe.len = static_cast<uint32_t>(len);
+        sqe.buf_index = buf_index;
+        sqe.user_data = user_data;
+        m_sq_array[idx] = idx;
+        __atomic_store_n(m_sq_tail, tail + 1, __ATOMIC_RELEASE);
+        while (enter(1, 0, 0) < 0) {
+          if (errno != EINTR && errno != EAGAIN)
+            throw std::runtime_error("FilePipeline: io_uring_enter failed");
+        }
+      }
+
+      io_uring_cqe wait() {
+        for (;;) {
+          const unsigned head = *m_cq_head;
+          if (head != __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE)) {
+            const io_uring_cqe cqe = m_cqes[head & m_cq_mask];
+            __atomic_store_n(m_cq_head, head + 1, __ATOMIC_RELEASE);
+            return cqe;
+          }
+          if (enter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+            throw std::runtime_error("FilePipeline: io_uring_enter failed");
+        }
+      }
+
+    private:
+      static int setup(unsigned entries, io_uring_params& params) {
+        return static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+      }
+
+      int enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+        return static_cast<int>(::syscall(__NR_io_uring_enter, m_fd.get(), to_submit,
+                                          min_complete, flags, nullptr, 0));
+      }
+
+      io_uring_params m_params{};
+      // declared before the mappings, which are therefore unmapped before
+      // the descriptor closes
+      FileDescriptor m_fd;
+      Mapping m_sq_map;
+      Mapping m_cq_map;
+      Mapping m_sqes_map;
+      io_uring_sqe* m_sqes = nullptr;
+      unsigned* m_sq_tail = nullptr;
+      unsigned* m_sq_array = nullptr;
+      unsigned m_sq_mask = 0;
+      unsigned* m_cq_head = nullptr;
+      unsigned* m_cq_tail = nullptr;
+      unsigned m_cq_mask = 0;
+      io_uring_cqe* m_cqes = nullptr;
+    };
+
+    // Slot s owns input buffer s (registered index s) and output buffer s
+    // (registered index depth + s). Chunk c always uses slot c % depth, so
+    // with depth 3 the read of chunk c + 2 and the write of chunk c - 1 are
+    // in flight while chunk c is transformed.
+    class UringPipeline {
+    public:
+      UringPipeline(const PipelineOptions& options, const ChunkTransform& transform)
+          : m_options(options), m_transform(transform),
+            m_depth(std::max<size_t>(options.depth, 2)),
+            m_ring(static_cast<unsigned>(2 * m_depth)),
+            m_slots(m_depth) {
+        std::vector<iovec> iovs;
+        for (auto& slot : m_slots) {
+          slot.in = allocate(options.chunk_size);
+          iovs.push_back({slot.in.get(), options.chunk_size});
+        }
+        for (auto& slot : m_slots) {
+          slot.out = allocate(options.output_capacity);
+          iovs.push_back({slot.out.get(), options.output_capacity});
+        }
+        m_ring.register_buffers(iovs);
+      }
+
+      void run(const std::string& input_path, const std::string& output_path) {
+        const int direct = m_options.direct_io ? O_DIRECT : 0;
+        int in_fd = ::open(input_path.c_str(), O_RDONLY | direct);
+        if (in_fd < 0 && direct != 0) {
+          // not every filesystem accepts O_DIRECT; fall back to the page cache
+          in_fd = ::open(input_path.c_str(), O_RDONLY);
+          m_direct = false;
+        } else {
+          m_direct = direct != 0;
+        }
+        FileDescriptor in(in_fd);
+        if (in.get() < 0) {
+          throw std::runtime_error("FilePipeline: cannot open file for reading: " + input_path);
+        }
+        struct stat st {};
+        if (::fstat(in.get(), &st) != 0) {
+          throw std::runtime_error("FilePipeline: cannot stat file: " + input_path);
+        }
+        FileDescriptor out(::open(output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644));
+        if (out.get() < 0) {
+          throw std::runtime_error("FilePipeline: cannot open file for writing: " + output_path);
+        }
+        m_in_fd = in.get();
+        m_out_fd = out.get();
+        m_file_size = static_cast<uint64_t>(st.st_size);
+
+        try {
+          pump();
+        } catch (...) {
+          // buffers must not be released while the kernel may still use them
+          drain();
+          throw;
+        }
+      }
+
+    private:
+      static constexpr uint64_t READ = 0;
+      static constexpr uint64_t WRITE = 1;
+
+      struct Slot {
+        AlignedBuffer in;
+        AlignedBuffer out;
+        size_t want = 0;
+        size_t got = 0;
+        // buffer position the read in flight started at
+        size_t read_base = 0;
+        bool ready = false;
+        size_t write_len = 0;
+        size_t write_done = 0;
+        uint64_t write_offset = 0;
+        bool writing = false;
+      };
+
+      void pump() {
+        const size_t chunk = m_options.chunk_size;
+        const size_t n_chunks =
+            std::max<uint64_t>(1, (m_file_size + chunk - 1) / chunk);
+
+        for (size_t c = 0; c < std::min(m_depth, n_chunks); ++c) start_read(c);
+
+        uint64_t out_offset = 0;
+        for (size_t c = 0; c < n_chunks; ++c) {
+          Slot& slot = m_slots[c % m_depth];
+          while (!slot.ready || slot.writing) reap();
+
+          const size_t n = m_transform(
+              std::span<const Byte>(slot.in.get(), slot.want),
+              std::span<Byte>(slot.out.get(), m_options.output_capacity),
+              c + 1 == n_chunks);
+          if (n > 0) {
+            slot.write_len = n;
+            slot.write_done = 0;
+            slot.write_offset = out_offset;
+            slot.writing = true;
+            submit_write(c % m_depth);
+            out_offset += n;
+          }
+          if (c + m_depth < n_chunks) start_read(c + m_depth);
+        }
+        while (m_in_flight > 0) reap();
+      }
+
+      void start_read(size_t chunk_index) {
+        const size_t s = chunk_index % m_depth;
+        Slot& slot = m_slots[s];
+        const uint64_t offset = static_cast<uint64_t>(chunk_index) * m_options.chunk_size;
+        slot.want = static_cast<size_t>(
+            std::min<uint64_t>(m_options.chunk_size, m_file_size - std::min(offset, m_file_size)));
+        slot.got = 0;
+        slot.ready = slot.want == 0;
+        m_read_offset[s] = offset;
+        if (!slot.ready) submit_read(s);
+      }
+
+      void submit_read(size_t s) {
+        Slot& slot = m_slots[s];
+        // O_DIRECT needs aligned offsets and lengths: read up to the end of
+        // the buffer from the last aligned position (the chunk offset and
+        // size are aligned) and let EOF cut it short
+        size_t len = slot.want - slot.got;
+        slot.read_base = slot.got;
+        if (m_direct) {
+          slot.read_base = slot.got / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+          len = m_options.chunk_size - slot.read_base;
+        }
+        m_ring.submit(IORING_OP_READ_FIXED, m_in_fd, slot.in.get() + slot.read_base, len,
+                      m_read_offset[s] + slot.read_base, static_cast<uint16_t>(s),
+                      (READ << 32) | s);
+        ++m_in_flight;
+      }
+
+      void submit_write(size_t s) {
+        Slot& slot = m_slots[s];
+        m_ring.submit(IORING_OP_WRITE_FIXED, m_out_fd, slot.out.get() + slot.write_done,
+                      slot.write_len - slot.write_done,
+                      slot.write_offset + slot.write_done,
+                      static_cast<uint16_t>(m_depth + s), (WRITE << 32) | s);
+        ++m_in_flight;
+      }
+
+      void reap() {
+        const io_uring_cqe cqe = m_ring.wait();
+        --m_in_flight;
+        const size_t s = static_cast<size_t>(cqe.user_data & 0xFFFFFFFF);
+        const bool is_write = (cqe.user_data >> 32) == WRITE;
+        if (cqe.res < 0) {
+          throw std::runtime_error(std::string("FilePipeline: ") +
+                                   (is_write ? "write" : "read") +
+                                   " error: " + std::strerror(-cqe.res));
+        }
+        Slot& slot = m_slots[s];
+        const auto res = static_cast<size_t>(cqe.res);
+        if (is_write) {
+          slot.write_done += res;
+          if (slot.write_done < slot.write_len) {
+            submit_write(s);
+          } else {
+            slot.writing = false;
+          }
+          return;
+        }
+        const size_t before = slot.got;
+        slot.got = std::min(slot.read_base + res, slot.want);
+        if (slot.got == slot.want) {
+          slot.ready = true;
+        } else if (slot.got <= before) {
+          throw std::runtime_error("FilePipeline: input file shrank while reading");
+        } else {
+          submit_read(s);
+        }
+      }
+
+      void drain() noexcept {
+        try {
+          while (m_in_flight > 0) {
+            m_ring.wait();
+            --m_in_flight;
+          }
+        } catch (...) {
+        }
+      }
+
+      const PipelineOptions& m_options;
+      const ChunkTransform& m_transform;
+      size_t m_depth;
+      Ring m_ring;
+      std::vector<Slot> m_slots;
+      std::vector<uint64_t> m_read_offset = std::vector<uint64_t>(m_depth);
+      bool m_direct = false;
+      int m_in_fd = -1;
+      int m_out_fd = -1;
+      uint64_t m_file_size = 0;
+      size_t m_in_flight = 0;
+    };
+#endif
+  } // namespace
+
+  bool io_uring_supported() {
+#ifdef CRYPTO_HAVE_IO_URING
+    static const bool supported = [] {
+      try {
+        Ring ring(2);
+        return true;
+      } catch (const std::exception&) {
+        return false;
+      }
+    }();
+    return supported;
+#else
+    return false;
+#endif
+  }
+
+  PipelineEngine run_file_pipeline(const std::string& input_path,
+                                   const std::string& output_path,
+                                   const PipelineOptions& options,
+                                   const ChunkTransform& transform) {
+    if (options.chunk_size == 0) {
+      throw std::invalid_argument("FilePipeline: chunk size must be > 0");
+    }
+    if (options.direct_io && options.chunk_size % DIRECT_IO_ALIGNMENT != 0) {
+      throw std::invalid_argument("FilePipeline: O_DIRECT chunk size must be aligned");
+    }
+#ifdef CRYPTO_HAVE_IO_URING
+    if (options.allow_io_uring && io_uring_supported()) {
+      std::optional<UringPipeline> pipeline;
+      try {
+        pipeline.emplace(options, transform);
+      } catch (const std::exception&) {
+        // e.g. buffer registration over RLIMIT_MEMLOCK; nothing touched yet
+      }
+      if (pipeline) {
+        pipeline->run(input_path, output_path);
+        return PipelineEngine::IoUring;
+      }
+    }
+#endif
+    run_threads(input_path, output_path, options, transform);
+    return PipelineEngine::Threads;
+  }
+
+} // namespace crypto::internal
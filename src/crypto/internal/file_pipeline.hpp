@@ -0,0 +1,53 @@
+#ifndef CRYPTO_INTERNAL_FILE_PIPELINE_HPP
+#define CRYPTO_INTERNAL_FILE_PIPELINE_HPP
+
+#include "crypto/internal/bytes.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <string>
+
+namespace crypto::internal {
+
+  // Transforms one chunk and returns the number of bytes written to out.
+  // Chunks arrive in file order; last is set on the final call, which may
+  // carry no input (e.g. for an empty file).
+  using ChunkTransform =
+      std::function<size_t(std::span<const Byte> in, std::span<Byte> out, bool last)>;
+
+  struct PipelineOptions {
+    size_t chunk_size = size_t{1} << 20;
+    // bytes the transform may write for one chunk
+    size_t output_capacity = (size_t{1} << 20) + 256;
+    // chunks in flight; 3 keeps one read, one transform and one write busy
+    size_t depth = 3;
+    // read with O_DIRECT (io_uring engine only); chunk_size must then be a
+    // multiple of DIRECT_IO_ALIGNMENT
+    bool direct_io = false;
+    bool allow_io_uring = true;
+  };
+
+  enum class PipelineEngine {
+    IoUring,
+    Threads,
+  };
+
+  inline constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+
+  // Reads input_path chunk by chunk, runs transform on each chunk in order
+  // and writes the results back to back to output_path. Reading ahead,
+  // transforming and writing behind overlap, so throughput approaches the
+  // slower of disk and transform rather than their sum. Uses io_uring with
+  // registered buffers where the kernel allows it, otherwise a reader and a
+  // writer thread around the calling thread. Returns the engine that ran.
+  PipelineEngine run_file_pipeline(const std::string &input_path,
+                                   const std::string &output_path,
+                                   const PipelineOptions &options,
+                                   const ChunkTransform &transform);
+
+  bool io_uring_supported();
+
+} // namespace crypto::internal
+
+#endif // CRYPTO_INTERNAL_FILE_PIPELINE_HPP
@@ -0,0 +1,166 @@
+#include "internal/mapped_file.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CRYPTO_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace crypto::internal {
+
+#ifdef CRYPTO_HAVE_MMAP
+  namespace {
+    void advise(Byte *data, size_t size) {
+      if (data == nullptr) return;
+      ::madvise(data, size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+      ::madvise(data, size, MADV_HUGEPAGE);
+#endif
+    }
+
+    // Reserves the blocks up front: stores into a sparse mapping that the
+    // filesystem cannot back raise SIGBUS, where this reports ENOSPC or
+    // EDQUOT. Filesystems without fallocate support only get resized.
+    void allocate(int fd, size_t size, const std::string &path) {
+#if defined(__APPLE__)
+      const int err = EOPNOTSUPP;
+#else
+      const int err = size == 0 ? 0 : ::posix_fallocate(fd, 0, static_cast<off_t>(size));
+#endif
+      if (err == 0) return;
+      if (err != EINVAL && err != EOPNOTSUPP) {
+        throw std::runtime_error("MappedFile: cannot allocate file: " + path + ": " +
+                                 std::strerror(err));
+      }
+      if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        throw std::runtime_error("MappedFile: cannot resize file: " + path);
+      }
+    }
+
+    Byte *map(int fd, size_t size, bool writable) {
+      if (size == 0) return nullptr;
+      const int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+      void *p = ::mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+      if (p == MAP_FAILED) return nullptr;
+      auto *data = static_cast<Byte *>(p);
+      advise(data, size);
+      return data;
+    }
+  } // namespace
+
+  bool MappedFile::supported() { return true; }
+
+  MappedFile MappedFile::open_read(const std::string &path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("MappedFile: cannot open file for reading: " + path);
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      throw std::runtime_error("MappedFile: cannot stat file: " + path);
+    }
+    const auto size = static_cast<size_t>(st.st_size);
+    Byte *data = map(fd, size, false);
+    if (size != 0 && data == nullptr) {
+      ::close(fd);
+      throw std::runtime_error("MappedFile: cannot map file: " + path);
+    }
+    return MappedFile(path, fd, data, size, false);
+  }
+
+  MappedFile MappedFile::create(const std::string &path, size_t size) {
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      throw std::runtime_error("MappedFile: cannot open file for writing: " + path);
+    }
+    try {
+      allocate(fd, size, path);
+    } catch (...) {
+      ::close(fd);
+      throw;
+    }
+    Byte *data = map(fd, size, true);
+    if (size != 0 && data == nullptr) {
+      ::close(fd);
+      throw std::runtime_error("MappedFile: cannot map file: " + path);
+    }
+    return MappedFile(path, fd, data, size, true);
+  }
+
+  void MappedFile::unmap() noexcept {
+    if (m_data != nullptr) ::munmap(m_data, m_size);
+    if (m_fd >= 0) ::close(m_fd);
+    m_data = nullptr;
+    m_fd = -1;
+  }
+
+  void MappedFile::close(size_t final_size) {
+    if (m_fd < 0) return;
+    const int fd = m_fd;
+    if (m_data != nullptr) ::munmap(m_data, m_size);
+    m_data = nullptr;
+    const bool ok = !m_writable || final_size == m_size ||
+                    ::ftruncate(fd, static_cast<off_t>(final_size)) == 0;
+    ::close(fd);
+    m_fd = -1;
+    if (!ok) {
+      throw std::runtime_error("MappedFile: cannot resize file: " + m_path);
+    }
+  }
+#else
+  bool MappedFile::supported() { return false; }
+
+  MappedFile MappedFile::open_read(const std::string &path) {
+    throw std::runtime_error("MappedFile: memory mapping is not supported: " + path);
+  }
+
+  MappedFile MappedFile::create(const std::string &path, size_t) {
+    throw std::runtime_error("MappedFile: memory mapping is not supported: " + path);
+  }
+
+  void MappedFile::unmap() noexcept {}
+
+  void MappedFile::close(size_t) {}
+#endif
+
+  MappedFile::MappedFile(std::string path, int fd, Byte *data, size_t size,
+                         bool writable)
+      : m_path(std::move(path)), m_fd(fd), m_data(data), m_size(size),
+        m_writable(writable) {}
+
+  MappedFile::MappedFile(MappedFile &&other) noexcept
+      : m_path(std::move(other.m_path)),
+        m_fd(std::exchange(other.m_fd, -1)),
+        m_data(std::exchange(other.m_data, nullptr)),
+        m_size(std::exchange(other.m_size, 0)),
+        m_writable(other.m_writable) {}
+
+  MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+      unmap();
+      m_path = std::move(other.m_path);
+      m_fd = std::exchange(other.m_fd, -1);
+      m_data = std::exchange(other.m_data, nullptr);
+      m_size = std::exchange(other.m_size, 0);
+      m_writable = other.m_writable;
+    }
+    return *this;
+  }
+
+  MappedFile::~MappedFile() { unmap(); }
+
+  const Byte *MappedFile::data() const { return m_data; }
+
+  Byte *MappedFile::data() { return m_data; }
+
+  size_t MappedFile::size() const { return m_size; }
+
+} // namespace crypto::internal
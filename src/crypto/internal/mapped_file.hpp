@@ -0,0 +1,51 @@
+#ifndef CRYPTO_INTERNAL_MAPPED_FILE_HPP
+#define CRYPTO_INTERNAL_MAPPED_FILE_HPP
+
+#include "crypto/internal/bytes.hpp"
+
+#include <cstddef>
+#include <string>
+
+namespace crypto::internal {
+
+  // A whole file mapped into memory: read-only for input, or created and
+  // allocated up front for output, so a full disk throws from create rather
+  // than faulting on a later store. Access is hinted as sequential and, where
+  // the kernel supports it, backed by transparent huge pages. Empty files
+  // are not mapped and report a null data pointer.
+  class MappedFile {
+  public:
+    static bool supported();
+
+    static MappedFile open_read(const std::string &path);
+    static MappedFile create(const std::string &path, size_t size);
+
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+
+    const Byte *data() const;
+    Byte *data();
+    size_t size() const;
+
+    // unmaps and, for a writable mapping, truncates the file to final_size;
+    // the data reaches the disk as for any other write, without a sync
+    void close(size_t final_size);
+
+  private:
+    MappedFile(std::string path, int fd, Byte *data, size_t size,
+               bool writable);
+    void unmap() noexcept;
+
+    std::string m_path;
+    int m_fd = -1;
+    Byte *m_data = nullptr;
+    size_t m_size = 0;
+    bool m_writable = false;
+  };
+
+} // namespace crypto::internal
+
+#endif // CRYPTO_INTERNAL_MAPPED_FILE_HPP
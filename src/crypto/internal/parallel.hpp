@@ -0,0 +1,61 @@
+#ifndef CRYPTO_INTERNAL_PARALLEL_HPP
+#define CRYPTO_INTERNAL_PARALLEL_HPP
+
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace crypto::internal {
+
+  inline constexpr size_t CACHE_LINE = 64;
+
+  // Per-thread scratch that workers update in a loop, padded to its own
+  // cache line so neighbouring threads do not invalidate each other's line.
+  template <typename T>
+  struct alignas(CACHE_LINE) CacheAligned {
+    T value{};
+  };
+
+  // Splits [0, n_items) into at most num_threads contiguous, near-equal ranges.
+  inline std::vector<std::pair<size_t, size_t>> split_work(size_t n_items,
+                                                           size_t num_threads) {
+    if (num_threads == 0) num_threads = 1;
+    if (num_threads > n_items) num_threads = n_items;
+
+    std::vector<std::pair<size_t, size_t>> ranges;
+    if (num_threads == 0) return ranges;
+
+    ranges.reserve(num_threads);
+    size_t base = n_items / num_threads;
+    size_t extra = n_items % num_threads;
+    size_t start = 0;
+    for (size_t t = 0; t < num_threads; ++t) {
+      size_t count = base + (t < extra ? 1 : 0);
+      ranges.emplace_back(start, start + count);
+      start += count;
+    }
+    return ranges;
+  }
+
+  // Runs fn(range_index, start, end) for every range, one thread per range.
+  // A single range runs on the calling thread.
+  template <typename Fn>
+  void run_ranges(const std::vector<std::pair<size_t, size_t>> &ranges, Fn &&fn) {
+    if (ranges.size() == 1) {
+      fn(size_t{0}, ranges[0].first, ranges[0].second);
+      return;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve(ranges.size());
+    for (size_t t = 0; t < ranges.size(); ++t) {
+      workers.emplace_back([&fn, &ranges, t]() {
+        fn(t, ranges[t].first, ranges[t].second);
+      });
+    }
+    for (auto &w : workers) w.join();
+  }
+
+} // namespace crypto::internal
+
+#endif // CRYPTO_INTERNAL_PARALLEL_HPP
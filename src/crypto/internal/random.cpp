@@ -0,0 +1,170 @@
+#include "internal/random.hpp"
+#include "internal/secure_wipe.hpp"
+#include "stream/algorithms/chacha20/chacha20.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <pthread.h>
+#include <sys/random.h>
+#endif
+
+namespace crypto::internal {
+
+  namespace {
+
+    // bumped in the child after fork() so every thread-local generator
+    // reseeds instead of repeating the parent's stream
+    std::atomic<uint64_t> g_fork_generation{0};
+
+    void os_entropy(Byte *out, size_t len) {
+#if defined(__linux__)
+      while (len > 0) {
+        const ssize_t got = ::getrandom(out, len, 0);
+        if (got < 0) {
+          if (errno == EINTR) continue;
+          throw std::runtime_error("random: getrandom failed");
+        }
+        out += got;
+        len -= static_cast<size_t>(got);
+      }
+#else
+      std::random_device device;
+      for (size_t i = 0; i < len; ++i) out[i] = static_cast<Byte>(device());
+#endif
+    }
+
+    class Generator {
+    public:
+      static constexpr size_t BUFFER_SIZE = 1024;
+
+      Generator() {
+#if defined(__linux__)
+        static std::once_flag registered;
+        std::call_once(registered, []() {
+          ::pthread_atfork(nullptr, nullptr, []() {
+            g_fork_generation.fetch_add(1, std::memory_order_relaxed);
+          });
+        });
+#endif
+        reseed();
+      }
+
+      ~Generator() { secure_wipe(m_buffer); }
+
+      void fill(Byte *out, size_t len) {
+        if (m_generation != g_fork_generation.load(std::memory_order_relaxed)) {
+          reseed();
+        }
+        while (len > 0) {
+          if (m_pos == BUFFER_SIZE) refill();
+          const size_t take = std::min(len, BUFFER_SIZE - m_pos);
+          std::memcpy(out, m_buffer.data() + m_pos, take);
+          secure_wipe(m_buffer.data() + m_pos, take);
+          m_pos += take;
+          out += take;
+          len -= take;
+        }
+      }
+
+    private:
+      // the key is replaced by fresh OS entropy XORed with our own output
+      void reseed() {
+        Bytes key(KEY_SIZE);
+        os_entropy(key.data(), key.size());
+        if (m_seeded) {
+          Bytes own(KEY_SIZE);
+          m_cipher.keystream(own);
+          for (size_t i = 0; i < key.size(); ++i) key[i] ^= own[i];
+          secure_wipe(own);
+        }
+        m_cipher.set_key(key);
+        secure_wipe(key);
+        m_seeded = true;
+        m_generation = g_fork_generation.load(std::memory_order_relaxed);
+        m_since_reseed = 0;
+        m_pos = BUFFER_SIZE;
+      }
+
+      // the first 32 bytes of each batch become the next key and are never
+      // handed out
+      void refill() {
+        if (m_since_reseed >= RESEED_INTERVAL) reseed();
+        m_cipher.keystream(m_buffer);
+        Bytes key(m_buffer.begin(), m_buffer.begin() + KEY_SIZE);
+        m_cipher.set_key(key);
+        secure_wipe(key);
+        secure_wipe(m_buffer.data(), KEY_SIZE);
+        m_pos = KEY_SIZE;
+        m_since_reseed += BUFFER_SIZE;
+      }
+
+      static constexpr size_t KEY_SIZE = chacha20::ChaCha20::KEY_SIZE;
+
+      // IETF layout, 96-bit nonce and 32-bit block counter. Every batch is
+      // produced under a fresh key that rewinds the counter, so the fixed
+      // nonce is safe and a batch of BUFFER_SIZE / 64 blocks never wraps it.
+      chacha20::ChaCha20 m_cipher{Bytes(12, 0)};
+      std::array<Byte, BUFFER_SIZE> m_buffer{};
+      size_t m_pos = BUFFER_SIZE;
+      uint64_t m_since_reseed = 0;
+      uint64_t m_generation = 0;
+      bool m_seeded = false;
+    };
+
+    Generator &generator() {
+      thread_local Generator instance;
+      return instance;
+    }
+
+  } // namespace
+
+  void random_bytes(std::span<Byte> out) { generator().fill(out.data(), out.size()); }
+
+  Bytes random_bytes(size_t n) {
+    Bytes out(n);
+    random_bytes(out);
+    return out;
+  }
+
+  uint64_t random_u64() {
+    Byte raw[8];
+    generator().fill(raw, sizeof(raw));
+    uint64_t v;
+    std::memcpy(&v, raw, sizeof(v));
+    return v;
+  }
+
+  mpz_class random_bits(mp_bitcnt_t bits) {
+    mpz_class result;
+    if (bits == 0) return result;
+    Bytes raw(static_cast<size_t>((bits + 7) / 8));
+    random_bytes(raw);
+    // clear the bits above the requested width in the leading byte
+    if (bits % 8 != 0) raw[0] &= static_cast<Byte>((1u << (bits % 8)) - 1);
+    mpz_import(result.get_mpz_t(), raw.size(), 1, 1, 1, 0, raw.data());
+    secure_wipe(raw);
+    return result;
+  }
+
+  mpz_class random_below(const mpz_class &bound) {
+    if (bound <= 0) {
+      throw std::invalid_argument("random: bound must be positive");
+    }
+    // rejection sampling over the bit width of bound keeps the result
+    // uniform; fewer than two draws are needed on average
+    const mp_bitcnt_t bits = mpz_sizeinbase(bound.get_mpz_t(), 2);
+    while (true) {
+      mpz_class candidate = random_bits(bits);
+      if (candidate < bound) return candidate;
+    }
+  }
+
+} // namespace crypto::internal
@@ -0,0 +1,34 @@
+#ifndef CRYPTO_INTERNAL_RANDOM_HPP
+#define CRYPTO_INTERNAL_RANDOM_HPP
+
+#include "crypto/internal/bytes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <gmpxx.h>
+
+namespace crypto::internal {
+
+  // Process-wide CSPRNG. Every thread owns a ChaCha20 generator keyed from
+  // the operating system (getrandom) on first use and hands out bytes from
+  // a small buffer, so a call normally costs a copy rather than a syscall or
+  // an engine construction. Each refill rekeys the generator from its own
+  // output (fast key erasure) and consumed bytes are wiped, so a later state
+  // compromise does not reveal earlier output. Fresh OS entropy is mixed in
+  // every RESEED_INTERVAL bytes and after fork().
+  inline constexpr uint64_t RESEED_INTERVAL = uint64_t{1} << 24;
+
+  void random_bytes(std::span<Byte> out);
+  Bytes random_bytes(size_t n);
+  uint64_t random_u64();
+
+  // uniform in [0, 2^bits)
+  mpz_class random_bits(mp_bitcnt_t bits);
+  // uniform in [0, bound); bound must be positive
+  mpz_class random_below(const mpz_class &bound);
+
+} // namespace crypto::internal
+
+#endif // CRYPTO_INTERNAL_RANDOM_HPP
@@ -0,0 +1,27 @@
+#ifndef CRYPTO_INTERNAL_SECURE_WIPE_HPP
+#define CRYPTO_INTERNAL_SECURE_WIPE_HPP
+
+#include "crypto/internal/bytes.hpp"
+
+#include <array>
+#include <cstddef>
+
+namespace crypto::internal {
+
+  // Zeroes key material through a volatile pointer so the stores survive
+  // even though the memory is about to be freed.
+  inline void secure_wipe(void *data, size_t size) {
+    auto *p = static_cast<volatile Byte *>(data);
+    for (size_t i = 0; i < size; ++i) p[i] = 0;
+  }
+
+  inline void secure_wipe(Bytes &bytes) { secure_wipe(bytes.data(), bytes.size()); }
+
+  template <typename T, size_t N>
+  void secure_wipe(std::array<T, N> &values) {
+    secure_wipe(values.data(), sizeof(T) * N);
+  }
+
+} // namespace crypto::internal
+
+#endif // CRYPTO_INTERNAL_SECURE_WIPE_HPP
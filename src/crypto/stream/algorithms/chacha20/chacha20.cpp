@@ -0,0 +1,450 @@
+#include "chacha20.hpp"
+#include "internal/secure_wipe.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CRYPTO_CHACHA_X86 1
+#include <immintrin.h>
+#endif
+
+namespace crypto::chacha20 {
+
+namespace {
+
+constexpr uint32_t SIGMA[4] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574};
+
+uint32_t load_le32(const Byte *p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+void store_le32(Byte *p, uint32_t v) {
+  for (size_t i = 0; i < 4; ++i) p[i] = static_cast<Byte>(v >> (8 * i));
+}
+
+void store_le64(Byte *p, uint64_t v) {
+  for (size_t i = 0; i < 8; ++i) p[i] = static_cast<Byte>(v >> (8 * i));
+}
+
+uint64_t load_le64(const Byte *p) {
+  uint64_t v = 0;
+  for (size_t i = 0; i < 8; ++i) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+  return v;
+}
+
+// counter words of the block with the given absolute counter
+void counter_words(const std::array<uint32_t, 16> &s, uint64_t counter, bool wide,
+                   uint32_t &lo, uint32_t &hi) {
+  lo = static_cast<uint32_t>(counter);
+  hi = wide ? static_cast<uint32_t>(counter >> 32) : s[13];
+}
+
+inline uint32_t rotl(uint32_t v, int r) { return (v << r) | (v >> (32 - r)); }
+
+inline void quarter_round(uint32_t &a, uint32_t &b, uint32_t &c, uint32_t &d) {
+  a += b; d = rotl(d ^ a, 16);
+  c += d; b = rotl(b ^ c, 12);
+  a += b; d = rotl(d ^ a, 8);
+  c += d; b = rotl(b ^ c, 7);
+}
+
+void block_scalar(const std::array<uint32_t, 16> &s, uint64_t counter, bool wide,
+                  const Byte *in, Byte *out) {
+  std::array<uint32_t, 16> x = s;
+  counter_words(s, counter, wide, x[12], x[13]);
+  const std::array<uint32_t, 16> orig = x;
+  for (int r = 0; r < 10; ++r) {
+    quarter_round(x[0], x[4], x[8], x[12]);
+    quarter_round(x[1], x[5], x[9], x[13]);
+    quarter_round(x[2], x[6], x[10], x[14]);
+    quarter_round(x[3], x[7], x[11], x[15]);
+    quarter_round(x[0], x[5], x[10], x[15]);
+    quarter_round(x[1], x[6], x[11], x[12]);
+    quarter_round(x[2], x[7], x[8], x[13]);
+    quarter_round(x[3], x[4], x[9], x[14]);
+  }
+  for (size_t k = 0; k < 16; ++k) {
+    Byte word[4];
+    store_le32(word, x[k] + orig[k]);
+    for (size_t b = 0; b < 4; ++b) {
+      out[4 * k + b] = in ? in[4 * k + b] ^ word[b] : word[b];
+    }
+  }
+}
+
+#ifdef CRYPTO_CHACHA_X86
+// The vector kernels keep word k of W consecutive blocks in lane l of x[k]
+// and transpose back to block order when storing.
+
+// fills the counter words of W consecutive blocks
+template <size_t W>
+void counter_lanes(const std::array<uint32_t, 16> &s, uint64_t counter, bool wide,
+                   uint32_t (&lo)[W], uint32_t (&hi)[W]) {
+  for (size_t l = 0; l < W; ++l) counter_words(s, counter + l, wide, lo[l], hi[l]);
+}
+
+#define CHACHA_DOUBLE_ROUNDS(QR)                                               \
+  for (int r = 0; r < 10; ++r) {                                               \
+    QR(0, 4, 8, 12); QR(1, 5, 9, 13); QR(2, 6, 10, 14); QR(3, 7, 11, 15);      \
+    QR(0, 5, 10, 15); QR(1, 6, 11, 12); QR(2, 7, 8, 13); QR(3, 4, 9, 14);      \
+  }
+
+__attribute__((target("sse2")))
+inline __m128i rotl_sse2(__m128i v, int r) {
+  return _mm_or_si128(_mm_slli_epi32(v, r), _mm_srli_epi32(v, 32 - r));
+}
+
+__attribute__((target("sse2")))
+inline void store_sse2(const Byte *in, Byte *out, __m128i v) {
+  if (in) v = _mm_xor_si128(v, _mm_loadu_si128(reinterpret_cast<const __m128i *>(in)));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out), v);
+}
+
+__attribute__((target("sse2")))
+void blocks_sse2(const std::array<uint32_t, 16> &s, uint64_t counter, bool wide,
+                 const Byte *in, Byte *out) {
+  alignas(16) uint32_t lo[4], hi[4];
+  counter_lanes(s, counter, wide, lo, hi);
+  __m128i orig[16], x[16];
+  for (size_t k = 0; k < 16; ++k) orig[k] = _mm_set1_epi32(static_cast<int>(s[k]));
+  orig[12] = _mm_load_si128(reinterpret_cast<const __m128i *>(lo));
+  orig[13] = _mm_load_si128(reinterpret_cast<const __m128i *>(hi));
+  for (size_t k = 0; k < 16; ++k) x[k] = orig[k];
+
+#define QR(a, b, c, d)                                                         \
+  x[a] = _mm_add_epi32(x[a], x[b]); x[d] = rotl_sse2(_mm_xor_si128(x[d], x[a]), 16); \
+  x[c] = _mm_add_epi32(x[c], x[d]); x[b] = rotl_sse2(_mm_xor_si128(x[b], x[c]), 12); \
+  x[a] = _mm_add_epi32(x[a], x[b]); x[d] = rotl_sse2(_mm_xor_si128(x[d], x[a]), 8);  \
+  x[c] = _mm_add_epi32(x[c], x[d]); x[b] = rotl_sse2(_mm_xor_si128(x[b], x[c]), 7);
+  CHACHA_DOUBLE_ROUNDS(QR)
+#undef QR
+
+  for (size_t k = 0; k < 16; ++k) x[k] = _mm_add_epi32(x[k], orig[k]);
+
+  for (size_t g = 0; g < 4; ++g) {
+    const __m128i t0 = _mm_unpacklo_epi32(x[4 * g], x[4 * g + 1]);
+    const __m128i t1 = _mm_unpacklo_epi32(x[4 * g + 2], x[4 * g + 3]);
+    const __m128i t2 = _mm_unpackhi_epi32(x[4 * g], x[4 * g + 1]);
+    const __m128i t3 = _mm_unpackhi_epi32(x[4 * g + 2], x[4 * g + 3]);
+    const __m128i r[4] = {_mm_unpacklo_epi64(t0, t1), _mm_unpackhi_epi64(t0, t1),
+                          _mm_unpacklo_epi64(t2, t3), _mm_unpackhi_epi64(t2, t3)};
+    for (size_t l = 0; l < 4; ++l) {
+      const size_t off = l * 64 + g * 16;
+      store_sse2(in ? in + off : nullptr, out + off, r[l]);
+    }
+  }
+}
+
+__attribute__((target("avx2")))
+inline __m256i rotl_avx2(__m256i v, int r) {
+  return _mm256_or_si256(_mm256_slli_epi32(v, r), _mm256_srli_epi32(v, 32 - r));
+}
+
+__attribute__((target("avx2")))
+inline void store_avx2(const Byte *in, Byte *out, __m256i v) {
+  if (in) v = _mm256_xor_si256(v, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in)));
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), v);
+}
+
+__attribute__((target("avx2")))
+void blocks_avx2(const std::array<uint32_t, 16> &s, uint64_t counter, bool wide,
+                 const Byte *in, Byte *out) {
+  alignas(32) uint32_t lo[8], hi[8];
+  counter_lanes(s, counter, wide, lo, hi);
+  __m256i orig[16], x[16];
+  for (size_t k = 0; k < 16; ++k) orig[k] = _mm256_set1_epi32(static_cast<int>(s[k]));
+  orig[12] = _mm256_load_si256(reinterpret_cast<const __m256i *>(lo));
+  orig[13] = _mm256_load_si256(reinterpret_cast<const __m256i *>(hi));
+  for (size_t k = 0; k < 16; ++k) x[k] = orig[k];
+
+#define QR(a, b, c, d)                                                         \
+  x[a] = _mm256_add_epi32(x[a], x[b]); x[d] = rotl_avx2(_mm256_xor_si256(x[d], x[a]), 16); \
+  x[c] = _mm256_add_epi32(x[c], x[d]); x[b] = rotl_avx2(_mm256_xor_si256(x[b], x[c]), 12); \
+  x[a] = _mm256_add_epi32(x[a], x[b]); x[d] = rotl_avx2(_mm256_xor_si256(x[d], x[a]), 8);  \
+  x[c] = _mm256_add_epi32(x[c], x[d]); x[b] = rotl_avx2(_mm256_xor_si256(x[b], x[c]), 7);
+  CHACHA_DOUBLE_ROUNDS(QR)
+#undef QR
+
+  for (size_t k = 0; k < 16; ++k) x[k] = _mm256_add_epi32(x[k], orig[k]);
+
+  // a 4x4 transpose inside each 128-bit half leaves r[g][l] holding words
+  // 4g..4g+3 of block l in the low half and of block l + 4 in the high half
+  __m256i r[4][4];
+  for (size_t g = 0; g < 4; ++g) {
+    const __m256i t0 = _mm256_unpacklo_epi32(x[4 * g], x[4 * g + 1]);
+    const __m256i t1 = _mm256_unpacklo_epi32(x[4 * g + 2], x[4 * g + 3]);
+    const __m256i t2 = _mm256_unpackhi_epi32(x[4 * g], x[4 * g + 1]);
+    const __m256i t3 = _mm256_unpackhi_epi32(x[4 * g + 2], x[4 * g + 3]);
+    r[g][0] = _mm256_unpacklo_epi64(t0, t1);
+    r[g][1] = _mm256_unpackhi_epi64(t0, t1);
+    r[g][2] = _mm256_unpacklo_epi64(t2, t3);
+    r[g][3] = _mm256_unpackhi_epi64(t2, t3);
+  }
+  for (size_t l = 0; l < 4; ++l) {
+    for (size_t g = 0; g < 4; g += 2) {
+      const size_t low = l * 64 + g * 16;
+      const size_t high = (l + 4) * 64 + g * 16;
+      store_avx2(in ? in + low : nullptr, out + low,
+                 _mm256_permute2x128_si256(r[g][l], r[g + 1][l], 0x20));
+      store_avx2(in ? in + high : nullptr, out + high,
+                 _mm256_permute2x128_si256(r[g][l], r[g + 1][l], 0x31));
+    }
+  }
+}
+
+__attribute__((target("avx512f")))
+inline void store_avx512(const Byte *in, Byte *out, __m512i v) {
+  if (in) v = _mm512_xor_si512(v, _mm512_loadu_si512(in));
+  _mm512_storeu_si512(out, v);
+}
+
+__attribute__((target("avx512f")))
+void blocks_avx512(const std::array<uint32_t, 16> &s, uint64_t counter, bool wide,
+                   const Byte *in, Byte *out) {
+  alignas(64) uint32_t lo[16], hi[16];
+  counter_lanes(s, counter, wide, lo, hi);
+  __m512i orig[16], x[16];
+  for (size_t k = 0; k < 16; ++k) orig[k] = _mm512_set1_epi32(static_cast<int>(s[k]));
+  orig[12] = _mm512_load_si512(lo);
+  orig[13] = _mm512_load_si512(hi);
+  for (size_t k = 0; k < 16; ++k) x[k] = orig[k];
+
+#define QR(a, b, c, d)                                                         \
+  x[a] = _mm512_add_epi32(x[a], x[b]); x[d] = _mm512_rol_epi32(_mm512_xor_si512(x[d], x[a]), 16); \
+  x[c] = _mm512_add_epi32(x[c], x[d]); x[b] = _mm512_rol_epi32(_mm512_xor_si512(x[b], x[c]), 12); \
+  x[a] = _mm512_add_epi32(x[a], x[b]); x[d] = _mm512_rol_epi32(_mm512_xor_si512(x[d], x[a]), 8);  \
+  x[c] = _mm512_add_epi32(x[c], x[d]); x[b] = _mm512_rol_epi32(_mm512_xor_si512(x[b], x[c]), 7);
+  CHACHA_DOUBLE_ROUNDS(QR)
+#undef QR
+
+  for (size_t k = 0; k < 16; ++k) x[k] = _mm512_add_epi32(x[k], orig[k]);
+
+  // after the 4x4 transpose inside each 128-bit chunk, chunk c of r[g][l]
+  // holds words 4g..4g+3 of block l + 4c; a 4x4 transpose of the chunks
+  // then gathers whole blocks
+  __m512i r[4][4];
+  for (size_t g = 0; g < 4; ++g) {
+    const __m512i t0 = _mm512_unpacklo_epi32(x[4 * g], x[4 * g + 1]);
+    const __m512i t1 = _mm512_unpacklo_epi32(x[4 * g + 2], x[4 * g + 3]);
+    const __m512i t2 = _mm512_unpackhi_epi32(x[4 * g], x[4 * g + 1]);
+    const __m512i t3 = _mm512_unpackhi_epi32(x[4 * g + 2], x[4 * g + 3]);
+    r[g][0] = _mm512_unpacklo_epi64(t0, t1);
+    r[g][1] = _mm512_unpackhi_epi64(t0, t1);
+    r[g][2] = _mm512_unpacklo_epi64(t2, t3);
+    r[g][3] = _mm512_unpackhi_epi64(t2, t3);
+  }
+  for (size_t l = 0; l < 4; ++l) {
+    const __m512i u0 = _mm512_shuffle_i32x4(r[0][l], r[1][l], _MM_SHUFFLE(1, 0, 1, 0));
+    const __m512i u1 = _mm512_shuffle_i32x4(r[0][l], r[1][l], _MM_SHUFFLE(3, 2, 3, 2));
+    const __m512i u2 = _mm512_shuffle_i32x4(r[2][l], r[3][l], _MM_SHUFFLE(1, 0, 1, 0));
+    const __m512i u3 = _mm512_shuffle_i32x4(r[2][l], r[3][l], _MM_SHUFFLE(3, 2, 3, 2));
+    const __m512i b[4] = {_mm512_shuffle_i32x4(u0, u2, _MM_SHUFFLE(2, 0, 2, 0)),
+                          _mm512_shuffle_i32x4(u0, u2, _MM_SHUFFLE(3, 1, 3, 1)),
+                          _mm512_shuffle_i32x4(u1, u3, _MM_SHUFFLE(2, 0, 2, 0)),
+                          _mm512_shuffle_i32x4(u1, u3, _MM_SHUFFLE(3, 1, 3, 1))};
+    for (size_t c = 0; c < 4; ++c) {
+      const size_t off = (l + 4 * c) * 64;
+      store_avx512(in ? in + off : nullptr, out + off, b[c]);
+    }
+  }
+}
+
+#undef CHACHA_DOUBLE_ROUNDS
+#endif
+
+} // namespace
+
+ChaCha20::ChaCha20(Bytes nonce, uint64_t initial_counter, Backend backend) {
+  if (backend == Backend::Auto) {
+    backend = supported(Backend::AVX512) ? Backend::AVX512
+              : supported(Backend::AVX2) ? Backend::AVX2
+              : supported(Backend::SSE2) ? Backend::SSE2
+                                         : Backend::Scalar;
+  }
+  if (!supported(backend)) {
+    throw std::invalid_argument("ChaCha20: backend is not supported on this CPU");
+  }
+  m_backend = backend;
+  for (size_t k = 0; k < 4; ++k) m_state[k] = SIGMA[k];
+  set_nonce(nonce, initial_counter);
+}
+
+ChaCha20::~ChaCha20() { internal::secure_wipe(m_state); }
+
+void ChaCha20::set_key(const Bytes &key) {
+  if (key.size() != KEY_SIZE) {
+    throw std::invalid_argument("ChaCha20: key must be 32 bytes");
+  }
+  for (size_t k = 0; k < 8; ++k) m_state[4 + k] = load_le32(key.data() + 4 * k);
+  m_keyed = true;
+  m_position = 0;
+}
+
+void ChaCha20::set_nonce(const Bytes &nonce, uint64_t initial_counter) {
+  if (nonce.size() == 12) {
+    if (initial_counter > 0xFFFFFFFFu) {
+      throw std::invalid_argument("ChaCha20: counter must fit 32 bits with a 12-byte nonce");
+    }
+    m_wide_counter = false;
+    for (size_t k = 0; k < 3; ++k) m_state[13 + k] = load_le32(nonce.data() + 4 * k);
+  } else if (nonce.size() == 8) {
+    m_wide_counter = true;
+    m_state[13] = 0;
+    for (size_t k = 0; k < 2; ++k) m_state[14 + k] = load_le32(nonce.data() + 4 * k);
+  } else {
+    throw std::invalid_argument("ChaCha20: nonce must be 8 or 12 bytes");
+  }
+  m_initial_counter = initial_counter;
+  m_position = 0;
+}
+
+void ChaCha20::keystream(std::span<Byte> out) {
+  process(nullptr, out.data(), out.size());
+}
+
+void ChaCha20::apply(std::span<const Byte> in, std::span<Byte> out) {
+  if (in.size() != out.size()) {
+    throw std::invalid_argument("ChaCha20: input and output sizes differ");
+  }
+  process(in.data(), out.data(), in.size());
+}
+
+void ChaCha20::discard(uint64_t n) { m_position += n; }
+
+bool ChaCha20::seekable() const { return true; }
+
+void ChaCha20::seek(uint64_t offset) { m_position = offset; }
+
+uint64_t ChaCha20::position() const { return m_position; }
+
+ChaCha20::Backend ChaCha20::backend() const { return m_backend; }
+
+bool ChaCha20::supported(Backend backend) {
+  switch (backend) {
+  case Backend::Auto:
+  case Backend::Scalar:
+    return true;
+#ifdef CRYPTO_CHACHA_X86
+  case Backend::SSE2: {
+    static const bool sse2 = __builtin_cpu_supports("sse2");
+    return sse2;
+  }
+  case Backend::AVX2: {
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+  }
+  case Backend::AVX512: {
+    static const bool avx512 = __builtin_cpu_supports("avx512f");
+    return avx512;
+  }
+#endif
+  default:
+    return false;
+  }
+}
+
+void ChaCha20::process(const Byte *in, Byte *out, size_t len) {
+  if (!m_keyed) {
+    throw std::logic_error("ChaCha20: key not set");
+  }
+  if (len == 0) return;
+  const uint64_t first_block = m_position / BLOCK_SIZE;
+  const uint64_t last_block = (m_position + len - 1) / BLOCK_SIZE;
+  if (!m_wide_counter && last_block > 0xFFFFFFFFu - m_initial_counter) {
+    throw std::runtime_error("ChaCha20: 32-bit block counter exhausted");
+  }
+
+  size_t done = 0;
+  uint64_t block = first_block;
+  const size_t skip = m_position % BLOCK_SIZE;
+  if (skip != 0) {
+    // finish the block the previous call stopped in
+    Byte ks[BLOCK_SIZE];
+    block_scalar(m_state, m_initial_counter + block, m_wide_counter, nullptr, ks);
+    const size_t take = std::min(BLOCK_SIZE - skip, len);
+    for (size_t k = 0; k < take; ++k) {
+      out[k] = in ? in[k] ^ ks[skip + k] : ks[skip + k];
+    }
+    done = take;
+    ++block;
+  }
+
+  const size_t full = (len - done) / BLOCK_SIZE;
+  blocks(m_initial_counter + block, in ? in + done : nullptr, out + done, full);
+  done += full * BLOCK_SIZE;
+  block += full;
+
+  if (done < len) {
+    Byte ks[BLOCK_SIZE];
+    block_scalar(m_state, m_initial_counter + block, m_wide_counter, nullptr, ks);
+    for (size_t k = 0; done + k < len; ++k) {
+      out[done + k] = in ? in[done + k] ^ ks[k] : ks[k];
+    }
+  }
+  m_position += len;
+}
+
+void ChaCha20::blocks(uint64_t counter, const Byte *in, Byte *out,
+                      size_t n_blocks) const {
+  auto advance = [&](size_t n) {
+    counter += n;
+    if (in) in += n * BLOCK_SIZE;
+    out += n * BLOCK_SIZE;
+    n_blocks -= n;
+  };
+#ifdef CRYPTO_CHACHA_X86
+  if (m_backend == Backend::AVX512) {
+    for (; n_blocks >= 16; advance(16)) {
+      blocks_avx512(m_state, counter, m_wide_counter, in, out);
+    }
+  }
+  if (m_backend == Backend::AVX512 || m_backend == Backend::AVX2) {
+    for (; n_blocks >= 8; advance(8)) {
+      blocks_avx2(m_state, counter, m_wide_counter, in, out);
+    }
+  }
+  if (m_backend != Backend::Scalar) {
+    for (; n_blocks >= 4; advance(4)) {
+      blocks_sse2(m_state, counter, m_wide_counter, in, out);
+    }
+  }
+#endif
+  for (; n_blocks >= 1; advance(1)) {
+    block_scalar(m_state, counter, m_wide_counter, in, out);
+  }
+}
+
+Bytes ChaCha20::snapshot() const {
+  const size_t nonce_size = m_wide_counter ? 8 : 12;
+  Bytes state(1 + KEY_SIZE + nonce_size + 16);
+  state[0] = static_cast<Byte>(nonce_size);
+  for (size_t k = 0; k < 8; ++k) store_le32(state.data() + 1 + 4 * k, m_state[4 + k]);
+  Byte *p = state.data() + 1 + KEY_SIZE;
+  for (size_t k = 16 - nonce_size / 4; k < 16; ++k, p += 4) store_le32(p, m_state[k]);
+  store_le64(p, m_initial_counter);
+  store_le64(p + 8, m_position);
+  return state;
+}
+
+void ChaCha20::restore(const Bytes &state) {
+  if (state.empty() || (state[0] != 8 && state[0] != 12) ||
+      state.size() != 1 + KEY_SIZE + state[0] + 16) {
+    throw std::invalid_argument("ChaCha20: malformed state");
+  }
+  const size_t nonce_size = state[0];
+  const Byte *p = state.data() + 1 + KEY_SIZE;
+  set_nonce(Bytes(p, p + nonce_size), load_le64(p + nonce_size));
+  Bytes key(state.data() + 1, state.data() + 1 + KEY_SIZE);
+  set_key(key);
+  internal::secure_wipe(key);
+  m_position = load_le64(p + nonce_size + 8);
+}
+
+std::unique_ptr<core::StreamCipher> ChaCha20::clone() const {
+  return std::make_unique<ChaCha20>(*this);
+}
+
+} // namespace crypto::chacha20
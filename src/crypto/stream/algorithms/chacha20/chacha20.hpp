@@ -0,0 +1,77 @@
+#ifndef CRYPTO_CHACHA20_HPP
+#define CRYPTO_CHACHA20_HPP
+
+#include "internal/core/stream_cipher.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace crypto::chacha20 {
+
+// ChaCha20 (RFC 8439). A 12-byte nonce gives the RFC layout with a 32-bit
+// block counter; an 8-byte nonce gives the original layout with a 64-bit
+// counter. Every 64-byte block depends only on its counter, so seek and
+// discard are O(1) and whole runs of blocks are computed side by side:
+// 4 at a time with SSE2, 8 with AVX2 and 16 with AVX-512, chosen at run
+// time unless a backend is forced.
+class ChaCha20 final : public core::StreamCipher {
+public:
+  static constexpr size_t KEY_SIZE = 32;
+  static constexpr size_t BLOCK_SIZE = 64;
+
+  enum class Backend {
+    Auto,
+    Scalar,
+    SSE2,
+    AVX2,
+    AVX512,
+  };
+
+  // there is no default nonce: a key must never be used twice with the
+  // same one
+  explicit ChaCha20(Bytes nonce, uint64_t initial_counter = 0,
+                    Backend backend = Backend::Auto);
+  ~ChaCha20() override;
+
+  // both rewind the keystream to its start
+  void set_key(const Bytes &key) override;
+  void set_nonce(const Bytes &nonce, uint64_t initial_counter = 0);
+
+  void keystream(std::span<Byte> out) override;
+  void apply(std::span<const Byte> in, std::span<Byte> out) override;
+  void discard(uint64_t n) override;
+  bool seekable() const override;
+
+  // moves to a byte offset from the start of the keystream
+  void seek(uint64_t offset);
+  uint64_t position() const;
+
+  // nonce length, key, nonce, initial counter and position. The snapshot
+  // holds the raw key, so treat it as key material and wipe it
+  // (internal::secure_wipe) once it is no longer needed
+  Bytes snapshot() const override;
+  void restore(const Bytes &state) override;
+  std::unique_ptr<core::StreamCipher> clone() const override;
+
+  Backend backend() const;
+  static bool supported(Backend backend);
+
+private:
+  // in may be null, in which case out receives the bare keystream
+  void process(const Byte *in, Byte *out, size_t len);
+  void blocks(uint64_t counter, const Byte *in, Byte *out, size_t n_blocks) const;
+
+  // words 0-3 constants, 4-11 key, 12-15 counter and nonce; the counter
+  // words are filled in per block
+  std::array<uint32_t, 16> m_state{};
+  bool m_wide_counter = false;
+  bool m_keyed = false;
+  uint64_t m_initial_counter = 0;
+  uint64_t m_position = 0;
+  Backend m_backend;
+};
+
+} // namespace crypto::chacha20
+
+#endif // !CRYPTO_CHACHA20_HPP
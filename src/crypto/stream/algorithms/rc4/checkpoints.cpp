@@ -0,0 +1,109 @@
+#include "checkpoints.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace crypto::rc4 {
+
+namespace {
+
+constexpr uint8_t MAGIC[4] = {'R', 'C', '4', 'K'};
+constexpr uint32_t VERSION = 1;
+constexpr size_t HEADER_SIZE = 16;
+constexpr size_t ENTRY_SIZE = 8 + State::SERIALIZED_SIZE;
+
+void store_le64(uint8_t *p, uint64_t v) {
+  for (size_t i = 0; i < 8; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+uint64_t load_le64(const uint8_t *p) {
+  uint64_t v = 0;
+  for (size_t i = 0; i < 8; ++i) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+  return v;
+}
+
+void store_le32(uint8_t *p, uint32_t v) {
+  for (size_t i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+uint32_t load_le32(const uint8_t *p) {
+  uint32_t v = 0;
+  for (size_t i = 0; i < 4; ++i) v |= static_cast<uint32_t>(p[i]) << (8 * i);
+  return v;
+}
+
+} // namespace
+
+CheckpointTable CheckpointTable::build(const std::vector<uint8_t> &key,
+                                       uint64_t length, uint64_t interval,
+                                       uint64_t drop) {
+  if (interval == 0) {
+    throw std::invalid_argument("rc4::CheckpointTable: interval must be > 0");
+  }
+  CheckpointTable table;
+  Encoder encoder(key, drop);
+  for (uint64_t offset = 0;; offset += interval) {
+    table.add(offset, encoder.state());
+    if (length - offset <= interval) break;
+    encoder.discard(interval);
+  }
+  return table;
+}
+
+void CheckpointTable::add(uint64_t offset, const State &state) {
+  m_states.insert_or_assign(offset, state);
+}
+
+Encoder CheckpointTable::resume(uint64_t offset) const {
+  auto it = m_states.upper_bound(offset);
+  if (it == m_states.begin()) {
+    throw std::out_of_range("rc4::CheckpointTable: no checkpoint before offset");
+  }
+  --it;
+  Encoder encoder;
+  encoder.set_state(it->second);
+  encoder.discard(offset - it->first);
+  return encoder;
+}
+
+size_t CheckpointTable::size() const { return m_states.size(); }
+
+bool CheckpointTable::empty() const { return m_states.empty(); }
+
+std::vector<uint8_t> CheckpointTable::serialize() const {
+  std::vector<uint8_t> out(HEADER_SIZE + m_states.size() * ENTRY_SIZE);
+  std::memcpy(out.data(), MAGIC, 4);
+  store_le32(out.data() + 4, VERSION);
+  store_le64(out.data() + 8, m_states.size());
+  uint8_t *p = out.data() + HEADER_SIZE;
+  for (const auto &[offset, state] : m_states) {
+    store_le64(p, offset);
+    const auto bytes = state.serialize();
+    std::memcpy(p + 8, bytes.data(), bytes.size());
+    p += ENTRY_SIZE;
+  }
+  return out;
+}
+
+CheckpointTable CheckpointTable::deserialize(std::span<const uint8_t> bytes) {
+  if (bytes.size() < HEADER_SIZE || std::memcmp(bytes.data(), MAGIC, 4) != 0) {
+    throw std::invalid_argument("rc4::CheckpointTable: not a checkpoint table");
+  }
+  if (load_le32(bytes.data() + 4) != VERSION) {
+    throw std::invalid_argument("rc4::CheckpointTable: unsupported version");
+  }
+  const uint64_t count = load_le64(bytes.data() + 8);
+  if (count > (bytes.size() - HEADER_SIZE) / ENTRY_SIZE ||
+      bytes.size() != HEADER_SIZE + count * ENTRY_SIZE) {
+    throw std::invalid_argument("rc4::CheckpointTable: truncated table");
+  }
+  CheckpointTable table;
+  const uint8_t *p = bytes.data() + HEADER_SIZE;
+  for (uint64_t k = 0; k < count; ++k, p += ENTRY_SIZE) {
+    table.add(load_le64(p),
+              State::deserialize(std::span(p + 8, State::SERIALIZED_SIZE)));
+  }
+  return table;
+}
+
+} // namespace crypto::rc4
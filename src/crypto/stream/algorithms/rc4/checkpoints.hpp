@@ -0,0 +1,53 @@
+#ifndef CRYPTO_RC4_CHECKPOINTS_HPP
+#define CRYPTO_RC4_CHECKPOINTS_HPP
+
+#include "encoder.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <span>
+#include <vector>
+
+namespace crypto::rc4 {
+
+// Encoder states of one keystream stored by offset. resume(offset) restores
+// the nearest state at or before offset and discards the rest, so resuming
+// costs at most the gap between two checkpoints instead of the whole offset:
+// with the default 1 MiB interval a resume anywhere in a 10 GiB stream runs
+// the PRGA over less than 1 MiB.
+class CheckpointTable final {
+public:
+  static constexpr uint64_t DEFAULT_INTERVAL = uint64_t{1} << 20;
+
+  CheckpointTable() = default;
+
+  // runs the keystream of key (after drop bytes, which then count as offset
+  // 0) up to length, recording a state every interval bytes from offset 0
+  static CheckpointTable build(const std::vector<uint8_t> &key, uint64_t length,
+                               uint64_t interval = DEFAULT_INTERVAL,
+                               uint64_t drop = 0);
+
+  // records the state of a stream positioned at offset, replacing any
+  // state already stored there
+  void add(uint64_t offset, const State &state);
+
+  // an encoder positioned at offset; throws std::out_of_range if no
+  // checkpoint lies at or before offset
+  Encoder resume(uint64_t offset) const;
+
+  size_t size() const;
+  bool empty() const;
+
+  // "RC4K", u32 version, u64 count, then per checkpoint the u64 offset and
+  // the serialised State; integers are little-endian
+  std::vector<uint8_t> serialize() const;
+  static CheckpointTable deserialize(std::span<const uint8_t> bytes);
+
+private:
+  std::map<uint64_t, State> m_states;
+};
+
+} // namespace crypto::rc4
+
+#endif // !CRYPTO_RC4_CHECKPOINTS_HPP
@@ -1,41 +1,142 @@
 #include "encoder.hpp"
 
+#include <algorithm>
+#include <stdexcept>
+
 namespace crypto::rc4 {
 
-Encoder::Encoder(const std::vector<uint8_t> &key) { KSA(key); }
+namespace {
 
-void Encoder::mutate(const std::vector<uint8_t> &key) { KSA(key); }
+// Runs the PRGA over len bytes, handing each keystream byte and its position
+// to emit. The indices live in registers for the whole run; S stays in
+// memory since out may alias it as far as the compiler knows.
+template <typename Emit>
+inline void generate(uint8_t *S, uint8_t &m_i, uint8_t &m_j, size_t len,
+                     Emit &&emit) {
+  size_t i = m_i;
+  size_t j = m_j;
+  for (size_t k = 0; k < len; ++k) {
+    i = (i + 1) & 0xFF;
+    const size_t si = S[i];
+    j = (j + si) & 0xFF;
+    const size_t sj = S[j];
+    S[i] = static_cast<uint8_t>(sj);
+    S[j] = static_cast<uint8_t>(si);
+    emit(k, S[(si + sj) & 0xFF]);
+  }
+  m_i = static_cast<uint8_t>(i);
+  m_j = static_cast<uint8_t>(j);
+}
 
-void Encoder::encode(std::vector<uint8_t> &data) {
-  for (auto &byte : data) {
-    byte ^= PRGA();
+} // namespace
+
+State State::schedule(const std::vector<uint8_t> &key, uint64_t drop) {
+  if (key.empty()) {
+    throw std::invalid_argument("rc4: key must not be empty");
+  }
+  State state;
+  for (size_t i = 0; i < state.S.size(); i++) {
+    state.S[i] = static_cast<uint8_t>(i);
+  }
+
+  uint8_t j = 0;
+  for (size_t i = 0; i < state.S.size(); i++) {
+    j = static_cast<uint8_t>(j + state.S[i] + key[i % key.size()]);
+    std::swap(state.S[i], state.S[j]);
   }
+
+  generate(state.S.data(), state.i, state.j, drop, [](size_t, uint8_t) {});
+  return state;
+}
+
+std::vector<uint8_t> State::serialize() const {
+  std::vector<uint8_t> bytes(S.begin(), S.end());
+  bytes.push_back(i);
+  bytes.push_back(j);
+  return bytes;
 }
 
-void Encoder::KSA(const std::vector<uint8_t> &key) {
-  for (auto i = 0; i < S_SIZE; i++) {
-    m_S[i] = i;
+State State::deserialize(std::span<const uint8_t> bytes) {
+  if (bytes.size() != SERIALIZED_SIZE) {
+    throw std::invalid_argument("rc4::State: state must be 258 bytes");
+  }
+  State state;
+  std::array<bool, 256> seen{};
+  for (size_t k = 0; k < state.S.size(); ++k) {
+    if (seen[bytes[k]]) {
+      throw std::invalid_argument("rc4::State: S is not a permutation");
+    }
+    seen[bytes[k]] = true;
+    state.S[k] = bytes[k];
   }
+  state.i = bytes[256];
+  state.j = bytes[257];
+  return state;
+}
+
+Encoder::Encoder(const std::vector<uint8_t> &key, uint64_t drop) {
+  mutate(key, drop);
+}
 
-  m_i = 0;
-  m_j = 0;
+void Encoder::mutate(const std::vector<uint8_t> &key, uint64_t drop) {
+  set_state(State::schedule(key, drop));
+}
 
-  size_t j = 0;
-  for (auto i = 0; i < S_SIZE; i++) {
-    j = (j + m_S[i] + key[i % key.size()]) % S_SIZE;
-    std::swap(m_S[i], m_S[j]);
+State Encoder::state() const {
+  State state;
+  state.S = m_S;
+  state.i = m_i;
+  state.j = m_j;
+  return state;
+}
+
+void Encoder::set_state(const State &state) {
+  m_S = state.S;
+  m_i = state.i;
+  m_j = state.j;
+}
+
+void Encoder::encode(std::vector<uint8_t> &data) {
+  encode(std::span<uint8_t>(data));
+}
+
+void Encoder::encode(std::span<uint8_t> data) { encode(data, data); }
+
+void Encoder::encode(std::span<const uint8_t> in, std::span<uint8_t> out) {
+  if (in.size() != out.size()) {
+    throw std::invalid_argument("rc4::Encoder: input and output sizes differ");
   }
+  const uint8_t *src = in.data();
+  uint8_t *dst = out.data();
+  generate(m_S.data(), m_i, m_j, in.size(),
+           [&](size_t k, uint8_t ks) { dst[k] = src[k] ^ ks; });
 }
 
-uint8_t Encoder::PRGA() {
-  m_i = (m_i + 1) % S_SIZE;
-  m_j = (m_j + m_S[m_i]) % S_SIZE;
+void Encoder::keystream(std::span<uint8_t> out) {
+  uint8_t *dst = out.data();
+  generate(m_S.data(), m_i, m_j, out.size(),
+           [&](size_t k, uint8_t ks) { dst[k] = ks; });
+}
+
+void Encoder::set_key(const std::vector<uint8_t> &key) { mutate(key); }
 
-  std::swap(m_S[m_i], m_S[m_j]);
+void Encoder::apply(std::span<const uint8_t> in, std::span<uint8_t> out) {
+  encode(in, out);
+}
 
-  auto const t = (m_S[m_i] + m_S[m_j]) % S_SIZE;
+void Encoder::discard(uint64_t n) {
+  // only the swaps are kept; the output lookup is dead and gets dropped
+  generate(m_S.data(), m_i, m_j, n, [](size_t, uint8_t) {});
+}
+
+std::vector<uint8_t> Encoder::snapshot() const { return state().serialize(); }
+
+void Encoder::restore(const std::vector<uint8_t> &state) {
+  set_state(State::deserialize(state));
+}
 
-  return m_S[t];
+std::unique_ptr<core::StreamCipher> Encoder::clone() const {
+  return std::make_unique<Encoder>(*this);
 }
 
 } // namespace crypto::rc4
@@ -1,29 +1,75 @@
 #ifndef CRYPTO_RC4_ENCODER_HPP
 #define CRYPTO_RC4_ENCODER_HPP
 
+#include "internal/core/stream_cipher.hpp"
 #include <array>
+#include <cstddef>
 #include <cstdint>
+#include <span>
 #include <vector>
 
 namespace crypto::rc4 {
 
-class Encoder final {
+// The complete generator state of one RC4 stream. serialize() writes S
+// followed by i and j.
+struct State {
+  static constexpr size_t SERIALIZED_SIZE = 258;
+
+  std::array<uint8_t, 256> S;
+  uint8_t i = 0;
+  uint8_t j = 0;
+
+  // the state after the key schedule, with the first drop keystream bytes
+  // discarded; throws std::invalid_argument if key is empty. Encoder and
+  // MultiEncoder both key through here.
+  static State schedule(const std::vector<uint8_t> &key, uint64_t drop = 0);
+
+  std::vector<uint8_t> serialize() const;
+  // throws std::invalid_argument unless bytes holds SERIALIZED_SIZE bytes
+  // and S is a permutation
+  static State deserialize(std::span<const uint8_t> bytes);
+
+  bool operator==(const State &) const = default;
+};
+
+class Encoder final : public core::StreamCipher {
 public:
-  Encoder(const std::vector<uint8_t> &key = {0});
+  // drop skips the first drop keystream bytes (RC4-drop[n])
+  Encoder(const std::vector<uint8_t> &key = {0}, uint64_t drop = 0);
 
-  void mutate(const std::vector<uint8_t> &key);
+  void mutate(const std::vector<uint8_t> &key, uint64_t drop = 0);
+
+  State state() const;
+  void set_state(const State &state);
 
   void encode(std::vector<uint8_t> &data);
+  void encode(std::span<uint8_t> data);
+  // out = in ^ keystream; in and out must have the same size and may be the
+  // same buffer
+  void encode(std::span<const uint8_t> in, std::span<uint8_t> out);
+
+  // writes the next out.size() keystream bytes
+  void keystream(std::span<uint8_t> out) override;
+
+  // core::StreamCipher; set_key is mutate and apply is encode(in, out)
+  void set_key(const std::vector<uint8_t> &key) override;
+  void apply(std::span<const uint8_t> in, std::span<uint8_t> out) override;
+  // runs the PRGA, including its swaps in S, but skips the output lookup
+  // and writes nothing out
+  void discard(uint64_t n) override;
+  // state().serialize(), STATE_SIZE bytes
+  std::vector<uint8_t> snapshot() const override;
+  void restore(const std::vector<uint8_t> &state) override;
+  std::unique_ptr<core::StreamCipher> clone() const override;
+
+  static constexpr size_t STATE_SIZE = State::SERIALIZED_SIZE;
 
 private:
   static constexpr size_t S_SIZE = 256;
 
   std::array<uint8_t, S_SIZE> m_S;
-  size_t m_i;
-  size_t m_j;
-
-  void KSA(const std::vector<uint8_t> &key);
-  uint8_t PRGA();
+  uint8_t m_i = 0;
+  uint8_t m_j = 0;
 };
 
 } // namespace crypto::rc4
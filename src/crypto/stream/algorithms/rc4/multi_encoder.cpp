@@ -0,0 +1,91 @@
+#include "multi_encoder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#include "internal/parallel.hpp"
+
+namespace crypto::rc4 {
+
+MultiEncoder::MultiEncoder(const std::vector<std::vector<uint8_t>> &keys,
+                           uint64_t drop) {
+  m_states.reserve(keys.size());
+  for (const auto &key : keys) {
+    m_states.push_back(State::schedule(key, drop));
+  }
+}
+
+size_t MultiEncoder::streams() const { return m_states.size(); }
+
+void MultiEncoder::mutate(size_t stream, const std::vector<uint8_t> &key,
+                          uint64_t drop) {
+  if (stream >= m_states.size()) {
+    throw std::out_of_range("MultiEncoder: stream index out of range");
+  }
+  m_states[stream] = State::schedule(key, drop);
+}
+
+void MultiEncoder::encode(std::vector<std::vector<uint8_t>> &buffers,
+                          size_t threads) {
+  if (buffers.size() != m_states.size()) {
+    throw std::invalid_argument("MultiEncoder: expected one buffer per stream");
+  }
+  const size_t groups = (m_states.size() + LANES - 1) / LANES;
+  internal::run_ranges(internal::split_work(groups, threads),
+                       [&](size_t, size_t start, size_t end) {
+    for (size_t g = start; g < end; ++g) {
+      const size_t first = g * LANES;
+      encode_group(buffers, first, std::min(LANES, m_states.size() - first));
+    }
+  });
+}
+
+void MultiEncoder::encode_group(std::vector<std::vector<uint8_t>> &buffers,
+                                size_t first, size_t count) {
+  // lanes still holding data, shortest remaining first, so each lockstep
+  // round runs until the next lane runs out and then drops it
+  std::array<size_t, LANES> lanes{};
+  for (size_t l = 0; l < count; ++l) lanes[l] = first + l;
+  std::sort(lanes.begin(), lanes.begin() + count, [&](size_t a, size_t b) {
+    return buffers[a].size() < buffers[b].size();
+  });
+
+  size_t done = 0;
+  size_t active_from = 0;
+  while (active_from < count) {
+    const size_t until = buffers[lanes[active_from]].size();
+    const size_t active = count - active_from;
+
+    // work on local copies: the output bytes may alias anything reachable
+    // through a pointer, which would force S-box reloads after every store
+    std::array<State, LANES> st;
+    std::array<uint8_t *, LANES> out{};
+    for (size_t l = 0; l < active; ++l) {
+      st[l] = m_states[lanes[active_from + l]];
+      out[l] = buffers[lanes[active_from + l]].data();
+    }
+
+    for (size_t n = done; n < until; ++n) {
+      for (size_t l = 0; l < active; ++l) {
+        State &s = st[l];
+        const uint8_t si = s.S[++s.i];
+        s.j = static_cast<uint8_t>(s.j + si);
+        const uint8_t sj = s.S[s.j];
+        s.S[s.i] = sj;
+        s.S[s.j] = si;
+        out[l][n] ^= s.S[static_cast<uint8_t>(si + sj)];
+      }
+    }
+
+    for (size_t l = 0; l < active; ++l) {
+      m_states[lanes[active_from + l]] = st[l];
+    }
+    done = until;
+    while (active_from < count && buffers[lanes[active_from]].size() == done) {
+      ++active_from;
+    }
+  }
+}
+
+} // namespace crypto::rc4
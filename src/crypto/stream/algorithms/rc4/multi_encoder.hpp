@@ -0,0 +1,42 @@
+#ifndef CRYPTO_RC4_MULTI_ENCODER_HPP
+#define CRYPTO_RC4_MULTI_ENCODER_HPP
+
+#include "encoder.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace crypto::rc4 {
+
+// Many independent RC4 streams advanced in lockstep. A single RC4 stream is
+// one long chain of dependent S-box loads and stores; stepping LANES streams
+// per iteration lets those chains overlap. Stream k produces exactly the
+// keystream of Encoder(keys[k], drop), and keeps its position across calls.
+class MultiEncoder final {
+public:
+  static constexpr size_t LANES = 8;
+
+  explicit MultiEncoder(const std::vector<std::vector<uint8_t>> &keys,
+                        uint64_t drop = 0);
+
+  size_t streams() const;
+
+  // rekeys one stream, restarting its keystream
+  void mutate(size_t stream, const std::vector<uint8_t> &key, uint64_t drop = 0);
+
+  // buffers[k] is XORed with the next buffers[k].size() keystream bytes of
+  // stream k; buffers may differ in length. Groups of LANES streams are
+  // distributed over the worker threads.
+  void encode(std::vector<std::vector<uint8_t>> &buffers, size_t threads = 1);
+
+private:
+  void encode_group(std::vector<std::vector<uint8_t>> &buffers, size_t first,
+                    size_t count);
+
+  std::vector<State> m_states;
+};
+
+} // namespace crypto::rc4
+
+#endif // !CRYPTO_RC4_MULTI_ENCODER_HPP
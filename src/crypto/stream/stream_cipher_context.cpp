@@ -0,0 +1,193 @@
+#include "stream_cipher_context.hpp"
+#include "internal/file_pipeline.hpp"
+#include "internal/mapped_file.hpp"
+#include "internal/parallel.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace crypto {
+
+StreamCipherContext::StreamCipherContext(
+    std::unique_ptr<core::StreamCipher> cipher)
+    : m_cipher(std::move(cipher)) {
+  if (!m_cipher) {
+    throw std::invalid_argument("StreamCipherContext: cipher must not be null");
+  }
+}
+
+void StreamCipherContext::set_key(const Bytes &key) { m_cipher->set_key(key); }
+
+void StreamCipherContext::set_file_backend(FileBackend backend) {
+  m_file_backend = backend;
+}
+
+void StreamCipherContext::set_direct_io(bool enabled) { m_direct_io = enabled; }
+
+void StreamCipherContext::encrypt(const Bytes &input, Bytes &output,
+                                  size_t threads) const {
+  transform(input, output, threads);
+}
+
+void StreamCipherContext::decrypt(const Bytes &input, Bytes &output,
+                                  size_t threads) const {
+  transform(input, output, threads);
+}
+
+std::unique_ptr<core::StreamCipher> StreamCipherContext::begin() const {
+  return m_cipher->clone();
+}
+
+void StreamCipherContext::transform(const Bytes &input, Bytes &output,
+                                    size_t threads) const {
+  output.resize(input.size());
+  apply(*begin(), input, output, threads);
+}
+
+void StreamCipherContext::apply(core::StreamCipher &cipher,
+                                std::span<const Byte> in, std::span<Byte> out,
+                                size_t threads) {
+  threads = std::min(threads, in.size() / MIN_PARALLEL_RANGE);
+  if (threads <= 1 || !cipher.seekable()) {
+    cipher.apply(in, out);
+    return;
+  }
+
+  // each range gets a clone moved to its offset, then cipher itself skips
+  // past the whole input
+  const auto ranges = internal::split_work(in.size(), threads);
+  std::vector<std::unique_ptr<core::StreamCipher>> clones(ranges.size());
+  for (size_t t = 0; t < ranges.size(); ++t) {
+    clones[t] = cipher.clone();
+    clones[t]->discard(ranges[t].first);
+  }
+  internal::run_ranges(ranges, [&](size_t t, size_t start, size_t end) {
+    clones[t]->apply(in.subspan(start, end - start),
+                     out.subspan(start, end - start));
+  });
+  cipher.discard(in.size());
+}
+
+std::future<void> StreamCipherContext::encrypt_file(const std::string &input_path,
+                                                    const std::string &output_path,
+                                                    size_t threads,
+                                                    size_t chunk_size) const {
+  return std::async(std::launch::async,
+                    [this, input_path, output_path, threads, chunk_size]() {
+                      transform_file(input_path, output_path, threads,
+                                     chunk_size);
+                    });
+}
+
+std::future<void> StreamCipherContext::decrypt_file(const std::string &input_path,
+                                                    const std::string &output_path,
+                                                    size_t threads,
+                                                    size_t chunk_size) const {
+  return encrypt_file(input_path, output_path, threads, chunk_size);
+}
+
+void StreamCipherContext::transform_file(const std::string &input_path,
+                                         const std::string &output_path,
+                                         size_t threads,
+                                         size_t chunk_size) const {
+  if (chunk_size == 0) {
+    throw std::invalid_argument("StreamCipherContext: chunk size must be > 0");
+  }
+  if (m_file_backend == FileBackend::Mapped && internal::MappedFile::supported()) {
+    transform_mapped(input_path, output_path, threads);
+    return;
+  }
+  if (m_file_backend == FileBackend::Pipelined) {
+    transform_pipelined(input_path, output_path, threads, chunk_size);
+    return;
+  }
+
+  std::ifstream in(input_path, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error(
+        "StreamCipherContext: cannot open file for reading: " + input_path);
+  }
+  std::ofstream out(output_path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error(
+        "StreamCipherContext: cannot open file for writing: " + output_path);
+  }
+
+  auto cipher = begin();
+  Bytes buf(chunk_size);
+  try {
+    while (in) {
+      in.read(reinterpret_cast<char *>(buf.data()),
+              static_cast<std::streamsize>(chunk_size));
+      const size_t got = static_cast<size_t>(in.gcount());
+      if (got == 0) break;
+      const std::span<Byte> chunk(buf.data(), got);
+      apply(*cipher, chunk, chunk, threads);
+      out.write(reinterpret_cast<const char *>(buf.data()),
+                static_cast<std::streamsize>(got));
+      if (!out) {
+        throw std::runtime_error("StreamCipherContext: write error: " + output_path);
+      }
+    }
+    if (in.bad()) {
+      throw std::runtime_error("StreamCipherContext: read error: " + input_path);
+    }
+  } catch (...) {
+    // never leave a partial result behind
+    out.close();
+    std::filesystem::remove(output_path);
+    throw;
+  }
+}
+
+void StreamCipherContext::transform_pipelined(const std::string &input_path,
+                                              const std::string &output_path,
+                                              size_t threads,
+                                              size_t chunk_size) const {
+  if (m_direct_io) {
+    chunk_size = (chunk_size + internal::DIRECT_IO_ALIGNMENT - 1) /
+                 internal::DIRECT_IO_ALIGNMENT * internal::DIRECT_IO_ALIGNMENT;
+  }
+  internal::PipelineOptions options;
+  options.chunk_size = chunk_size;
+  options.output_capacity = chunk_size;
+  options.direct_io = m_direct_io;
+
+  auto cipher = begin();
+  try {
+    internal::run_file_pipeline(
+        input_path, output_path, options,
+        [&](std::span<const Byte> in, std::span<Byte> out, bool) {
+          apply(*cipher, in, out.first(in.size()), threads);
+          return in.size();
+        });
+  } catch (...) {
+    std::filesystem::remove(output_path);
+    throw;
+  }
+}
+
+void StreamCipherContext::transform_mapped(const std::string &input_path,
+                                           const std::string &output_path,
+                                           size_t threads) const {
+  auto in = internal::MappedFile::open_read(input_path);
+  const size_t n = in.size();
+  auto out = internal::MappedFile::create(output_path, n);
+  try {
+    apply(*begin(), std::span<const Byte>(in.data(), n),
+          std::span<Byte>(out.data(), n), threads);
+    out.close(n);
+  } catch (...) {
+    try {
+      out.close(0);
+    } catch (...) {
+    }
+    std::filesystem::remove(output_path);
+    throw;
+  }
+}
+
+} // namespace crypto
@@ -0,0 +1,76 @@
+#ifndef CRYPTO_STREAM_CIPHER_CONTEXT_HPP
+#define CRYPTO_STREAM_CIPHER_CONTEXT_HPP
+
+#include "internal/core/stream_cipher.hpp"
+#include "symmetric/cipher_context.hpp"
+
+#include <future>
+#include <memory>
+#include <span>
+#include <string>
+
+namespace crypto {
+
+  // Stream-cipher counterpart of SymmetricCipherContext. The context keeps
+  // a keyed cipher positioned at the start of its keystream, and every
+  // message, file or begin() works on its own clone, so once the key and
+  // file settings are in place the const members may be called from many
+  // threads at once. Encryption and decryption are the same operation.
+  class StreamCipherContext {
+  public:
+    explicit StreamCipherContext(std::unique_ptr<core::StreamCipher> cipher);
+
+    void set_key(const Bytes &key);
+    void set_file_backend(FileBackend backend);
+    // Pipelined backend only, see SymmetricCipherContext::set_direct_io
+    void set_direct_io(bool enabled);
+
+    // threads only helps seekable ciphers, whose keystream can be split
+    // into independent ranges; others run on the calling thread
+    void encrypt(const Bytes &input, Bytes &output, size_t threads = 1) const;
+    void decrypt(const Bytes &input, Bytes &output, size_t threads = 1) const;
+
+    // a fresh cipher at the start of the keystream for one incremental pass
+    std::unique_ptr<core::StreamCipher> begin() const;
+
+    static constexpr size_t DEFAULT_FILE_CHUNK = size_t{1} << 20;
+
+    // Files are processed chunk_size bytes at a time with the configured
+    // backend, so memory use does not depend on the file size; the Mapped
+    // backend ignores chunk_size. Each call runs on its own std::async thread.
+    std::future<void> encrypt_file(const std::string &input_path,
+                                   const std::string &output_path,
+                                   size_t threads = 1,
+                                   size_t chunk_size = DEFAULT_FILE_CHUNK) const;
+    std::future<void> decrypt_file(const std::string &input_path,
+                                   const std::string &output_path,
+                                   size_t threads = 1,
+                                   size_t chunk_size = DEFAULT_FILE_CHUNK) const;
+
+  private:
+    // bytes per thread below which splitting a seekable stream does not pay
+    static constexpr size_t MIN_PARALLEL_RANGE = 16 * 1024;
+
+    // out = in ^ keystream, advancing cipher by in.size() bytes
+    static void apply(core::StreamCipher &cipher, std::span<const Byte> in,
+                      std::span<Byte> out, size_t threads);
+
+    void transform(const Bytes &input, Bytes &output, size_t threads) const;
+    void transform_file(const std::string &input_path,
+                        const std::string &output_path, size_t threads,
+                        size_t chunk_size) const;
+    void transform_mapped(const std::string &input_path,
+                          const std::string &output_path,
+                          size_t threads) const;
+    void transform_pipelined(const std::string &input_path,
+                             const std::string &output_path, size_t threads,
+                             size_t chunk_size) const;
+
+    std::unique_ptr<core::StreamCipher> m_cipher;
+    FileBackend m_file_backend = FileBackend::Buffered;
+    bool        m_direct_io = false;
+  };
+
+} // namespace crypto
+
+#endif // CRYPTO_STREAM_CIPHER_CONTEXT_HPP
@@ -1,7 +1,6 @@
 #include "des.hpp"
-#include "internal/bits/permute.hpp"
-#include "internal/bits/substitute.hpp"
 #include "internal/bits/utils.hpp"
+#include "internal/bits/word_permute.hpp"
 #include "../../../crypto.hpp"
 #include "internal/core/feistel_network.hpp"
 
@@ -88,23 +87,6 @@ static const std::vector<size_t> PC2 = {
     26, 8,  16, 7,  27, 20, 13, 2,  41, 52, 31, 37, 47, 55, 30, 40,
     51, 45, 33, 48, 44, 49, 39, 56, 34, 53, 46, 42, 50, 36, 29, 32};
 
-static const std::vector<size_t> SPLIT_C = {
-    1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14,
-    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28};
-
-static const std::vector<size_t> SPLIT_D = {
-    29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42,
-    43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56};
-
-static const std::vector<size_t> COMPACT_CD = {
-    1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15, 16, 17, 18, 19,
-    20, 21, 22, 23, 24, 25, 26, 27, 28, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42,
-    43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60};
-
-static const std::vector<size_t> COMPACT_64_32 = {
-    1,  2,  3,  4,  9,  10, 11, 12, 17, 18, 19, 20, 25, 26, 27, 28,
-    33, 34, 35, 36, 41, 42, 43, 44, 49, 50, 51, 52, 57, 58, 59, 60};
-
 static const std::vector<size_t> DES_KEY_SHIFTS = {1, 1, 2, 2, 2, 2, 2, 2,
                                                    1, 2, 2, 2, 2, 2, 2, 1};
 
@@ -112,22 +94,51 @@ static const std::vector<size_t> DES_KEY_SHIFTS = {1, 1, 2, 2, 2, 2, 2, 2,
 
 namespace crypto::des {
 
+namespace {
+using bits::BitIndexBase;
+using bits::BitOrder;
+using bits::WordPermutation;
+
+WordPermutation des_permutation(const std::vector<size_t> &p_block,
+                                size_t input_bits) {
+  return WordPermutation(p_block, input_bits, BitOrder::BigEndian,
+                         BitIndexBase::One);
+}
+
+// every DES permutation fits in a word; they are compiled on first use
+// rather than during static initialisation, where picking a backend would
+// query CPU features and read the tables before they may be constructed
+struct DesPermutations {
+  WordPermutation ip = des_permutation(des_tables::IP, 64);
+  WordPermutation fp = des_permutation(des_tables::FP, 64);
+  WordPermutation e = des_permutation(des_tables::E, 32);
+  WordPermutation p = des_permutation(des_tables::P, 32);
+  WordPermutation pc1 = des_permutation(des_tables::PC1, 64);
+  WordPermutation pc2 = des_permutation(des_tables::PC2, 56);
+};
+
+const DesPermutations &permutations() {
+  static const DesPermutations instance;
+  return instance;
+}
+
+constexpr uint64_t HALF_KEY_MASK = (uint64_t{1} << 28) - 1;
+} // namespace
+
 DES::DES()
     : m_network(m_key_expansion, m_round_function, 16, 8),
       core::FeistelNetworkWrapper(m_network) {}
 
 void DES::before_rounds(Bytes &block, bool encrypting) const {
-  block =
-      crypto::bits::permute(block, des_tables::IP, bits::BitOrder::BigEndian,
-                            bits::BitIndexBase::One);
+  bits::store_word(permutations().ip.apply(bits::load_word(block, 64)), 64,
+                   block);
 
   (void)encrypting;
 }
 
 void DES::after_rounds(Bytes &block, bool encrypting) const {
-  block =
-      crypto::bits::permute(block, des_tables::FP, bits::BitOrder::BigEndian,
-                            bits::BitIndexBase::One);
+  bits::store_word(permutations().fp.apply(bits::load_word(block, 64)), 64,
+                   block);
 
   (void)encrypting;
 }
@@ -135,29 +146,17 @@ void DES::after_rounds(Bytes &block, bool encrypting) const {
 core::RoundKeys DES::KeyExpansionDES::expand(const Bytes &key) const {
   core::RoundKeys round_keys(16);
 
-  auto cd = bits::permute(key, des_tables::PC1, bits::BitOrder::BigEndian,
-                          bits::BitIndexBase::One);
-  auto C = bits::permute(cd, des_tables::SPLIT_C, bits::BitOrder::BigEndian,
-                         bits::BitIndexBase::One);
-  auto D = bits::permute(cd, des_tables::SPLIT_D, bits::BitOrder::BigEndian,
-                         bits::BitIndexBase::One);
+  const DesPermutations &perms = permutations();
+  const uint64_t cd = perms.pc1.apply(bits::load_word(key, 64));
+  uint64_t C = cd >> 28;
+  uint64_t D = cd & HALF_KEY_MASK;
 
   for (int round = 0; round < 16; round++) {
+    C = bits::rotate_left(C, 28, des_tables::DES_KEY_SHIFTS[round]);
+    D = bits::rotate_left(D, 28, des_tables::DES_KEY_SHIFTS[round]);
 
-    bits::rotate_left(C, 28, des_tables::DES_KEY_SHIFTS[round]);
-    bits::rotate_left(D, 28, des_tables::DES_KEY_SHIFTS[round]);
-
-    Bytes CD;
-    CD.insert(CD.end(), C.begin(), C.end());
-    CD.insert(CD.end(), D.begin(), D.end());
-
-    CD = bits::permute(CD, des_tables::COMPACT_CD, bits::BitOrder::BigEndian,
-                       bits::BitIndexBase::One);
-
-    auto round_key =
-        bits::permute(CD, des_tables::PC2, bits::BitOrder::BigEndian,
-                      bits::BitIndexBase::One);
-    round_keys[round] = std::move(round_key);
+    round_keys[round].resize(6);
+    bits::store_word(perms.pc2.apply(C << 28 | D), 48, round_keys[round]);
   }
 
   return round_keys;
@@ -166,42 +165,20 @@ core::RoundKeys DES::KeyExpansionDES::expand(const Bytes &key) const {
 Bytes
 DES::FeistelRoundFunctionDES::apply(const Bytes &half_block,
                                     const Bytes &round_key) const {
-  auto expanded_half =
-      bits::permute(half_block, des_tables::E, bits::BitOrder::BigEndian,
-                    bits::BitIndexBase::One);
-
-  for (int i = 0; i < expanded_half.size(); i++) {
-    expanded_half[i] ^= round_key[i];
-  }
-
-  size_t block_index = 0;
-
-  Bytes substituted_sparce(8, 0);
+  const DesPermutations &perms = permutations();
+  const uint64_t expanded_half =
+      perms.e.apply(bits::load_word(half_block, 32)) ^
+      bits::load_word(round_key, 48);
 
+  // S-box i reads the i-th six-bit group, most significant first
+  uint64_t substituted = 0;
   for (int i = 0; i < 8; i++) {
-    size_t bit_offset = i * 6;
-
-    std::vector<size_t> indices = {bit_offset,     bit_offset + 1,
-                                   bit_offset + 2, bit_offset + 3,
-                                   bit_offset + 4, bit_offset + 5};
-    std::vector<uint8_t> six_bits =
-        bits::permute(expanded_half, indices, bits::BitOrder::BigEndian,
-                      bits::BitIndexBase::Zero);
-
-    std::vector<uint8_t> four_bits =
-        bits::substitute(six_bits, des_tables::SBOXES[i], 6, 4);
-
-    substituted_sparce[i] = four_bits[0];
+    const uint8_t six_bits = (expanded_half >> (42 - 6 * i)) & 0x3F;
+    substituted = substituted << 4 | (des_tables::SBOXES[i][six_bits] & 0x0F);
   }
 
-  Bytes substituted =
-      bits::permute(substituted_sparce, des_tables::COMPACT_64_32,
-                    bits::BitOrder::BigEndian, bits::BitIndexBase::One);
-
-  auto final_block =
-      bits::permute(substituted, des_tables::P, bits::BitOrder::BigEndian,
-                    bits::BitIndexBase::One);
-
+  Bytes final_block(4);
+  bits::store_word(perms.p.apply(substituted), 32, final_block);
   return final_block;
 }
 
@@ -1,4 +1,5 @@
 #include "mars.hpp"
+#include "internal/secure_wipe.hpp"
 #include <stdexcept>
 
 namespace crypto::mars {
@@ -118,6 +119,8 @@ namespace crypto::mars {
 
 
   void MARS::key_schedule(const Bytes& key) {
+    // a rejected key must not leave the previous schedule usable
+    wipe_keys();
     size_t key_len = key.size();
     if (key_len < 16 || key_len > 56 || key_len % 4 != 0) {
       throw std::invalid_argument("MARS: key must be 16..56 bytes, multiple of 4");
@@ -183,6 +186,8 @@ namespace crypto::mars {
       uint32_t p = rol32(B[j], r);
       m_K[i] = w ^ (p & M);
     }
+
+    internal::secure_wipe(T, sizeof(T));
   }
 
   void MARS::e_func(uint32_t A, uint32_t Kei, uint32_t Koi,
@@ -308,6 +313,10 @@ namespace crypto::mars {
     }
   }
 
+  MARS::~MARS() { wipe_keys(); }
+
+  void MARS::wipe_keys() { internal::secure_wipe(m_K); }
+
   void MARS::set_encryption_key(const Bytes& key) {
     key_schedule(key);
   }
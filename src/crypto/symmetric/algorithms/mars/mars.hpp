@@ -10,6 +10,7 @@ namespace crypto::mars {
   class MARS final : public core::SymmetricCipher {
   public:
     explicit MARS() = default;
+    ~MARS() override;
 
     void set_encryption_key(const Bytes &key) override;
     void set_decryption_key(const Bytes &key) override;
@@ -28,6 +29,7 @@ namespace crypto::mars {
     static const uint32_t SBOX[512];
 
     void key_schedule(const Bytes &key);
+    void wipe_keys();
 
     static uint32_t rol32(uint32_t x, int n);
     static uint32_t ror32(uint32_t x, int n);
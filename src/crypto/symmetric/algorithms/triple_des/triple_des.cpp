@@ -1,11 +1,20 @@
 #include <stdexcept>
 
 #include "triple_des.hpp"
+#include "internal/secure_wipe.hpp"
 
 namespace crypto::des {
 
 TripleDES::TripleDES(TripleDESMode mode) : m_mode(mode) {}
 
+TripleDES::~TripleDES() { wipe_keys(); }
+
+void TripleDES::wipe_keys() {
+  internal::secure_wipe(m_key1);
+  internal::secure_wipe(m_key2);
+  internal::secure_wipe(m_key3);
+}
+
   void TripleDES::set_encryption_key(const Bytes& key) {
   init_keys(key);
 }
@@ -62,6 +71,7 @@ Bytes TripleDES::process_block(const Bytes &block,
 }
 
   void TripleDES::init_keys(const Bytes& key) {
+  wipe_keys();
   if (key.size() == 16) {
     m_key1 = Bytes(key.begin(), key.begin() + 8);
     m_key2 = Bytes(key.begin() + 8, key.end());
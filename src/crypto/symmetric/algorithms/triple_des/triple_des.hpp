@@ -16,6 +16,7 @@ enum class TripleDESMode {
 class TripleDES final : public core::SymmetricCipher {
 public:
   explicit TripleDES(TripleDESMode mode);
+  ~TripleDES() override;
 
   void set_encryption_key(const Bytes &key) override;
   void set_decryption_key(const Bytes &key) override;
@@ -38,6 +39,7 @@ private:
 
   Bytes process_block(const Bytes &block, bool encrypting) const;
   void init_keys(const Bytes& key);
+  void wipe_keys();
 };
 
 } // namespace crypto::des
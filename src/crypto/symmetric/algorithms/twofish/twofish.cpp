@@ -1,4 +1,5 @@
 #include "twofish.hpp"
+#include "internal/secure_wipe.hpp"
 #include <stdexcept>
 
 namespace crypto::twofish {
@@ -142,6 +143,8 @@ namespace crypto::twofish {
   }
 
   void Twofish::key_schedule(const Bytes& key) {
+    // a rejected key must not leave the previous schedule usable
+    wipe_keys();
     size_t key_len = key.size();
     if (key_len != 16 && key_len != 24 && key_len != 32) {
       throw std::invalid_argument("Twofish: key must be 16, 24 or 32 bytes");
@@ -226,6 +229,12 @@ namespace crypto::twofish {
       m_sbox[2][i] = (uint8_t)(val >> 16);
       m_sbox[3][i] = (uint8_t)(val >> 24);
     }
+
+    internal::secure_wipe(padded_key);
+    internal::secure_wipe(Me);
+    internal::secure_wipe(Mo);
+    internal::secure_wipe(S);
+    internal::secure_wipe(S_arr);
   }
 
   uint32_t Twofish::h_func(uint32_t x, const std::array<uint32_t, 4>& L, int k) {
@@ -280,6 +289,13 @@ namespace crypto::twofish {
       | ((uint32_t)m_sbox[3][b3] << 24);
   }
 
+  Twofish::~Twofish() { wipe_keys(); }
+
+  void Twofish::wipe_keys() {
+    internal::secure_wipe(m_subkeys);
+    internal::secure_wipe(m_sbox);
+  }
+
   void Twofish::set_encryption_key(const Bytes& key) {
     key_schedule(key);
   }
@@ -10,6 +10,7 @@ namespace crypto::twofish {
   class Twofish final : public core::SymmetricCipher {
   public:
     explicit Twofish() = default;
+    ~Twofish() override;
 
     void set_encryption_key(const Bytes &key) override;
     void set_decryption_key(const Bytes &key) override;
@@ -35,6 +36,7 @@ namespace crypto::twofish {
     static const uint8_t RS[4][8];
 
     void key_schedule(const Bytes &key);
+    void wipe_keys();
 
     uint32_t g_func(uint32_t x) const;
     static uint32_t h_func(uint32_t x, const std::array<uint32_t, 4> &L, int k) ;
@@ -1,84 +1,546 @@
 #include "cipher_context.hpp"
+#include "container.hpp"
+#include "internal/file_pipeline.hpp"
+#include "internal/mapped_file.hpp"
+#include "internal/parallel.hpp"
+#include "internal/random.hpp"
 #include "mode/modes.hpp"
 #include "padding/padding.hpp"
 
+#include <algorithm>
+#include <exception>
+#include <filesystem>
 #include <fstream>
 #include <iterator>
+#include <numeric>
 #include <stdexcept>
 
 namespace crypto {
 
+namespace {
+
+// a fresh name in the directory of path
+std::string staging_path(const std::string &path) {
+  static constexpr char HEX[] = "0123456789abcdef";
+  std::string suffix = ".part-";
+  uint64_t tag = internal::random_u64();
+  for (int i = 0; i < 16; ++i, tag >>= 4) suffix += HEX[tag & 0xF];
+  return path + suffix;
+}
+
+} // namespace
+
+void SymmetricCipherContext::init() {
+  if (!m_cipher) {
+    throw std::invalid_argument("CipherContext: cipher must not be null");
+  }
+  build_mode();
+  build_padding();
+}
+
 void SymmetricCipherContext::set_encryption_key(const Bytes &key) const {
-  m_cipher->set_encryption_key(key);
+  if (!m_owned_cipher) {
+    throw std::logic_error("CipherContext: key schedule is shared and immutable");
+  }
+  m_owned_cipher->set_encryption_key(key);
 }
 
 void SymmetricCipherContext::set_decryption_key(const Bytes &key) const {
-  m_cipher->set_decryption_key(key);
+  if (!m_owned_cipher) {
+    throw std::logic_error("CipherContext: key schedule is shared and immutable");
+  }
+  m_owned_cipher->set_decryption_key(key);
+}
+
+void SymmetricCipherContext::set_tweak_key(const Bytes &key) const {
+  if (!m_tweak_cipher) {
+    throw std::invalid_argument("CipherContext: no tweak cipher configured");
+  }
+  if (!m_owned_tweak_cipher) {
+    throw std::logic_error("CipherContext: key schedule is shared and immutable");
+  }
+  m_owned_tweak_cipher->set_encryption_key(key);
+}
+
+void SymmetricCipherContext::set_file_backend(FileBackend backend) {
+  m_file_backend = backend;
+}
+
+void SymmetricCipherContext::set_direct_io(bool enabled) {
+  m_direct_io = enabled;
+}
+
+void SymmetricCipherContext::set_file_format(FileFormat format) {
+  m_file_format = format;
 }
 
 void SymmetricCipherContext::encrypt(const Bytes &input, Bytes &output,
                              size_t threads) const {
-  const size_t bs = m_cipher->block_size();
-  Bytes padded = m_padding->apply(input, bs);
-  m_mode->encrypt(*m_cipher, padded, output, threads);
+  encrypt_with(*m_mode, input, output, threads);
 }
 
 void SymmetricCipherContext::decrypt(const Bytes &input, Bytes &output,
                              size_t threads) const {
-  Bytes raw;
-  m_mode->decrypt(*m_cipher, input, raw, threads);
-  output = m_padding->remove(raw, m_cipher->block_size());
+  decrypt_with(*m_mode, input, output, threads);
+}
+
+void SymmetricCipherContext::encrypt_with(const mode::SymmetricCipherMode &mode,
+                                          const Bytes &input, Bytes &output,
+                                          size_t threads) const {
+  if (!mode.requires_padding()) {
+    mode.encrypt(*m_cipher, input, output, threads);
+    return;
+  }
+  // only the final partial block goes through the padding scheme; the
+  // aligned prefix is read by the mode straight from input
+  const size_t bs = m_cipher->block_size();
+  const size_t aligned = input.size() - input.size() % bs;
+  Bytes tail = m_padding->pad_tail(input.data() + aligned,
+                                   input.size() - aligned, bs);
+  mode.encrypt_padded(*m_cipher, input, tail, output, threads);
+}
+
+void SymmetricCipherContext::decrypt_with(const mode::SymmetricCipherMode &mode,
+                                          const Bytes &input, Bytes &output,
+                                          size_t threads) const {
+  mode.decrypt(*m_cipher, input, output, threads);
+  if (mode.requires_padding()) {
+    m_padding->remove_in_place(output, m_cipher->block_size());
+  }
+}
+
+CipherSession SymmetricCipherContext::begin(CipherDirection direction) const {
+  auto stream = m_mode->stream(*m_cipher, direction == CipherDirection::Encrypt);
+  if (!stream) {
+    throw std::invalid_argument("CipherContext: mode does not support streaming");
+  }
+  return make_session(std::move(stream), direction);
+}
+
+CipherSession SymmetricCipherContext::make_session(
+    std::unique_ptr<mode::BlockStream> stream, CipherDirection direction) const {
+  if (!m_mode->requires_padding()) {
+    return CipherSession(std::move(stream), m_cipher->block_size(), direction);
+  }
+  return CipherSession(std::move(stream), *m_padding, m_cipher->block_size(),
+                       direction);
 }
 
 std::future<void> SymmetricCipherContext::encrypt_file(const std::string &input_path,
                                                const std::string &output_path,
-                                               size_t threads) const {
+                                               size_t threads,
+                                               size_t chunk_size) const {
   return std::async(std::launch::async,
-                    [this, input_path, output_path, threads]() {
-                      Bytes raw = read_file(input_path);
-                      Bytes result;
-                      encrypt(raw, result, threads);
-                      write_file(output_path, result);
+                    [this, input_path, output_path, threads, chunk_size]() {
+                      transform_file(input_path, output_path,
+                                     CipherDirection::Encrypt, threads,
+                                     chunk_size);
                     });
 }
 
 std::future<void> SymmetricCipherContext::decrypt_file(const std::string &input_path,
                                                const std::string &output_path,
-                                               size_t threads) const {
+                                               size_t threads,
+                                               size_t chunk_size) const {
   return std::async(std::launch::async,
-                    [this, input_path, output_path, threads]() {
-                      Bytes raw = read_file(input_path);
-                      Bytes result;
-                      decrypt(raw, result, threads);
-                      write_file(output_path, result);
+                    [this, input_path, output_path, threads, chunk_size]() {
+                      transform_file(input_path, output_path,
+                                     CipherDirection::Decrypt, threads,
+                                     chunk_size);
                     });
 }
 
-size_t SymmetricCipherContext::cipher_block_size() const { return m_cipher->block_size(); }
+void SymmetricCipherContext::transform_file(const std::string &input_path,
+                                            const std::string &output_path,
+                                            CipherDirection direction,
+                                            size_t threads,
+                                            size_t chunk_size) const {
+  if (chunk_size == 0) {
+    throw std::invalid_argument("CipherContext: chunk size must be > 0");
+  }
+  const bool encrypting = direction == CipherDirection::Encrypt;
+  if (m_file_format == FileFormat::Container) {
+    if (encrypting) {
+      write_container(input_path, output_path, threads, chunk_size);
+    } else {
+      read_container(input_path, output_path, threads);
+    }
+    return;
+  }
+  auto stream = m_mode->stream(*m_cipher, encrypting);
+  if (!stream) {
+    throw std::invalid_argument("CipherContext: mode does not support streaming");
+  }
+
+  // authenticated decryption writes next to output_path and moves the file
+  // into place only once the tag has been checked
+  const bool staged = !encrypting && (m_enc_mode == SymmetricEncryptionMode::GCM ||
+                                      m_enc_mode == SymmetricEncryptionMode::OCB);
+  const std::string target = staged ? staging_path(output_path) : output_path;
+  if (m_file_backend == FileBackend::Mapped && internal::MappedFile::supported()) {
+    transform_mapped(std::move(stream), input_path, target, direction, threads);
+  } else if (m_file_backend == FileBackend::Pipelined) {
+    transform_pipelined(std::move(stream), input_path, target, direction,
+                        threads, chunk_size);
+  } else {
+    transform_buffered(std::move(stream), input_path, target, direction,
+                       threads, chunk_size);
+  }
+  if (staged) {
+    try {
+      std::filesystem::rename(target, output_path);
+    } catch (...) {
+      std::filesystem::remove(target);
+      throw;
+    }
+  }
+}
 
-Bytes SymmetricCipherContext::read_file(const std::string &path) {
-  std::ifstream file(path, std::ios::binary);
-  if (!file) {
+void SymmetricCipherContext::transform_buffered(
+    std::unique_ptr<mode::BlockStream> stream, const std::string &input_path,
+    const std::string &output_path, CipherDirection direction, size_t threads,
+    size_t chunk_size) const {
+  std::ifstream in(input_path, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error(
+        "CipherContext: cannot open file for reading: " + input_path);
+  }
+  std::ofstream out(output_path, std::ios::binary | std::ios::trunc);
+  if (!out) {
     throw std::runtime_error(
-        "CipherContext: cannot open file for reading: " + path);
+        "CipherContext: cannot open file for writing: " + output_path);
+  }
+
+  // whole blocks per read keep the session from carrying a partial block
+  // between chunks
+  const size_t bs = m_cipher->block_size();
+  chunk_size = (chunk_size + bs - 1) / bs * bs;
+  CipherSession session = make_session(std::move(stream), direction);
+  Bytes in_buf(chunk_size);
+  Bytes out_buf(session.output_bound(chunk_size));
+
+  auto write = [&](size_t n) {
+    out.write(reinterpret_cast<const char *>(out_buf.data()),
+              static_cast<std::streamsize>(n));
+    if (!out) {
+      throw std::runtime_error("CipherContext: write error: " + output_path);
+    }
+  };
+
+  try {
+    while (in) {
+      in.read(reinterpret_cast<char *>(in_buf.data()),
+              static_cast<std::streamsize>(chunk_size));
+      const size_t got = static_cast<size_t>(in.gcount());
+      if (got == 0) break;
+      write(session.update(std::span(in_buf.data(), got), out_buf, threads));
+    }
+    if (in.bad()) {
+      throw std::runtime_error("CipherContext: read error: " + input_path);
+    }
+    write(session.finalize(out_buf));
+  } catch (...) {
+    // never leave a partial result behind
+    out.close();
+    std::filesystem::remove(output_path);
+    throw;
   }
-  return Bytes(std::istreambuf_iterator<char>(file),
-                     std::istreambuf_iterator<char>());
 }
 
-void SymmetricCipherContext::write_file(const std::string &path,
-                                const Bytes &data) {
-  std::ofstream file(path, std::ios::binary);
-  if (!file) {
+void SymmetricCipherContext::transform_pipelined(
+    std::unique_ptr<mode::BlockStream> stream, const std::string &input_path,
+    const std::string &output_path, CipherDirection direction, size_t threads,
+    size_t chunk_size) const {
+  const size_t bs = m_cipher->block_size();
+  // O_DIRECT reads need page-aligned chunks; both sizes are block multiples
+  // for every cipher here, so one rounding covers both
+  const size_t align = m_direct_io
+                           ? std::lcm(bs, internal::DIRECT_IO_ALIGNMENT)
+                           : bs;
+  chunk_size = (chunk_size + align - 1) / align * align;
+  CipherSession session = make_session(std::move(stream), direction);
+
+  internal::PipelineOptions options;
+  options.chunk_size = chunk_size;
+  options.output_capacity =
+      session.output_bound(chunk_size) + session.output_bound(0);
+  options.direct_io = m_direct_io;
+
+  try {
+    internal::run_file_pipeline(
+        input_path, output_path, options,
+        [&](std::span<const Byte> in, std::span<Byte> out, bool last) {
+          size_t n = session.update(in, out, threads);
+          if (last) n += session.finalize(out.subspan(n));
+          return n;
+        });
+  } catch (...) {
+    std::filesystem::remove(output_path);
+    throw;
+  }
+}
+
+void SymmetricCipherContext::transform_mapped(
+    std::unique_ptr<mode::BlockStream> stream, const std::string &input_path,
+    const std::string &output_path, CipherDirection direction,
+    size_t threads) const {
+  const bool encrypting = direction == CipherDirection::Encrypt;
+  const bool padded = m_mode->requires_padding();
+  const size_t bs = m_cipher->block_size();
+  auto in = internal::MappedFile::open_read(input_path);
+  const size_t n = in.size();
+  if (padded && !encrypting && (n == 0 || n % bs != 0)) {
+    throw std::invalid_argument("CipherContext: ciphertext not block-aligned");
+  }
+
+  // ciphertext length is known up front; plaintext is at most the
+  // ciphertext length and the file is trimmed once the padding is known
+  const size_t aligned = n - n % bs;
+  const size_t out_size = (padded && encrypting ? aligned + bs : n) +
+                          stream->overhead();
+  auto out = internal::MappedFile::create(output_path, out_size);
+
+  try {
+    if (!padded) {
+      const size_t held = stream->held_blocks();
+      const size_t blocks = n / bs > held ? n / bs - held : 0;
+      size_t written = blocks == 0 ? 0
+                                   : stream->process(in.data(), out.data(),
+                                                     blocks, threads);
+      written += stream->finish(in.data() + blocks * bs, n - blocks * bs,
+                                out.data() + written);
+      out.close(written);
+      return;
+    }
+    size_t written = stream->process(in.data(), out.data(), aligned / bs, threads);
+    if (encrypting) {
+      Bytes last = m_padding->pad_tail(in.data() + aligned, n - aligned, bs);
+      written += stream->process(last.data(), out.data() + written, 1, 1);
+    } else {
+      written -= m_padding->padding_length(out.data(), written, bs);
+    }
+    out.close(written);
+  } catch (...) {
+    try {
+      out.close(0);
+    } catch (...) {
+    }
+    std::filesystem::remove(output_path);
+    throw;
+  }
+}
+
+std::unique_ptr<mode::SymmetricCipherMode>
+SymmetricCipherContext::chunk_mode(const container::Header &header,
+                                   uint64_t index, bool last) const {
+  const size_t bs = m_cipher->block_size();
+  const size_t chunk_size = static_cast<size_t>(header.chunk_size);
+  auto derive = [&](Bytes base) {
+    if (base.size() < 8 && (index >> (8 * base.size())) != 0) {
+      throw std::invalid_argument("CipherContext: nonce too short for chunk count");
+    }
+    for (size_t i = 0; i < std::min<size_t>(8, base.size()); ++i) {
+      base[base.size() - 1 - i] ^= static_cast<Byte>(index >> (8 * i));
+    }
+    return base;
+  };
+  // without an IV the random per-file base keeps files under one key apart
+  Bytes base = m_iv;
+  if (base.empty()) {
+    base.assign(bs, 0x00);
+    std::copy_n(header.base.begin(), std::min(bs, header.base.size()), base.begin());
+  }
+  // enciphered so that chunk IVs are unpredictable, not just distinct
+  auto chunk_iv = [&] {
+    if (base.size() != bs) {
+      throw std::invalid_argument("CipherContext: IV size must equal block size");
+    }
+    return m_cipher->encrypt_block(derive(base));
+  };
+  auto chunk_aad = [&] {
+    Bytes aad = container::encode_header(header);
+    for (size_t i = 0; i < 8; ++i) aad.push_back(static_cast<Byte>(index >> (8 * i)));
+    aad.push_back(last ? 0x01 : 0x00);
+    return aad;
+  };
+
+  switch (m_enc_mode) {
+  case SymmetricEncryptionMode::ECB:
+    return std::make_unique<mode::ECB>();
+  case SymmetricEncryptionMode::CBC:
+    return std::make_unique<mode::CBC>(chunk_iv());
+  case SymmetricEncryptionMode::PCBC:
+    return std::make_unique<mode::PCBC>(chunk_iv());
+  case SymmetricEncryptionMode::CFB:
+    return std::make_unique<mode::CFB>(chunk_iv());
+  case SymmetricEncryptionMode::OFB:
+    return std::make_unique<mode::OFB>(chunk_iv());
+  case SymmetricEncryptionMode::CTR: {
+    const uint64_t first = index * (chunk_size / bs);
+    if (!m_iv.empty()) {
+      return std::make_unique<mode::CTR>(m_iv, first);
+    }
+    // the base supplies the nonce and a random starting counter
+    uint64_t start = 0;
+    for (size_t i = 0; i < 8; ++i) start = (start << 8) | base[bs - 8 + i];
+    return std::make_unique<mode::CTR>(Bytes(base.begin(), base.end() - 8),
+                                       start + first);
+  }
+  case SymmetricEncryptionMode::RD:
+    return std::make_unique<mode::RD>();
+  case SymmetricEncryptionMode::GCM:
+    return std::make_unique<mode::GCM>(derive(m_iv), chunk_aad());
+  case SymmetricEncryptionMode::XTS:
+    return std::make_unique<mode::XTS>(
+        *m_tweak_cipher, mode::XTS::DEFAULT_SECTOR_SIZE,
+        index * (chunk_size / mode::XTS::DEFAULT_SECTOR_SIZE));
+  case SymmetricEncryptionMode::OCB:
+    return std::make_unique<mode::OCB>(derive(m_iv), chunk_aad());
+  default:
+    throw std::invalid_argument("CipherContext: mode cannot be used in a container");
+  }
+}
+
+void SymmetricCipherContext::encrypt_chunk(const container::Header &header,
+                                           uint64_t index, const Bytes &input,
+                                           bool last, Bytes &output) const {
+  auto mode = chunk_mode(header, index, last);
+  if (last) {
+    encrypt_with(*mode, input, output, 1);
+  } else {
+    mode->encrypt(*m_cipher, input, output, 1);
+  }
+}
+
+void SymmetricCipherContext::decrypt_chunk(const container::Header &header,
+                                           uint64_t index, const Bytes &input,
+                                           bool last, Bytes &output) const {
+  auto mode = chunk_mode(header, index, last);
+  if (last) {
+    decrypt_with(*mode, input, output, 1);
+  } else {
+    mode->decrypt(*m_cipher, input, output, 1);
+  }
+}
+
+void SymmetricCipherContext::write_container(const std::string &input_path,
+                                             const std::string &output_path,
+                                             size_t threads,
+                                             size_t chunk_size) const {
+  if (m_enc_mode == SymmetricEncryptionMode::CTS) {
+    throw std::invalid_argument("CipherContext: mode cannot be used in a container");
+  }
+  // non-final chunks must end on a block (and for XTS a sector) boundary
+  const size_t align = m_enc_mode == SymmetricEncryptionMode::XTS
+                           ? mode::XTS::DEFAULT_SECTOR_SIZE
+                           : m_cipher->block_size();
+  chunk_size = (chunk_size + align - 1) / align * align;
+
+  std::ifstream in(input_path, std::ios::binary);
+  if (!in) {
     throw std::runtime_error(
-        "CipherContext: cannot open file for writing: " + path);
+        "CipherContext: cannot open file for reading: " + input_path);
   }
-  file.write(reinterpret_cast<const char *>(data.data()), data.size());
-  if (!file) {
-    throw std::runtime_error("CipherContext: write error: " + path);
+  std::ofstream out(output_path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error(
+        "CipherContext: cannot open file for writing: " + output_path);
+  }
+
+  container::Header header{chunk_size, std::filesystem::file_size(input_path)};
+  if (m_iv.empty()) {
+    internal::random_bytes(header.base);
+  }
+  const uint64_t n_chunks = container::chunk_count(header);
+  const size_t batch = std::max<size_t>(threads, 1);
+  std::vector<Bytes> plain(batch), encrypted(batch);
+  std::vector<uint64_t> offsets;
+  offsets.reserve(n_chunks);
+  uint64_t offset = container::HEADER_SIZE;
+
+  auto write = [&](const Bytes &data) {
+    out.write(reinterpret_cast<const char *>(data.data()),
+              static_cast<std::streamsize>(data.size()));
+    if (!out) {
+      throw std::runtime_error("CipherContext: write error: " + output_path);
+    }
+  };
+
+  try {
+    write(container::encode_header(header));
+    for (uint64_t first = 0; first < n_chunks; first += batch) {
+      const size_t count = static_cast<size_t>(std::min<uint64_t>(batch, n_chunks - first));
+      for (size_t i = 0; i < count; ++i) {
+        const uint64_t begin = (first + i) * chunk_size;
+        plain[i].resize(static_cast<size_t>(
+            std::min<uint64_t>(chunk_size, header.plaintext_size - begin)));
+        in.read(reinterpret_cast<char *>(plain[i].data()),
+                static_cast<std::streamsize>(plain[i].size()));
+        if (static_cast<size_t>(in.gcount()) != plain[i].size()) {
+          throw std::runtime_error("CipherContext: read error: " + input_path);
+        }
+      }
+
+      // chunks are independent, so every mode runs one chunk per worker
+      const auto ranges = internal::split_work(count, threads);
+      std::vector<std::exception_ptr> errors(ranges.size());
+      internal::run_ranges(ranges, [&](size_t r, size_t start, size_t end) {
+        try {
+          for (size_t i = start; i < end; ++i) {
+            encrypt_chunk(header, first + i, plain[i],
+                          first + i + 1 == n_chunks, encrypted[i]);
+          }
+        } catch (...) {
+          errors[r] = std::current_exception();
+        }
+      });
+      for (const auto &e : errors) {
+        if (e) std::rethrow_exception(e);
+      }
+
+      for (size_t i = 0; i < count; ++i) {
+        offsets.push_back(offset);
+        offset += encrypted[i].size();
+        write(encrypted[i]);
+      }
+    }
+    write(container::encode_index(offsets, offset));
+  } catch (...) {
+    out.close();
+    std::filesystem::remove(output_path);
+    throw;
+  }
+}
+
+void SymmetricCipherContext::read_container(const std::string &input_path,
+                                            const std::string &output_path,
+                                            size_t threads) const {
+  ContainerReader reader(*this, input_path);
+  std::ofstream out(output_path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error(
+        "CipherContext: cannot open file for writing: " + output_path);
+  }
+  const size_t batch = std::max<size_t>(threads, 1);
+  try {
+    for (size_t first = 0; first < reader.chunk_count(); first += batch) {
+      const Bytes plain = reader.read_chunks(
+          first, std::min(batch, reader.chunk_count() - first), threads);
+      out.write(reinterpret_cast<const char *>(plain.data()),
+                static_cast<std::streamsize>(plain.size()));
+      if (!out) {
+        throw std::runtime_error("CipherContext: write error: " + output_path);
+      }
+    }
+  } catch (...) {
+    out.close();
+    std::filesystem::remove(output_path);
+    throw;
   }
 }
 
+size_t SymmetricCipherContext::cipher_block_size() const { return m_cipher->block_size(); }
+
 void SymmetricCipherContext::build_mode() {
   switch (m_enc_mode) {
   case SymmetricEncryptionMode::ECB:
@@ -102,6 +564,21 @@ void SymmetricCipherContext::build_mode() {
   case SymmetricEncryptionMode::RD:
     m_mode = std::make_unique<mode::RD>();
     break;
+  case SymmetricEncryptionMode::GCM:
+    m_mode = std::make_unique<mode::GCM>(m_iv);
+    break;
+  case SymmetricEncryptionMode::XTS:
+    if (!m_tweak_cipher) {
+      throw std::invalid_argument("CipherContext: XTS requires a tweak cipher");
+    }
+    m_mode = std::make_unique<mode::XTS>(*m_tweak_cipher);
+    break;
+  case SymmetricEncryptionMode::OCB:
+    m_mode = std::make_unique<mode::OCB>(m_iv);
+    break;
+  case SymmetricEncryptionMode::CTS:
+    m_mode = std::make_unique<mode::CTS>(m_iv);
+    break;
   default:
     throw std::invalid_argument("CipherContext: unknown encryption mode");
   }
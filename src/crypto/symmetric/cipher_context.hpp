@@ -2,15 +2,22 @@
 #define CRYPTO_CIPHER_CONTEXT_HPP
 
 #include "internal/core/symmetric_cipher.hpp"
+#include "symmetric/cipher_session.hpp"
+#include "symmetric/key_schedule.hpp"
 #include "symmetric/mode/cipher_mode.hpp"
 #include "symmetric/padding/padding.hpp"
 
+#include <concepts>
 #include <future>
 #include <memory>
 #include <string>
 
 namespace crypto {
 
+  namespace container {
+    struct Header;
+  } // namespace container
+
   enum class SymmetricEncryptionMode {
     ECB,
     CBC,
@@ -19,6 +26,30 @@ namespace crypto {
     OFB,
     CTR,
     RD,
+    GCM,
+    XTS,
+    OCB,
+    CTS,
+  };
+
+  // How encrypt_file/decrypt_file move data between disk and the mode.
+  // Buffered streams fixed-size chunks through std::fstream; Mapped maps
+  // both files and runs the mode directly over the mapped pages; Pipelined
+  // overlaps reading ahead, encryption and writing behind (io_uring where
+  // available, helper threads otherwise).
+  enum class FileBackend {
+    Buffered,
+    Mapped,
+    Pipelined,
+  };
+
+  // Layout of encrypt_file output. Raw is the mode output as is. Container
+  // encrypts fixed-size chunks independently and appends an index (see
+  // symmetric/container.hpp), so any mode decrypts in parallel across
+  // chunks and ContainerReader can read arbitrary ranges.
+  enum class FileFormat {
+    Raw,
+    Container,
   };
 
   enum class SymmetricPaddingScheme {
@@ -28,48 +59,157 @@ namespace crypto {
     ISO10126,
   };
 
+  // Once keys and file settings are in place, the const members may be
+  // called from many threads at once on one context: the key schedule is
+  // shared read-only and chaining state lives on each call's stack. The
+  // setters must not run concurrently with anything else.
   class SymmetricCipherContext {
   public:
-    SymmetricCipherContext(std::unique_ptr<core::SymmetricCipher> cipher,
+    // Templated on the concrete cipher so that a unique_ptr<Twofish> picks
+    // these owning overloads rather than converting to a KeySchedule.
+    template <std::derived_from<core::SymmetricCipher> Cipher>
+    SymmetricCipherContext(std::unique_ptr<Cipher> cipher,
+                  const SymmetricEncryptionMode enc_mode, const SymmetricPaddingScheme pad_scheme,
+                  Bytes iv = {})
+        : SymmetricCipherContext(std::move(cipher), nullptr, enc_mode,
+                                 pad_scheme, std::move(iv)) {}
+
+    // tweak_cipher is the second, independently keyed cipher used by XTS
+    template <std::derived_from<core::SymmetricCipher> Cipher>
+    SymmetricCipherContext(std::unique_ptr<Cipher> cipher,
+                  std::unique_ptr<core::SymmetricCipher> tweak_cipher,
+                  const SymmetricEncryptionMode enc_mode, const SymmetricPaddingScheme pad_scheme,
+                  Bytes iv = {})
+        : m_owned_cipher(std::move(cipher)),
+          m_owned_tweak_cipher(std::move(tweak_cipher)),
+          m_cipher(m_owned_cipher),
+          m_tweak_cipher(m_owned_tweak_cipher),
+          m_enc_mode(enc_mode),
+          m_pad_scheme(pad_scheme),
+          m_iv(std::move(iv)) {
+      init();
+    }
+
+    // Shared, already keyed schedules (see KeyScheduleCache) instead of
+    // owned ciphers; the set_*_key members then throw std::logic_error.
+    SymmetricCipherContext(KeySchedule cipher,
+                  const SymmetricEncryptionMode enc_mode, const SymmetricPaddingScheme pad_scheme,
+                  Bytes iv = {})
+        : SymmetricCipherContext(std::move(cipher), nullptr, enc_mode,
+                                 pad_scheme, std::move(iv)) {}
+
+    SymmetricCipherContext(KeySchedule cipher, KeySchedule tweak_cipher,
                   const SymmetricEncryptionMode enc_mode, const SymmetricPaddingScheme pad_scheme,
                   Bytes iv = {})
         : m_cipher(std::move(cipher)),
+          m_tweak_cipher(std::move(tweak_cipher)),
           m_enc_mode(enc_mode),
           m_pad_scheme(pad_scheme),
           m_iv(std::move(iv)) {
-      if (!m_cipher) {
-        throw std::invalid_argument("CipherContext: cipher must not be null");
-      }
-      build_mode();
-      build_padding();
+      init();
     }
 
     void set_encryption_key(const Bytes &key) const;
     void set_decryption_key(const Bytes &key) const;
+    void set_tweak_key(const Bytes &key) const;
+    void set_file_backend(FileBackend backend);
+    // Pipelined backend only: read the input with O_DIRECT, bypassing the
+    // page cache; ignored where the filesystem or engine does not allow it
+    void set_direct_io(bool enabled);
+    void set_file_format(FileFormat format);
 
     void encrypt(const Bytes &input, Bytes &output, size_t threads = 1) const;
     void decrypt(const Bytes &input, Bytes &output, size_t threads = 1) const;
 
+    // starts an incremental pass over one message; the context must outlive
+    // the session. GCM and OCB decryption check the tag in finalize, so what
+    // update returns before then is unauthenticated and must be discarded if
+    // finalize throws.
+    CipherSession begin(CipherDirection direction) const;
+
+    static constexpr size_t DEFAULT_FILE_CHUNK = size_t{1} << 20;
+
+    // Files are processed chunk_size bytes at a time through a CipherSession,
+    // so memory use is a few chunks regardless of file size, in every mode;
+    // the Mapped backend ignores chunk_size. GCM and OCB append the tag when
+    // encrypting. When decrypting they write the plaintext to a temporary
+    // file next to output_path, which is renamed to output_path only once
+    // the tag has been checked and removed otherwise. With
+    // FileFormat::Container, chunk_size is the container chunk size, threads
+    // chunks are processed at a time, and every mode but CTS is supported.
+    // Each call runs on its own std::async thread; for many files use
+    // FileCryptoScheduler, which bounds the number of threads.
     std::future<void> encrypt_file(const std::string &input_path,
                                    const std::string &output_path,
-                                   size_t threads = 1) const;
+                                   size_t threads = 1,
+                                   size_t chunk_size = DEFAULT_FILE_CHUNK) const;
     std::future<void> decrypt_file(const std::string &input_path,
                                    const std::string &output_path,
-                                   size_t threads = 1) const;
+                                   size_t threads = 1,
+                                   size_t chunk_size = DEFAULT_FILE_CHUNK) const;
     size_t cipher_block_size() const;
 
   private:
-    static Bytes read_file(const std::string &path);
-    static void write_file(const std::string &path, const Bytes &data);
+    friend class ContainerReader;
+    friend class FileCryptoScheduler;
+
+    // session over stream, padded unless the mode takes input of any length
+    CipherSession make_session(std::unique_ptr<mode::BlockStream> stream,
+                               CipherDirection direction) const;
+    void transform_file(const std::string &input_path,
+                        const std::string &output_path,
+                        CipherDirection direction, size_t threads,
+                        size_t chunk_size) const;
+    void transform_buffered(std::unique_ptr<mode::BlockStream> stream,
+                            const std::string &input_path,
+                            const std::string &output_path,
+                            CipherDirection direction, size_t threads,
+                            size_t chunk_size) const;
+    void transform_mapped(std::unique_ptr<mode::BlockStream> stream,
+                          const std::string &input_path,
+                          const std::string &output_path,
+                          CipherDirection direction, size_t threads) const;
+    void transform_pipelined(std::unique_ptr<mode::BlockStream> stream,
+                             const std::string &input_path,
+                             const std::string &output_path,
+                             CipherDirection direction, size_t threads,
+                             size_t chunk_size) const;
+
+    void write_container(const std::string &input_path,
+                         const std::string &output_path, size_t threads,
+                         size_t chunk_size) const;
+    void read_container(const std::string &input_path,
+                        const std::string &output_path, size_t threads) const;
+    // per-chunk mode: IV E_K(base ^ index), nonce XORed with the index and
+    // bound to the header, index and last flag through the AAD, CTR counter
+    // and XTS sector continued from the chunk's plaintext offset
+    std::unique_ptr<mode::SymmetricCipherMode>
+    chunk_mode(const container::Header &header, uint64_t index, bool last) const;
+    void encrypt_chunk(const container::Header &header, uint64_t index,
+                       const Bytes &input, bool last, Bytes &output) const;
+    void decrypt_chunk(const container::Header &header, uint64_t index,
+                       const Bytes &input, bool last, Bytes &output) const;
+    void encrypt_with(const mode::SymmetricCipherMode &mode, const Bytes &input,
+                      Bytes &output, size_t threads) const;
+    void decrypt_with(const mode::SymmetricCipherMode &mode, const Bytes &input,
+                      Bytes &output, size_t threads) const;
 
+    void init();
     void build_mode();
     void build_padding();
 
-    std::unique_ptr<core::SymmetricCipher> m_cipher;
+    // null when the context was given shared schedules
+    std::shared_ptr<core::SymmetricCipher> m_owned_cipher;
+    std::shared_ptr<core::SymmetricCipher> m_owned_tweak_cipher;
+    KeySchedule m_cipher;
+    KeySchedule m_tweak_cipher;
     std::unique_ptr<mode::SymmetricCipherMode>      m_mode;
     std::unique_ptr<padding::SymmetricPaddingMode>  m_padding;
     SymmetricEncryptionMode m_enc_mode;
     SymmetricPaddingScheme  m_pad_scheme;
+    FileBackend             m_file_backend = FileBackend::Buffered;
+    bool                    m_direct_io = false;
+    FileFormat              m_file_format = FileFormat::Raw;
     Bytes    m_iv;
   };
 
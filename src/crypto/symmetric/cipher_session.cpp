@@ -0,0 +1,107 @@
+#include "cipher_session.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace crypto {
+
+CipherSession::CipherSession(std::unique_ptr<mode::BlockStream> stream,
+                             const padding::SymmetricPaddingMode &padding,
+                             size_t block_size, CipherDirection direction)
+    : CipherSession(std::move(stream), block_size, direction) {
+  m_padding = &padding;
+}
+
+CipherSession::CipherSession(std::unique_ptr<mode::BlockStream> stream,
+                             size_t block_size, CipherDirection direction)
+    : m_padding(nullptr),
+      m_stream(std::move(stream)),
+      m_encrypting(direction == CipherDirection::Encrypt),
+      m_block_size(block_size) {
+  if (!m_stream) {
+    throw std::invalid_argument("CipherSession: stream must not be null");
+  }
+  m_pending.reserve((m_stream->held_blocks() + 1) * m_block_size);
+}
+
+size_t CipherSession::output_bound(size_t in_len) const {
+  return in_len + (m_stream->held_blocks() + 1) * m_block_size +
+         m_stream->overhead();
+}
+
+size_t CipherSession::process(const Byte *in, Byte *out, size_t n_blocks,
+                              size_t threads) {
+  return n_blocks == 0 ? 0 : m_stream->process(in, out, n_blocks, threads);
+}
+
+size_t CipherSession::update(std::span<const Byte> in, std::span<Byte> out,
+                             size_t threads) {
+  if (m_finalized) {
+    throw std::logic_error("CipherSession: update after finalize");
+  }
+  if (out.size() < output_bound(in.size())) {
+    throw std::invalid_argument("CipherSession: output buffer too small");
+  }
+  const size_t bs = m_block_size;
+  const size_t available = m_pending.size() + in.size();
+  size_t n_blocks;
+  if (!m_padding) {
+    const size_t held = m_stream->held_blocks();
+    n_blocks = available / bs > held ? available / bs - held : 0;
+  } else if (m_encrypting) {
+    n_blocks = available / bs;
+  } else {
+    // a decrypting session always keeps the last block for finalize
+    n_blocks = available == 0 ? 0 : (available - 1) / bs;
+  }
+
+  // blocks that start in m_pending are completed from in and processed
+  // from there; once m_pending is drained the rest is read from in directly
+  size_t consumed = 0;
+  size_t written = 0;
+  if (!m_pending.empty() && n_blocks > 0) {
+    const size_t pending_blocks = (m_pending.size() + bs - 1) / bs;
+    const size_t take = std::min(n_blocks, pending_blocks) * bs;
+    if (take > m_pending.size()) {
+      consumed = take - m_pending.size();
+      m_pending.insert(m_pending.end(), in.begin(), in.begin() + consumed);
+    }
+    written += process(m_pending.data(), out.data(), take / bs, 1);
+    m_pending.erase(m_pending.begin(), m_pending.begin() + take);
+    n_blocks -= take / bs;
+  }
+
+  written += process(in.data() + consumed, out.data() + written, n_blocks,
+                     threads);
+  consumed += n_blocks * bs;
+
+  m_pending.insert(m_pending.end(), in.begin() + consumed, in.end());
+  return written;
+}
+
+size_t CipherSession::finalize(std::span<Byte> out) {
+  if (m_finalized) {
+    throw std::logic_error("CipherSession: finalize called twice");
+  }
+  if (out.size() < output_bound(0)) {
+    throw std::invalid_argument("CipherSession: output buffer too small");
+  }
+  m_finalized = true;
+
+  if (!m_padding) {
+    return m_stream->finish(m_pending.data(), m_pending.size(), out.data());
+  }
+  if (m_encrypting) {
+    Bytes last = m_padding->pad_tail(m_pending.data(), m_pending.size(),
+                                    m_block_size);
+    return process(last.data(), out.data(), 1, 1);
+  }
+
+  if (m_pending.size() != m_block_size) {
+    throw std::invalid_argument("CipherSession: ciphertext not block-aligned");
+  }
+  const size_t written = process(m_pending.data(), out.data(), 1, 1);
+  return written - m_padding->padding_length(out.data(), written, m_block_size);
+}
+
+} // namespace crypto
@@ -0,0 +1,60 @@
+#ifndef CRYPTO_CIPHER_SESSION_HPP
+#define CRYPTO_CIPHER_SESSION_HPP
+
+#include "internal/core/symmetric_cipher.hpp"
+#include "symmetric/mode/cipher_mode.hpp"
+#include "symmetric/padding/padding.hpp"
+
+#include <memory>
+#include <span>
+
+namespace crypto {
+
+  enum class CipherDirection {
+    Encrypt,
+    Decrypt,
+  };
+
+  // Incremental encryption or decryption of one message. update accepts
+  // input of any length and passes whole blocks to the mode right away,
+  // holding back at most one block: the partial tail when encrypting, the
+  // last full block when decrypting, so that finalize can pad or unpad it.
+  // Sessions over modes that do not pad instead hold back the partial tail
+  // plus the stream's held_blocks() and let the stream finish the message.
+  // Memory use does not depend on the message length. The padding and the
+  // cipher behind the stream are borrowed and must outlive the session.
+  class CipherSession {
+  public:
+    CipherSession(std::unique_ptr<mode::BlockStream> stream,
+                  const padding::SymmetricPaddingMode &padding,
+                  size_t block_size, CipherDirection direction);
+    // for modes that do not pad (requires_padding() is false)
+    CipherSession(std::unique_ptr<mode::BlockStream> stream,
+                  size_t block_size, CipherDirection direction);
+
+    // bytes out must be able to hold for update with in_len bytes of input;
+    // output_bound(0) is enough for finalize
+    size_t output_bound(size_t in_len) const;
+
+    // both return the number of bytes written to out; threads is used by
+    // modes whose blocks can be processed independently
+    size_t update(std::span<const Byte> in, std::span<Byte> out,
+                  size_t threads = 1);
+    size_t finalize(std::span<Byte> out);
+
+  private:
+    size_t process(const Byte *in, Byte *out, size_t n_blocks,
+                   size_t threads);
+
+    // null for modes that do not pad
+    const padding::SymmetricPaddingMode *m_padding;
+    std::unique_ptr<mode::BlockStream> m_stream;
+    bool m_encrypting;
+    bool m_finalized = false;
+    size_t m_block_size;
+    Bytes m_pending;
+  };
+
+} // namespace crypto
+
+#endif
@@ -0,0 +1,193 @@
+#include "container.hpp"
+#include "internal/parallel.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+
+namespace crypto {
+  namespace {
+    constexpr char HEADER_MAGIC[4] = {'C', 'C', 'F', '1'};
+    constexpr char TRAILER_MAGIC[4] = {'C', 'C', 'I', 'X'};
+
+    void store_le64(Byte* p, uint64_t v) {
+      for (int i = 0; i < 8; ++i) p[i] = static_cast<Byte>(v >> (8 * i));
+    }
+
+    uint64_t load_le64(const Byte* p) {
+      uint64_t v = 0;
+      for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+      return v;
+    }
+
+    void store_le32(Byte* p, uint32_t v) {
+      for (int i = 0; i < 4; ++i) p[i] = static_cast<Byte>(v >> (8 * i));
+    }
+
+    uint32_t load_le32(const Byte* p) {
+      return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+             (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    void read_at(std::ifstream& file, uint64_t offset, Byte* out, size_t len,
+                 const std::string& path) {
+      file.clear();
+      file.seekg(static_cast<std::streamoff>(offset));
+      file.read(reinterpret_cast<char*>(out), static_cast<std::streamsize>(len));
+      if (static_cast<size_t>(file.gcount()) != len) {
+        throw std::invalid_argument("Container: truncated file: " + path);
+      }
+    }
+  } // namespace
+
+  namespace container {
+    uint64_t chunk_count(const Header& header) {
+      // no rounding addition, which a corrupt header could overflow
+      const uint64_t whole = header.plaintext_size / header.chunk_size;
+      return std::max<uint64_t>(1, whole + (header.plaintext_size % header.chunk_size != 0));
+    }
+
+    Bytes encode_header(const Header& header) {
+      Bytes out(HEADER_SIZE);
+      std::memcpy(out.data(), HEADER_MAGIC, 4);
+      store_le32(out.data() + 4, VERSION);
+      store_le64(out.data() + 8, header.chunk_size);
+      store_le64(out.data() + 16, header.plaintext_size);
+      std::copy(header.base.begin(), header.base.end(), out.begin() + 24);
+      return out;
+    }
+
+    Header decode_header(const Bytes& bytes) {
+      if (bytes.size() < HEADER_SIZE || std::memcmp(bytes.data(), HEADER_MAGIC, 4) != 0) {
+        throw std::invalid_argument("Container: not a container file");
+      }
+      if (load_le32(bytes.data() + 4) != VERSION) {
+        throw std::invalid_argument("Container: unsupported version");
+      }
+      Header header{load_le64(bytes.data() + 8), load_le64(bytes.data() + 16)};
+      std::copy_n(bytes.begin() + 24, BASE_SIZE, header.base.begin());
+      if (header.chunk_size == 0) {
+        throw std::invalid_argument("Container: chunk size must be > 0");
+      }
+      return header;
+    }
+
+    Bytes encode_index(const std::vector<uint64_t>& offsets, uint64_t index_offset) {
+      Bytes out(offsets.size() * 8 + TRAILER_SIZE);
+      for (size_t i = 0; i < offsets.size(); ++i) store_le64(out.data() + 8 * i, offsets[i]);
+      Byte* trailer = out.data() + offsets.size() * 8;
+      store_le64(trailer, index_offset);
+      store_le64(trailer + 8, offsets.size());
+      std::memcpy(trailer + 16, TRAILER_MAGIC, 4);
+      store_le32(trailer + 20, 0);
+      return out;
+    }
+  } // namespace container
+
+  ContainerReader::ContainerReader(const SymmetricCipherContext& context,
+                                   const std::string& path)
+      : m_context(context), m_path(path), m_file(path, std::ios::binary) {
+    if (!m_file) {
+      throw std::runtime_error("Container: cannot open file for reading: " + path);
+    }
+    m_file.seekg(0, std::ios::end);
+    const auto file_size = static_cast<uint64_t>(m_file.tellg());
+    if (file_size < container::HEADER_SIZE + container::TRAILER_SIZE) {
+      throw std::invalid_argument("Container: truncated file: " + path);
+    }
+
+    Bytes header(container::HEADER_SIZE);
+    read_at(m_file, 0, header.data(), header.size(), path);
+    m_header = container::decode_header(header);
+
+    Bytes trailer(container::TRAILER_SIZE);
+    read_at(m_file, file_size - trailer.size(), trailer.data(), trailer.size(), path);
+    if (std::memcmp(trailer.data() + 16, TRAILER_MAGIC, 4) != 0) {
+      throw std::invalid_argument("Container: missing index: " + path);
+    }
+    const uint64_t index_offset = load_le64(trailer.data());
+    const uint64_t count = load_le64(trailer.data() + 8);
+    // bound count and index_offset by the file size before multiplying or
+    // adding them, so a corrupt trailer cannot wrap around
+    const uint64_t room = file_size - container::HEADER_SIZE - container::TRAILER_SIZE;
+    if (count > room / 8 || index_offset > file_size - container::TRAILER_SIZE - count * 8 ||
+        count != container::chunk_count(m_header) ||
+        index_offset + count * 8 + container::TRAILER_SIZE != file_size ||
+        index_offset < container::HEADER_SIZE ||
+        // no mode produces less ciphertext than plaintext
+        m_header.plaintext_size > index_offset - container::HEADER_SIZE) {
+      throw std::invalid_argument("Container: corrupt index: " + path);
+    }
+
+    Bytes index(count * 8);
+    read_at(m_file, index_offset, index.data(), index.size(), path);
+    m_offsets.resize(count + 1);
+    for (size_t i = 0; i < count; ++i) m_offsets[i] = load_le64(index.data() + 8 * i);
+    m_offsets[count] = index_offset;
+    if (m_offsets[0] != container::HEADER_SIZE ||
+        !std::is_sorted(m_offsets.begin(), m_offsets.end())) {
+      throw std::invalid_argument("Container: corrupt index: " + path);
+    }
+  }
+
+  uint64_t ContainerReader::size() const { return m_header.plaintext_size; }
+
+  size_t ContainerReader::chunk_size() const {
+    return static_cast<size_t>(m_header.chunk_size);
+  }
+
+  size_t ContainerReader::chunk_count() const { return m_offsets.size() - 1; }
+
+  Bytes ContainerReader::read_chunks(size_t first, size_t count, size_t threads) {
+    if (first > chunk_count() || count > chunk_count() - first) {
+      throw std::out_of_range("Container: chunk range out of bounds");
+    }
+    const size_t last_chunk = chunk_count() - 1;
+    std::vector<Bytes> encrypted(count), plain(count);
+    for (size_t i = 0; i < count; ++i) {
+      const size_t c = first + i;
+      encrypted[i].resize(m_offsets[c + 1] - m_offsets[c]);
+      read_at(m_file, m_offsets[c], encrypted[i].data(), encrypted[i].size(), m_path);
+    }
+
+    // a bad chunk must surface as an exception, not terminate a worker
+    const auto ranges = internal::split_work(count, threads);
+    std::vector<std::exception_ptr> errors(ranges.size());
+    internal::run_ranges(ranges, [&](size_t r, size_t start, size_t end) {
+      try {
+        for (size_t i = start; i < end; ++i) {
+          const size_t c = first + i;
+          m_context.decrypt_chunk(m_header, c, encrypted[i], c == last_chunk,
+                                  plain[i]);
+          const uint64_t begin = static_cast<uint64_t>(c) * m_header.chunk_size;
+          const uint64_t expected =
+              std::min<uint64_t>(m_header.chunk_size, m_header.plaintext_size - begin);
+          if (plain[i].size() != expected) {
+            throw std::invalid_argument("Container: corrupt chunk");
+          }
+        }
+      } catch (...) {
+        errors[r] = std::current_exception();
+      }
+    });
+    for (const auto& e : errors) {
+      if (e) std::rethrow_exception(e);
+    }
+
+    Bytes out;
+    for (const auto& p : plain) out.insert(out.end(), p.begin(), p.end());
+    return out;
+  }
+
+  Bytes ContainerReader::read(uint64_t offset, size_t length, size_t threads) {
+    if (offset >= size() || length == 0) return {};
+    length = static_cast<size_t>(std::min<uint64_t>(length, size() - offset));
+    const size_t first = static_cast<size_t>(offset / m_header.chunk_size);
+    const size_t last = static_cast<size_t>((offset + length - 1) / m_header.chunk_size);
+    Bytes chunks = read_chunks(first, last - first + 1, threads);
+    const size_t skip = static_cast<size_t>(offset - first * m_header.chunk_size);
+    return Bytes(chunks.begin() + skip, chunks.begin() + skip + length);
+  }
+
+} // namespace crypto
@@ -0,0 +1,82 @@
+#ifndef CRYPTO_SYMMETRIC_CONTAINER_HPP
+#define CRYPTO_SYMMETRIC_CONTAINER_HPP
+
+#include "symmetric/cipher_context.hpp"
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace crypto {
+
+  // Seekable container written by encrypt_file with FileFormat::Container.
+  // All integers are little-endian u64 unless noted.
+  //
+  //   header   "CCF1" | u32 version | chunk_size | plaintext_size | base[16]
+  //   chunks   chunk_count ciphertexts, back to back
+  //   index    chunk_count absolute chunk offsets
+  //   trailer  index_offset | chunk_count | "CCIX" | u32 reserved
+  //
+  // Every chunk holds chunk_size plaintext bytes (the last one the rest,
+  // possibly none) and is encrypted on its own. The base is the context IV,
+  // or when the context has none, random bytes stored in the header. CBC,
+  // PCBC, CFB and OFB chunks use the IV E_K(base ^ index). CTR continues
+  // one counter across chunks. GCM and OCB XOR the index into the nonce
+  // and authenticate the header, the index and a final-chunk flag as AAD,
+  // so reordered, dropped or relabelled chunks fail to decrypt. XTS
+  // continues the sector number. Only the last chunk is padded, and only
+  // in modes that pad at all; an XTS container's final chunk must hold at
+  // least one block.
+  namespace container {
+    inline constexpr size_t BASE_SIZE = 16;
+    inline constexpr size_t HEADER_SIZE = 24 + BASE_SIZE;
+    inline constexpr size_t TRAILER_SIZE = 24;
+    inline constexpr uint32_t VERSION = 2;
+
+    struct Header {
+      uint64_t chunk_size;
+      uint64_t plaintext_size;
+      // all zero when the context has an IV
+      std::array<Byte, BASE_SIZE> base{};
+    };
+
+    uint64_t chunk_count(const Header &header);
+
+    Bytes encode_header(const Header &header);
+    Header decode_header(const Bytes &bytes);
+    Bytes encode_index(const std::vector<uint64_t> &offsets, uint64_t index_offset);
+  } // namespace container
+
+  // Random access to a container file. The index is read once on
+  // construction; each read touches only the chunks covering the requested
+  // range and decrypts them in parallel. The context must be keyed for
+  // decryption and configured as for the encryption, and must outlive the
+  // reader. Chunk IVs come from the encryption key, so a CBC or PCBC
+  // reader needs both keys set. Not safe for concurrent use.
+  class ContainerReader {
+  public:
+    ContainerReader(const SymmetricCipherContext &context, const std::string &path);
+
+    uint64_t size() const;
+    size_t chunk_size() const;
+    size_t chunk_count() const;
+
+    // plaintext bytes [offset, offset + length), clamped to the end of data
+    Bytes read(uint64_t offset, size_t length, size_t threads = 1);
+    // plaintext of chunks [first, first + count)
+    Bytes read_chunks(size_t first, size_t count, size_t threads = 1);
+
+  private:
+    const SymmetricCipherContext &m_context;
+    std::string m_path;
+    std::ifstream m_file;
+    container::Header m_header{};
+    // chunk_count + 1 entries; the last one is the index offset
+    std::vector<uint64_t> m_offsets;
+  };
+
+} // namespace crypto
+
+#endif // CRYPTO_SYMMETRIC_CONTAINER_HPP
@@ -0,0 +1,179 @@
+#include "file_scheduler.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+
+namespace crypto {
+
+FileCryptoScheduler::FileCryptoScheduler(const SymmetricCipherContext &context,
+                                         size_t workers,
+                                         size_t threads_per_file,
+                                         size_t chunk_size,
+                                         uint64_t large_file)
+    : m_context(context),
+      m_threads_per_file(std::max<size_t>(threads_per_file, 1)),
+      m_chunk_size(chunk_size),
+      m_large_file(large_file) {
+  if (chunk_size == 0) {
+    throw std::invalid_argument("FileCryptoScheduler: chunk size must be > 0");
+  }
+  if (workers == 0) {
+    workers = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  }
+  // a single worker has to run large files too; it alternates instead
+  m_large_slots = std::max<size_t>(workers / 2, 1);
+  m_workers.reserve(workers);
+  for (size_t i = 0; i < workers; ++i) {
+    m_workers.emplace_back([this] { worker_loop(); });
+  }
+}
+
+FileCryptoScheduler::~FileCryptoScheduler() {
+  {
+    std::lock_guard lock(m_mutex);
+    m_stopping = true;
+  }
+  m_work_cv.notify_all();
+  for (auto &w : m_workers) w.join();
+}
+
+std::vector<std::future<void>>
+FileCryptoScheduler::submit(const std::vector<FileJob> &jobs,
+                            CipherDirection direction) {
+  std::vector<std::future<void>> futures;
+  futures.reserve(jobs.size());
+  std::vector<Task> tasks;
+  tasks.reserve(jobs.size());
+  uint64_t bytes = 0;
+  for (const auto &job : jobs) {
+    // an unreadable input sorts first and fails in the worker
+    std::error_code ec;
+    const uint64_t size = std::filesystem::file_size(job.input_path, ec);
+    Task task{job, direction, ec ? 0 : size, 0,
+              std::make_shared<std::promise<void>>()};
+    futures.push_back(task.promise->get_future());
+    bytes += task.size;
+    tasks.push_back(std::move(task));
+  }
+
+  m_files_total += jobs.size();
+  m_bytes_total += bytes;
+  {
+    std::lock_guard lock(m_mutex);
+    for (auto &task : tasks) {
+      task.sequence = m_sequence++;
+      (task.size >= m_large_file ? m_large : m_small).push(std::move(task));
+    }
+    m_pending += tasks.size();
+  }
+  m_work_cv.notify_all();
+  return futures;
+}
+
+std::vector<std::future<void>>
+FileCryptoScheduler::submit_directory(const std::string &input_dir,
+                                      const std::string &output_dir,
+                                      CipherDirection direction,
+                                      const std::string &suffix) {
+  namespace fs = std::filesystem;
+  if (!fs::is_directory(input_dir)) {
+    throw std::invalid_argument("FileCryptoScheduler: not a directory: " + input_dir);
+  }
+  std::vector<FileJob> jobs;
+  for (const auto &entry : fs::recursive_directory_iterator(input_dir)) {
+    if (!entry.is_regular_file()) continue;
+    fs::path out = fs::path(output_dir) / fs::relative(entry.path(), input_dir);
+    out += suffix;
+    jobs.push_back({entry.path().string(), out.string()});
+  }
+  return submit(jobs, direction);
+}
+
+void FileCryptoScheduler::on_file_done(std::function<void(const FileJob &)> callback) {
+  std::lock_guard lock(m_mutex);
+  m_on_file_done = std::move(callback);
+}
+
+BatchProgress FileCryptoScheduler::progress() const {
+  BatchProgress p;
+  p.files_total = m_files_total;
+  p.files_done = m_files_done;
+  p.files_failed = m_files_failed;
+  p.bytes_total = m_bytes_total;
+  p.bytes_done = m_bytes_done;
+  return p;
+}
+
+size_t FileCryptoScheduler::large_slots() const { return m_large_slots; }
+
+void FileCryptoScheduler::wait() {
+  std::unique_lock lock(m_mutex);
+  m_idle_cv.wait(lock, [&] { return m_pending == 0; });
+}
+
+void FileCryptoScheduler::worker_loop() {
+  for (;;) {
+    Task task;
+    bool large = false;
+    {
+      std::unique_lock lock(m_mutex);
+      m_work_cv.wait(lock, [&] {
+        return !m_small.empty() ||
+               (!m_large.empty() && m_large_running < m_large_slots) ||
+               (m_stopping && m_pending == 0);
+      });
+      if (m_small.empty() &&
+          (m_large.empty() || m_large_running >= m_large_slots)) {
+        return;
+      }
+      // small files first; a large file with a free slot gets its turn
+      // after a burst of small ones, so a steady stream of small files
+      // cannot starve it either
+      const bool large_ready = !m_large.empty() && m_large_running < m_large_slots;
+      large = large_ready &&
+              (m_small.empty() || m_small_streak >= SMALL_FILES_PER_LARGE);
+      TaskQueue &queue = large ? m_large : m_small;
+      task = queue.top();
+      queue.pop();
+      if (large) {
+        ++m_large_running;
+        m_small_streak = 0;
+      } else if (!m_large.empty()) {
+        ++m_small_streak;
+      }
+    }
+
+    run(task);
+    if (m_on_file_done) m_on_file_done(task.job);
+
+    bool idle = false;
+    {
+      std::lock_guard lock(m_mutex);
+      if (large) --m_large_running;
+      idle = --m_pending == 0;
+    }
+    // a freed large slot or the last job may unblock other waiters
+    m_work_cv.notify_all();
+    if (idle) m_idle_cv.notify_all();
+  }
+}
+
+void FileCryptoScheduler::run(const Task &task) {
+  try {
+    const auto parent = std::filesystem::path(task.job.output_path).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent);
+    m_context.transform_file(task.job.input_path, task.job.output_path,
+                             task.direction, m_threads_per_file, m_chunk_size);
+    m_bytes_done += task.size;
+    ++m_files_done;
+    task.promise->set_value();
+  } catch (...) {
+    ++m_files_failed;
+    ++m_files_done;
+    task.promise->set_exception(std::current_exception());
+  }
+}
+
+} // namespace crypto
@@ -0,0 +1,125 @@
+#ifndef CRYPTO_SYMMETRIC_FILE_SCHEDULER_HPP
+#define CRYPTO_SYMMETRIC_FILE_SCHEDULER_HPP
+
+#include "symmetric/cipher_context.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace crypto {
+
+  struct FileJob {
+    std::string input_path;
+    std::string output_path;
+  };
+
+  struct BatchProgress {
+    size_t files_total = 0;
+    size_t files_done = 0;
+    size_t files_failed = 0;
+    uint64_t bytes_total = 0;
+    uint64_t bytes_done = 0;
+  };
+
+  // Runs encrypt_file/decrypt_file work for many files on a fixed set of
+  // worker threads instead of one std::async thread per file. Pending files
+  // are taken smallest first, and small files go ahead of large ones (at
+  // least large_file bytes): a waiting large file is only taken once
+  // SMALL_FILES_PER_LARGE small files have started since the previous one,
+  // or when no small file is queued. With two or more workers large files
+  // occupy at most half of them, so small files keep flowing while big
+  // ones run. The context must outlive the scheduler; the destructor
+  // finishes queued work.
+  class FileCryptoScheduler {
+  public:
+    static constexpr uint64_t LARGE_FILE = uint64_t{64} << 20;
+    static constexpr size_t SMALL_FILES_PER_LARGE = 4;
+
+    // workers: files processed at once (0 picks the hardware concurrency);
+    // threads_per_file is passed on to the mode for each file
+    explicit FileCryptoScheduler(const SymmetricCipherContext &context,
+                                 size_t workers = 0,
+                                 size_t threads_per_file = 1,
+                                 size_t chunk_size = SymmetricCipherContext::DEFAULT_FILE_CHUNK,
+                                 uint64_t large_file = LARGE_FILE);
+    FileCryptoScheduler(const FileCryptoScheduler &) = delete;
+    FileCryptoScheduler &operator=(const FileCryptoScheduler &) = delete;
+    ~FileCryptoScheduler();
+
+    // one future per job, in the order given
+    std::vector<std::future<void>> submit(const std::vector<FileJob> &jobs,
+                                          CipherDirection direction);
+    // every regular file under input_dir, mirrored under output_dir with
+    // suffix appended to each file name
+    std::vector<std::future<void>> submit_directory(const std::string &input_dir,
+                                                    const std::string &output_dir,
+                                                    CipherDirection direction,
+                                                    const std::string &suffix = "");
+
+    // called on the worker thread after each file, failed or not; set it
+    // before the first submit. It must not throw
+    void on_file_done(std::function<void(const FileJob &)> callback);
+
+    BatchProgress progress() const;
+    // large files allowed to run at once
+    size_t large_slots() const;
+    // blocks until every job submitted so far has finished
+    void wait();
+
+  private:
+    struct Task {
+      FileJob job;
+      CipherDirection direction;
+      uint64_t size;
+      uint64_t sequence;
+      std::shared_ptr<std::promise<void>> promise;
+    };
+    // smallest file first, submission order among equals
+    struct LargerFirst {
+      bool operator()(const Task &a, const Task &b) const {
+        return a.size != b.size ? a.size > b.size : a.sequence > b.sequence;
+      }
+    };
+    using TaskQueue = std::priority_queue<Task, std::vector<Task>, LargerFirst>;
+
+    void worker_loop();
+    void run(const Task &task);
+
+    const SymmetricCipherContext &m_context;
+    size_t m_threads_per_file;
+    size_t m_chunk_size;
+    uint64_t m_large_file;
+    size_t m_large_slots;
+    std::function<void(const FileJob &)> m_on_file_done;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_work_cv;
+    std::condition_variable m_idle_cv;
+    TaskQueue m_small;
+    TaskQueue m_large;
+    size_t m_large_running = 0;
+    size_t m_small_streak = 0;
+    size_t m_pending = 0;
+    uint64_t m_sequence = 0;
+    bool m_stopping = false;
+
+    std::atomic<size_t> m_files_total{0};
+    std::atomic<size_t> m_files_done{0};
+    std::atomic<size_t> m_files_failed{0};
+    std::atomic<uint64_t> m_bytes_total{0};
+    std::atomic<uint64_t> m_bytes_done{0};
+
+    std::vector<std::thread> m_workers;
+  };
+
+} // namespace crypto
+
+#endif // CRYPTO_SYMMETRIC_FILE_SCHEDULER_HPP
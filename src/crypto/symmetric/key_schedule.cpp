@@ -0,0 +1,143 @@
+#include "key_schedule.hpp"
+#include "algorithms/mars/mars.hpp"
+#include "algorithms/triple_des/triple_des.hpp"
+#include "algorithms/twofish/twofish.hpp"
+#include "internal/random.hpp"
+#include "internal/secure_wipe.hpp"
+
+#include <stdexcept>
+
+namespace crypto {
+
+KeySchedule make_key_schedule(SymmetricAlgorithm algorithm, const Bytes &key) {
+  std::shared_ptr<core::SymmetricCipher> cipher;
+  bool separate_schedules = true;
+  switch (algorithm) {
+  case SymmetricAlgorithm::DES:
+    cipher = std::make_shared<des::DES>();
+    break;
+  case SymmetricAlgorithm::TripleDES_EEE3:
+    cipher = std::make_shared<des::TripleDES>(des::TripleDESMode::EEE3);
+    separate_schedules = false;
+    break;
+  case SymmetricAlgorithm::TripleDES_EDE3:
+    cipher = std::make_shared<des::TripleDES>(des::TripleDESMode::EDE3);
+    separate_schedules = false;
+    break;
+  case SymmetricAlgorithm::TripleDES_EEE2:
+    cipher = std::make_shared<des::TripleDES>(des::TripleDESMode::EEE2);
+    separate_schedules = false;
+    break;
+  case SymmetricAlgorithm::TripleDES_EDE2:
+    cipher = std::make_shared<des::TripleDES>(des::TripleDESMode::EDE2);
+    separate_schedules = false;
+    break;
+  case SymmetricAlgorithm::Twofish:
+    cipher = std::make_shared<twofish::Twofish>();
+    separate_schedules = false;
+    break;
+  case SymmetricAlgorithm::MARS:
+    cipher = std::make_shared<mars::MARS>();
+    separate_schedules = false;
+    break;
+  default:
+    throw std::invalid_argument("KeySchedule: unknown algorithm");
+  }
+  // Twofish and MARS use one schedule for both directions, and Triple DES
+  // expands all of its DES schedules whichever key is set
+  cipher->set_encryption_key(key);
+  if (separate_schedules) cipher->set_decryption_key(key);
+  return cipher;
+}
+
+KeyScheduleCache::KeyScheduleCache(size_t capacity)
+    : m_capacity(capacity),
+      m_salt(internal::random_u64()) {
+  if (capacity == 0) {
+    throw std::invalid_argument("KeyScheduleCache: capacity must be > 0");
+  }
+}
+
+KeyScheduleCache::~KeyScheduleCache() { clear(); }
+
+uint64_t KeyScheduleCache::hash(SymmetricAlgorithm algorithm, const Bytes &key) const {
+  // salted FNV-1a; collisions only cost a full key comparison
+  uint64_t h = 0xcbf29ce484222325ULL ^ m_salt;
+  auto mix = [&h](Byte b) {
+    h ^= b;
+    h *= 0x100000001b3ULL;
+  };
+  mix(static_cast<Byte>(algorithm));
+  for (Byte b : key) mix(b);
+  return h;
+}
+
+KeyScheduleCache::Lru::iterator KeyScheduleCache::find(uint64_t h,
+                                                       SymmetricAlgorithm algorithm,
+                                                       const Bytes &key) {
+  auto [first, last] = m_index.equal_range(h);
+  for (auto it = first; it != last; ++it) {
+    if (it->second->algorithm == algorithm && it->second->key == key) return it->second;
+  }
+  return m_lru.end();
+}
+
+void KeyScheduleCache::evict(Lru::iterator it) {
+  auto [first, last] = m_index.equal_range(it->hash);
+  for (auto i = first; i != last; ++i) {
+    if (i->second == it) {
+      m_index.erase(i);
+      break;
+    }
+  }
+  internal::secure_wipe(it->key);
+  m_lru.erase(it);
+}
+
+KeySchedule KeyScheduleCache::get(SymmetricAlgorithm algorithm, const Bytes &key) {
+  const uint64_t h = hash(algorithm, key);
+  {
+    std::lock_guard lock(m_mutex);
+    auto it = find(h, algorithm, key);
+    if (it != m_lru.end()) {
+      ++m_stats.hits;
+      m_lru.splice(m_lru.begin(), m_lru, it);
+      return it->schedule;
+    }
+    ++m_stats.misses;
+  }
+
+  // key expansion runs outside the lock so other lookups are not held up
+  KeySchedule schedule = make_key_schedule(algorithm, key);
+
+  std::lock_guard lock(m_mutex);
+  auto it = find(h, algorithm, key);
+  if (it != m_lru.end()) {
+    // another thread built the same schedule meanwhile
+    m_lru.splice(m_lru.begin(), m_lru, it);
+    return it->schedule;
+  }
+  m_lru.push_front({algorithm, h, key, schedule});
+  m_index.emplace(h, m_lru.begin());
+  while (m_lru.size() > m_capacity) {
+    evict(std::prev(m_lru.end()));
+    ++m_stats.evictions;
+  }
+  return schedule;
+}
+
+KeyScheduleCache::Stats KeyScheduleCache::stats() const {
+  std::lock_guard lock(m_mutex);
+  Stats stats = m_stats;
+  stats.size = m_lru.size();
+  return stats;
+}
+
+size_t KeyScheduleCache::capacity() const { return m_capacity; }
+
+void KeyScheduleCache::clear() {
+  std::lock_guard lock(m_mutex);
+  while (!m_lru.empty()) evict(m_lru.begin());
+}
+
+} // namespace crypto
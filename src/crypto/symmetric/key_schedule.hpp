@@ -0,0 +1,81 @@
+#ifndef CRYPTO_SYMMETRIC_KEY_SCHEDULE_HPP
+#define CRYPTO_SYMMETRIC_KEY_SCHEDULE_HPP
+
+#include "internal/core/symmetric_cipher.hpp"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace crypto {
+
+  enum class SymmetricAlgorithm {
+    DES,
+    TripleDES_EEE3,
+    TripleDES_EDE3,
+    TripleDES_EEE2,
+    TripleDES_EDE2,
+    Twofish,
+    MARS,
+  };
+
+  // A cipher keyed for both directions and never changed afterwards, so any
+  // number of contexts and threads can share it. The schedule is wiped when
+  // the last reference goes away.
+  using KeySchedule = std::shared_ptr<const core::SymmetricCipher>;
+
+  KeySchedule make_key_schedule(SymmetricAlgorithm algorithm, const Bytes &key);
+
+  // Bounded LRU cache of key schedules keyed by algorithm and key. Lookups
+  // hash the key with a per-cache random salt and then compare it in full.
+  // Evicted entries wipe their copy of the key; the schedule itself is
+  // wiped once callers still holding it let go. Safe for concurrent use.
+  class KeyScheduleCache {
+  public:
+    struct Stats {
+      uint64_t hits = 0;
+      uint64_t misses = 0;
+      uint64_t evictions = 0;
+      size_t size = 0;
+    };
+
+    explicit KeyScheduleCache(size_t capacity);
+    KeyScheduleCache(const KeyScheduleCache &) = delete;
+    KeyScheduleCache &operator=(const KeyScheduleCache &) = delete;
+    ~KeyScheduleCache();
+
+    // cached schedule, built with make_key_schedule on a miss
+    KeySchedule get(SymmetricAlgorithm algorithm, const Bytes &key);
+
+    Stats stats() const;
+    size_t capacity() const;
+    void clear();
+
+  private:
+    struct Entry {
+      SymmetricAlgorithm algorithm;
+      uint64_t hash;
+      Bytes key;
+      KeySchedule schedule;
+    };
+    using Lru = std::list<Entry>;
+
+    uint64_t hash(SymmetricAlgorithm algorithm, const Bytes &key) const;
+    Lru::iterator find(uint64_t hash, SymmetricAlgorithm algorithm, const Bytes &key);
+    void evict(Lru::iterator it);
+
+    size_t m_capacity;
+    uint64_t m_salt;
+
+    mutable std::mutex m_mutex;
+    // front is the most recently used entry
+    Lru m_lru;
+    std::unordered_multimap<uint64_t, Lru::iterator> m_index;
+    Stats m_stats;
+  };
+
+} // namespace crypto
+
+#endif // CRYPTO_SYMMETRIC_KEY_SCHEDULE_HPP
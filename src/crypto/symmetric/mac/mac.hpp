@@ -0,0 +1,34 @@
+#ifndef CRYPTO_MAC_MAC_HPP
+#define CRYPTO_MAC_MAC_HPP
+
+#include "internal/core/symmetric_cipher.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace crypto::mac {
+
+  class SymmetricMac {
+  public:
+    virtual ~SymmetricMac() = default;
+
+    // streaming interface; finalize returns the tag and resets the state
+    virtual void update(const Byte *data, size_t len) = 0;
+    void update(const Bytes &data) { update(data.data(), data.size()); }
+    virtual Bytes finalize() = 0;
+    virtual void reset() = 0;
+
+    // one-shot over a whole message, independent of the streaming state
+    virtual Bytes compute(const Bytes &message, size_t threads = 1) const = 0;
+    virtual size_t tag_size() const = 0;
+
+    bool verify(const Bytes &message, const Bytes &tag, size_t threads = 1) const;
+    // verifies many short messages, spreading whole messages over threads
+    std::vector<bool> verify_batch(const std::vector<Bytes> &messages,
+                                   const std::vector<Bytes> &tags,
+                                   size_t threads = 1) const;
+  };
+
+} // namespace crypto::mac
+
+#endif // CRYPTO_MAC_MAC_HPP
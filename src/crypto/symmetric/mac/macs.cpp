@@ -0,0 +1,214 @@
+#include "symmetric/mac/macs.hpp"
+#include "internal/parallel.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace crypto::mac {
+  using mode::LTable;
+
+  namespace {
+    bool constant_time_equal(const Bytes& a, const Bytes& b) {
+      if (a.size() != b.size()) return false;
+      Byte diff = 0;
+      for (size_t i = 0; i < a.size(); ++i) diff |= a[i] ^ b[i];
+      return diff == 0;
+    }
+
+    Bytes dbl(const Bytes& b) {
+      const Byte rb = b.size() == 16 ? 0x87 : 0x1B;
+      Bytes result(b.size());
+      const Byte carry = b[0] >> 7;
+      for (size_t i = 0; i + 1 < b.size(); ++i) {
+        result[i] = static_cast<Byte>((b[i] << 1) | (b[i + 1] >> 7));
+      }
+      result.back() = static_cast<Byte>((b.back() << 1) ^ (carry * rb));
+      return result;
+    }
+  } // namespace
+
+  bool SymmetricMac::verify(const Bytes& message, const Bytes& tag,
+                            size_t threads) const {
+    return constant_time_equal(compute(message, threads), tag);
+  }
+
+  std::vector<bool> SymmetricMac::verify_batch(const std::vector<Bytes>& messages,
+                                               const std::vector<Bytes>& tags,
+                                               size_t threads) const {
+    if (messages.size() != tags.size()) {
+      throw std::invalid_argument("MAC: messages and tags count mismatch");
+    }
+    // std::vector<bool> packs bits, so workers write to separate bytes first
+    std::vector<Byte> ok(messages.size(), 0);
+    internal::run_ranges(internal::split_work(messages.size(), threads),
+                         [&](size_t, size_t start, size_t end) {
+                           for (size_t i = start; i < end; ++i)
+                             ok[i] = verify(messages[i], tags[i], 1) ? 1 : 0;
+                         });
+    return {ok.begin(), ok.end()};
+  }
+
+  CMAC::CMAC(const core::SymmetricCipher& cipher)
+      : m_cipher(cipher), m_bs(cipher.block_size()) {
+    if (m_bs != 8 && m_bs != 16) {
+      throw std::invalid_argument("CMAC: cipher block size must be 8 or 16 bytes");
+    }
+    rekey();
+  }
+
+  void CMAC::rekey() {
+    const Bytes l = m_cipher.encrypt_block(Bytes(m_bs, 0x00));
+    m_k1 = dbl(l);
+    m_k2 = dbl(m_k1);
+    reset();
+  }
+
+  void CMAC::reset() {
+    m_state.assign(m_bs, 0x00);
+    m_buffer.clear();
+  }
+
+  size_t CMAC::tag_size() const { return m_bs; }
+
+  void CMAC::chain(Bytes& state, const Byte* data, size_t n_blocks) const {
+    for (size_t b = 0; b < n_blocks; ++b) {
+      for (size_t i = 0; i < m_bs; ++i) state[i] ^= data[b * m_bs + i];
+      state = m_cipher.encrypt_block(state);
+    }
+  }
+
+  Bytes CMAC::finish(Bytes state, const Byte* last, size_t last_len) const {
+    const Bytes& subkey = last_len == m_bs ? m_k1 : m_k2;
+    for (size_t i = 0; i < last_len; ++i) state[i] ^= last[i];
+    if (last_len != m_bs) state[last_len] ^= 0x80;
+    for (size_t i = 0; i < m_bs; ++i) state[i] ^= subkey[i];
+    return m_cipher.encrypt_block(state);
+  }
+
+  void CMAC::update(const Byte* data, size_t len) {
+    if (m_buffer.size() + len <= m_bs) {
+      m_buffer.insert(m_buffer.end(), data, data + len);
+      return;
+    }
+    // the last block gets a subkey, so a full block is only chained once
+    // more data is known to follow it
+    const size_t fill = m_bs - m_buffer.size();
+    m_buffer.insert(m_buffer.end(), data, data + fill);
+    chain(m_state, m_buffer.data(), 1);
+    data += fill;
+    len -= fill;
+
+    const size_t n_blocks = (len - 1) / m_bs;
+    chain(m_state, data, n_blocks);
+    m_buffer.assign(data + n_blocks * m_bs, data + len);
+  }
+
+  Bytes CMAC::finalize() {
+    Bytes tag = finish(m_state, m_buffer.data(), m_buffer.size());
+    reset();
+    return tag;
+  }
+
+  Bytes CMAC::compute(const Bytes& message, size_t) const {
+    const size_t n_blocks = message.empty() ? 0 : (message.size() - 1) / m_bs;
+    Bytes state(m_bs, 0x00);
+    chain(state, message.data(), n_blocks);
+    return finish(std::move(state), message.data() + n_blocks * m_bs,
+                  message.size() - n_blocks * m_bs);
+  }
+
+  PMAC::PMAC(const core::SymmetricCipher& cipher, size_t threads)
+      : m_cipher(cipher), m_threads(threads), m_table(derive_table(cipher)) {
+    m_l_inv = LTable::halve(m_table[0]);
+  }
+
+  LTable PMAC::derive_table(const core::SymmetricCipher& cipher) {
+    if (cipher.block_size() != LTable::BLOCK_SIZE) {
+      throw std::invalid_argument("PMAC: cipher block size must be 16 bytes");
+    }
+    const Bytes l = cipher.encrypt_block(Bytes(LTable::BLOCK_SIZE, 0x00));
+    LTable::Block l0{};
+    std::copy(l.begin(), l.end(), l0.begin());
+    return LTable(l0);
+  }
+
+  void PMAC::rekey() {
+    m_table = derive_table(m_cipher);
+    m_l_inv = LTable::halve(m_table[0]);
+    reset();
+  }
+
+  void PMAC::reset() {
+    m_sum = {};
+    m_blocks = 0;
+    m_buffer.clear();
+  }
+
+  size_t PMAC::tag_size() const { return LTable::BLOCK_SIZE; }
+
+  LTable::Block PMAC::sum_blocks(const Byte* data, size_t n_blocks,
+                                 uint64_t first_index, size_t threads) const {
+    constexpr size_t bs = LTable::BLOCK_SIZE;
+    const auto ranges = internal::split_work(n_blocks, threads);
+    std::vector<internal::CacheAligned<LTable::Block>> partial(ranges.size());
+
+    internal::run_ranges(ranges, [&](size_t t, size_t start, size_t end) {
+      LTable::Block offset = m_table.offset(first_index + start);
+      Bytes block(bs);
+      for (size_t b = start; b < end; ++b) {
+        LTable::xor_into(offset, m_table[LTable::ntz(first_index + b + 1)].data());
+        for (size_t i = 0; i < bs; ++i) block[i] = data[b * bs + i] ^ offset[i];
+        LTable::xor_into(partial[t].value, m_cipher.encrypt_block(block).data());
+      }
+    });
+
+    LTable::Block sum{};
+    for (const auto& p : partial) LTable::xor_into(sum, p.value.data());
+    return sum;
+  }
+
+  Bytes PMAC::finish(LTable::Block sum, const Byte* last, size_t last_len) const {
+    constexpr size_t bs = LTable::BLOCK_SIZE;
+    for (size_t i = 0; i < last_len; ++i) sum[i] ^= last[i];
+    if (last_len == bs) {
+      LTable::xor_into(sum, m_l_inv.data());
+    } else {
+      sum[last_len] ^= 0x80;
+    }
+    return m_cipher.encrypt_block(Bytes(sum.begin(), sum.end()));
+  }
+
+  void PMAC::update(const Byte* data, size_t len) {
+    constexpr size_t bs = LTable::BLOCK_SIZE;
+    if (m_buffer.size() + len <= bs) {
+      m_buffer.insert(m_buffer.end(), data, data + len);
+      return;
+    }
+    const size_t fill = bs - m_buffer.size();
+    m_buffer.insert(m_buffer.end(), data, data + fill);
+    LTable::xor_into(m_sum, sum_blocks(m_buffer.data(), 1, m_blocks, 1).data());
+    ++m_blocks;
+    data += fill;
+    len -= fill;
+
+    const size_t n_blocks = (len - 1) / bs;
+    LTable::xor_into(m_sum, sum_blocks(data, n_blocks, m_blocks, m_threads).data());
+    m_blocks += n_blocks;
+    m_buffer.assign(data + n_blocks * bs, data + len);
+  }
+
+  Bytes PMAC::finalize() {
+    Bytes tag = finish(m_sum, m_buffer.data(), m_buffer.size());
+    reset();
+    return tag;
+  }
+
+  Bytes PMAC::compute(const Bytes& message, size_t threads) const {
+    constexpr size_t bs = LTable::BLOCK_SIZE;
+    const size_t n_blocks = message.empty() ? 0 : (message.size() - 1) / bs;
+    const LTable::Block sum = sum_blocks(message.data(), n_blocks, 0, threads);
+    return finish(sum, message.data() + n_blocks * bs,
+                  message.size() - n_blocks * bs);
+  }
+
+} // namespace crypto::mac
@@ -0,0 +1,77 @@
+#ifndef CRYPTO_MAC_MACS_HPP
+#define CRYPTO_MAC_MACS_HPP
+
+#include "symmetric/mac/mac.hpp"
+#include "symmetric/mode/l_table.hpp"
+
+namespace crypto::mac {
+
+// CMAC (NIST SP 800-38B) for 64- and 128-bit block ciphers. The cipher must
+// be keyed for encryption and outlive the MAC; subkeys K1/K2 are derived once
+// and cached, so call rekey() after changing the cipher key.
+class CMAC final : public SymmetricMac {
+public:
+  explicit CMAC(const core::SymmetricCipher &cipher);
+
+  using SymmetricMac::update;
+  void update(const Byte *data, size_t len) override;
+  Bytes finalize() override;
+  void reset() override;
+
+  Bytes compute(const Bytes &message, size_t threads = 1) const override;
+  size_t tag_size() const override;
+
+  void rekey();
+
+private:
+  void chain(Bytes &state, const Byte *data, size_t n_blocks) const;
+  Bytes finish(Bytes state, const Byte *last, size_t last_len) const;
+
+  const core::SymmetricCipher &m_cipher;
+  size_t m_bs;
+  Bytes m_k1;
+  Bytes m_k2;
+
+  Bytes m_state;
+  Bytes m_buffer;
+};
+
+// PMAC1 for 128-bit block ciphers. Every block except the last is masked
+// with its own offset and enciphered independently, so long messages are
+// split across threads; only the final XOR-sum and tag are serial.
+class PMAC final : public SymmetricMac {
+public:
+  explicit PMAC(const core::SymmetricCipher &cipher, size_t threads = 1);
+
+  using SymmetricMac::update;
+  void update(const Byte *data, size_t len) override;
+  Bytes finalize() override;
+  void reset() override;
+
+  Bytes compute(const Bytes &message, size_t threads = 1) const override;
+  size_t tag_size() const override;
+
+  void rekey();
+
+private:
+  static mode::LTable derive_table(const core::SymmetricCipher &cipher);
+
+  // XOR-sum of E(M_i ^ Offset_i) for blocks first_index + 1 ...
+  mode::LTable::Block sum_blocks(const Byte *data, size_t n_blocks,
+                                 uint64_t first_index, size_t threads) const;
+  Bytes finish(mode::LTable::Block sum, const Byte *last,
+               size_t last_len) const;
+
+  const core::SymmetricCipher &m_cipher;
+  size_t m_threads;
+  mode::LTable m_table;
+  mode::LTable::Block m_l_inv{};
+
+  mode::LTable::Block m_sum{};
+  uint64_t m_blocks = 0;
+  Bytes m_buffer;
+};
+
+} // namespace crypto::mac
+
+#endif // CRYPTO_MAC_MACS_HPP
@@ -2,25 +2,92 @@
 #define CRYPTO_MODE_CIPHER_MODE_HPP
 
 #include "internal/core/symmetric_cipher.hpp"
+#include <algorithm>
 #include <cstddef>
+#include <memory>
+#include <stdexcept>
 
 namespace crypto::mode {
 
+  // Chaining state of one mode over one message, fed whole blocks at a time
+  // so a message can be processed in pieces of any size.
+  class BlockStream {
+  public:
+    virtual ~BlockStream() = default;
+
+    // processes n_blocks blocks and returns the number of bytes written to
+    // output, which may differ from n_blocks * block_size for modes that
+    // emit or consume a header; modes without a serial dependency between
+    // blocks split the work over threads
+    virtual size_t process(const Byte *input, Byte *output,
+                           size_t n_blocks, size_t threads) = 0;
+
+    // bytes a stream may write on top of its input over the whole message
+    virtual size_t overhead() const { return 0; }
+
+    // Streams of modes that take unpadded input end the message here rather
+    // than with a padded final block. input holds the len bytes left after
+    // the last block given to process, fewer than held_blocks() + 1 blocks;
+    // any trailer such as a tag follows the output. Returns the number of
+    // bytes written.
+    virtual size_t finish(const Byte *, size_t, Byte *) {
+      throw std::logic_error("BlockStream: mode only takes padded input");
+    }
+
+    // whole blocks the caller keeps back from process for finish
+    virtual size_t held_blocks() const { return 0; }
+  };
+
+  // A configured mode is immutable: encrypt and decrypt keep all chaining
+  // state on the stack, so one instance may serve any number of threads at
+  // once as long as the cipher's key is not changed meanwhile.
   class SymmetricCipherMode {
   public:
     virtual ~SymmetricCipherMode() = default;
 
     virtual void encrypt(
-        core::SymmetricCipher &cipher,
+        const core::SymmetricCipher &cipher,
         const Bytes &input,
         Bytes &output,
-        size_t threads) = 0;
+        size_t threads) const = 0;
 
     virtual void decrypt(
-        core::SymmetricCipher &cipher,
+        const core::SymmetricCipher &cipher,
+        const Bytes &input,
+        Bytes &output,
+        size_t threads) const = 0;
+
+    // Encrypts the block-aligned prefix of input followed by tail (one full
+    // block, or empty), as if the two were a single buffer. This lets the
+    // context pad only the final block. The default joins them in a copy;
+    // every padding mode in this library walks the input block by block
+    // and overrides it.
+    virtual void encrypt_padded(
+        const core::SymmetricCipher &cipher,
         const Bytes &input,
+        const Bytes &tail,
         Bytes &output,
-        size_t threads) = 0;
+        size_t threads) const {
+      const size_t bs = cipher.block_size();
+      Bytes joined;
+      joined.reserve(input.size() + bs);
+      joined.assign(input.begin(), input.end() - input.size() % bs);
+      joined.insert(joined.end(), tail.begin(), tail.end());
+      encrypt(cipher, joined, output, threads);
+    }
+
+    // Starts an incremental pass over one message. The cipher must outlive
+    // the stream. The default returns nullptr for modes that cannot be run
+    // incrementally; every mode in this library overrides it.
+    virtual std::unique_ptr<BlockStream> stream(
+        const core::SymmetricCipher &,
+        bool) const {
+      return nullptr;
+    }
+
+    // false for modes that accept input of any length, in which case the
+    // context hands the input to the mode without padding it first
+    virtual bool requires_padding() const { return true; }
   };
 
 } // namespace crypto::mode
@@ -0,0 +1,294 @@
+#include "symmetric/mode/ghash.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CRYPTO_GHASH_X86 1
+#include <immintrin.h>
+#endif
+
+namespace crypto::mode {
+  namespace {
+    constexpr uint64_t LAST4[16] = {
+      0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+      0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0,
+    };
+
+    uint64_t load_be64(const Byte* p) {
+      uint64_t v = 0;
+      for (int i = 0; i < 8; ++i) v = (v << 8) | p[i];
+      return v;
+    }
+
+    void store_be64(Byte* p, uint64_t v) {
+      for (int i = 7; i >= 0; --i) {
+        p[i] = static_cast<Byte>(v & 0xFF);
+        v >>= 8;
+      }
+    }
+
+    void xor_into(GHash::Block& y, const Byte* data, size_t len) {
+      for (size_t i = 0; i < len; ++i) y[i] ^= data[i];
+    }
+
+#ifdef CRYPTO_GHASH_X86
+    __attribute__((target("pclmul,ssse3")))
+    inline __m128i bswap128(__m128i x) {
+      const __m128i mask = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7,
+                                        8, 9, 10, 11, 12, 13, 14, 15);
+      return _mm_shuffle_epi8(x, mask);
+    }
+
+    __attribute__((target("pclmul,ssse3")))
+    inline void clmul_unreduced(__m128i a, __m128i b, __m128i& lo, __m128i& hi) {
+      __m128i t0 = _mm_clmulepi64_si128(a, b, 0x00);
+      __m128i t1 = _mm_clmulepi64_si128(a, b, 0x10);
+      __m128i t2 = _mm_clmulepi64_si128(a, b, 0x01);
+      __m128i t3 = _mm_clmulepi64_si128(a, b, 0x11);
+      t1 = _mm_xor_si128(t1, t2);
+      lo = _mm_xor_si128(t0, _mm_slli_si128(t1, 8));
+      hi = _mm_xor_si128(t3, _mm_srli_si128(t1, 8));
+    }
+
+    // Shifts the 256-bit product left by one (bit-reflected operands) and
+    // reduces it modulo x^128 + x^7 + x^2 + x + 1.
+    __attribute__((target("pclmul,ssse3")))
+    inline __m128i clmul_reduce(__m128i lo, __m128i hi) {
+      __m128i t7 = _mm_srli_epi32(lo, 31);
+      __m128i t8 = _mm_srli_epi32(hi, 31);
+      lo = _mm_slli_epi32(lo, 1);
+      hi = _mm_slli_epi32(hi, 1);
+      __m128i t9 = _mm_srli_si128(t7, 12);
+      t8 = _mm_slli_si128(t8, 4);
+      t7 = _mm_slli_si128(t7, 4);
+      lo = _mm_or_si128(lo, t7);
+      hi = _mm_or_si128(hi, t8);
+      hi = _mm_or_si128(hi, t9);
+
+      t7 = _mm_slli_epi32(lo, 31);
+      t8 = _mm_slli_epi32(lo, 30);
+      t9 = _mm_slli_epi32(lo, 25);
+      t7 = _mm_xor_si128(t7, t8);
+      t7 = _mm_xor_si128(t7, t9);
+      t8 = _mm_srli_si128(t7, 4);
+      t7 = _mm_slli_si128(t7, 12);
+      lo = _mm_xor_si128(lo, t7);
+
+      __m128i t2 = _mm_srli_epi32(lo, 1);
+      __m128i t4 = _mm_srli_epi32(lo, 2);
+      __m128i t5 = _mm_srli_epi32(lo, 7);
+      t2 = _mm_xor_si128(t2, t4);
+      t2 = _mm_xor_si128(t2, t5);
+      t2 = _mm_xor_si128(t2, t8);
+      lo = _mm_xor_si128(lo, t2);
+      return _mm_xor_si128(hi, lo);
+    }
+
+    __attribute__((target("pclmul,ssse3")))
+    inline __m128i clmul_mul(__m128i a, __m128i b) {
+      __m128i lo, hi;
+      clmul_unreduced(a, b, lo, hi);
+      return clmul_reduce(lo, hi);
+    }
+#endif
+  } // namespace
+
+  GHash::GHash(const Block& h, Backend backend) : m_h(h) {
+    if (backend == Backend::Auto) {
+      backend = clmul_supported() ? Backend::Clmul : Backend::Table;
+    }
+    if (backend == Backend::Clmul && !clmul_supported()) {
+      throw std::invalid_argument("GHash: PCLMULQDQ is not supported on this CPU");
+    }
+    m_backend = backend;
+
+    uint64_t vh = load_be64(m_h.data());
+    uint64_t vl = load_be64(m_h.data() + 8);
+    m_hl[8] = vl;
+    m_hh[8] = vh;
+    for (size_t i = 4; i > 0; i >>= 1) {
+      const uint64_t t = (vl & 1) * 0xE1000000ULL;
+      vl = (vh << 63) | (vl >> 1);
+      vh = (vh >> 1) ^ (t << 32);
+      m_hl[i] = vl;
+      m_hh[i] = vh;
+    }
+    for (size_t i = 2; i <= 8; i *= 2) {
+      vh = m_hh[i];
+      vl = m_hl[i];
+      for (size_t j = 1; j < i; ++j) {
+        m_hh[i + j] = vh ^ m_hh[j];
+        m_hl[i + j] = vl ^ m_hl[j];
+      }
+    }
+
+    Block p = m_h;
+    for (size_t k = 0; k < m_h_pow.size(); ++k) {
+      // byte-reflected: the lower qword holds the last 8 bytes reversed
+      m_h_pow[k][0] = 0;
+      m_h_pow[k][1] = 0;
+      for (size_t i = 0; i < 8; ++i) {
+        m_h_pow[k][0] |= static_cast<uint64_t>(p[15 - i]) << (8 * i);
+        m_h_pow[k][1] |= static_cast<uint64_t>(p[7 - i]) << (8 * i);
+      }
+      p = multiply(p, m_h);
+    }
+  }
+
+  GHash::Backend GHash::backend() const { return m_backend; }
+
+  bool GHash::clmul_supported() {
+#ifdef CRYPTO_GHASH_X86
+    static const bool supported = __builtin_cpu_supports("pclmul") &&
+                                  __builtin_cpu_supports("ssse3");
+    return supported;
+#else
+    return false;
+#endif
+  }
+
+  GHash::Block GHash::multiply(const Block& x, const Block& y) {
+    const uint64_t xh = load_be64(x.data());
+    const uint64_t xl = load_be64(x.data() + 8);
+    uint64_t vh = load_be64(y.data());
+    uint64_t vl = load_be64(y.data() + 8);
+    uint64_t zh = 0, zl = 0;
+
+    for (int i = 0; i < 128; ++i) {
+      const uint64_t bit = i < 64 ? (xh >> (63 - i)) & 1 : (xl >> (127 - i)) & 1;
+      if (bit) {
+        zh ^= vh;
+        zl ^= vl;
+      }
+      const uint64_t lsb = vl & 1;
+      vl = (vl >> 1) | (vh << 63);
+      vh >>= 1;
+      if (lsb) vh ^= 0xE100000000000000ULL;
+    }
+
+    Block z{};
+    store_be64(z.data(), zh);
+    store_be64(z.data() + 8, zl);
+    return z;
+  }
+
+  GHash::Block GHash::power(uint64_t n) const {
+    Block result{};
+    result[0] = 0x80;
+    Block base = m_h;
+    while (n != 0) {
+      if (n & 1) result = multiply(result, base);
+      base = multiply(base, base);
+      n >>= 1;
+    }
+    return result;
+  }
+
+  void GHash::mul_h_table(Block& y) const {
+    size_t lo = y[15] & 0x0F;
+    uint64_t zh = m_hh[lo];
+    uint64_t zl = m_hl[lo];
+
+    for (int i = 15; i >= 0; --i) {
+      lo = y[i] & 0x0F;
+      const size_t hi = (y[i] >> 4) & 0x0F;
+
+      if (i != 15) {
+        const size_t rem = zl & 0x0F;
+        zl = (zh << 60) | (zl >> 4);
+        zh = (zh >> 4) ^ (LAST4[rem] << 48);
+        zh ^= m_hh[lo];
+        zl ^= m_hl[lo];
+      }
+      const size_t rem = zl & 0x0F;
+      zl = (zh << 60) | (zl >> 4);
+      zh = (zh >> 4) ^ (LAST4[rem] << 48);
+      zh ^= m_hh[hi];
+      zl ^= m_hl[hi];
+    }
+
+    store_be64(y.data(), zh);
+    store_be64(y.data() + 8, zl);
+  }
+
+  void GHash::absorb_table(Block& y, const Byte* data, size_t n_blocks) const {
+    for (size_t b = 0; b < n_blocks; ++b) {
+      xor_into(y, data + b * BLOCK_SIZE, BLOCK_SIZE);
+      mul_h_table(y);
+    }
+  }
+
+#ifdef CRYPTO_GHASH_X86
+  __attribute__((target("pclmul,ssse3")))
+  void GHash::absorb_clmul(Block& y, const Byte* data, size_t n_blocks) const {
+    const __m128i h1 = _mm_load_si128(reinterpret_cast<const __m128i*>(m_h_pow[0].data()));
+    const __m128i h2 = _mm_load_si128(reinterpret_cast<const __m128i*>(m_h_pow[1].data()));
+    const __m128i h3 = _mm_load_si128(reinterpret_cast<const __m128i*>(m_h_pow[2].data()));
+    const __m128i h4 = _mm_load_si128(reinterpret_cast<const __m128i*>(m_h_pow[3].data()));
+
+    __m128i acc = bswap128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y.data())));
+
+    size_t b = 0;
+    for (; b + 4 <= n_blocks; b += 4) {
+      const auto* p = reinterpret_cast<const __m128i*>(data + b * BLOCK_SIZE);
+      const __m128i x1 = _mm_xor_si128(acc, bswap128(_mm_loadu_si128(p)));
+      const __m128i x2 = bswap128(_mm_loadu_si128(p + 1));
+      const __m128i x3 = bswap128(_mm_loadu_si128(p + 2));
+      const __m128i x4 = bswap128(_mm_loadu_si128(p + 3));
+
+      __m128i lo, hi, l, h;
+      clmul_unreduced(x1, h4, lo, hi);
+      clmul_unreduced(x2, h3, l, h);
+      lo = _mm_xor_si128(lo, l);
+      hi = _mm_xor_si128(hi, h);
+      clmul_unreduced(x3, h2, l, h);
+      lo = _mm_xor_si128(lo, l);
+      hi = _mm_xor_si128(hi, h);
+      clmul_unreduced(x4, h1, l, h);
+      lo = _mm_xor_si128(lo, l);
+      hi = _mm_xor_si128(hi, h);
+      acc = clmul_reduce(lo, hi);
+    }
+    for (; b < n_blocks; ++b) {
+      const auto* p = reinterpret_cast<const __m128i*>(data + b * BLOCK_SIZE);
+      acc = clmul_mul(_mm_xor_si128(acc, bswap128(_mm_loadu_si128(p))), h1);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(y.data()), bswap128(acc));
+  }
+#else
+  void GHash::absorb_clmul(Block& y, const Byte* data, size_t n_blocks) const {
+    absorb_table(y, data, n_blocks);
+  }
+#endif
+
+  void GHash::absorb(Block& y, const Byte* data, size_t n_blocks) const {
+    if (n_blocks == 0) return;
+    if (m_backend == Backend::Clmul) {
+      absorb_clmul(y, data, n_blocks);
+    } else {
+      absorb_table(y, data, n_blocks);
+    }
+  }
+
+  void GHash::absorb_padded(Block& y, const Byte* data, size_t len) const {
+    const size_t n_full = len / BLOCK_SIZE;
+    absorb(y, data, n_full);
+
+    const size_t tail = len % BLOCK_SIZE;
+    if (tail != 0) {
+      Block last{};
+      std::copy(data + n_full * BLOCK_SIZE, data + len, last.begin());
+      absorb(y, last.data(), 1);
+    }
+  }
+
+  void GHash::absorb_lengths(Block& y, uint64_t aad_len, uint64_t text_len) const {
+    Block lengths{};
+    store_be64(lengths.data(), aad_len * 8);
+    store_be64(lengths.data() + 8, text_len * 8);
+    absorb(y, lengths.data(), 1);
+  }
+
+} // namespace crypto::mode
@@ -0,0 +1,62 @@
+#ifndef CRYPTO_MODE_GHASH_HPP
+#define CRYPTO_MODE_GHASH_HPP
+
+#include "crypto/internal/bytes.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace crypto::mode {
+
+  // GHASH universal hash over GF(2^128) as used by GCM (NIST SP 800-38D).
+  // Uses PCLMULQDQ with 4-block aggregated reduction when the CPU supports
+  // it, and Shoup's 4-bit table method otherwise. The object only holds
+  // per-key tables; the running accumulator is passed in by the caller, so
+  // one instance can be shared by several threads hashing disjoint ranges.
+  class GHash {
+  public:
+    static constexpr size_t BLOCK_SIZE = 16;
+    using Block = std::array<Byte, BLOCK_SIZE>;
+
+    enum class Backend {
+      Auto,
+      Table,
+      Clmul,
+    };
+
+    explicit GHash(const Block &h, Backend backend = Backend::Auto);
+
+    // y = (...((y ^ X1) * H ^ X2) * H ...) over n_blocks full blocks
+    void absorb(Block &y, const Byte *data, size_t n_blocks) const;
+    // same as absorb, but a trailing partial block is zero-padded
+    void absorb_padded(Block &y, const Byte *data, size_t len) const;
+    // absorbs the final [len(A)]64 || [len(C)]64 block, lengths in bytes
+    void absorb_lengths(Block &y, uint64_t aad_len, uint64_t text_len) const;
+
+    // H^n, used to stitch together accumulators computed over adjacent ranges
+    Block power(uint64_t n) const;
+
+    Backend backend() const;
+
+    static Block multiply(const Block &x, const Block &y);
+    static bool clmul_supported();
+
+  private:
+    void mul_h_table(Block &y) const;
+    void absorb_table(Block &y, const Byte *data, size_t n_blocks) const;
+    void absorb_clmul(Block &y, const Byte *data, size_t n_blocks) const;
+
+    Block m_h;
+    Backend m_backend;
+
+    std::array<uint64_t, 16> m_hl{};
+    std::array<uint64_t, 16> m_hh{};
+
+    // H^1..H^4, byte-reflected, for the aggregated PCLMULQDQ path
+    alignas(16) std::array<std::array<uint64_t, 2>, 4> m_h_pow{};
+  };
+
+} // namespace crypto::mode
+
+#endif // CRYPTO_MODE_GHASH_HPP
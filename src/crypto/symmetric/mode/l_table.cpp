@@ -0,0 +1,53 @@
+#include "symmetric/mode/l_table.hpp"
+
+namespace crypto::mode {
+
+  LTable::LTable(const Block& l0) {
+    m_l[0] = l0;
+    for (size_t i = 1; i < m_l.size(); ++i) {
+      m_l[i] = dbl(m_l[i - 1]);
+    }
+  }
+
+  const LTable::Block& LTable::operator[](size_t i) const { return m_l[i]; }
+
+  LTable::Block LTable::offset(uint64_t i) const {
+    Block result{};
+    uint64_t gray = i ^ (i >> 1);
+    for (size_t j = 0; gray != 0; ++j, gray >>= 1) {
+      if (gray & 1) xor_into(result, m_l[j].data());
+    }
+    return result;
+  }
+
+  LTable::Block LTable::dbl(const Block& b) {
+    Block result{};
+    const Byte carry = b[0] >> 7;
+    for (size_t i = 0; i + 1 < BLOCK_SIZE; ++i) {
+      result[i] = static_cast<Byte>((b[i] << 1) | (b[i + 1] >> 7));
+    }
+    result[BLOCK_SIZE - 1] = static_cast<Byte>((b[BLOCK_SIZE - 1] << 1) ^ (carry * 0x87));
+    return result;
+  }
+
+  LTable::Block LTable::halve(const Block& b) {
+    Block result{};
+    const Byte carry = b[BLOCK_SIZE - 1] & 1;
+    Block src = b;
+    if (carry) src[BLOCK_SIZE - 1] ^= 0x87;
+    for (size_t i = BLOCK_SIZE - 1; i > 0; --i) {
+      result[i] = static_cast<Byte>((src[i] >> 1) | (src[i - 1] << 7));
+    }
+    result[0] = static_cast<Byte>((src[0] >> 1) | (carry << 7));
+    return result;
+  }
+
+  size_t LTable::ntz(uint64_t i) {
+    return i == 0 ? 64 : static_cast<size_t>(__builtin_ctzll(i));
+  }
+
+  void LTable::xor_into(Block& dst, const Byte* src) {
+    for (size_t i = 0; i < BLOCK_SIZE; ++i) dst[i] ^= src[i];
+  }
+
+} // namespace crypto::mode
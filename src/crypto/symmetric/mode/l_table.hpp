@@ -0,0 +1,37 @@
+#ifndef CRYPTO_MODE_L_TABLE_HPP
+#define CRYPTO_MODE_L_TABLE_HPP
+
+#include "crypto/internal/bytes.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace crypto::mode {
+
+  // Table of L_i = L * x^i in GF(2^128) (big-endian, x^128 = x^7 + x^2 + x + 1)
+  // used by OCB and PMAC. The offset after i blocks is the XOR of L_j over
+  // the bits of the Gray code of i, so a worker starting mid-message can
+  // derive its offset directly instead of walking from block 1.
+  class LTable {
+  public:
+    static constexpr size_t BLOCK_SIZE = 16;
+    using Block = std::array<Byte, BLOCK_SIZE>;
+
+    explicit LTable(const Block &l0);
+
+    const Block &operator[](size_t i) const;
+    Block offset(uint64_t i) const;
+
+    static Block dbl(const Block &b);
+    static Block halve(const Block &b);
+    static size_t ntz(uint64_t i);
+    static void xor_into(Block &dst, const Byte *src);
+
+  private:
+    std::array<Block, 64> m_l{};
+  };
+
+} // namespace crypto::mode
+
+#endif // CRYPTO_MODE_L_TABLE_HPP
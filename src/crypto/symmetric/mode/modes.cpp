@@ -1,13 +1,34 @@
 #include "symmetric/mode/modes.hpp"
 #include "internal/core/symmetric_cipher.hpp"
+#include "internal/parallel.hpp"
+#include "internal/random.hpp"
 
+#include <algorithm>
 #include <random>
 #include <stdexcept>
 #include <thread>
 #include <vector>
 
 namespace crypto::mode {
+  using internal::split_work;
+
   namespace {
+    // Initial counter and delta for RD. A non-zero seed gives reproducible
+    // values for tests; otherwise both come from the CSPRNG.
+    void rd_initial_values(uint64_t seed, size_t bs, Bytes& initial,
+                           uint64_t& delta) {
+      initial.resize(bs);
+      if (seed == 0) {
+        internal::random_bytes(std::span(initial));
+        delta = internal::random_u64();
+        return;
+      }
+      std::mt19937_64 rng(seed);
+      for (auto& byte : initial)
+        byte = static_cast<uint8_t>(rng() & 0xFF);
+      delta = rng();
+    }
+
     void add_to_block(Bytes& block, uint64_t delta) {
       uint64_t carry = delta;
       for (size_t i = 0; i < block.size() && carry != 0; ++i) {
@@ -17,6 +38,16 @@ namespace crypto::mode {
       }
     }
 
+    // block += delta * k, little-endian, wrapping like repeated add_to_block
+    void add_multiple_to_block(Bytes& block, uint64_t delta, uint64_t k) {
+      unsigned __int128 carry = static_cast<unsigned __int128>(delta) * k;
+      for (size_t i = 0; i < block.size() && carry != 0; ++i) {
+        carry += block[i];
+        block[i] = static_cast<uint8_t>(carry & 0xFF);
+        carry >>= 8;
+      }
+    }
+
     Bytes xor_blocks(const Bytes& a, const Bytes& b) {
       if (a.size() != b.size()) {
         throw std::invalid_argument("xor_blocks: size mismatch");
@@ -28,24 +59,6 @@ namespace crypto::mode {
       return result;
     }
 
-    std::vector<std::pair<size_t, size_t>> split_work(size_t n_blocks,
-                                                      size_t num_threads) {
-      if (num_threads == 0) num_threads = 1;
-      if (num_threads > n_blocks) num_threads = n_blocks;
-
-      std::vector<std::pair<size_t, size_t>> ranges;
-      ranges.reserve(num_threads);
-      size_t base = n_blocks / num_threads;
-      size_t extra = n_blocks % num_threads;
-      size_t start = 0;
-      for (size_t t = 0; t < num_threads; ++t) {
-        size_t count = base + (t < extra ? 1 : 0);
-        ranges.emplace_back(start, start + count);
-        start += count;
-      }
-      return ranges;
-    }
-
     Bytes validated_iv(const Bytes& iv, size_t bs,
                              const char* mode_name) {
       if (iv.empty()) return Bytes(bs, 0x00);
@@ -54,26 +67,757 @@ namespace crypto::mode {
           ": IV size does not match block size");
       return iv;
     }
+
+    uint32_t load_be32(const Byte* p) {
+      return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+             (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+    }
+
+    void store_be32(Byte* p, uint32_t v) {
+      p[0] = static_cast<Byte>(v >> 24);
+      p[1] = static_cast<Byte>(v >> 16);
+      p[2] = static_cast<Byte>(v >> 8);
+      p[3] = static_cast<Byte>(v);
+    }
+
+    // number of blocks in the aligned prefix of input plus the optional tail
+    size_t padded_block_count(const Bytes& input, const Bytes& tail,
+                              size_t bs, const char* mode_name) {
+      if (!tail.empty() && tail.size() != bs)
+        throw std::invalid_argument(std::string(mode_name) +
+          ": tail must be exactly one block");
+      return input.size() / bs + (tail.empty() ? 0 : 1);
+    }
+
+    // block b of the aligned prefix of input, or the tail once past it
+    Bytes padded_block(const Bytes& input, const Bytes& tail, size_t b,
+                       size_t bs) {
+      if ((b + 1) * bs <= input.size())
+        return Bytes(input.begin() + b * bs, input.begin() + (b + 1) * bs);
+      return tail;
+    }
+
+    bool constant_time_equal(const Byte* a, const Byte* b, size_t n) {
+      Byte diff = 0;
+      for (size_t i = 0; i < n; ++i) diff |= a[i] ^ b[i];
+      return diff == 0;
+    }
+
+    // Per-message chaining state for the sequential modes. Each stream keeps
+    // exactly the register its one-shot counterpart carries between blocks.
+    class EcbStream final : public BlockStream {
+    public:
+      EcbStream(const core::SymmetricCipher& cipher, bool encrypting)
+          : m_cipher(cipher), m_encrypting(encrypting) {}
+
+      size_t process(const Byte* input, Byte* output, size_t n_blocks,
+                     size_t threads) override {
+        const size_t bs = m_cipher.block_size();
+        internal::run_ranges(split_work(n_blocks, threads),
+                             [&](size_t, size_t start, size_t end) {
+          for (size_t b = start; b < end; ++b) {
+            Bytes block(input + b * bs, input + (b + 1) * bs);
+            Bytes result = m_encrypting ? m_cipher.encrypt_block(block)
+                                        : m_cipher.decrypt_block(block);
+            std::copy(result.begin(), result.end(), output + b * bs);
+          }
+        });
+        return n_blocks * bs;
+      }
+
+    private:
+      const core::SymmetricCipher& m_cipher;
+      bool m_encrypting;
+    };
+
+    enum class Chaining { CBC, PCBC, CFB, OFB };
+
+    class ChainStream final : public BlockStream {
+    public:
+      ChainStream(const core::SymmetricCipher& cipher, bool encrypting,
+                  Chaining chaining, Bytes iv)
+          : m_cipher(cipher), m_encrypting(encrypting), m_chaining(chaining),
+            m_register(std::move(iv)) {}
+
+      size_t process(const Byte* input, Byte* output, size_t n_blocks,
+                     size_t) override {
+        const size_t bs = m_cipher.block_size();
+        for (size_t b = 0; b < n_blocks; ++b) {
+          Bytes in(input + b * bs, input + (b + 1) * bs);
+          Bytes out = step(in);
+          std::copy(out.begin(), out.end(), output + b * bs);
+        }
+        return n_blocks * bs;
+      }
+
+    private:
+      Bytes step(const Bytes& in) {
+        Bytes out;
+        switch (m_chaining) {
+        case Chaining::CBC:
+          if (m_encrypting) {
+            out = m_cipher.encrypt_block(xor_blocks(in, m_register));
+            m_register = out;
+          } else {
+            out = xor_blocks(m_cipher.decrypt_block(in), m_register);
+            m_register = in;
+          }
+          break;
+        case Chaining::PCBC:
+          if (m_encrypting) {
+            out = m_cipher.encrypt_block(xor_blocks(in, m_register));
+            m_register = xor_blocks(in, out);
+          } else {
+            out = xor_blocks(m_cipher.decrypt_block(in), m_register);
+            m_register = xor_blocks(out, in);
+          }
+          break;
+        case Chaining::CFB:
+          out = xor_blocks(m_cipher.encrypt_block(m_register), in);
+          m_register = m_encrypting ? out : in;
+          break;
+        case Chaining::OFB:
+          m_register = m_cipher.encrypt_block(m_register);
+          out = xor_blocks(in, m_register);
+          break;
+        }
+        return out;
+      }
+
+      const core::SymmetricCipher& m_cipher;
+      bool m_encrypting;
+      Chaining m_chaining;
+      Bytes m_register;
+    };
+
+    // CBC-CS3 over a message fed in whole blocks. Everything before the last
+    // two blocks is plain CBC; finish is handed the rest (a full block and
+    // the final one to two blocks' worth of bytes) and does the stealing and
+    // the swap exactly as CTS::encrypt and CTS::decrypt do.
+    class CtsStream final : public BlockStream {
+    public:
+      CtsStream(const core::SymmetricCipher& cipher, bool encrypting, Bytes iv)
+          : m_cipher(cipher), m_encrypting(encrypting),
+            m_body(cipher, encrypting, Chaining::CBC, iv), m_chain(std::move(iv)) {}
+
+      size_t process(const Byte* input, Byte* output, size_t n_blocks,
+                     size_t threads) override {
+        if (n_blocks == 0) return 0;
+        const size_t bs = m_cipher.block_size();
+        const size_t written = m_body.process(input, output, n_blocks, threads);
+        // the register CBC carries on: the last ciphertext block
+        const Byte* last = (m_encrypting ? output : input) + (n_blocks - 1) * bs;
+        m_chain.assign(last, last + bs);
+        m_started = true;
+        return written;
+      }
+
+      size_t held_blocks() const override { return 2; }
+
+      size_t finish(const Byte* input, size_t len, Byte* output) override {
+        const size_t bs = m_cipher.block_size();
+        if (!m_started && len < bs)
+          throw std::invalid_argument("CTS: input shorter than one block");
+
+        const size_t n_blocks = (len + bs - 1) / bs;
+        const size_t tail = len - (n_blocks - 1) * bs;
+        const size_t body = n_blocks == 1 ? 1 : n_blocks - 2;
+        size_t written = process(input, output, body, 1);
+        if (n_blocks == 1) return written;
+        input += body * bs;
+        output += body * bs;
+
+        Bytes block(bs);
+        if (m_encrypting) {
+          for (size_t i = 0; i < bs; ++i) block[i] = input[i] ^ m_chain[i];
+          const Bytes penultimate = m_cipher.encrypt_block(block);
+          for (size_t i = 0; i < bs; ++i)
+            block[i] = (i < tail ? input[bs + i] : 0) ^ penultimate[i];
+          const Bytes enc = m_cipher.encrypt_block(block);
+          std::copy(enc.begin(), enc.end(), output);
+          std::copy(penultimate.begin(), penultimate.begin() + tail, output + bs);
+          return written + bs + tail;
+        }
+
+        std::copy(input, input + bs, block.begin());
+        const Bytes dec = m_cipher.decrypt_block(block);
+        Bytes penultimate(bs);
+        for (size_t i = 0; i < bs; ++i)
+          penultimate[i] = i < tail ? input[bs + i] : dec[i];
+        for (size_t i = 0; i < tail; ++i) output[bs + i] = dec[i] ^ penultimate[i];
+        const Bytes prev_plain = m_cipher.decrypt_block(penultimate);
+        for (size_t i = 0; i < bs; ++i) output[i] = prev_plain[i] ^ m_chain[i];
+        return written + bs + tail;
+      }
+
+    private:
+      const core::SymmetricCipher& m_cipher;
+      bool m_encrypting;
+      ChainStream m_body;
+      Bytes m_chain;
+      bool m_started = false;
+    };
+
+    class CtrStream final : public BlockStream {
+    public:
+      CtrStream(const core::SymmetricCipher& cipher, Bytes counter_block,
+                uint64_t first_counter)
+          : m_cipher(cipher), m_counter_block(std::move(counter_block)),
+            m_counter(first_counter) {}
+
+      size_t process(const Byte* input, Byte* output, size_t n_blocks,
+                     size_t threads) override {
+        const size_t bs = m_cipher.block_size();
+        internal::run_ranges(split_work(n_blocks, threads),
+                             [&](size_t, size_t start, size_t end) {
+          Bytes counter_block = m_counter_block;
+          for (size_t b = start; b < end; ++b) {
+            uint64_t counter = m_counter + b;
+            for (int i = 7; i >= 0; --i) {
+              counter_block[bs - 8 + i] = static_cast<uint8_t>(counter & 0xFF);
+              counter >>= 8;
+            }
+            Bytes keystream = m_cipher.encrypt_block(counter_block);
+            for (size_t i = 0; i < bs; ++i)
+              output[b * bs + i] = input[b * bs + i] ^ keystream[i];
+          }
+        });
+        m_counter += n_blocks;
+        return n_blocks * bs;
+      }
+
+    private:
+      const core::SymmetricCipher& m_cipher;
+      Bytes m_counter_block;
+      uint64_t m_counter;
+    };
+
+    // RD writes two header blocks (encrypted initial counter and delta)
+    // ahead of the first data block; the decrypting side consumes them
+    // before producing any output. Data block i is masked with
+    // initial + (i + 1) * delta, so any range of blocks can be processed
+    // on its own.
+    class RdStream final : public BlockStream {
+    public:
+      RdStream(const core::SymmetricCipher& cipher, bool encrypting, uint64_t seed)
+          : m_cipher(cipher), m_encrypting(encrypting) {
+        if (!encrypting) return;
+        rd_initial_values(seed, cipher.block_size(), m_initial, m_delta);
+      }
+
+      size_t overhead() const override {
+        return m_encrypting ? 2 * m_cipher.block_size() : 0;
+      }
+
+      size_t process(const Byte* input, Byte* output, size_t n_blocks,
+                     size_t threads) override {
+        const size_t bs = m_cipher.block_size();
+        size_t written = 0;
+        if (m_encrypting && m_header_blocks == 0) {
+          Bytes delta_block(bs, 0);
+          for (size_t i = 0; i < 8 && i < bs; ++i)
+            delta_block[i] = static_cast<uint8_t>((m_delta >> (i * 8)) & 0xFF);
+          Bytes enc_initial = m_cipher.encrypt_block(m_initial);
+          Bytes enc_delta = m_cipher.encrypt_block(delta_block);
+          std::copy(enc_initial.begin(), enc_initial.end(), output);
+          std::copy(enc_delta.begin(), enc_delta.end(), output + bs);
+          m_header_blocks = 2;
+          written = 2 * bs;
+        }
+
+        size_t skip = 0;
+        for (; skip < n_blocks && m_header_blocks < 2; ++skip)
+          read_header(Bytes(input + skip * bs, input + (skip + 1) * bs));
+
+        const size_t n_data = n_blocks - skip;
+        const Byte* data_in = input + skip * bs;
+        Byte* data_out = output + written;
+        internal::run_ranges(split_work(n_data, threads),
+                             [&](size_t, size_t start, size_t end) {
+          Bytes counter = m_initial;
+          add_multiple_to_block(counter, m_delta, m_index + start);
+          for (size_t b = start; b < end; ++b) {
+            add_to_block(counter, m_delta);
+            Bytes in(data_in + b * bs, data_in + (b + 1) * bs);
+            Bytes out = m_encrypting
+                          ? m_cipher.encrypt_block(xor_blocks(in, counter))
+                          : xor_blocks(m_cipher.decrypt_block(in), counter);
+            std::copy(out.begin(), out.end(), data_out + b * bs);
+          }
+        });
+        m_index += n_data;
+        return written + n_data * bs;
+      }
+
+    private:
+      void read_header(const Bytes& block) {
+        Bytes plain = m_cipher.decrypt_block(block);
+        if (m_header_blocks++ == 0) {
+          m_initial = plain;
+          return;
+        }
+        m_delta = 0;
+        for (size_t i = 0; i < 8 && i < plain.size(); ++i)
+          m_delta |= static_cast<uint64_t>(plain[i]) << (i * 8);
+      }
+
+      const core::SymmetricCipher& m_cipher;
+      bool m_encrypting;
+      Bytes m_initial;
+      uint64_t m_delta = 0;
+      uint64_t m_index = 0;
+      size_t m_header_blocks = 0;
+    };
+
+    // XTS over a message fed in whole blocks. Each block only depends on its
+    // sector and position, so process runs sectors in parallel; finish is
+    // handed the last full block together with any partial block and does
+    // the ciphertext stealing.
+    class XtsStream final : public BlockStream {
+    public:
+      XtsStream(const core::SymmetricCipher& cipher,
+                const core::SymmetricCipher& tweak_cipher, size_t sector_size,
+                uint64_t first_sector, bool encrypting)
+          : m_cipher(cipher), m_tweak_cipher(tweak_cipher),
+            m_sector_blocks(sector_size / 16), m_first_sector(first_sector),
+            m_encrypting(encrypting) {
+        if (cipher.block_size() != 16 || tweak_cipher.block_size() != 16)
+          throw std::invalid_argument("XTS: cipher block size must be 16 bytes");
+      }
+
+      size_t process(const Byte* input, Byte* output, size_t n_blocks,
+                     size_t threads) override {
+        constexpr size_t bs = 16;
+        const uint64_t first = m_position;
+        const uint64_t last = first + n_blocks;
+        const uint64_t first_sector = first / m_sector_blocks;
+        const uint64_t n_sectors =
+            n_blocks == 0 ? 0 : (last - 1) / m_sector_blocks - first_sector + 1;
+
+        internal::run_ranges(split_work(n_sectors, threads),
+                             [&](size_t, size_t start, size_t end) {
+          for (size_t s = start; s < end; ++s) {
+            const uint64_t sector = first_sector + s;
+            const uint64_t from = std::max(first, sector * m_sector_blocks);
+            const uint64_t to = std::min(last, (sector + 1) * m_sector_blocks);
+            process_run(sector, from - sector * m_sector_blocks,
+                        input + (from - first) * bs,
+                        output + (from - first) * bs, to - from);
+          }
+        });
+        m_position = last;
+        return n_blocks * bs;
+      }
+
+      size_t held_blocks() const override { return 1; }
+
+      size_t finish(const Byte* input, size_t len, Byte* output) override {
+        constexpr size_t bs = 16;
+        if (m_position == 0 && len < bs)
+          throw std::invalid_argument("XTS: input shorter than one block");
+        const size_t tail = len % bs;
+        const size_t whole = len / bs - (tail != 0 ? 1 : 0);
+        const size_t written = process(input, output, whole, 1);
+        if (tail == 0) return written;
+
+        const uint64_t sector = m_position / m_sector_blocks;
+        const uint64_t index = m_position % m_sector_blocks;
+        if (len < bs || index + 1 == m_sector_blocks)
+          throw std::invalid_argument("XTS: data unit shorter than one block");
+
+        // as in XTS::process_sector, decryption swaps the tweaks of the last
+        // full block and the partial one
+        const Bytes prev = tweak_at(sector, index);
+        Bytes last = prev;
+        double_tweak(last);
+        input += whole * bs;
+        output += whole * bs;
+
+        Byte cc[bs];
+        apply(input, cc, m_encrypting ? prev : last);
+        Byte pp[bs];
+        std::copy(input + bs, input + bs + tail, pp);
+        std::copy(cc + tail, cc + bs, pp + tail);
+        std::copy(cc, cc + tail, output + bs);
+        apply(pp, output, m_encrypting ? last : prev);
+        m_position += 2;
+        return written + bs + tail;
+      }
+
+    private:
+      // blocks [index, index + count) of one sector
+      void process_run(uint64_t sector, uint64_t index, const Byte* input,
+                       Byte* output, uint64_t count) const {
+        constexpr size_t bs = 16;
+        Bytes tweak = tweak_at(sector, index);
+        for (uint64_t b = 0; b < count; ++b) {
+          apply(input + b * bs, output + b * bs, tweak);
+          double_tweak(tweak);
+        }
+      }
+
+      // tweak of block index within sector, counted from the stream's start
+      Bytes tweak_at(uint64_t sector, uint64_t index) const {
+        Bytes tweak(16, 0x00);
+        const uint64_t unit = m_first_sector + sector;
+        for (size_t i = 0; i < 8; ++i)
+          tweak[i] = static_cast<Byte>((unit >> (i * 8)) & 0xFF);
+        tweak = m_tweak_cipher.encrypt_block(tweak);
+        for (uint64_t j = 0; j < index; ++j) double_tweak(tweak);
+        return tweak;
+      }
+
+      void apply(const Byte* input, Byte* output, const Bytes& tweak) const {
+        constexpr size_t bs = 16;
+        Bytes block(bs);
+        for (size_t i = 0; i < bs; ++i) block[i] = input[i] ^ tweak[i];
+        block = m_encrypting ? m_cipher.encrypt_block(block)
+                             : m_cipher.decrypt_block(block);
+        for (size_t i = 0; i < bs; ++i) output[i] = block[i] ^ tweak[i];
+      }
+
+      // multiplication by alpha on the little-endian 128-bit tweak
+      static void double_tweak(Bytes& tweak) {
+        Byte carry = 0;
+        for (size_t i = 0; i < 16; ++i) {
+          const Byte next = tweak[i] >> 7;
+          tweak[i] = static_cast<Byte>((tweak[i] << 1) | carry);
+          carry = next;
+        }
+        if (carry) tweak[0] ^= 0x87;
+      }
+
+      const core::SymmetricCipher& m_cipher;
+      const core::SymmetricCipher& m_tweak_cipher;
+      uint64_t m_sector_blocks;
+      uint64_t m_first_sector;
+      bool m_encrypting;
+      uint64_t m_position = 0;
+    };
+
+    // GCM over a message fed in whole blocks. CTR and GHASH run together
+    // over small batches, so ciphertext is hashed while it is still in cache;
+    // each worker hashes its own range and the partial accumulators are
+    // stitched with powers of H. finish handles the partial tail and the
+    // length block. A decrypting stream holds back one block so that finish
+    // sees the whole tag; the plaintext process has already written is
+    // unauthenticated until finish returns.
+    class GcmStream final : public BlockStream {
+    public:
+      GcmStream(const core::SymmetricCipher& cipher, bool encrypting,
+                const Bytes& iv, const Bytes& aad)
+          : m_cipher(cipher), m_encrypting(encrypting),
+            m_ghash(hash_key(cipher)), m_aad_len(aad.size()) {
+        constexpr size_t bs = GHash::BLOCK_SIZE;
+        if (iv.size() == 12) {
+          std::copy(iv.begin(), iv.end(), m_j0.begin());
+          m_j0[bs - 1] = 0x01;
+        } else {
+          m_ghash.absorb_padded(m_j0, iv.data(), iv.size());
+          m_ghash.absorb_lengths(m_j0, 0, iv.size());
+        }
+        m_counter0 = load_be32(m_j0.data() + 12);
+        m_ghash.absorb_padded(m_tag, aad.data(), aad.size());
+      }
+
+      size_t overhead() const override {
+        return m_encrypting ? GHash::BLOCK_SIZE : 0;
+      }
+
+      size_t held_blocks() const override { return m_encrypting ? 0 : 1; }
+
+      size_t process(const Byte* input, Byte* output, size_t n_blocks,
+                     size_t threads) override {
+        constexpr size_t bs = GHash::BLOCK_SIZE;
+        if (m_blocks + n_blocks + 1 >= 0xFFFFFFFFULL)
+          throw std::invalid_argument("GCM: input too long");
+        if (n_blocks == 0) return 0;
+
+        const Byte* text = m_encrypting ? output : input;
+        constexpr size_t batch = 64;
+        auto ranges = split_work(n_blocks, threads);
+        std::vector<internal::CacheAligned<GHash::Block>> partial(ranges.size());
+        partial[0].value = m_tag;
+
+        internal::run_ranges(ranges, [&](size_t t, size_t start, size_t end) {
+          for (size_t b0 = start; b0 < end; b0 += batch) {
+            const size_t b1 = std::min(end, b0 + batch);
+            for (size_t b = b0; b < b1; ++b) {
+              const Bytes ks = keystream(m_blocks + b + 1);
+              for (size_t i = 0; i < bs; ++i)
+                output[b * bs + i] = input[b * bs + i] ^ ks[i];
+            }
+            m_ghash.absorb(partial[t].value, text + b0 * bs, b1 - b0);
+          }
+        });
+
+        m_tag = partial[0].value;
+        for (size_t t = 1; t < ranges.size(); ++t) {
+          m_tag = GHash::multiply(m_tag, m_ghash.power(ranges[t].second - ranges[t].first));
+          for (size_t i = 0; i < bs; ++i) m_tag[i] ^= partial[t].value[i];
+        }
+        m_blocks += n_blocks;
+        return n_blocks * bs;
+      }
+
+      size_t finish(const Byte* input, size_t len, Byte* output) override {
+        constexpr size_t bs = GHash::BLOCK_SIZE;
+        if (m_encrypting) {
+          const GHash::Block tag = final_tag(input, len, output);
+          std::copy(tag.begin(), tag.end(), output + len);
+          return len + tag.size();
+        }
+
+        if (len < GCM::TAG_SIZE)
+          throw std::invalid_argument("GCM: ciphertext shorter than tag");
+        const size_t data = len - GCM::TAG_SIZE;
+        const size_t whole = process(input, output, data / bs, 1);
+        const GHash::Block tag =
+            final_tag(input + whole, data - whole, output + whole);
+        if (!constant_time_equal(tag.data(), input + data, GCM::TAG_SIZE)) {
+          std::fill(output, output + data, 0x00);
+          throw std::invalid_argument("GCM: authentication tag mismatch");
+        }
+        return data;
+      }
+
+      // processes the last len < 16 bytes and returns the tag
+      GHash::Block final_tag(const Byte* input, size_t len, Byte* output) {
+        constexpr size_t bs = GHash::BLOCK_SIZE;
+        if (len != 0) {
+          const Bytes ks = keystream(m_blocks + 1);
+          for (size_t i = 0; i < len; ++i) output[i] = input[i] ^ ks[i];
+        }
+        m_ghash.absorb_padded(m_tag, m_encrypting ? output : input, len);
+        m_ghash.absorb_lengths(m_tag, m_aad_len, m_blocks * bs + len);
+
+        GHash::Block tag = m_tag;
+        const Bytes mask = keystream(0);
+        for (size_t i = 0; i < bs; ++i) tag[i] ^= mask[i];
+        return tag;
+      }
+
+    private:
+      static GHash::Block hash_key(const core::SymmetricCipher& cipher) {
+        constexpr size_t bs = GHash::BLOCK_SIZE;
+        if (cipher.block_size() != bs)
+          throw std::invalid_argument("GCM: cipher block size must be 16 bytes");
+        GHash::Block h{};
+        const Bytes enc_zero = cipher.encrypt_block(Bytes(bs, 0x00));
+        std::copy(enc_zero.begin(), enc_zero.end(), h.begin());
+        return h;
+      }
+
+      Bytes keystream(uint64_t index) const {
+        Bytes counter_block(m_j0.begin(), m_j0.end());
+        store_be32(counter_block.data() + 12,
+                   m_counter0 + static_cast<uint32_t>(index));
+        return m_cipher.encrypt_block(counter_block);
+      }
+
+      const core::SymmetricCipher& m_cipher;
+      bool m_encrypting;
+      GHash m_ghash;
+      GHash::Block m_j0{};
+      uint32_t m_counter0 = 0;
+      GHash::Block m_tag{};
+      size_t m_aad_len;
+      uint64_t m_blocks = 0;
+    };
+
+    // OCB3 over a message fed in whole blocks. Blocks are independent, so
+    // process splits them across threads like ECB, each worker deriving its
+    // starting offset from the Gray code; only the checksum fold and the
+    // final tag are serial. As with GCM, a decrypting stream holds back one
+    // block and checks the tag in finish.
+    class OcbStream final : public BlockStream {
+    public:
+      OcbStream(const core::SymmetricCipher& cipher, bool encrypting,
+                const Bytes& nonce, const Bytes& aad)
+          : m_cipher(cipher), m_encrypting(encrypting),
+            m_l_star(l_star(cipher)), m_l_dollar(LTable::dbl(m_l_star)),
+            m_table(LTable::dbl(m_l_dollar)), m_offset0(initial_offset(nonce)),
+            m_aad_sum(hash_aad(aad)) {}
+
+      size_t overhead() const override {
+        return m_encrypting ? LTable::BLOCK_SIZE : 0;
+      }
+
+      size_t held_blocks() const override { return m_encrypting ? 0 : 1; }
+
+      size_t process(const Byte* input, Byte* output, size_t n_blocks,
+                     size_t threads) override {
+        constexpr size_t bs = LTable::BLOCK_SIZE;
+        if (n_blocks == 0) return 0;
+
+        const Byte* plain = m_encrypting ? input : output;
+        auto ranges = split_work(n_blocks, threads);
+        std::vector<internal::CacheAligned<LTable::Block>> partial(ranges.size());
+
+        internal::run_ranges(ranges, [&](size_t t, size_t start, size_t end) {
+          LTable::Block offset = m_table.offset(m_blocks + start);
+          LTable::xor_into(offset, m_offset0.data());
+          Bytes block(bs);
+          for (size_t b = start; b < end; ++b) {
+            LTable::xor_into(offset, m_table[LTable::ntz(m_blocks + b + 1)].data());
+            for (size_t i = 0; i < bs; ++i) block[i] = input[b * bs + i] ^ offset[i];
+            block = m_encrypting ? m_cipher.encrypt_block(block)
+                                 : m_cipher.decrypt_block(block);
+            for (size_t i = 0; i < bs; ++i) output[b * bs + i] = block[i] ^ offset[i];
+            LTable::xor_into(partial[t].value, plain + b * bs);
+          }
+        });
+
+        for (const auto& p : partial) LTable::xor_into(m_checksum, p.value.data());
+        m_blocks += n_blocks;
+        return n_blocks * bs;
+      }
+
+      size_t finish(const Byte* input, size_t len, Byte* output) override {
+        constexpr size_t bs = LTable::BLOCK_SIZE;
+        if (m_encrypting) {
+          const LTable::Block tag = final_tag(input, len, output);
+          std::copy(tag.begin(), tag.end(), output + len);
+          return len + tag.size();
+        }
+
+        if (len < OCB::TAG_SIZE)
+          throw std::invalid_argument("OCB: ciphertext shorter than tag");
+        const size_t data = len - OCB::TAG_SIZE;
+        const size_t whole = process(input, output, data / bs, 1);
+        const LTable::Block tag =
+            final_tag(input + whole, data - whole, output + whole);
+        if (!constant_time_equal(tag.data(), input + data, OCB::TAG_SIZE)) {
+          std::fill(output, output + data, 0x00);
+          throw std::invalid_argument("OCB: authentication tag mismatch");
+        }
+        return data;
+      }
+
+      // processes the last len < 16 bytes and returns the tag
+      LTable::Block final_tag(const Byte* input, size_t len, Byte* output) {
+        constexpr size_t bs = LTable::BLOCK_SIZE;
+        LTable::Block offset = m_table.offset(m_blocks);
+        LTable::xor_into(offset, m_offset0.data());
+
+        if (len != 0) {
+          LTable::xor_into(offset, m_l_star.data());
+          const Bytes pad = m_cipher.encrypt_block(Bytes(offset.begin(), offset.end()));
+          for (size_t i = 0; i < len; ++i) output[i] = input[i] ^ pad[i];
+          const Byte* plain = m_encrypting ? input : output;
+          for (size_t i = 0; i < len; ++i) m_checksum[i] ^= plain[i];
+          m_checksum[len] ^= 0x80;
+        }
+
+        Bytes final_block(bs);
+        for (size_t i = 0; i < bs; ++i)
+          final_block[i] = m_checksum[i] ^ offset[i] ^ m_l_dollar[i];
+        const Bytes enc_final = m_cipher.encrypt_block(final_block);
+
+        LTable::Block tag = m_aad_sum;
+        LTable::xor_into(tag, enc_final.data());
+        return tag;
+      }
+
+    private:
+      static LTable::Block l_star(const core::SymmetricCipher& cipher) {
+        constexpr size_t bs = LTable::BLOCK_SIZE;
+        if (cipher.block_size() != bs)
+          throw std::invalid_argument("OCB: cipher block size must be 16 bytes");
+        LTable::Block l{};
+        const Bytes enc_zero = cipher.encrypt_block(Bytes(bs, 0x00));
+        std::copy(enc_zero.begin(), enc_zero.end(), l.begin());
+        return l;
+      }
+
+      LTable::Block initial_offset(const Bytes& nonce) const {
+        constexpr size_t bs = LTable::BLOCK_SIZE;
+        Bytes nonce_block(bs, 0x00);
+        std::copy(nonce.begin(), nonce.end(), nonce_block.end() - nonce.size());
+        nonce_block[bs - 1 - nonce.size()] |= 0x01;
+
+        const size_t bottom = nonce_block[bs - 1] & 0x3F;
+        nonce_block[bs - 1] &= 0xC0;
+        const Bytes ktop = m_cipher.encrypt_block(nonce_block);
+
+        Byte stretch[bs + 8];
+        std::copy(ktop.begin(), ktop.end(), stretch);
+        for (size_t i = 0; i < 8; ++i) stretch[bs + i] = ktop[i] ^ ktop[i + 1];
+
+        LTable::Block offset{};
+        const size_t byte_shift = bottom / 8;
+        const size_t bit_shift = bottom % 8;
+        for (size_t i = 0; i < bs; ++i) {
+          offset[i] = static_cast<Byte>(stretch[i + byte_shift] << bit_shift);
+          if (bit_shift != 0)
+            offset[i] |= static_cast<Byte>(stretch[i + byte_shift + 1] >> (8 - bit_shift));
+        }
+        return offset;
+      }
+
+      LTable::Block hash_aad(const Bytes& aad) const {
+        constexpr size_t bs = LTable::BLOCK_SIZE;
+        const size_t n_blocks = aad.size() / bs;
+
+        LTable::Block sum{}, offset{};
+        Bytes block(bs);
+        for (size_t b = 0; b < n_blocks; ++b) {
+          LTable::xor_into(offset, m_table[LTable::ntz(b + 1)].data());
+          for (size_t i = 0; i < bs; ++i) block[i] = aad[b * bs + i] ^ offset[i];
+          LTable::xor_into(sum, m_cipher.encrypt_block(block).data());
+        }
+
+        const size_t tail = aad.size() % bs;
+        if (tail != 0) {
+          LTable::xor_into(offset, m_l_star.data());
+          std::fill(block.begin(), block.end(), 0x00);
+          std::copy(aad.begin() + n_blocks * bs, aad.end(), block.begin());
+          block[tail] = 0x80;
+          for (size_t i = 0; i < bs; ++i) block[i] ^= offset[i];
+          LTable::xor_into(sum, m_cipher.encrypt_block(block).data());
+        }
+        return sum;
+      }
+
+      const core::SymmetricCipher& m_cipher;
+      bool m_encrypting;
+      LTable::Block m_l_star;
+      LTable::Block m_l_dollar;
+      LTable m_table;
+      LTable::Block m_offset0;
+      LTable::Block m_aad_sum;
+      LTable::Block m_checksum{};
+      uint64_t m_blocks = 0;
+    };
   } // namespace
 
-  void ECB::encrypt(core::SymmetricCipher& cipher, const Bytes& input,
-                    Bytes& output, size_t threads) {
-    process(cipher, input, output, threads, true);
+  void ECB::encrypt(const core::SymmetricCipher& cipher, const Bytes& input,
+                    Bytes& output, size_t threads) const {
+    if (input.size() % cipher.block_size() != 0) {
+      throw std::invalid_argument("ECB: input not block-aligned");
+    }
+    process(cipher, input, {}, output, threads, true);
+  }
+
+  void ECB::decrypt(const core::SymmetricCipher& cipher, const Bytes& input,
+                    Bytes& output, size_t threads) const {
+    if (input.size() % cipher.block_size() != 0) {
+      throw std::invalid_argument("ECB: input not block-aligned");
+    }
+    process(cipher, input, {}, output, threads, false);
   }
 
-  void ECB::decrypt(core::SymmetricCipher& cipher, const Bytes& input,
-                    Bytes& output, size_t threads) {
-    process(cipher, input, output, threads, false);
+  void ECB::encrypt_padded(const core::SymmetricCipher& cipher, const Bytes& input,
+                           const Bytes& tail, Bytes& output, size_t threads) const {
+    process(cipher, input, tail, output, threads, true);
   }
 
-  void ECB::process(core::SymmetricCipher& cipher, const Bytes& input,
-                    Bytes& output, size_t threads, bool encrypting) {
+  void ECB::process(const core::SymmetricCipher& cipher, const Bytes& input,
+                    const Bytes& tail, Bytes& output, size_t threads,
+                    bool encrypting) {
     const size_t bs = cipher.block_size();
-    if (input.size() % bs != 0) {
-      throw std::invalid_argument("ECB: input not block-aligned");
-    }
-    const size_t n_blocks = input.size() / bs;
-    output.resize(input.size());
+    const size_t n_blocks = padded_block_count(input, tail, bs, "ECB");
+    output.resize(n_blocks * bs);
 
     auto ranges = split_work(n_blocks, threads);
     std::vector<std::thread> workers;
@@ -82,8 +826,7 @@ namespace crypto::mode {
     for (auto [start, end] : ranges) {
       workers.emplace_back([&, start, end]() {
         for (size_t b = start; b < end; ++b) {
-          Bytes block(input.begin() + b * bs,
-                            input.begin() + (b + 1) * bs);
+          Bytes block = padded_block(input, tail, b, bs);
           Bytes result = encrypting
                                  ? cipher.encrypt_block(block)
                                  : cipher.decrypt_block(block);
@@ -94,24 +837,33 @@ namespace crypto::mode {
     for (auto& w : workers) { w.join(); }
   }
 
+  std::unique_ptr<BlockStream> ECB::stream(const core::SymmetricCipher& cipher,
+                                           bool encrypting) const {
+    return std::make_unique<EcbStream>(cipher, encrypting);
+  }
+
   CBC::CBC(Bytes iv) : m_iv(std::move(iv)) {}
 
   Bytes CBC::get_iv(size_t bs) const {
     return validated_iv(m_iv, bs, "CBC");
   }
 
-  void CBC::encrypt(core::SymmetricCipher& cipher, const Bytes& input,
-                    Bytes& output, size_t) {
-    const size_t bs = cipher.block_size();
-    if (input.size() % bs != 0)
+  void CBC::encrypt(const core::SymmetricCipher& cipher, const Bytes& input,
+                    Bytes& output, size_t threads) const {
+    if (input.size() % cipher.block_size() != 0)
       throw std::invalid_argument("CBC: input not block-aligned");
+    encrypt_padded(cipher, input, {}, output, threads);
+  }
 
+  void CBC::encrypt_padded(const core::SymmetricCipher& cipher, const Bytes& input,
+                           const Bytes& tail, Bytes& output, size_t) const {
+    const size_t bs = cipher.block_size();
     Bytes iv = get_iv(bs);
-    const size_t n_blocks = input.size() / bs;
-    output.resize(input.size());
+    const size_t n_blocks = padded_block_count(input, tail, bs, "CBC");
+    output.resize(n_blocks * bs);
 
     for (size_t b = 0; b < n_blocks; ++b) {
-      Bytes block(input.begin() + b * bs, input.begin() + (b + 1) * bs);
+      Bytes block = padded_block(input, tail, b, bs);
       block = xor_blocks(block, iv);
       Bytes enc = cipher.encrypt_block(block);
       std::copy(enc.begin(), enc.end(), output.begin() + b * bs);
@@ -119,8 +871,8 @@ namespace crypto::mode {
     }
   }
 
-  void CBC::decrypt(core::SymmetricCipher& cipher, const Bytes& input,
-                    Bytes& output, size_t threads) {
+  void CBC::decrypt(const core::SymmetricCipher& cipher, const Bytes& input,
+                    Bytes& output, size_t threads) const {
     const size_t bs = cipher.block_size();
     if (input.size() % bs != 0)
       throw std::invalid_argument("CBC: input not block-aligned");
@@ -152,32 +904,144 @@ namespace crypto::mode {
     for (auto& w : workers) w.join();
   }
 
+  std::unique_ptr<BlockStream> CBC::stream(const core::SymmetricCipher& cipher,
+                                           bool encrypting) const {
+    return std::make_unique<ChainStream>(cipher, encrypting, Chaining::CBC,
+                                         get_iv(cipher.block_size()));
+  }
+
+  CTS::CTS(Bytes iv) : m_iv(std::move(iv)) {}
+
+  Bytes CTS::get_iv(size_t bs) const {
+    return validated_iv(m_iv, bs, "CTS");
+  }
+
+  bool CTS::requires_padding() const { return false; }
+
+  std::unique_ptr<BlockStream> CTS::stream(const core::SymmetricCipher& cipher,
+                                           bool encrypting) const {
+    return std::make_unique<CtsStream>(cipher, encrypting,
+                                       get_iv(cipher.block_size()));
+  }
+
+  void CTS::encrypt(const core::SymmetricCipher& cipher, const Bytes& input,
+                    Bytes& output, size_t) const {
+    const size_t bs = cipher.block_size();
+    if (input.size() < bs)
+      throw std::invalid_argument("CTS: input shorter than one block");
+
+    const size_t n_blocks = (input.size() + bs - 1) / bs;
+    const size_t tail = input.size() - (n_blocks - 1) * bs;
+    output.resize(input.size());
+
+    Bytes iv = get_iv(bs);
+    Bytes block(bs);
+    for (size_t b = 0; b + 1 < n_blocks; ++b) {
+      for (size_t i = 0; i < bs; ++i) block[i] = input[b * bs + i] ^ iv[i];
+      iv = cipher.encrypt_block(block);
+      if (b + 2 < n_blocks)
+        std::copy(iv.begin(), iv.end(), output.begin() + b * bs);
+    }
+    if (n_blocks == 1) {
+      for (size_t i = 0; i < bs; ++i) block[i] = input[i] ^ iv[i];
+      iv = cipher.encrypt_block(block);
+      std::copy(iv.begin(), iv.end(), output.begin());
+      return;
+    }
+
+    // iv now holds the full penultimate block; the last plaintext block is
+    // zero-padded, chained to it, and the two are emitted in swapped order
+    const size_t last = (n_blocks - 1) * bs;
+    for (size_t i = 0; i < bs; ++i)
+      block[i] = (i < tail ? input[last + i] : 0) ^ iv[i];
+    Bytes enc = cipher.encrypt_block(block);
+    std::copy(enc.begin(), enc.end(), output.begin() + last - bs);
+    std::copy(iv.begin(), iv.begin() + tail, output.begin() + last);
+  }
+
+  void CTS::decrypt(const core::SymmetricCipher& cipher, const Bytes& input,
+                    Bytes& output, size_t threads) const {
+    const size_t bs = cipher.block_size();
+    if (input.size() < bs)
+      throw std::invalid_argument("CTS: input shorter than one block");
+
+    const size_t n_blocks = (input.size() + bs - 1) / bs;
+    const size_t tail = input.size() - (n_blocks - 1) * bs;
+    const Bytes iv = get_iv(bs);
+    output.resize(input.size());
+
+    auto chain = [&](size_t b) {
+      return b == 0 ? iv.data() : input.data() + (b - 1) * bs;
+    };
+
+    // everything before the swapped pair is plain CBC and decrypts in parallel
+    const size_t body = n_blocks == 1 ? 1 : n_blocks - 2;
+    auto ranges = split_work(body, threads);
+    std::vector<std::thread> workers;
+    workers.reserve(ranges.size());
+
+    for (auto [start, end] : ranges) {
+      workers.emplace_back([&, start, end]() {
+        for (size_t b = start; b < end; ++b) {
+          Bytes block(input.begin() + b * bs, input.begin() + (b + 1) * bs);
+          Bytes dec = cipher.decrypt_block(block);
+          const Byte* prev = chain(b);
+          for (size_t i = 0; i < bs; ++i) output[b * bs + i] = dec[i] ^ prev[i];
+        }
+      });
+    }
+    for (auto& w : workers) w.join();
+    if (n_blocks == 1) return;
+
+    const size_t last = (n_blocks - 1) * bs;
+    Bytes swapped(input.begin() + last - bs, input.begin() + last);
+    Bytes dec = cipher.decrypt_block(swapped);
+
+    // rebuild the full penultimate block from the stolen tail and the
+    // padding bytes recovered by decrypting the swapped block
+    Bytes penultimate(bs);
+    for (size_t i = 0; i < bs; ++i)
+      penultimate[i] = i < tail ? input[last + i] : dec[i];
+    for (size_t i = 0; i < tail; ++i)
+      output[last + i] = dec[i] ^ penultimate[i];
+
+    Bytes prev_plain = cipher.decrypt_block(penultimate);
+    const Byte* prev = chain(n_blocks - 2);
+    for (size_t i = 0; i < bs; ++i)
+      output[last - bs + i] = prev_plain[i] ^ prev[i];
+  }
+
   PCBC::PCBC(Bytes iv) : m_iv(std::move(iv)) {}
 
   Bytes PCBC::get_iv(size_t bs) const {
     return validated_iv(m_iv, bs, "PCBC");
   }
 
-  void PCBC::encrypt(core::SymmetricCipher& cipher, const Bytes& input,
-                     Bytes& output, size_t) {
-    const size_t bs = cipher.block_size();
-    if (input.size() % bs != 0) {
+  void PCBC::encrypt(const core::SymmetricCipher& cipher, const Bytes& input,
+                     Bytes& output, size_t threads) const {
+    if (input.size() % cipher.block_size() != 0) {
       throw std::invalid_argument("PCBC: input not block-aligned");
     }
+    encrypt_padded(cipher, input, {}, output, threads);
+  }
+
+  void PCBC::encrypt_padded(const core::SymmetricCipher& cipher, const Bytes& input,
+                            const Bytes& tail, Bytes& output, size_t) const {
+    const size_t bs = cipher.block_size();
     Bytes iv = get_iv(bs);
-    const size_t n_blocks = input.size() / bs;
-    output.resize(input.size());
+    const size_t n_blocks = padded_block_count(input, tail, bs, "PCBC");
+    output.resize(n_blocks * bs);
 
     for (size_t b = 0; b < n_blocks; ++b) {
-      Bytes plain(input.begin() + b * bs, input.begin() + (b + 1) * bs);
+      Bytes plain = padded_block(input, tail, b, bs);
       Bytes enc = cipher.encrypt_block(xor_blocks(plain, iv));
       std::copy(enc.begin(), enc.end(), output.begin() + b * bs);
       iv = xor_blocks(plain, enc);
     }
   }
 
-  void PCBC::decrypt(core::SymmetricCipher& cipher, const Bytes& input,
-                     Bytes& output, size_t) {
+  void PCBC::decrypt(const core::SymmetricCipher& cipher, const Bytes& input,
+                     Bytes& output, size_t) const {
     const size_t bs = cipher.block_size();
     if (input.size() % bs != 0)
       throw std::invalid_argument("PCBC: input not block-aligned");
@@ -195,32 +1059,42 @@ namespace crypto::mode {
     }
   }
 
+  std::unique_ptr<BlockStream> PCBC::stream(const core::SymmetricCipher& cipher,
+                                            bool encrypting) const {
+    return std::make_unique<ChainStream>(cipher, encrypting, Chaining::PCBC,
+                                         get_iv(cipher.block_size()));
+  }
+
   CFB::CFB(Bytes iv) : m_iv(std::move(iv)) {}
 
   Bytes CFB::get_iv(size_t bs) const {
     return validated_iv(m_iv, bs, "CFB");
   }
 
-  void CFB::encrypt(core::SymmetricCipher& cipher, const Bytes& input,
-                    Bytes& output, size_t) {
-    const size_t bs = cipher.block_size();
-    if (input.size() % bs != 0)
+  void CFB::encrypt(const core::SymmetricCipher& cipher, const Bytes& input,
+                    Bytes& output, size_t threads) const {
+    if (input.size() % cipher.block_size() != 0)
       throw std::invalid_argument("CFB: input not block-aligned");
+    encrypt_padded(cipher, input, {}, output, threads);
+  }
 
+  void CFB::encrypt_padded(const core::SymmetricCipher& cipher, const Bytes& input,
+                           const Bytes& tail, Bytes& output, size_t) const {
+    const size_t bs = cipher.block_size();
     Bytes iv = get_iv(bs);
-    const size_t n_blocks = input.size() / bs;
-    output.resize(input.size());
+    const size_t n_blocks = padded_block_count(input, tail, bs, "CFB");
+    output.resize(n_blocks * bs);
 
     for (size_t b = 0; b < n_blocks; ++b) {
-      Bytes plain(input.begin() + b * bs, input.begin() + (b + 1) * bs);
+      Bytes plain = padded_block(input, tail, b, bs);
       Bytes enc = xor_blocks(cipher.encrypt_block(iv), plain);
       std::copy(enc.begin(), enc.end(), output.begin() + b * bs);
       iv = enc;
     }
   }
 
-  void CFB::decrypt(core::SymmetricCipher& cipher, const Bytes& input,
-                    Bytes& output, size_t) {
+  void CFB::decrypt(const core::SymmetricCipher& cipher, const Bytes& input,
+                    Bytes& output, size_t) const {
     const size_t bs = cipher.block_size();
     if (input.size() % bs != 0)
       throw std::invalid_argument("CFB: input not block-aligned");
@@ -238,44 +1112,62 @@ namespace crypto::mode {
     }
   }
 
+  std::unique_ptr<BlockStream> CFB::stream(const core::SymmetricCipher& cipher,
+                                           bool encrypting) const {
+    return std::make_unique<ChainStream>(cipher, encrypting, Chaining::CFB,
+                                         get_iv(cipher.block_size()));
+  }
+
   OFB::OFB(Bytes iv) : m_iv(std::move(iv)) {}
 
   Bytes OFB::get_iv(size_t bs) const {
     return validated_iv(m_iv, bs, "OFB");
   }
 
-  void OFB::process(core::SymmetricCipher& cipher, const Bytes& iv,
-                    const Bytes& input, Bytes& output) {
+  void OFB::process(const core::SymmetricCipher& cipher, const Bytes& iv,
+                    const Bytes& input, const Bytes& tail, Bytes& output) {
     const size_t bs = cipher.block_size();
-    const size_t n_blocks = input.size() / bs;
-    output.resize(input.size());
+    const size_t n_blocks = padded_block_count(input, tail, bs, "OFB");
+    output.resize(n_blocks * bs);
 
     Bytes keystream = iv;
     for (size_t b = 0; b < n_blocks; ++b) {
       keystream = cipher.encrypt_block(keystream);
-      Bytes plain(input.begin() + b * bs, input.begin() + (b + 1) * bs);
+      Bytes plain = padded_block(input, tail, b, bs);
       Bytes out_block = xor_blocks(plain, keystream);
       std::copy(out_block.begin(), out_block.end(), output.begin() + b * bs);
     }
   }
 
-  void OFB::encrypt(core::SymmetricCipher& cipher, const Bytes& input,
-                    Bytes& output, size_t) {
+  void OFB::encrypt(const core::SymmetricCipher& cipher, const Bytes& input,
+                    Bytes& output, size_t) const {
     const size_t bs = cipher.block_size();
     if (input.size() % bs != 0)
       throw std::invalid_argument("OFB: input not block-aligned");
-    process(cipher, get_iv(bs), input, output);
+    process(cipher, get_iv(bs), input, {}, output);
+  }
+
+  void OFB::encrypt_padded(const core::SymmetricCipher& cipher, const Bytes& input,
+                           const Bytes& tail, Bytes& output, size_t) const {
+    process(cipher, get_iv(cipher.block_size()), input, tail, output);
   }
 
-  void OFB::decrypt(core::SymmetricCipher& cipher, const Bytes& input,
-                    Bytes& output, size_t) {
+  void OFB::decrypt(const core::SymmetricCipher& cipher, const Bytes& input,
+                    Bytes& output, size_t) const {
     const size_t bs = cipher.block_size();
     if (input.size() % bs != 0)
       throw std::invalid_argument("OFB: input not block-aligned");
-    process(cipher, get_iv(bs), input, output);
+    process(cipher, get_iv(bs), input, {}, output);
+  }
+
+  std::unique_ptr<BlockStream> OFB::stream(const core::SymmetricCipher& cipher,
+                                           bool encrypting) const {
+    return std::make_unique<ChainStream>(cipher, encrypting, Chaining::OFB,
+                                         get_iv(cipher.block_size()));
   }
 
-  CTR::CTR(Bytes nonce) : m_nonce(std::move(nonce)) {}
+  CTR::CTR(Bytes nonce, uint64_t first_counter)
+      : m_nonce(std::move(nonce)), m_first_counter(first_counter) {}
 
   Bytes CTR::make_counter_block(const Bytes& nonce,
                                       uint64_t counter, size_t bs) {
@@ -295,14 +1187,11 @@ namespace crypto::mode {
     return block;
   }
 
-  void CTR::process(core::SymmetricCipher& cipher, const Bytes& input,
-                    Bytes& output, size_t threads) const {
+  void CTR::process(const core::SymmetricCipher& cipher, const Bytes& input,
+                    const Bytes& tail, Bytes& output, size_t threads) const {
     const size_t bs = cipher.block_size();
-    if (input.size() % bs != 0)
-      throw std::invalid_argument("CTR: input not block-aligned");
-
-    const size_t n_blocks = input.size() / bs;
-    output.resize(input.size());
+    const size_t n_blocks = padded_block_count(input, tail, bs, "CTR");
+    output.resize(n_blocks * bs);
 
     auto ranges = split_work(n_blocks, threads);
     std::vector<std::thread> workers;
@@ -311,10 +1200,9 @@ namespace crypto::mode {
     for (auto [start, end] : ranges) {
       workers.emplace_back([&, start, end]() {
         for (size_t b = start; b < end; ++b) {
-          Bytes counter_block = make_counter_block(m_nonce, b, bs);
+          Bytes counter_block = make_counter_block(m_nonce, m_first_counter + b, bs);
           Bytes keystream = cipher.encrypt_block(counter_block);
-          Bytes plain(input.begin() + b * bs,
-                            input.begin() + (b + 1) * bs);
+          Bytes plain = padded_block(input, tail, b, bs);
           Bytes out_block = xor_blocks(plain, keystream);
           std::copy(out_block.begin(), out_block.end(),
                     output.begin() + b * bs);
@@ -324,39 +1212,55 @@ namespace crypto::mode {
     for (auto& w : workers) w.join();
   }
 
-  void CTR::encrypt(core::SymmetricCipher& cipher, const Bytes& input,
-                    Bytes& output, size_t threads) {
-    process(cipher, input, output, threads);
+  void CTR::encrypt(const core::SymmetricCipher& cipher, const Bytes& input,
+                    Bytes& output, size_t threads) const {
+    if (input.size() % cipher.block_size() != 0)
+      throw std::invalid_argument("CTR: input not block-aligned");
+    process(cipher, input, {}, output, threads);
+  }
+
+  void CTR::decrypt(const core::SymmetricCipher& cipher, const Bytes& input,
+                    Bytes& output, size_t threads) const {
+    if (input.size() % cipher.block_size() != 0)
+      throw std::invalid_argument("CTR: input not block-aligned");
+    process(cipher, input, {}, output, threads);
   }
 
-  void CTR::decrypt(core::SymmetricCipher& cipher, const Bytes& input,
-                    Bytes& output, size_t threads) {
-    process(cipher, input, output, threads);
+  void CTR::encrypt_padded(const core::SymmetricCipher& cipher, const Bytes& input,
+                           const Bytes& tail, Bytes& output, size_t threads) const {
+    process(cipher, input, tail, output, threads);
   }
 
 
+  std::unique_ptr<BlockStream> CTR::stream(const core::SymmetricCipher& cipher,
+                                           bool) const {
+    return std::make_unique<CtrStream>(
+        cipher, make_counter_block(m_nonce, 0, cipher.block_size()),
+        m_first_counter);
+  }
+
   RD::RD(uint64_t seed) : m_seed(seed) {}
 
-  void RD::encrypt(core::SymmetricCipher& cipher,
+  void RD::encrypt(const core::SymmetricCipher& cipher,
                    const Bytes& input,
                    Bytes& output,
-                   size_t) {
-    const size_t bs = cipher.block_size();
-
-    if (input.size() % bs != 0)
+                   size_t threads) const {
+    if (input.size() % cipher.block_size() != 0)
       throw std::invalid_argument("RandomDelta: input not block-aligned");
+    encrypt_padded(cipher, input, {}, output, threads);
+  }
 
-    const size_t n_blocks = input.size() / bs;
-
-    std::mt19937_64 rng(m_seed != 0
-                          ? m_seed
-                          : static_cast<uint64_t>(std::random_device{}()));
-
-    Bytes initial(bs);
-    for (auto& byte : initial)
-      byte = static_cast<uint8_t>(rng() & 0xFF);
+  void RD::encrypt_padded(const core::SymmetricCipher& cipher,
+                          const Bytes& input,
+                          const Bytes& tail,
+                          Bytes& output,
+                          size_t) const {
+    const size_t bs = cipher.block_size();
+    const size_t n_blocks = padded_block_count(input, tail, bs, "RandomDelta");
 
-    const uint64_t delta = rng();
+    Bytes initial;
+    uint64_t delta = 0;
+    rd_initial_values(m_seed, bs, initial, delta);
 
     Bytes delta_block(bs, 0);
     for (size_t i = 0; i < 8 && i < bs; ++i)
@@ -374,7 +1278,7 @@ namespace crypto::mode {
     for (size_t b = 0; b < n_blocks; ++b) {
       add_to_block(counter, delta);
 
-      Bytes plain(input.begin() + b * bs, input.begin() + (b + 1) * bs);
+      Bytes plain = padded_block(input, tail, b, bs);
       Bytes masked = xor_blocks(plain, counter);
       Bytes enc = cipher.encrypt_block(masked);
 
@@ -382,10 +1286,10 @@ namespace crypto::mode {
     }
   }
 
-  void RD::decrypt(core::SymmetricCipher& cipher,
+  void RD::decrypt(const core::SymmetricCipher& cipher,
                    const Bytes& input,
                    Bytes& output,
-                   size_t) {
+                   size_t) const {
     const size_t bs = cipher.block_size();
 
     if (input.size() < 3 * bs || input.size() % bs != 0)
@@ -416,4 +1320,243 @@ namespace crypto::mode {
       std::copy(plain.begin(), plain.end(), output.begin() + b * bs);
     }
   }
+
+  std::unique_ptr<BlockStream> RD::stream(const core::SymmetricCipher& cipher,
+                                          bool encrypting) const {
+    return std::make_unique<RdStream>(cipher, encrypting, m_seed);
+  }
+
+  GCM::GCM(Bytes iv, Bytes aad) : m_iv(std::move(iv)), m_aad(std::move(aad)) {
+    if (m_iv.empty())
+      throw std::invalid_argument("GCM: an IV is required");
+  }
+
+  bool GCM::requires_padding() const { return false; }
+
+  GHash::Block GCM::process(const core::SymmetricCipher& cipher, const Byte* input,
+                            size_t len, Byte* output, size_t threads,
+                            bool encrypting) const {
+    constexpr size_t bs = GHash::BLOCK_SIZE;
+    GcmStream stream(cipher, encrypting, m_iv, m_aad);
+    const size_t n_blocks = len / bs;
+    stream.process(input, output, n_blocks, threads);
+    return stream.final_tag(input + n_blocks * bs, len % bs, output + n_blocks * bs);
+  }
+
+  std::unique_ptr<BlockStream> GCM::stream(const core::SymmetricCipher& cipher,
+                                           bool encrypting) const {
+    return std::make_unique<GcmStream>(cipher, encrypting, m_iv, m_aad);
+  }
+
+  void GCM::encrypt(const core::SymmetricCipher& cipher, const Bytes& input,
+                    Bytes& output, size_t threads) const {
+    output.resize(input.size() + TAG_SIZE);
+    const GHash::Block tag = process(cipher, input.data(), input.size(),
+                                     output.data(), threads, true);
+    std::copy(tag.begin(), tag.end(), output.begin() + input.size());
+  }
+
+  void GCM::decrypt(const core::SymmetricCipher& cipher, const Bytes& input,
+                    Bytes& output, size_t threads) const {
+    if (input.size() < TAG_SIZE)
+      throw std::invalid_argument("GCM: ciphertext shorter than tag");
+
+    const size_t len = input.size() - TAG_SIZE;
+    output.resize(len);
+    const GHash::Block tag = process(cipher, input.data(), len,
+                                     output.data(), threads, false);
+    if (!constant_time_equal(tag.data(), input.data() + len, TAG_SIZE)) {
+      std::fill(output.begin(), output.end(), 0x00);
+      output.clear();
+      throw std::invalid_argument("GCM: authentication tag mismatch");
+    }
+  }
+
+  XTS::XTS(const core::SymmetricCipher& tweak_cipher, size_t sector_size,
+           uint64_t first_sector)
+      : m_tweak_cipher(tweak_cipher), m_sector_size(sector_size),
+        m_first_sector(first_sector) {
+    if (sector_size < 16 || sector_size % 16 != 0)
+      throw std::invalid_argument("XTS: sector size must be a positive multiple of 16");
+  }
+
+  size_t XTS::sector_size() const { return m_sector_size; }
+
+  bool XTS::requires_padding() const { return false; }
+
+  std::unique_ptr<BlockStream> XTS::stream(const core::SymmetricCipher& cipher,
+                                           bool encrypting) const {
+    return std::make_unique<XtsStream>(cipher, m_tweak_cipher, m_sector_size,
+                                       m_first_sector, encrypting);
+  }
+
+  void XTS::encrypt(const core::SymmetricCipher& cipher, const Bytes& input,
+                    Bytes& output, size_t threads) const {
+    process_sectors(cipher, m_first_sector, input, output, threads, true);
+  }
+
+  void XTS::decrypt(const core::SymmetricCipher& cipher, const Bytes& input,
+                    Bytes& output, size_t threads) const {
+    process_sectors(cipher, m_first_sector, input, output, threads, false);
+  }
+
+  void XTS::encrypt_sectors(const core::SymmetricCipher& cipher, uint64_t first_sector,
+                            const Bytes& input, Bytes& output,
+                            size_t threads) const {
+    process_sectors(cipher, first_sector, input, output, threads, true);
+  }
+
+  void XTS::decrypt_sectors(const core::SymmetricCipher& cipher, uint64_t first_sector,
+                            const Bytes& input, Bytes& output,
+                            size_t threads) const {
+    process_sectors(cipher, first_sector, input, output, threads, false);
+  }
+
+  void XTS::process_sectors(const core::SymmetricCipher& cipher, uint64_t first_sector,
+                            const Bytes& input, Bytes& output, size_t threads,
+                            bool encrypting) const {
+    constexpr size_t bs = 16;
+    if (cipher.block_size() != bs || m_tweak_cipher.block_size() != bs)
+      throw std::invalid_argument("XTS: cipher block size must be 16 bytes");
+
+    if (input.size() < bs)
+      throw std::invalid_argument("XTS: input shorter than one block");
+    const size_t n_sectors = (input.size() + m_sector_size - 1) / m_sector_size;
+    const size_t last_len = input.size() - (n_sectors - 1) * m_sector_size;
+    if (last_len < bs)
+      throw std::invalid_argument("XTS: data unit shorter than one block");
+
+    output.resize(input.size());
+
+    auto ranges = split_work(n_sectors, threads);
+    std::vector<std::thread> workers;
+    workers.reserve(ranges.size());
+
+    for (auto [start, end] : ranges) {
+      workers.emplace_back([&, start, end]() {
+        for (size_t s = start; s < end; ++s) {
+          const size_t offset = s * m_sector_size;
+          const size_t len = std::min(m_sector_size, input.size() - offset);
+          process_sector(cipher, first_sector + s, input.data() + offset,
+                         output.data() + offset, len, encrypting);
+        }
+      });
+    }
+    for (auto& w : workers) w.join();
+  }
+
+  void XTS::process_sector(const core::SymmetricCipher& cipher, uint64_t sector,
+                           const Byte* input, Byte* output, size_t len,
+                           bool encrypting) const {
+    constexpr size_t bs = 16;
+
+    Bytes tweak_block(bs, 0x00);
+    for (size_t i = 0; i < 8; ++i)
+      tweak_block[i] = static_cast<Byte>((sector >> (i * 8)) & 0xFF);
+    tweak_block = m_tweak_cipher.encrypt_block(tweak_block);
+
+    // tweak as a little-endian 128-bit integer, multiplied by alpha per block
+    uint64_t t_lo = 0, t_hi = 0;
+    for (size_t i = 0; i < 8; ++i) {
+      t_lo |= static_cast<uint64_t>(tweak_block[i]) << (i * 8);
+      t_hi |= static_cast<uint64_t>(tweak_block[i + 8]) << (i * 8);
+    }
+    auto next_tweak = [&]() {
+      const uint64_t carry = t_hi >> 63;
+      t_hi = (t_hi << 1) | (t_lo >> 63);
+      t_lo = (t_lo << 1) ^ (carry * 0x87);
+    };
+    auto apply = [&](const Byte* in, Byte* out, uint64_t lo, uint64_t hi) {
+      Bytes block(bs);
+      for (size_t i = 0; i < 8; ++i) {
+        block[i] = in[i] ^ static_cast<Byte>(lo >> (i * 8));
+        block[i + 8] = in[i + 8] ^ static_cast<Byte>(hi >> (i * 8));
+      }
+      block = encrypting ? cipher.encrypt_block(block) : cipher.decrypt_block(block);
+      for (size_t i = 0; i < 8; ++i) {
+        out[i] = block[i] ^ static_cast<Byte>(lo >> (i * 8));
+        out[i + 8] = block[i + 8] ^ static_cast<Byte>(hi >> (i * 8));
+      }
+    };
+
+    const size_t tail = len % bs;
+    const size_t n_full = len / bs;
+    const size_t plain_blocks = tail == 0 ? n_full : n_full - 1;
+
+    for (size_t b = 0; b < plain_blocks; ++b) {
+      apply(input + b * bs, output + b * bs, t_lo, t_hi);
+      next_tweak();
+    }
+    if (tail == 0) return;
+
+    // ciphertext stealing: the last full block and the partial block swap
+    // tweaks on decryption, since encryption processed them in order
+    const uint64_t prev_lo = t_lo, prev_hi = t_hi;
+    next_tweak();
+    const uint64_t last_lo = t_lo, last_hi = t_hi;
+
+    const size_t full = plain_blocks * bs;
+    Byte cc[bs];
+    if (encrypting) {
+      apply(input + full, cc, prev_lo, prev_hi);
+    } else {
+      apply(input + full, cc, last_lo, last_hi);
+    }
+    Byte pp[bs];
+    std::copy(input + full + bs, input + len, pp);
+    std::copy(cc + tail, cc + bs, pp + tail);
+    std::copy(cc, cc + tail, output + full + bs);
+    if (encrypting) {
+      apply(pp, output + full, last_lo, last_hi);
+    } else {
+      apply(pp, output + full, prev_lo, prev_hi);
+    }
+  }
+
+  OCB::OCB(Bytes nonce, Bytes aad)
+      : m_nonce(std::move(nonce)), m_aad(std::move(aad)) {
+    if (m_nonce.empty() || m_nonce.size() > 15)
+      throw std::invalid_argument("OCB: nonce must be 1 to 15 bytes");
+  }
+
+  bool OCB::requires_padding() const { return false; }
+
+  LTable::Block OCB::process(const core::SymmetricCipher& cipher, const Byte* input,
+                             size_t len, Byte* output, size_t threads,
+                             bool encrypting) const {
+    constexpr size_t bs = LTable::BLOCK_SIZE;
+    OcbStream stream(cipher, encrypting, m_nonce, m_aad);
+    const size_t n_blocks = len / bs;
+    stream.process(input, output, n_blocks, threads);
+    return stream.final_tag(input + n_blocks * bs, len % bs, output + n_blocks * bs);
+  }
+
+  std::unique_ptr<BlockStream> OCB::stream(const core::SymmetricCipher& cipher,
+                                           bool encrypting) const {
+    return std::make_unique<OcbStream>(cipher, encrypting, m_nonce, m_aad);
+  }
+
+  void OCB::encrypt(const core::SymmetricCipher& cipher, const Bytes& input,
+                    Bytes& output, size_t threads) const {
+    output.resize(input.size() + TAG_SIZE);
+    const LTable::Block tag = process(cipher, input.data(), input.size(),
+                                      output.data(), threads, true);
+    std::copy(tag.begin(), tag.end(), output.begin() + input.size());
+  }
+
+  void OCB::decrypt(const core::SymmetricCipher& cipher, const Bytes& input,
+                    Bytes& output, size_t threads) const {
+    if (input.size() < TAG_SIZE)
+      throw std::invalid_argument("OCB: ciphertext shorter than tag");
+
+    const size_t len = input.size() - TAG_SIZE;
+    output.resize(len);
+    const LTable::Block tag = process(cipher, input.data(), len,
+                                      output.data(), threads, false);
+    if (!constant_time_equal(tag.data(), input.data() + len, TAG_SIZE)) {
+      std::fill(output.begin(), output.end(), 0x00);
+      output.clear();
+      throw std::invalid_argument("OCB: authentication tag mismatch");
+    }
+  }
 } // namespace crypto::mode
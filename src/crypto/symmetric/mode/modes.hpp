@@ -2,28 +2,62 @@
 #define CRYPTO_MODE_MODES_HPP
 
 #include "symmetric/mode/cipher_mode.hpp"
+#include "symmetric/mode/ghash.hpp"
+#include "symmetric/mode/l_table.hpp"
 
 namespace crypto::mode {
 
 class ECB final : public SymmetricCipherMode {
 public:
-  void encrypt(core::SymmetricCipher &cipher, const Bytes &input,
-               Bytes &output, size_t threads) override;
-  void decrypt(core::SymmetricCipher &cipher, const Bytes &input,
-               Bytes &output, size_t threads) override;
+  void encrypt(const core::SymmetricCipher &cipher, const Bytes &input,
+               Bytes &output, size_t threads) const override;
+  void decrypt(const core::SymmetricCipher &cipher, const Bytes &input,
+               Bytes &output, size_t threads) const override;
+  void encrypt_padded(const core::SymmetricCipher &cipher, const Bytes &input,
+                      const Bytes &tail, Bytes &output,
+                      size_t threads) const override;
+  std::unique_ptr<BlockStream> stream(const core::SymmetricCipher &cipher,
+                                      bool encrypting) const override;
 
 private:
-  static void process(core::SymmetricCipher &cipher, const Bytes &input,
-                      Bytes &output, size_t threads, bool encrypting);
+  static void process(const core::SymmetricCipher &cipher, const Bytes &input,
+                      const Bytes &tail, Bytes &output, size_t threads,
+                      bool encrypting);
 };
 
 class CBC final : public SymmetricCipherMode {
 public:
   explicit CBC(Bytes iv = {});
-  void encrypt(core::SymmetricCipher &cipher, const Bytes &input,
-               Bytes &output, size_t threads) override;
-  void decrypt(core::SymmetricCipher &cipher, const Bytes &input,
-               Bytes &output, size_t threads) override;
+  void encrypt(const core::SymmetricCipher &cipher, const Bytes &input,
+               Bytes &output, size_t threads) const override;
+  void decrypt(const core::SymmetricCipher &cipher, const Bytes &input,
+               Bytes &output, size_t threads) const override;
+  void encrypt_padded(const core::SymmetricCipher &cipher, const Bytes &input,
+                      const Bytes &tail, Bytes &output,
+                      size_t threads) const override;
+  std::unique_ptr<BlockStream> stream(const core::SymmetricCipher &cipher,
+                                      bool encrypting) const override;
+
+private:
+  Bytes get_iv(size_t bs) const;
+  Bytes m_iv;
+};
+
+// CBC with ciphertext stealing, variant CS3 (NIST SP 800-38A addendum):
+// the ciphertext has the same length as the plaintext, which must be at least
+// one block long, and the last two ciphertext blocks are always swapped.
+// No padding is applied. The stream holds back the last two blocks, so
+// only they wait for the end of the message.
+class CTS final : public SymmetricCipherMode {
+public:
+  explicit CTS(Bytes iv = {});
+  void encrypt(const core::SymmetricCipher &cipher, const Bytes &input,
+               Bytes &output, size_t threads) const override;
+  void decrypt(const core::SymmetricCipher &cipher, const Bytes &input,
+               Bytes &output, size_t threads) const override;
+  bool requires_padding() const override;
+  std::unique_ptr<BlockStream> stream(const core::SymmetricCipher &cipher,
+                                      bool encrypting) const override;
 
 private:
   Bytes get_iv(size_t bs) const;
@@ -33,10 +67,15 @@ private:
 class PCBC final : public SymmetricCipherMode {
 public:
   explicit PCBC(Bytes iv = {});
-  void encrypt(core::SymmetricCipher &cipher, const Bytes &input,
-               Bytes &output, size_t threads) override;
-  void decrypt(core::SymmetricCipher &cipher, const Bytes &input,
-               Bytes &output, size_t threads) override;
+  void encrypt(const core::SymmetricCipher &cipher, const Bytes &input,
+               Bytes &output, size_t threads) const override;
+  void decrypt(const core::SymmetricCipher &cipher, const Bytes &input,
+               Bytes &output, size_t threads) const override;
+  void encrypt_padded(const core::SymmetricCipher &cipher, const Bytes &input,
+                      const Bytes &tail, Bytes &output,
+                      size_t threads) const override;
+  std::unique_ptr<BlockStream> stream(const core::SymmetricCipher &cipher,
+                                      bool encrypting) const override;
 
 private:
   Bytes get_iv(size_t bs) const;
@@ -46,10 +85,15 @@ private:
 class CFB final : public SymmetricCipherMode {
 public:
   explicit CFB(Bytes iv = {});
-  void encrypt(core::SymmetricCipher &cipher, const Bytes &input,
-               Bytes &output, size_t threads) override;
-  void decrypt(core::SymmetricCipher &cipher, const Bytes &input,
-               Bytes &output, size_t threads) override;
+  void encrypt(const core::SymmetricCipher &cipher, const Bytes &input,
+               Bytes &output, size_t threads) const override;
+  void decrypt(const core::SymmetricCipher &cipher, const Bytes &input,
+               Bytes &output, size_t threads) const override;
+  void encrypt_padded(const core::SymmetricCipher &cipher, const Bytes &input,
+                      const Bytes &tail, Bytes &output,
+                      size_t threads) const override;
+  std::unique_ptr<BlockStream> stream(const core::SymmetricCipher &cipher,
+                                      bool encrypting) const override;
 
 private:
   Bytes get_iv(size_t bs) const;
@@ -59,47 +103,163 @@ private:
 class OFB final : public SymmetricCipherMode {
 public:
   explicit OFB(Bytes iv = {});
-  void encrypt(core::SymmetricCipher &cipher, const Bytes &input,
-               Bytes &output, size_t threads) override;
-  void decrypt(core::SymmetricCipher &cipher, const Bytes &input,
-               Bytes &output, size_t threads) override;
+  void encrypt(const core::SymmetricCipher &cipher, const Bytes &input,
+               Bytes &output, size_t threads) const override;
+  void decrypt(const core::SymmetricCipher &cipher, const Bytes &input,
+               Bytes &output, size_t threads) const override;
+  void encrypt_padded(const core::SymmetricCipher &cipher, const Bytes &input,
+                      const Bytes &tail, Bytes &output,
+                      size_t threads) const override;
+  std::unique_ptr<BlockStream> stream(const core::SymmetricCipher &cipher,
+                                      bool encrypting) const override;
 
 private:
   Bytes get_iv(size_t bs) const;
-  static void process(core::SymmetricCipher &cipher, const Bytes &iv,
-                      const Bytes &input, Bytes &output);
+  static void process(const core::SymmetricCipher &cipher, const Bytes &iv,
+                      const Bytes &input, const Bytes &tail, Bytes &output);
   Bytes m_iv;
 };
 
+// The counter of block i is first_counter + i, so a message that continues
+// another at block n can be processed on its own with first_counter = n.
 class CTR final : public SymmetricCipherMode {
 public:
-  explicit CTR(Bytes nonce = {});
-  void encrypt(core::SymmetricCipher &cipher, const Bytes &input,
-               Bytes &output, size_t threads) override;
-  void decrypt(core::SymmetricCipher &cipher, const Bytes &input,
-               Bytes &output, size_t threads) override;
+  explicit CTR(Bytes nonce = {}, uint64_t first_counter = 0);
+  void encrypt(const core::SymmetricCipher &cipher, const Bytes &input,
+               Bytes &output, size_t threads) const override;
+  void decrypt(const core::SymmetricCipher &cipher, const Bytes &input,
+               Bytes &output, size_t threads) const override;
+  void encrypt_padded(const core::SymmetricCipher &cipher, const Bytes &input,
+                      const Bytes &tail, Bytes &output,
+                      size_t threads) const override;
+  std::unique_ptr<BlockStream> stream(const core::SymmetricCipher &cipher,
+                                      bool encrypting) const override;
 
 private:
-  void process(core::SymmetricCipher &cipher, const Bytes &input,
-               Bytes &output, size_t threads) const;
+  void process(const core::SymmetricCipher &cipher, const Bytes &input,
+               const Bytes &tail, Bytes &output, size_t threads) const;
   static Bytes make_counter_block(const Bytes &nonce, uint64_t counter,
                                         size_t bs);
   Bytes m_nonce;
+  uint64_t m_first_counter;
 };
 
-
 class RD final : public SymmetricCipherMode {
 public:
   explicit RD(uint64_t seed = 0);
-  void encrypt(core::SymmetricCipher &cipher, const Bytes &input,
-               Bytes &output, size_t threads) override;
-  void decrypt(core::SymmetricCipher &cipher, const Bytes &input,
-               Bytes &output, size_t threads) override;
+  void encrypt(const core::SymmetricCipher &cipher, const Bytes &input,
+               Bytes &output, size_t threads) const override;
+  void decrypt(const core::SymmetricCipher &cipher, const Bytes &input,
+               Bytes &output, size_t threads) const override;
+  void encrypt_padded(const core::SymmetricCipher &cipher, const Bytes &input,
+                      const Bytes &tail, Bytes &output,
+                      size_t threads) const override;
+  std::unique_ptr<BlockStream> stream(const core::SymmetricCipher &cipher,
+                                      bool encrypting) const override;
 
 private:
   uint64_t m_seed;
 };
 
+// Galois/Counter Mode for 128-bit block ciphers. The ciphertext is followed
+// by a 16-byte authentication tag; decrypt throws if the tag does not match.
+// The IV is required and must never repeat under one key. Input of any length
+// is encrypted as is, without padding.
+class GCM final : public SymmetricCipherMode {
+public:
+  static constexpr size_t TAG_SIZE = 16;
+
+  explicit GCM(Bytes iv, Bytes aad = {});
+  void encrypt(const core::SymmetricCipher &cipher, const Bytes &input,
+               Bytes &output, size_t threads) const override;
+  void decrypt(const core::SymmetricCipher &cipher, const Bytes &input,
+               Bytes &output, size_t threads) const override;
+  bool requires_padding() const override;
+  // a decrypting stream releases plaintext before finish checks the tag;
+  // callers must discard it if finish throws
+  std::unique_ptr<BlockStream> stream(const core::SymmetricCipher &cipher,
+                                      bool encrypting) const override;
+
+private:
+  GHash::Block process(const core::SymmetricCipher &cipher, const Byte *input,
+                       size_t len, Byte *output, size_t threads,
+                       bool encrypting) const;
+  Bytes m_iv;
+  Bytes m_aad;
+};
+
+// XTS (IEEE 1619) for 128-bit block ciphers. The input is split into data
+// units of sector_size bytes, each tweaked by its sector number, so any
+// sector can be encrypted or decrypted on its own. A trailing partial block
+// is handled with ciphertext stealing, so the output has the length of the
+// input and no padding is applied; input shorter than one block, or ending
+// in a data unit shorter than one block, is rejected. The tweak cipher must
+// be keyed for encryption with the second XTS key and must outlive the mode.
+class XTS final : public SymmetricCipherMode {
+public:
+  static constexpr size_t DEFAULT_SECTOR_SIZE = 512;
+
+  explicit XTS(const core::SymmetricCipher &tweak_cipher,
+               size_t sector_size = DEFAULT_SECTOR_SIZE,
+               uint64_t first_sector = 0);
+  void encrypt(const core::SymmetricCipher &cipher, const Bytes &input,
+               Bytes &output, size_t threads) const override;
+  void decrypt(const core::SymmetricCipher &cipher, const Bytes &input,
+               Bytes &output, size_t threads) const override;
+
+  // input holds consecutive sectors starting at first_sector; sectors are
+  // distributed over the worker threads
+  void encrypt_sectors(const core::SymmetricCipher &cipher, uint64_t first_sector,
+                       const Bytes &input, Bytes &output, size_t threads) const;
+  void decrypt_sectors(const core::SymmetricCipher &cipher, uint64_t first_sector,
+                       const Bytes &input, Bytes &output, size_t threads) const;
+
+  size_t sector_size() const;
+  bool requires_padding() const override;
+
+  std::unique_ptr<BlockStream> stream(const core::SymmetricCipher &cipher,
+                                      bool encrypting) const override;
+
+private:
+  void process_sectors(const core::SymmetricCipher &cipher, uint64_t first_sector,
+                       const Bytes &input, Bytes &output, size_t threads,
+                       bool encrypting) const;
+  void process_sector(const core::SymmetricCipher &cipher, uint64_t sector,
+                      const Byte *input, Byte *output, size_t len,
+                      bool encrypting) const;
+
+  const core::SymmetricCipher &m_tweak_cipher;
+  size_t m_sector_size;
+  uint64_t m_first_sector;
+};
+
+// OCB3 (RFC 7253) authenticated encryption for 128-bit block ciphers with a
+// 128-bit tag appended to the ciphertext. Blocks are independent, so both
+// directions split across threads like ECB; only the checksum fold and the
+// final tag are serial. The nonce is required, 1..15 bytes, and must never
+// repeat under one key. Like GCM, OCB takes input of any length unpadded.
+class OCB final : public SymmetricCipherMode {
+public:
+  static constexpr size_t TAG_SIZE = 16;
+
+  explicit OCB(Bytes nonce, Bytes aad = {});
+  void encrypt(const core::SymmetricCipher &cipher, const Bytes &input,
+               Bytes &output, size_t threads) const override;
+  void decrypt(const core::SymmetricCipher &cipher, const Bytes &input,
+               Bytes &output, size_t threads) const override;
+  bool requires_padding() const override;
+  // decrypting streams check the tag in finish, as for GCM
+  std::unique_ptr<BlockStream> stream(const core::SymmetricCipher &cipher,
+                                      bool encrypting) const override;
+
+private:
+  LTable::Block process(const core::SymmetricCipher &cipher, const Byte *input,
+                        size_t len, Byte *output, size_t threads,
+                        bool encrypting) const;
+  Bytes m_nonce;
+  Bytes m_aad;
+};
+
 } // namespace crypto::mode
 
 #endif // CRYPTO_MODE_MODES_HPP
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "symmetric/padding/padding.hpp"
+#include "internal/random.hpp"
 
+#include <algorithm>
 #include <random>
 #include <stdexcept>
 
@@ -11,115 +13,152 @@ static void validate_block_size(size_t block_size) {
   }
 }
 
-static void validate_data(const Bytes &data, size_t block_size) {
-  if (data.empty() || data.size() % block_size != 0) {
+static void validate_tail(size_t tail_len, size_t block_size) {
+  validate_block_size(block_size);
+  if (tail_len >= block_size) {
+    throw std::invalid_argument("tail must be shorter than block_size");
+  }
+}
+
+static void validate_data(size_t size, size_t block_size) {
+  validate_block_size(block_size);
+  if (size == 0 || size % block_size != 0) {
     throw std::invalid_argument("data size is not a multiple of block_size");
   }
 }
 
-static size_t compute_pad_len(size_t data_size, size_t block_size) {
-  size_t pad_len = block_size - (data_size % block_size);
-  return pad_len == 0 ? block_size : pad_len;
+// tail followed by zeros; the caller fills in whatever the scheme needs
+static Bytes start_block(const Byte *tail, size_t tail_len, size_t block_size) {
+  Bytes block(block_size, 0x00);
+  std::copy(tail, tail + tail_len, block.begin());
+  return block;
 }
 
-Bytes ZerosPadding::apply(const Bytes &data, size_t block_size) const {
+Bytes SymmetricPaddingMode::apply(const Bytes &data, size_t block_size) const {
   validate_block_size(block_size);
-  size_t pad_len = compute_pad_len(data.size(), block_size);
-  Bytes padded = data;
-  padded.insert(padded.end(), pad_len, 0x00);
+  const size_t aligned = data.size() - data.size() % block_size;
+  Bytes padded;
+  padded.reserve(aligned + block_size);
+  padded.assign(data.begin(), data.begin() + aligned);
+  Bytes last = pad_tail(data.data() + aligned, data.size() - aligned, block_size);
+  padded.insert(padded.end(), last.begin(), last.end());
   return padded;
 }
 
-Bytes ZerosPadding::remove(const Bytes &data, size_t block_size) const {
-  validate_block_size(block_size);
-  validate_data(data, block_size);
-  size_t end = data.size();
-  while (end > 0 && data[end - 1] == 0x00) {
+Bytes SymmetricPaddingMode::remove(const Bytes &data, size_t block_size) const {
+  const size_t pad_len = padding_length(data.data(), data.size(), block_size);
+  return Bytes(data.begin(), data.end() - pad_len);
+}
+
+void SymmetricPaddingMode::remove_in_place(Bytes &data, size_t block_size) const {
+  data.resize(data.size() - padding_length(data.data(), data.size(), block_size));
+}
+
+Bytes ZerosPadding::pad_tail(const Byte *tail, size_t tail_len,
+                             size_t block_size) const {
+  validate_tail(tail_len, block_size);
+  return start_block(tail, tail_len, block_size);
+}
+
+size_t ZerosPadding::padding_length(const Byte *data, size_t size,
+                                    size_t block_size) const {
+  validate_data(size, block_size);
+  // only the final block, like every other scheme, so the answer does not
+  // depend on how much of the message the caller still holds
+  const size_t block_start = size - block_size;
+  size_t end = size;
+  while (end > block_start && data[end - 1] == 0x00) {
     --end;
   }
-  return Bytes(data.begin(), data.begin() + end);
+  return size - end;
 }
 
-Bytes AnsiX923Padding::apply(const Bytes &data, size_t block_size) const {
-  validate_block_size(block_size);
-  size_t pad_len = compute_pad_len(data.size(), block_size);
-  Bytes padded = data;
-  padded.insert(padded.end(), pad_len - 1, 0x00);
-  padded.push_back(static_cast<uint8_t>(pad_len));
-  return padded;
+Bytes AnsiX923Padding::pad_tail(const Byte *tail, size_t tail_len,
+                                size_t block_size) const {
+  validate_tail(tail_len, block_size);
+  if (block_size > 255) {
+    throw std::invalid_argument("ANSI X.923: block_size must be <= 255");
+  }
+  Bytes block = start_block(tail, tail_len, block_size);
+  block.back() = static_cast<uint8_t>(block_size - tail_len);
+  return block;
 }
 
-Bytes AnsiX923Padding::remove(const Bytes &data, size_t block_size) const {
-  validate_block_size(block_size);
-  validate_data(data, block_size);
-  uint8_t pad_len = data.back();
-  if (pad_len == 0 || pad_len > block_size || pad_len > data.size()) {
+size_t AnsiX923Padding::padding_length(const Byte *data, size_t size,
+                                       size_t block_size) const {
+  validate_data(size, block_size);
+  uint8_t pad_len = data[size - 1];
+  if (pad_len == 0 || pad_len > block_size) {
     throw std::invalid_argument("invalid ANSI X.923 padding");
   }
-  for (size_t i = data.size() - pad_len; i < data.size() - 1; ++i) {
+  for (size_t i = size - pad_len; i < size - 1; ++i) {
     if (data[i] != 0x00) {
       throw std::invalid_argument("invalid ANSI X.923 padding: non-zero byte found");
     }
   }
-  return Bytes(data.begin(), data.end() - pad_len);
+  return pad_len;
 }
 
-Bytes PKCS7Padding::apply(const Bytes &data, size_t block_size) const {
-  validate_block_size(block_size);
+Bytes PKCS7Padding::pad_tail(const Byte *tail, size_t tail_len,
+                             size_t block_size) const {
+  validate_tail(tail_len, block_size);
   if (block_size > 255) {
     throw std::invalid_argument("PKCS7: block_size must be <= 255");
   }
-  size_t pad_len = compute_pad_len(data.size(), block_size);
-  Bytes padded = data;
-  padded.insert(padded.end(), pad_len, static_cast<uint8_t>(pad_len));
-  return padded;
+  Bytes block = start_block(tail, tail_len, block_size);
+  std::fill(block.begin() + tail_len, block.end(),
+            static_cast<uint8_t>(block_size - tail_len));
+  return block;
 }
 
-Bytes PKCS7Padding::remove(const Bytes &data, size_t block_size) const {
-  validate_block_size(block_size);
-  validate_data(data, block_size);
-  uint8_t pad_len = data.back();
-  if (pad_len == 0 || pad_len > block_size || pad_len > data.size()) {
+size_t PKCS7Padding::padding_length(const Byte *data, size_t size,
+                                    size_t block_size) const {
+  validate_data(size, block_size);
+  uint8_t pad_len = data[size - 1];
+  if (pad_len == 0 || pad_len > block_size) {
     throw std::invalid_argument("invalid PKCS7 padding");
   }
-  for (size_t i = data.size() - pad_len; i < data.size(); ++i) {
+  for (size_t i = size - pad_len; i < size; ++i) {
     if (data[i] != pad_len) {
       throw std::invalid_argument("invalid PKCS7 padding: inconsistent bytes");
     }
   }
-  return Bytes(data.begin(), data.end() - pad_len);
+  return pad_len;
 }
 
 ISO10126Padding::ISO10126Padding(uint64_t seed) : m_seed(seed) {}
 
-Bytes ISO10126Padding::apply(const Bytes &data, size_t block_size) const {
-  validate_block_size(block_size);
+Bytes ISO10126Padding::pad_tail(const Byte *tail, size_t tail_len,
+                                size_t block_size) const {
+  validate_tail(tail_len, block_size);
   if (block_size > 255) {
     throw std::invalid_argument("ISO10126: block_size must be <= 255");
   }
-  size_t pad_len = compute_pad_len(data.size(), block_size);
-  Bytes padded = data;
-
-  std::mt19937_64 rng(m_seed != 0 ? m_seed
-                                   : std::mt19937_64::result_type(
-                                         std::random_device{}()));
-  std::uniform_int_distribution<uint8_t> dist(0, 255);
-
-  for (size_t i = 0; i < pad_len - 1; ++i) {
-    padded.push_back(dist(rng));
+  Bytes block = start_block(tail, tail_len, block_size);
+
+  if (m_seed != 0) {
+    // reproducible filler for tests
+    std::mt19937_64 rng(m_seed);
+    std::uniform_int_distribution<uint16_t> dist(0, 255);
+    for (size_t i = tail_len; i + 1 < block_size; ++i) {
+      block[i] = static_cast<uint8_t>(dist(rng));
+    }
+  } else if (tail_len + 1 < block_size) {
+    internal::random_bytes(
+        std::span(block.data() + tail_len, block_size - 1 - tail_len));
   }
-  padded.push_back(static_cast<uint8_t>(pad_len));
-  return padded;
+  block.back() = static_cast<uint8_t>(block_size - tail_len);
+  return block;
 }
 
-Bytes ISO10126Padding::remove(const Bytes &data, size_t block_size) const {
-  validate_block_size(block_size);
-  validate_data(data, block_size);
-  uint8_t pad_len = data.back();
-  if (pad_len == 0 || pad_len > block_size || pad_len > data.size()) {
+size_t ISO10126Padding::padding_length(const Byte *data, size_t size,
+                                       size_t block_size) const {
+  validate_data(size, block_size);
+  uint8_t pad_len = data[size - 1];
+  if (pad_len == 0 || pad_len > block_size) {
     throw std::invalid_argument("invalid ISO 10126 padding");
   }
-  return Bytes(data.begin(), data.end() - pad_len);
+  return pad_len;
 }
 
-} // namespace crypto::padding
\ No newline at end of file
+} // namespace crypto::padding
@@ -5,36 +5,58 @@
 
 namespace crypto::padding {
 
+  // A padding scheme only ever touches the final block: pad_tail builds it
+  // from the trailing tail_len (< block_size) plaintext bytes, and
+  // padding_length validates the end of a decrypted buffer and reports how
+  // many bytes to drop. apply/remove are whole-buffer conveniences on top.
   class SymmetricPaddingMode {
   public:
     virtual ~SymmetricPaddingMode() = default;
-    virtual Bytes apply(const Bytes &data, size_t block_size) const = 0;
-    virtual Bytes remove(const Bytes &data, size_t block_size) const = 0;
+
+    virtual Bytes pad_tail(const Byte *tail, size_t tail_len,
+                           size_t block_size) const = 0;
+    virtual size_t padding_length(const Byte *data, size_t size,
+                                  size_t block_size) const = 0;
+
+    Bytes apply(const Bytes &data, size_t block_size) const;
+    Bytes remove(const Bytes &data, size_t block_size) const;
+    void remove_in_place(Bytes &data, size_t block_size) const;
   };
 
+  // Strips the trailing zero bytes of the final block. Plaintext ending in
+  // zeros inside that block loses them; a full zero block added after
+  // aligned plaintext is removed without touching the block before it.
   class ZerosPadding final : public SymmetricPaddingMode {
   public:
-    Bytes apply(const Bytes &data, size_t block_size) const override;
-    Bytes remove(const Bytes &data, size_t block_size) const override;
+    Bytes pad_tail(const Byte *tail, size_t tail_len,
+                   size_t block_size) const override;
+    size_t padding_length(const Byte *data, size_t size,
+                          size_t block_size) const override;
   };
 
   class AnsiX923Padding final : public SymmetricPaddingMode {
   public:
-    Bytes apply(const Bytes &data, size_t block_size) const override;
-    Bytes remove(const Bytes &data, size_t block_size) const override;
+    Bytes pad_tail(const Byte *tail, size_t tail_len,
+                   size_t block_size) const override;
+    size_t padding_length(const Byte *data, size_t size,
+                          size_t block_size) const override;
   };
 
   class PKCS7Padding final : public SymmetricPaddingMode {
   public:
-    Bytes apply(const Bytes &data, size_t block_size) const override;
-    Bytes remove(const Bytes &data, size_t block_size) const override;
+    Bytes pad_tail(const Byte *tail, size_t tail_len,
+                   size_t block_size) const override;
+    size_t padding_length(const Byte *data, size_t size,
+                          size_t block_size) const override;
   };
 
   class ISO10126Padding final : public SymmetricPaddingMode {
   public:
     explicit ISO10126Padding(uint64_t seed = 0);
-    Bytes apply(const Bytes &data, size_t block_size) const override;
-    Bytes remove(const Bytes &data, size_t block_size) const override;
+    Bytes pad_tail(const Byte *tail, size_t tail_len,
+                   size_t block_size) const override;
+    size_t padding_length(const Byte *data, size_t size,
+                          size_t block_size) const override;
 
   private:
     uint64_t m_seed;
@@ -42,4 +64,4 @@ namespace crypto::padding {
 
 } // namespace crypto::padding
 
-#endif
\ No newline at end of file
+#endif
@@ -1,14 +1,8 @@
 #include "miller_rabin_prime_test.hpp"
 
-#include <random>
-
 #include "utils.hpp"
 
 namespace math {
-  MillerRabinPrimeTest::MillerRabinPrimeTest() : m_rng(gmp_randinit_default) {
-    m_rng.seed(std::random_device{}());
-  }
-
   int MillerRabinPrimeTest::calculate_iterations(double min_probability) const {
     return static_cast<int>(std::ceil(std::log(1.0 / (1.0 - min_probability)) / std::log(4)));
   }
@@ -22,7 +16,7 @@ namespace math {
       ++s;
     }
 
-    const mpz_class a = m_rng.get_z_range(n - 3) + 2;
+    const mpz_class a = random_witness(n);
 
     mpz_class x = powm(a, d, n);
 
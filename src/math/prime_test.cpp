@@ -4,6 +4,9 @@
 
 #include "prime_test.hpp"
 
+#include <random>
+#include <stdexcept>
+
 namespace math {
   bool PrimeTest::is_prime(const mpz_class& n, double min_probability) {
     if (min_probability < 0.5 || min_probability > 1.0) {
@@ -24,6 +27,17 @@ namespace math {
     return true;
   }
 
+  mpz_class PrimeTest::random_witness(const mpz_class& n) {
+    thread_local gmp_randclass rng(gmp_randinit_default);
+    thread_local bool seeded = false;
+    if (!seeded) {
+      std::random_device device;
+      rng.seed((static_cast<unsigned long>(device()) << 32) ^ device());
+      seeded = true;
+    }
+    return rng.get_z_range(n - 3) + 2;
+  }
+
   int PrimeTest::calculate_iterations(double min_probability) const {
     return static_cast<int>(std::ceil(std::log(1.0 / (1.0 - min_probability)) / std::log(2)));
   }
@@ -25,6 +25,10 @@ namespace math {
 
     virtual bool single_test_iteration(const mpz_class& n, int iteration_index) const = 0;
 
+    // uniform witness in [2, n-2]; the generator is per thread and seeded
+    // once, so building a test is free and concurrent tests do not share it
+    static mpz_class random_witness(const mpz_class& n);
+
   };
 }
 
@@ -1,21 +1,15 @@
 #include "solovay_strassen_prime_test.hpp"
 
-#include <random>
-
 #include "utils.hpp"
 
 namespace math {
-  SolovayStrassenPrimeTest::SolovayStrassenPrimeTest() : m_rng(gmp_randinit_default) {
-    m_rng.seed(std::random_device{}());
-  }
-
   bool SolovayStrassenPrimeTest::single_test_iteration(const mpz_class& n,
                                                        int /*iteration_index*/) const {
     if (mpz_even_p(n.get_mpz_t())) {
       return false;
     }
 
-    const mpz_class a = m_rng.get_z_range(n - 3) + 2;
+    const mpz_class a = random_witness(n);
 
     if (math::gcd(a, n) != 1) {
       return false;
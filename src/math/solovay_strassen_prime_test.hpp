@@ -6,14 +6,8 @@
 namespace math {
 
   class SolovayStrassenPrimeTest : public PrimeTest {
-  public:
-    SolovayStrassenPrimeTest();
-
   protected:
     bool single_test_iteration(const mpz_class& n, int iteration_index) const override;
-
-  private:
-    mutable gmp_randclass m_rng;
   };
 
 }  // namespace math
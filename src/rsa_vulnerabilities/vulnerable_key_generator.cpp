@@ -2,8 +2,8 @@
 
 #include <stdexcept>
 
+#include "internal/random.hpp"
 #include "math/utils.hpp"
-#include <random>
 
 namespace crypto::rsa {
   VulnerableKeyGenerator::VulnerableKeyGenerator(
@@ -14,12 +14,10 @@ namespace crypto::rsa {
     : m_prime_test(std::move(prime_test)),
       m_prime_bits(prime_bits),
       m_min_probability(min_prime_probability),
-      m_vulnerability(vulnerability),
-      m_rng(gmp_randinit_default) {
+      m_vulnerability(vulnerability) {
     if (prime_bits < 512) {
       throw std::invalid_argument("prime_bits must be at least 512");
     }
-    m_rng.seed(std::random_device{}());
   }
 
   KeyPair VulnerableKeyGenerator::generate() const {
@@ -32,7 +30,7 @@ namespace crypto::rsa {
 
   mpz_class VulnerableKeyGenerator::generate_prime() const {
     while (true) {
-      mpz_class candidate = m_rng.get_z_bits(m_prime_bits);
+      mpz_class candidate = internal::random_bits(m_prime_bits);
       mpz_setbit(candidate.get_mpz_t(), m_prime_bits - 1);
       mpz_setbit(candidate.get_mpz_t(), 0);
       if (m_prime_test->is_prime(candidate, m_min_probability)) {
@@ -51,7 +49,7 @@ namespace crypto::rsa {
     if (threshold < 2) threshold = 2;
 
     while (true) {
-      mpz_class offset = m_rng.get_z_range(threshold * 2);
+      mpz_class offset = internal::random_below(threshold * 2);
       offset -= threshold;
       if (offset % 2 == 0) offset += 1;
 
@@ -84,7 +82,7 @@ namespace crypto::rsa {
 
       mpz_class range = d_bound - 3;
       if (range < 1) continue;
-      mpz_class d = m_rng.get_z_range(range) + 3;
+      mpz_class d = internal::random_below(range) + 3;
       mpz_setbit(d.get_mpz_t(), 0);
 
       if (math::gcd(d, phi_n) != 1) continue;
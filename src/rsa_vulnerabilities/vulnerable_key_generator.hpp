@@ -36,7 +36,6 @@ namespace crypto::rsa {
     mp_bitcnt_t m_prime_bits;
     double m_min_probability;
     Vulnerability m_vulnerability;
-    mutable gmp_randclass m_rng;
   };
 } // namespace crypto::rsa
 
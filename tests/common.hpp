@@ -1,10 +1,18 @@
 #ifndef CRYPTO_TESTS_COMMON_HPP
 #define CRYPTO_TESTS_COMMON_HPP
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "crypto/symmetric/algorithms/twofish/twofish.hpp"
+#include "crypto/symmetric/cipher_context.hpp"
+
 inline std::vector<uint8_t> bits_from_string(const std::string &bitstr) {
   std::vector<uint8_t> bytes;
   size_t i = 0;
@@ -32,4 +40,159 @@ inline std::string bits_to_string(const std::vector<uint8_t> &bytes) {
   return bitstr;
 }
 
+// n bytes of (i * mul + add) mod 256
+inline crypto::Bytes make_data(size_t n, size_t mul, size_t add) {
+  crypto::Bytes data(n);
+  for (size_t i = 0; i < n; ++i) data[i] = static_cast<uint8_t>((i * mul + add) & 0xFF);
+  return data;
+}
+
+// "0a1b..." to bytes; the string must have an even number of hex digits
+inline crypto::Bytes from_hex(const std::string &hex) {
+  crypto::Bytes out;
+  for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+    out.push_back(static_cast<uint8_t>(std::stoul(hex.substr(i, 2), nullptr, 16)));
+  }
+  return out;
+}
+
+inline void write_bytes(const std::string &path, const crypto::Bytes &data) {
+  std::ofstream f(path, std::ios::binary | std::ios::trunc);
+  f.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+inline crypto::Bytes read_bytes(const std::string &path) {
+  std::ifstream f(path, std::ios::binary);
+  return crypto::Bytes(std::istreambuf_iterator<char>(f), {});
+}
+
+// The library ships no AES, but the published GCM, XTS and OCB vectors are
+// all for AES. This is a plain byte-oriented AES-128, only good enough to
+// drive the modes.
+class Aes128 final : public crypto::core::SymmetricCipher {
+public:
+  Aes128() {
+    uint8_t p = 1, q = 1;
+    do {
+      p = static_cast<uint8_t>(p ^ (p << 1) ^ (p & 0x80 ? 0x1B : 0));
+      q ^= q << 1;
+      q ^= q << 2;
+      q ^= q << 4;
+      if (q & 0x80) q ^= 0x09;
+      const uint8_t s = static_cast<uint8_t>(q ^ rotl(q, 1) ^ rotl(q, 2) ^ rotl(q, 3) ^
+                                             rotl(q, 4) ^ 0x63);
+      m_sbox[p] = s;
+      m_inv[s] = p;
+    } while (p != 1);
+    m_sbox[0] = 0x63;
+    m_inv[0x63] = 0;
+  }
+
+  void set_encryption_key(const crypto::Bytes &key) override { expand(key); }
+  void set_decryption_key(const crypto::Bytes &key) override { expand(key); }
+  size_t block_size() const override { return 16; }
+
+  crypto::Bytes encrypt_block(const crypto::Bytes &in) const override {
+    crypto::Bytes s(in);
+    add_round_key(s, 0);
+    for (size_t r = 1; r <= 10; ++r) {
+      for (auto &b : s) b = m_sbox[b];
+      s = shift_rows(s, 1);
+      if (r != 10) mix_columns(s, {2, 3, 1, 1});
+      add_round_key(s, r);
+    }
+    return s;
+  }
+
+  crypto::Bytes decrypt_block(const crypto::Bytes &in) const override {
+    crypto::Bytes s(in);
+    add_round_key(s, 10);
+    for (size_t r = 10; r-- > 0;) {
+      s = shift_rows(s, 3);
+      for (auto &b : s) b = m_inv[b];
+      add_round_key(s, r);
+      if (r != 0) mix_columns(s, {14, 11, 13, 9});
+    }
+    return s;
+  }
+
+private:
+  static uint8_t rotl(uint8_t x, int n) { return static_cast<uint8_t>((x << n) | (x >> (8 - n))); }
+
+  static uint8_t mul(uint8_t a, uint8_t b) {
+    uint8_t r = 0;
+    for (; b; b >>= 1) {
+      if (b & 1) r ^= a;
+      a = static_cast<uint8_t>((a << 1) ^ (a & 0x80 ? 0x1B : 0));
+    }
+    return r;
+  }
+
+  void expand(const crypto::Bytes &key) {
+    std::copy(key.begin(), key.end(), m_round_keys.begin());
+    uint8_t rcon = 1;
+    for (size_t i = 16; i < m_round_keys.size(); i += 4) {
+      std::array<uint8_t, 4> t{m_round_keys[i - 4], m_round_keys[i - 3], m_round_keys[i - 2],
+                               m_round_keys[i - 1]};
+      if (i % 16 == 0) {
+        t = {static_cast<uint8_t>(m_sbox[t[1]] ^ rcon), m_sbox[t[2]], m_sbox[t[3]], m_sbox[t[0]]};
+        rcon = mul(rcon, 2);
+      }
+      for (size_t j = 0; j < 4; ++j) m_round_keys[i + j] = m_round_keys[i + j - 16] ^ t[j];
+    }
+  }
+
+  void add_round_key(crypto::Bytes &s, size_t round) const {
+    for (size_t i = 0; i < 16; ++i) s[i] ^= m_round_keys[round * 16 + i];
+  }
+
+  // row r moves left by r * step columns (step 3 undoes step 1)
+  static crypto::Bytes shift_rows(const crypto::Bytes &s, size_t step) {
+    crypto::Bytes out(16);
+    for (size_t c = 0; c < 4; ++c)
+      for (size_t r = 0; r < 4; ++r) out[c * 4 + r] = s[((c + r * step) % 4) * 4 + r];
+    return out;
+  }
+
+  static void mix_columns(crypto::Bytes &s, std::array<uint8_t, 4> m) {
+    for (size_t c = 0; c < 4; ++c) {
+      const std::array<uint8_t, 4> a{s[c * 4], s[c * 4 + 1], s[c * 4 + 2], s[c * 4 + 3]};
+      for (size_t r = 0; r < 4; ++r)
+        s[c * 4 + r] = mul(a[0], m[(4 - r) % 4]) ^ mul(a[1], m[(5 - r) % 4]) ^
+                       mul(a[2], m[(6 - r) % 4]) ^ mul(a[3], m[(7 - r) % 4]);
+    }
+  }
+
+  std::array<uint8_t, 256> m_sbox{};
+  std::array<uint8_t, 256> m_inv{};
+  std::array<uint8_t, 176> m_round_keys{};
+};
+
+// An IV of the length the mode expects: 8 bytes for CTR, 12 for GCM and OCB
+// and one block otherwise.
+inline crypto::Bytes mode_iv(crypto::SymmetricEncryptionMode mode, uint8_t fill) {
+  switch (mode) {
+  case crypto::SymmetricEncryptionMode::CTR:
+    return crypto::Bytes(8, fill);
+  case crypto::SymmetricEncryptionMode::GCM:
+  case crypto::SymmetricEncryptionMode::OCB:
+    return crypto::Bytes(12, fill);
+  default:
+    return crypto::Bytes(16, fill);
+  }
+}
+
+// Twofish context keyed both ways with key; XTS also gets a fixed tweak key.
+inline crypto::SymmetricCipherContext
+make_context(crypto::SymmetricEncryptionMode mode, const crypto::Bytes &key, uint8_t iv_fill,
+             crypto::SymmetricPaddingScheme pad = crypto::SymmetricPaddingScheme::PKCS7) {
+  crypto::SymmetricCipherContext ctx(std::make_unique<crypto::twofish::Twofish>(),
+                                     std::make_unique<crypto::twofish::Twofish>(), mode, pad,
+                                     mode_iv(mode, iv_fill));
+  ctx.set_encryption_key(key);
+  ctx.set_decryption_key(key);
+  if (mode == crypto::SymmetricEncryptionMode::XTS) ctx.set_tweak_key(crypto::Bytes(16, 0x77));
+  return ctx;
+}
+
 #endif // !CRYPTO_TESTS_COMMON_HPP
@@ -1,7 +1,13 @@
+#include <algorithm>
 #include <cstdint>
+#include <numeric>
+#include <random>
+#include <stdexcept>
 #include <gtest/gtest.h>
 
 #include "crypto/internal/bits/permute.hpp"
+#include "crypto/internal/bits/utils.hpp"
+#include "crypto/internal/bits/word_permute.hpp"
 #include "common.hpp"
 
 using namespace crypto::bits;
@@ -124,3 +130,143 @@ TEST(bits_permute_test, out_of_range_one_based_multi_byte) {
               permute(bits, indexes, BitOrder::BigEndian, BitIndexBase::One));
   }
 }
+
+// straightforward per-bit reference for the compiled plans
+static std::vector<uint8_t> reference_permute(const std::vector<uint8_t> &bits,
+                                              const std::vector<size_t> &p_block,
+                                              BitOrder order,
+                                              BitIndexBase index_base) {
+  std::vector<uint8_t> out((p_block.size() + 7) / 8, 0);
+  const size_t total_bits = bits.size() * 8;
+  for (size_t i = 0; i < p_block.size(); i++) {
+    size_t index = p_block[i] - (index_base == BitIndexBase::One ? 1 : 0);
+    if (order == BitOrder::LittleEndian) {
+      index = total_bits - 1 - index;
+    }
+    if (index < total_bits && ((bits[index / 8] >> (7 - index % 8)) & 1)) {
+      out[i / 8] |= 1 << (7 - i % 8);
+    }
+  }
+  return out;
+}
+
+TEST(bits_permute_test, plan_matches_reference_for_all_layouts) {
+  std::mt19937 rng(7);
+  for (size_t in_bytes : {1u, 4u, 7u, 8u, 16u}) {
+    for (size_t out_bits : {1u, 6u, 48u, 64u, 65u, 128u}) {
+      std::vector<uint8_t> bits(in_bytes);
+      for (auto &b : bits) b = static_cast<uint8_t>(rng());
+      std::vector<size_t> p_block(out_bits);
+      for (auto &index : p_block) index = rng() % (in_bytes * 8 + 4);
+
+      for (auto order : {BitOrder::BigEndian, BitOrder::LittleEndian}) {
+        for (auto base : {BitIndexBase::Zero, BitIndexBase::One}) {
+          const auto expected = reference_permute(bits, p_block, order, base);
+          PermutationPlan plan(p_block, in_bytes, order, base);
+          ASSERT_EQ(plan.output_size(), expected.size());
+          ASSERT_EQ(plan.apply(bits), expected);
+
+          std::vector<uint8_t> out(plan.output_size(), 0xFF);
+          plan.apply(std::span<const uint8_t>(bits), std::span<uint8_t>(out));
+          ASSERT_EQ(out, expected);
+
+          // the cached path, twice so the second call hits the cache
+          ASSERT_EQ(permute(bits, p_block, order, base), expected);
+          ASSERT_EQ(permute(bits, p_block, order, base), expected);
+        }
+      }
+    }
+  }
+}
+
+TEST(bits_permute_test, plan_rejects_wrong_buffer_sizes) {
+  PermutationPlan plan({1, 2, 3, 4, 5, 6, 7, 8}, 2, BitOrder::BigEndian,
+                       BitIndexBase::One);
+  EXPECT_THROW(plan.apply(std::vector<uint8_t>(3, 0)), std::invalid_argument);
+  std::vector<uint8_t> in(2);
+  std::vector<uint8_t> small_out(0);
+  EXPECT_THROW(plan.apply(std::span<const uint8_t>(in),
+                          std::span<uint8_t>(small_out)),
+               std::invalid_argument);
+}
+
+TEST(bits_permute_test, large_permutation_uses_bitwise_fallback) {
+  std::mt19937 rng(11);
+  std::vector<uint8_t> bits(64);
+  for (auto &b : bits) b = static_cast<uint8_t>(rng());
+  std::vector<size_t> p_block(512);
+  for (size_t i = 0; i < p_block.size(); i++) p_block[i] = 511 - i;
+  EXPECT_EQ(permute(bits, p_block, BitOrder::BigEndian, BitIndexBase::Zero),
+            reference_permute(bits, p_block, BitOrder::BigEndian,
+                              BitIndexBase::Zero));
+}
+
+TEST(bits_permute_test, same_p_block_different_input_lengths) {
+  // LittleEndian indices count from the end of the input, so plans for
+  // different lengths must not be shared
+  std::vector<size_t> p_block = {0, 1, 2, 3, 4, 5, 6, 7};
+  auto one = bits_from_string("10110001");
+  auto two = bits_from_string("1111000010110001");
+  EXPECT_EQ(permute(one, p_block, BitOrder::LittleEndian, BitIndexBase::Zero),
+            reference_permute(one, p_block, BitOrder::LittleEndian,
+                              BitIndexBase::Zero));
+  EXPECT_EQ(permute(two, p_block, BitOrder::LittleEndian, BitIndexBase::Zero),
+            reference_permute(two, p_block, BitOrder::LittleEndian,
+                              BitIndexBase::Zero));
+}
+
+static void expect_word_matches_permute(const std::vector<size_t> &p_block,
+                                        size_t input_bits, BitOrder order,
+                                        BitIndexBase base,
+                                        WordPermutation::Backend backend,
+                                        std::mt19937_64 &rng) {
+  WordPermutation word(p_block, input_bits, order, base, backend);
+  for (int trial = 0; trial < 32; trial++) {
+    std::vector<uint8_t> bits(input_bits / 8);
+    for (auto &b : bits) b = static_cast<uint8_t>(rng());
+    std::vector<uint8_t> out(word.output_bits() / 8 + 1);
+    store_word(word.apply(load_word(bits, input_bits)), word.output_bits(),
+               out);
+    out.resize((word.output_bits() + 7) / 8);
+    ASSERT_EQ(out, reference_permute(bits, p_block, order, base));
+  }
+}
+
+TEST(bits_permute_test, word_backends_match_reference) {
+  std::mt19937_64 rng(3);
+  std::vector<WordPermutation::Backend> backends = {
+      WordPermutation::Backend::Auto, WordPermutation::Backend::ShiftMask};
+  if (WordPermutation::supported(WordPermutation::Backend::Bmi2)) {
+    backends.push_back(WordPermutation::Backend::Bmi2);
+  }
+
+  for (size_t n : {8u, 32u, 48u, 64u}) {
+    std::vector<size_t> bijection(n);
+    std::iota(bijection.begin(), bijection.end(), 0);
+    std::shuffle(bijection.begin(), bijection.end(), rng);
+    std::vector<size_t> selection(n / 2 + 3);
+    for (auto &index : selection) index = rng() % (n + 2);
+
+    for (auto order : {BitOrder::BigEndian, BitOrder::LittleEndian}) {
+      for (auto backend : backends) {
+        expect_word_matches_permute(bijection, n, order, BitIndexBase::Zero,
+                                    backend, rng);
+        expect_word_matches_permute(selection, n, order, BitIndexBase::One,
+                                    backend, rng);
+      }
+      expect_word_matches_permute(bijection, n, order, BitIndexBase::Zero,
+                                  WordPermutation::Backend::Benes, rng);
+    }
+  }
+}
+
+TEST(bits_permute_test, word_benes_requires_bijection) {
+  EXPECT_THROW(WordPermutation({0, 0, 1, 2}, 8, BitOrder::BigEndian,
+                               BitIndexBase::Zero,
+                               WordPermutation::Backend::Benes),
+               std::invalid_argument);
+  std::vector<size_t> too_long(65, 0);
+  EXPECT_THROW(WordPermutation(too_long, 64, BitOrder::BigEndian,
+                               BitIndexBase::Zero),
+               std::invalid_argument);
+}
@@ -0,0 +1,211 @@
+#include <array>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <gtest/gtest.h>
+
+#include "internal/bits/bit_span.hpp"
+#include "internal/bits/permute.hpp"
+#include "internal/bits/substitute.hpp"
+#include "internal/bits/utils.hpp"
+
+#include "common.hpp"
+
+using namespace crypto::bits;
+
+namespace {
+
+std::vector<uint8_t> random_bytes(std::mt19937 &rng, size_t n) {
+  std::vector<uint8_t> out(n);
+  for (auto &b : out) b = static_cast<uint8_t>(rng());
+  return out;
+}
+
+// the first n_bits bits of bytes, zero-padded
+std::vector<uint8_t> truncated(std::vector<uint8_t> bytes, size_t n_bits) {
+  bytes.resize((n_bits + 7) / 8);
+  if (n_bits % 8 != 0) {
+    bytes.back() &= static_cast<uint8_t>(0xFF << (8 - n_bits % 8));
+  }
+  return bytes;
+}
+
+} // namespace
+
+TEST(bits_span_test, get_and_set) {
+  auto bytes = bits_from_string("1010101000001111");
+  BitSpan span(bytes);
+  EXPECT_EQ(span.size(), 16u);
+  EXPECT_EQ(span.get(0), 1);
+  EXPECT_EQ(span[1], 0);
+  EXPECT_EQ(span.get(15), 1);
+
+  span.set(0, 0);
+  span.set_unchecked(8, 1);
+  EXPECT_EQ(bits_to_string(bytes), "0010101010001111");
+
+  BitView view = span;
+  EXPECT_EQ(view.get(8), 1);
+  EXPECT_THROW(view.get(16), std::invalid_argument);
+  EXPECT_THROW(span.set(16, 1), std::invalid_argument);
+}
+
+TEST(bits_span_test, length_is_checked_against_the_buffer) {
+  std::vector<uint8_t> bytes(2);
+  EXPECT_NO_THROW(BitSpan(bytes, 16));
+  EXPECT_THROW(BitSpan(bytes, 17), std::invalid_argument);
+
+  BitView view(std::span<const uint8_t>(bytes), 10);
+  EXPECT_EQ(view.size(), 10u);
+  EXPECT_EQ(view.bytes().size(), 2u);
+  EXPECT_THROW(view.get(10), std::invalid_argument);
+}
+
+TEST(bits_span_test, read_and_write_across_bytes) {
+  std::vector<uint8_t> bytes = {0x12, 0x34, 0x56, 0x78, 0x9A};
+  BitSpan span(bytes);
+  EXPECT_EQ(span.read(4, 16), 0x2345u);
+  EXPECT_EQ(span.read(0, 40), 0x123456789Aull);
+  EXPECT_EQ(span.read_unchecked(3, 5), 0x12u & 0x1F);
+
+  span.write(4, 16, 0xABCD);
+  EXPECT_EQ(bytes, (std::vector<uint8_t>{0x1A, 0xBC, 0xD6, 0x78, 0x9A}));
+  span.write_unchecked(37, 3, 0x5);
+  EXPECT_EQ(bytes[4], 0x9D);
+
+  EXPECT_THROW(span.read(30, 11), std::invalid_argument);
+  EXPECT_THROW(span.read(0, 65), std::invalid_argument);
+  EXPECT_THROW(span.write(39, 2, 0), std::invalid_argument);
+  EXPECT_NO_THROW(span.read(40, 0));
+}
+
+TEST(bits_span_test, clear_from_zeroes_the_tail_and_pad_bits) {
+  std::vector<uint8_t> bytes(3, 0xFF);
+  BitSpan span(std::span<uint8_t>(bytes), 20);
+  span.clear_from(13);
+  EXPECT_EQ(bytes, (std::vector<uint8_t>{0xFF, 0xF8, 0x00}));
+  span.clear_from(0);
+  EXPECT_EQ(bytes, (std::vector<uint8_t>(3, 0)));
+}
+
+TEST(bits_span_test, permute_matches_vector_version) {
+  std::mt19937 rng(5);
+  for (size_t input_bits : {8u, 13u, 32u, 64u}) {
+    const auto bytes = truncated(random_bytes(rng, 8), input_bits);
+    std::vector<size_t> p_block(input_bits + 3);
+    for (auto &index : p_block) index = rng() % (input_bits + 2) + 1;
+
+    for (auto order : {BitOrder::BigEndian, BitOrder::LittleEndian}) {
+      std::vector<uint8_t> out((p_block.size() + 7) / 8 + 1, 0xFF);
+      permute(BitView(std::span<const uint8_t>(bytes), input_bits), out,
+              p_block, order, BitIndexBase::One);
+
+      std::vector<uint8_t> expected((p_block.size() + 7) / 8);
+      for (size_t i = 0; i < p_block.size(); i++) {
+        size_t index = p_block[i] - 1;
+        if (order == BitOrder::LittleEndian) index = input_bits - 1 - index;
+        if (index < input_bits) set_bit(expected, i, get_bit(bytes, index));
+      }
+      expected.push_back(0);
+      EXPECT_EQ(out, expected) << input_bits;
+      if (input_bits % 8 == 0) {
+        expected.pop_back();
+        EXPECT_EQ(permute(bytes, p_block, order, BitIndexBase::One), expected);
+      }
+    }
+  }
+
+  std::vector<uint8_t> small(1);
+  std::vector<uint8_t> in(2);
+  EXPECT_THROW(permute(in, small, std::vector<size_t>(9, 1), BitOrder::BigEndian,
+                       BitIndexBase::One),
+               std::invalid_argument);
+}
+
+TEST(bits_span_test, substitute_matches_vector_version) {
+  std::mt19937 rng(9);
+  std::array<uint8_t, 256> s_block{};
+  for (auto &v : s_block) v = static_cast<uint8_t>(rng());
+  const auto bytes = random_bytes(rng, 13);
+
+  for (auto [in, out] : {std::pair<size_t, size_t>{4, 4}, {6, 4}, {8, 8},
+                         {3, 5}, {0, 4}}) {
+    const auto expected = substitute(bytes, s_block, in, out);
+    const SubstitutionPlan plan(s_block, in, out);
+
+    std::vector<uint8_t> view_out(expected.size() + 1, 0xFF);
+    substitute(bytes, view_out, s_block, in, out);
+    EXPECT_EQ(truncated(view_out, expected.size() * 8), expected);
+    EXPECT_EQ(view_out.back(), 0);
+
+    std::fill(view_out.begin(), view_out.end(), 0xFF);
+    plan.apply(bytes, view_out);
+    EXPECT_EQ(truncated(view_out, expected.size() * 8), expected);
+    EXPECT_EQ(view_out.back(), 0);
+  }
+}
+
+TEST(bits_span_test, substitute_unaligned_view) {
+  std::array<uint8_t, 256> s_block{};
+  for (size_t i = 0; i < 16; i++) s_block[i] = static_cast<uint8_t>(15 - i);
+  const auto bytes = bits_from_string("0001001000111111");
+  const BitView view(std::span<const uint8_t>(bytes), 14);
+
+  // three 4-bit blocks are substituted, the last two bits copied through
+  std::vector<uint8_t> out(2, 0xFF);
+  substitute(view, out, s_block, 4, 4);
+  EXPECT_EQ(bits_to_string(out), "1110110111001100");
+
+  std::fill(out.begin(), out.end(), 0xFF);
+  SubstitutionPlan(s_block, 4, 4).apply(view, out);
+  EXPECT_EQ(bits_to_string(out), "1110110111001100");
+}
+
+TEST(bits_span_test, utils_match_vector_versions) {
+  std::mt19937 rng(17);
+  const auto bytes = random_bytes(rng, 12);
+  const auto mask = random_bytes(rng, 12);
+
+  for (auto type : {MaskType::And, MaskType::Or, MaskType::Xor}) {
+    auto in_place = bytes;
+    apply_mask(in_place, mask, type);
+    EXPECT_EQ(in_place, apply_mask(bytes, mask, 96, type));
+
+    // a 21-bit mask leaves later bits alone
+    in_place = bytes;
+    apply_mask(in_place, BitView(std::span<const uint8_t>(mask), 21), type);
+    auto partial = apply_mask(bytes, mask, 96, type);
+    for (size_t i = 21; i < 96; i++) set_bit(partial, i, get_bit(bytes, i));
+    EXPECT_EQ(in_place, partial);
+  }
+
+  for (auto [i, j] : {std::pair<size_t, size_t>{0, 95}, {3, 17}, {9, 9},
+                      {40, 90}}) {
+    std::vector<uint8_t> out(12, 0xFF);
+    get_bits(bytes, i, j, out);
+    auto expected = get_bits(bytes, i, j);
+    expected.resize(out.size());
+    EXPECT_EQ(out, expected);
+  }
+  std::vector<uint8_t> small(1);
+  EXPECT_THROW(get_bits(bytes, 0, 8, small), std::invalid_argument);
+  EXPECT_THROW(get_bits(bytes, 0, 96, BitSpan(small)), std::invalid_argument);
+
+  for (size_t n_bits : {28u, 64u, 90u}) {
+    for (size_t shift : {1u, 7u, 27u}) {
+      auto view_rotated = bytes;
+      rotate_left(BitSpan(std::span<uint8_t>(view_rotated), n_bits), shift);
+      EXPECT_EQ(truncated(view_rotated, n_bits),
+                truncated(rotate_left(bytes, n_bits, shift), n_bits));
+      rotate_right(BitSpan(std::span<uint8_t>(view_rotated), n_bits), shift);
+      EXPECT_EQ(truncated(view_rotated, n_bits), truncated(bytes, n_bits));
+    }
+  }
+
+  auto swapped = bytes;
+  auto expected = bytes;
+  swap_bits(BitSpan(swapped), 3, 77);
+  swap_bits(expected, 3, 77);
+  EXPECT_EQ(swapped, expected);
+  EXPECT_THROW(swap_bits(BitSpan(swapped), 0, 96), std::invalid_argument);
+}
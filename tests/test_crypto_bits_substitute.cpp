@@ -1,5 +1,7 @@
 #include "internal/bits/substitute.hpp"
 #include <cstdint>
+#include <random>
+#include <stdexcept>
 #include <gtest/gtest.h>
 
 using namespace crypto::bits;
@@ -113,3 +115,80 @@ TEST(substitute_wrappers, function_wrapper) {
   // Should match the same result as the array-based version
   EXPECT_EQ(out[0], 0b11010100);
 }
+
+// bit-at-a-time reference with the layout substitute() has always produced
+static std::vector<uint8_t>
+reference_substitute(const std::vector<uint8_t> &bits,
+                     const std::array<uint8_t, 256> &s_block, size_t in,
+                     size_t out) {
+  const size_t total = bits.size() * 8;
+  const size_t blocks = total / in;
+  const size_t rest = total % in;
+  std::vector<uint8_t> result((blocks * out + rest + 7) / 8, 0);
+  size_t pos = 0;
+  auto bit_at = [&](size_t k) { return (bits[k / 8] >> (7 - k % 8)) & 1; };
+  auto put = [&](unsigned v) {
+    result[pos / 8] |= v << (7 - pos % 8);
+    ++pos;
+  };
+  for (size_t b = 0; b < blocks; ++b) {
+    unsigned key = 0;
+    for (size_t k = 0; k < in; ++k) key = key << 1 | bit_at(b * in + k);
+    const unsigned value = s_block[key] & ((1u << out) - 1);
+    for (size_t k = out; k > 0; --k) put((value >> (k - 1)) & 1);
+  }
+  for (size_t k = blocks * in; k < total; ++k) put(bit_at(k));
+  return result;
+}
+
+TEST(substitution_plan, matches_reference_for_all_block_sizes) {
+  std::mt19937 rng(5);
+  std::array<uint8_t, 256> s_block{};
+  for (auto &v : s_block) v = static_cast<uint8_t>(rng());
+
+  for (size_t in = 1; in <= 8; ++in) {
+    for (size_t out = 1; out <= 8; ++out) {
+      SubstitutionPlan plan(s_block, in, out);
+      for (size_t len : {0u, 1u, 2u, 3u, 5u, 6u, 7u, 12u, 13u, 100u}) {
+        std::vector<uint8_t> input(len);
+        for (auto &b : input) b = static_cast<uint8_t>(rng());
+        const auto expected = reference_substitute(input, s_block, in, out);
+        ASSERT_EQ(substitute(input, s_block, in, out), expected)
+            << in << "/" << out << " len " << len;
+        ASSERT_EQ(plan.apply(input), expected)
+            << in << "/" << out << " len " << len;
+      }
+    }
+  }
+}
+
+TEST(substitution_plan, map_and_function_sources_agree) {
+  std::unordered_map<uint8_t, uint8_t> s_map;
+  std::array<uint8_t, 256> s_array{};
+  for (int i = 0; i < 64; i += 3) {
+    s_map[i] = static_cast<uint8_t>(i * 7);
+    s_array[i] = static_cast<uint8_t>(i * 7);
+  }
+  auto s_func = [&s_array](uint8_t x) -> uint8_t { return s_array[x]; };
+
+  std::vector<uint8_t> input = {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE};
+  const auto expected = reference_substitute(input, s_array, 6, 4);
+  EXPECT_EQ(SubstitutionPlan(s_map, 6, 4).apply(input), expected);
+  EXPECT_EQ(SubstitutionPlan(std::function<uint8_t(uint8_t)>(s_func), 6, 4)
+                .apply(input),
+            expected);
+}
+
+TEST(substitution_plan, degenerate_sizes_and_errors) {
+  std::array<uint8_t, 256> s_block{};
+  std::vector<uint8_t> input = {0xAB, 0xCD};
+  EXPECT_EQ(SubstitutionPlan(s_block, 0, 4).apply(input), input);
+  EXPECT_TRUE(SubstitutionPlan(s_block, 4, 0).apply(input).empty());
+  EXPECT_THROW(SubstitutionPlan(s_block, 9, 4), std::invalid_argument);
+
+  SubstitutionPlan plan(s_block, 4, 4);
+  std::vector<uint8_t> small(1);
+  EXPECT_THROW(plan.apply(std::span<const uint8_t>(input),
+                          std::span<uint8_t>(small)),
+               std::invalid_argument);
+}
@@ -1,4 +1,6 @@
 #include <cstdint>
+#include <random>
+#include <stdexcept>
 #include <gtest/gtest.h>
 
 #include "internal/bits/utils.hpp"
@@ -93,6 +95,17 @@ TEST(bits_apply_mask_test, xor_mask) {
   EXPECT_EQ(bits_to_string(res), "0011110100000000");
 }
 
+TEST(bits_apply_mask_test, short_mask) {
+  auto bits = bits_from_string("110011010000111100110011");
+  auto mask = bits_from_string("10101111");
+  // only the first four bits are masked, whatever follows in the mask byte
+  auto res = apply_mask(bits, mask, 4, MaskType::Xor);
+  EXPECT_EQ(bits_to_string(res), "011011010000111100110011");
+  res = apply_mask(bits, mask, 4, MaskType::And);
+  EXPECT_EQ(bits_to_string(res), "100011010000111100110011");
+  EXPECT_THROW(apply_mask(bits, mask, 12, MaskType::Or), std::invalid_argument);
+}
+
 TEST(bits_edge_cases_test, empty_vector) {
   std::vector<uint8_t> empty;
   EXPECT_EQ(rotate_left(empty, 0, 5), std::vector<uint8_t>{});
@@ -106,3 +119,59 @@ TEST(bits_edge_cases_test, single_bit) {
   auto res = rotate_left(bits, 1, 1);
   EXPECT_EQ(bits_to_string(res), "00000001");
 }
+
+// per-bit reference: bit i of the result is bit (i + shift) % n_bits
+static std::string reference_rotate_left(const std::string &bits, size_t n_bits,
+                                         size_t shift) {
+  std::string out(bits.size(), '0');
+  for (size_t i = 0; i < n_bits; i++) {
+    out[i] = bits[(i + shift) % n_bits];
+  }
+  return out;
+}
+
+TEST(bits_rotate_left_test, odd_widths_keep_all_bits) {
+  // 28-bit halves as in the DES key schedule, and widths past one word
+  std::mt19937 rng(9);
+  for (size_t n_bits : {28u, 56u, 63u, 64u, 65u, 100u, 257u, 1000u}) {
+    const size_t n_bytes = (n_bits + 7) / 8;
+    std::string text(n_bytes * 8, '0');
+    for (size_t i = 0; i < n_bits; i++) text[i] = '0' + (rng() & 1);
+    const auto bits = bits_from_string(text);
+    for (size_t shift : {1u, 2u, 7u, 8u, 9u, 27u, 600u}) {
+      const auto expected = reference_rotate_left(text, n_bits, shift % n_bits);
+      EXPECT_EQ(bits_to_string(rotate_left(bits, n_bits, shift)), expected)
+          << n_bits << " " << shift;
+      EXPECT_EQ(bits_to_string(rotate_right(bits, n_bits, n_bits - shift % n_bits)),
+                expected)
+          << n_bits << " " << shift;
+
+      auto in_place = bits;
+      rotate_left(std::span<uint8_t>(in_place), n_bits, shift);
+      EXPECT_EQ(bits_to_string(in_place), expected) << n_bits << " " << shift;
+    }
+  }
+}
+
+TEST(bits_rotate_left_test, word_rotation) {
+  EXPECT_EQ(rotate_left(uint64_t{0x8000001}, 28, 1), uint64_t{0x0000003});
+  EXPECT_EQ(rotate_right(uint64_t{0x0000003}, 28, 1), uint64_t{0x8000001});
+  EXPECT_EQ(rotate_left(uint64_t{0x8000000000000001}, 64, 4),
+            uint64_t{0x0000000000000018});
+  EXPECT_EQ(rotate_left(uint64_t{0xFF}, 4, 1), uint64_t{0xF});
+  EXPECT_THROW(rotate_left(uint64_t{1}, 65, 1), std::invalid_argument);
+}
+
+TEST(bits_rotate_left_test, rejects_width_past_input) {
+  auto bits = bits_from_string("10110011");
+  EXPECT_THROW(rotate_left(bits, 9, 1), std::invalid_argument);
+}
+
+TEST(bits_word_test, load_store_roundtrip) {
+  auto bits = bits_from_string("1011001110001111010");
+  const uint64_t value = load_word(bits, 19);
+  EXPECT_EQ(value, 0b1011001110001111010u);
+  std::vector<uint8_t> out(3, 0xFF);
+  store_word(value, 19, out);
+  EXPECT_EQ(out, bits);
+}
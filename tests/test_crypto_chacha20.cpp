@@ -0,0 +1,138 @@
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include <gtest/gtest.h>
+
+#include "crypto/stream/algorithms/chacha20/chacha20.hpp"
+#include "crypto/stream/stream_cipher_context.hpp"
+
+#include "common.hpp"
+
+using Bytes = crypto::Bytes;
+using crypto::chacha20::ChaCha20;
+
+static Bytes key_0_to_31() {
+  Bytes key(32);
+  for (size_t i = 0; i < key.size(); ++i) key[i] = static_cast<uint8_t>(i);
+  return key;
+}
+
+static const ChaCha20::Backend BACKENDS[] = {
+    ChaCha20::Backend::Scalar, ChaCha20::Backend::SSE2, ChaCha20::Backend::AVX2,
+    ChaCha20::Backend::AVX512};
+
+TEST(ChaCha20, Rfc8439SunscreenVector) {
+  const std::string text =
+      "Ladies and Gentlemen of the class of '99: If I could offer you only one "
+      "tip for the future, sunscreen would be it.";
+  const Bytes plain(text.begin(), text.end());
+  const Bytes expected = from_hex(
+      "6e2e359a2568f98041ba0728dd0d6981e97e7aec1d4360c20a27afccfd9fae0b"
+      "f91b65c5524733ab8f593dabcd62b3571639d624e65152ab8f530c359f0861d8"
+      "07ca0dbf500d6a6156a38e088a22b65e52bc514d16ccf806818ce91ab7793736"
+      "5af90bbf74a35be6b40b8eedf2785e42874d");
+  for (auto backend : BACKENDS) {
+    if (!ChaCha20::supported(backend)) continue;
+    ChaCha20 cipher(from_hex("000000000000004a00000000"), 1, backend);
+    cipher.set_key(key_0_to_31());
+    Bytes out(plain.size());
+    cipher.apply(plain, out);
+    ASSERT_EQ(out, expected);
+  }
+}
+
+TEST(ChaCha20, WideCounterCarriesIntoHighWord) {
+  ChaCha20 cipher(from_hex("0102030405060708"), 0xFFFFFFFDull);
+  cipher.set_key(key_0_to_31());
+  cipher.seek(3 * ChaCha20::BLOCK_SIZE);
+  Bytes ks(32);
+  cipher.keystream(ks);
+  ASSERT_EQ(ks, from_hex("04220a5961510e72677e0d3339946e4f9592160ac17cef9e822009b7d5488b50"));
+}
+
+TEST(ChaCha20, BackendsAgreeOnLongRuns) {
+  const Bytes plain = make_data(64 * 37 + 13, 31, 7);
+  Bytes reference;
+  for (auto backend : BACKENDS) {
+    if (!ChaCha20::supported(backend)) continue;
+    ChaCha20 cipher(from_hex("0102030405060708"), 0xFFFFFFF0ull, backend);
+    cipher.set_key(key_0_to_31());
+    Bytes out(plain.size());
+    cipher.apply(plain, out);
+    if (reference.empty()) {
+      reference = out;
+    } else {
+      ASSERT_EQ(out, reference);
+    }
+  }
+}
+
+TEST(ChaCha20, SplitCallsAndSeekMatchOneCall) {
+  ChaCha20 whole_cipher(Bytes(12, 0));
+  whole_cipher.set_key(key_0_to_31());
+  Bytes whole(5000);
+  whole_cipher.keystream(whole);
+
+  ChaCha20 pieces_cipher(Bytes(12, 0));
+  pieces_cipher.set_key(key_0_to_31());
+  Bytes pieces(whole.size());
+  size_t off = 0;
+  for (size_t len : {1u, 63u, 64u, 65u, 1000u, 3807u}) {
+    pieces_cipher.keystream(std::span(pieces).subspan(off, len));
+    off += len;
+  }
+  ASSERT_EQ(pieces, whole);
+
+  ChaCha20 seeking(Bytes(12, 0));
+  seeking.set_key(key_0_to_31());
+  seeking.seek(4321);
+  Bytes tail(100);
+  seeking.keystream(tail);
+  ASSERT_EQ(tail, Bytes(whole.begin() + 4321, whole.begin() + 4421));
+  ASSERT_EQ(seeking.position(), 4421u);
+}
+
+TEST(ChaCha20, SnapshotRestore) {
+  ChaCha20 cipher(from_hex("0102030405060708"), 7);
+  cipher.set_key(key_0_to_31());
+  cipher.discard(999);
+  const Bytes state = cipher.snapshot();
+  Bytes a(70), b(70);
+  cipher.keystream(a);
+
+  ChaCha20 other(Bytes(12, 0));
+  other.restore(state);
+  other.keystream(b);
+  ASSERT_EQ(a, b);
+  ASSERT_THROW(other.restore(Bytes(5)), std::invalid_argument);
+}
+
+TEST(ChaCha20, RejectsBadParameters) {
+  static_assert(!std::is_default_constructible_v<ChaCha20>, "the nonce must be explicit");
+  ASSERT_THROW(ChaCha20(Bytes(10)), std::invalid_argument);
+  ASSERT_THROW(ChaCha20(Bytes(12), uint64_t{1} << 32), std::invalid_argument);
+  ChaCha20 cipher(Bytes(12, 0));
+  Bytes out(4);
+  ASSERT_THROW(cipher.keystream(out), std::logic_error);
+  ASSERT_THROW(cipher.set_key(Bytes(16)), std::invalid_argument);
+
+  ChaCha20 narrow(Bytes(12), 0xFFFFFFFFull);
+  narrow.set_key(key_0_to_31());
+  Bytes one_block(64), more(1);
+  narrow.keystream(one_block);
+  ASSERT_THROW(narrow.keystream(more), std::runtime_error);
+}
+
+TEST(ChaCha20, ContextSplitsAcrossThreads) {
+  crypto::StreamCipherContext ctx(std::make_unique<ChaCha20>(Bytes(12, 0x24)));
+  ctx.set_key(key_0_to_31());
+  const Bytes plain = make_data(300001, 31, 7);
+  Bytes one, four, dec;
+  ctx.encrypt(plain, one, 1);
+  ctx.encrypt(plain, four, 4);
+  ASSERT_EQ(one, four);
+  ctx.decrypt(four, dec, 3);
+  ASSERT_EQ(dec, plain);
+}
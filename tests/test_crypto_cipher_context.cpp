@@ -545,6 +545,21 @@ TEST(CipherContext, RandomDeltaAnsiX923Roundtrip) {
   ASSERT_EQ(dec, plain);
 }
 
+TEST(CipherContext, RandomDeltaPaddedTailMatchesJoinedInput) {
+  XorCipher cipher;
+  const crypto::mode::RD rd(0x5EED);
+  Bytes input(29);
+  for (size_t i = 0; i < input.size(); ++i) input[i] = static_cast<uint8_t>(i * 7 + 1);
+  const Bytes tail = {0x01, 0x02, 0x03, 0x04, 0x05, 0x03, 0x03, 0x03};
+  Bytes joined(input.begin(), input.begin() + 24);
+  joined.insert(joined.end(), tail.begin(), tail.end());
+
+  Bytes expected, padded;
+  rd.encrypt(cipher, joined, expected, 1);
+  rd.encrypt_padded(cipher, input, tail, padded, 1);
+  ASSERT_EQ(padded, expected);
+}
+
 TEST(CipherContext, RandomDeltaOutputIsLarger) {
   crypto::SymmetricCipherContext ctx(make_identity(), crypto::SymmetricEncryptionMode::RD,
                             crypto::SymmetricPaddingScheme::Zeros);
@@ -936,3 +951,46 @@ TEST(CipherContext, RandomDeltaISO10126Roundtrip) {
   ctx_dec.decrypt(enc, dec, 1);
   ASSERT_EQ(dec, plain);
 }
+
+TEST(PKCS7Padding, PadTailBuildsSingleBlock) {
+  crypto::padding::PKCS7Padding p;
+  Bytes tail = {0x01, 0x02, 0x03};
+  Bytes block = p.pad_tail(tail.data(), tail.size(), 8);
+  ASSERT_EQ(block, (Bytes{0x01, 0x02, 0x03, 0x05, 0x05, 0x05, 0x05, 0x05}));
+  ASSERT_EQ(p.pad_tail(nullptr, 0, 8), Bytes(8, 0x08));
+  ASSERT_THROW(p.pad_tail(tail.data(), 8, 8), std::invalid_argument);
+}
+
+TEST(PKCS7Padding, RemoveInPlaceOnlyShrinks) {
+  crypto::padding::PKCS7Padding p;
+  Bytes data = p.apply(Bytes(13, 0x77), 8);
+  const uint8_t *before = data.data();
+  p.remove_in_place(data, 8);
+  ASSERT_EQ(data, Bytes(13, 0x77));
+  ASSERT_EQ(data.data(), before);
+}
+
+TEST(CipherContext, TailPaddingMatchesWholeBufferPadding) {
+  const crypto::SymmetricEncryptionMode modes[] = {
+      crypto::SymmetricEncryptionMode::ECB, crypto::SymmetricEncryptionMode::CBC,
+      crypto::SymmetricEncryptionMode::PCBC, crypto::SymmetricEncryptionMode::CFB,
+      crypto::SymmetricEncryptionMode::OFB, crypto::SymmetricEncryptionMode::CTR};
+  Bytes iv(8, 0x33);
+  crypto::padding::AnsiX923Padding padding;
+  for (auto m : modes) {
+    // CTR with 8-byte blocks takes no nonce
+    crypto::SymmetricCipherContext ctx(
+        make_xor(), m, crypto::SymmetricPaddingScheme::AnsiX923,
+        m == crypto::SymmetricEncryptionMode::CTR ? Bytes{} : iv);
+    for (size_t len : {0u, 5u, 8u, 21u}) {
+      Bytes plain(len, 0x6B);
+      Bytes enc, reference, dec;
+      ctx.encrypt(plain, enc, 2);
+      ctx.encrypt(padding.apply(plain, 8), reference, 2);
+      reference.resize(reference.size() - 8);
+      ASSERT_EQ(enc, reference);
+      ctx.decrypt(enc, dec, 2);
+      ASSERT_EQ(dec, plain);
+    }
+  }
+}
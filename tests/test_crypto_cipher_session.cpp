@@ -0,0 +1,481 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include "crypto/symmetric/algorithms/des/des.hpp"
+#include "crypto/symmetric/algorithms/twofish/twofish.hpp"
+#include "crypto/symmetric/cipher_context.hpp"
+#include "internal/file_pipeline.hpp"
+
+#include "common.hpp"
+
+using Bytes = crypto::Bytes;
+using crypto::Byte;
+using crypto::CipherDirection;
+using crypto::SymmetricEncryptionMode;
+using crypto::SymmetricPaddingScheme;
+
+static const Bytes KEY(16, 0x4D);
+
+// feeds input through a session in chunks of the given sizes, cycling
+static Bytes run_session(crypto::CipherSession session, const Bytes &input,
+                         std::initializer_list<size_t> chunks) {
+  Bytes out;
+  size_t pos = 0;
+  auto it = chunks.begin();
+  while (pos < input.size()) {
+    const size_t n = std::min(*it, input.size() - pos);
+    Bytes buf(session.output_bound(n));
+    const size_t written = session.update(std::span(input).subspan(pos, n), buf);
+    out.insert(out.end(), buf.begin(), buf.begin() + written);
+    pos += n;
+    if (++it == chunks.end()) it = chunks.begin();
+  }
+  Bytes buf(session.output_bound(0));
+  const size_t written = session.finalize(buf);
+  out.insert(out.end(), buf.begin(), buf.begin() + written);
+  return out;
+}
+
+TEST(CipherSession, ChunkedMatchesOneShot) {
+  for (auto mode : {SymmetricEncryptionMode::ECB, SymmetricEncryptionMode::CBC,
+                    SymmetricEncryptionMode::PCBC, SymmetricEncryptionMode::CFB,
+                    SymmetricEncryptionMode::OFB, SymmetricEncryptionMode::CTR}) {
+    auto ctx = make_context(mode, KEY, 0x21);
+    for (size_t len : {0u, 1u, 15u, 16u, 17u, 100u, 1000u}) {
+      Bytes plain = make_data(len, 7, 1);
+      Bytes expected;
+      ctx.encrypt(plain, expected);
+      Bytes enc = run_session(ctx.begin(CipherDirection::Encrypt), plain, {1, 7, 16, 33});
+      ASSERT_EQ(enc, expected) << "mode " << static_cast<int>(mode) << " length " << len;
+      Bytes dec = run_session(ctx.begin(CipherDirection::Decrypt), enc, {5, 16, 64});
+      ASSERT_EQ(dec, plain);
+    }
+  }
+}
+
+TEST(CipherSession, RandomDeltaRoundtrip) {
+  auto ctx = make_context(SymmetricEncryptionMode::RD, KEY, 0x21, SymmetricPaddingScheme::AnsiX923);
+  for (size_t len : {0u, 16u, 50u}) {
+    Bytes plain = make_data(len, 7, 1);
+    Bytes enc = run_session(ctx.begin(CipherDirection::Encrypt), plain, {3, 40});
+    ASSERT_EQ(enc.size(), (len / 16 + 3) * 16);
+    Bytes one_shot;
+    ctx.decrypt(enc, one_shot);
+    ASSERT_EQ(one_shot, plain);
+    Bytes dec = run_session(ctx.begin(CipherDirection::Decrypt), enc, {1, 17});
+    ASSERT_EQ(dec, plain);
+  }
+}
+
+TEST(CipherSession, OneShotCiphertextDecryptsIncrementally) {
+  auto ctx = make_context(SymmetricEncryptionMode::CBC, KEY, 0x21, SymmetricPaddingScheme::ISO10126);
+  Bytes plain = make_data(4096 + 3, 7, 1);
+  Bytes enc;
+  ctx.encrypt(plain, enc, 4);
+  ASSERT_EQ(run_session(ctx.begin(CipherDirection::Decrypt), enc, {512}), plain);
+}
+
+TEST(CipherSession, EightByteBlockCipher) {
+  crypto::SymmetricCipherContext ctx(std::make_unique<crypto::des::DES>(),
+                                     SymmetricEncryptionMode::CFB,
+                                     SymmetricPaddingScheme::PKCS7, Bytes(8, 0x09));
+  ctx.set_encryption_key(make_data(8, 7, 1));
+  ctx.set_decryption_key(make_data(8, 7, 1));
+  Bytes plain = make_data(77, 7, 1);
+  Bytes expected;
+  ctx.encrypt(plain, expected);
+  ASSERT_EQ(run_session(ctx.begin(CipherDirection::Encrypt), plain, {3}), expected);
+  ASSERT_EQ(run_session(ctx.begin(CipherDirection::Decrypt), expected, {9}), plain);
+}
+
+TEST(CipherSession, TruncatedCiphertextThrows) {
+  auto ctx = make_context(SymmetricEncryptionMode::CBC, KEY, 0x21);
+  Bytes enc;
+  ctx.encrypt(make_data(40, 7, 1), enc);
+  enc.pop_back();
+  auto session = ctx.begin(CipherDirection::Decrypt);
+  Bytes buf(session.output_bound(enc.size()));
+  session.update(enc, buf);
+  ASSERT_THROW(session.finalize(buf), std::invalid_argument);
+}
+
+TEST(CipherSession, MisuseThrows) {
+  auto ctx = make_context(SymmetricEncryptionMode::ECB, KEY, 0x21);
+  auto session = ctx.begin(CipherDirection::Encrypt);
+  Bytes in = make_data(32, 7, 1);
+  Bytes small(16);
+  ASSERT_THROW(session.update(in, small), std::invalid_argument);
+  Bytes buf(session.output_bound(0));
+  session.finalize(buf);
+  ASSERT_THROW(session.finalize(buf), std::logic_error);
+  ASSERT_THROW(session.update({}, buf), std::logic_error);
+}
+
+TEST(CipherSession, CtsMatchesOneShot) {
+  crypto::SymmetricCipherContext ctx(std::make_unique<crypto::twofish::Twofish>(),
+                                     SymmetricEncryptionMode::CTS, SymmetricPaddingScheme::PKCS7,
+                                     mode_iv(SymmetricEncryptionMode::CTS, 0x21));
+  ctx.set_encryption_key(KEY);
+  ctx.set_decryption_key(KEY);
+  for (size_t len : {16u, 17u, 32u, 33u, 47u, 48u, 100u, 1000u}) {
+    const Bytes plain = make_data(len, 7, 1);
+    Bytes expected;
+    ctx.encrypt(plain, expected);
+    ASSERT_EQ(run_session(ctx.begin(CipherDirection::Encrypt), plain, {7, 16}), expected) << len;
+    ASSERT_EQ(run_session(ctx.begin(CipherDirection::Decrypt), expected, {5, 33}), plain) << len;
+  }
+  auto session = ctx.begin(CipherDirection::Encrypt);
+  Bytes buf(session.output_bound(15));
+  session.update(make_data(15, 7, 1), buf);
+  ASSERT_THROW(session.finalize(buf), std::invalid_argument);
+}
+
+TEST(CipherSession, AeadDecryptionChecksTagInFinalize) {
+  for (auto mode : {SymmetricEncryptionMode::GCM, SymmetricEncryptionMode::OCB}) {
+    auto ctx = make_context(mode, KEY, 0x21);
+    for (size_t len : {0u, 1u, 15u, 16u, 17u, 100u, 1000u}) {
+      const Bytes plain = make_data(len, 7, 1);
+      Bytes enc;
+      ctx.encrypt(plain, enc, 3);
+      ASSERT_EQ(run_session(ctx.begin(CipherDirection::Decrypt), enc, {1, 7, 16, 333}), plain)
+          << "mode " << static_cast<int>(mode) << " length " << len;
+
+      enc.back() ^= 0x01;
+      ASSERT_THROW(run_session(ctx.begin(CipherDirection::Decrypt), enc, {5, 64}),
+                   std::invalid_argument);
+    }
+    auto session = ctx.begin(CipherDirection::Decrypt);
+    Bytes buf(session.output_bound(15));
+    session.update(make_data(15, 7, 1), buf);
+    ASSERT_THROW(session.finalize(buf), std::invalid_argument);
+  }
+}
+
+TEST(CipherSession, AeadEncryptionMatchesOneShot) {
+  for (auto mode : {SymmetricEncryptionMode::GCM, SymmetricEncryptionMode::OCB}) {
+    auto ctx = make_context(mode, KEY, 0x21);
+    for (size_t len : {0u, 1u, 15u, 16u, 17u, 100u, 1000u}) {
+      Bytes plain = make_data(len, 7, 1);
+      Bytes expected;
+      ctx.encrypt(plain, expected, 3);
+      ASSERT_EQ(run_session(ctx.begin(CipherDirection::Encrypt), plain, {1, 7, 16, 333}),
+                expected)
+          << "mode " << static_cast<int>(mode) << " length " << len;
+    }
+  }
+}
+
+TEST(CipherSession, XtsMatchesOneShot) {
+  auto tweak = std::make_unique<crypto::twofish::Twofish>();
+  crypto::SymmetricCipherContext ctx(std::make_unique<crypto::twofish::Twofish>(),
+                                     std::move(tweak), SymmetricEncryptionMode::XTS,
+                                     SymmetricPaddingScheme::PKCS7);
+  ctx.set_encryption_key(KEY);
+  ctx.set_decryption_key(KEY);
+  ctx.set_tweak_key(Bytes(16, 0x99));
+  Bytes plain = make_data(512 * 3 + 100, 7, 1);
+  Bytes expected;
+  ctx.encrypt(plain, expected, 2);
+  ASSERT_EQ(expected.size(), plain.size());
+  auto session = ctx.begin(CipherDirection::Encrypt);
+  ASSERT_EQ(run_session(std::move(session), plain, {48, 1000, 16}), expected);
+  ASSERT_EQ(run_session(ctx.begin(CipherDirection::Decrypt), expected, {7, 600}), plain);
+}
+
+TEST(ChunkedFile, MatchesInMemoryForEveryChunkSize) {
+  const std::string in_path = "/tmp/chunked_plain.bin";
+  const std::string enc_path = "/tmp/chunked_enc.bin";
+  const std::string dec_path = "/tmp/chunked_dec.bin";
+  Bytes plain = make_data(10000, 7, 1);
+  write_bytes(in_path, plain);
+
+  for (auto mode : {SymmetricEncryptionMode::CBC, SymmetricEncryptionMode::CTR,
+                    SymmetricEncryptionMode::OFB, SymmetricEncryptionMode::PCBC}) {
+    auto ctx = make_context(mode, KEY, 0x21);
+    Bytes expected;
+    ctx.encrypt(plain, expected);
+    for (size_t chunk : {1u, 16u, 100u, 4096u, 1u << 20}) {
+      ctx.encrypt_file(in_path, enc_path, 2, chunk).get();
+      ASSERT_EQ(read_bytes(enc_path), expected) << "chunk " << chunk;
+      ctx.decrypt_file(enc_path, dec_path, 2, chunk).get();
+      ASSERT_EQ(read_bytes(dec_path), plain) << "chunk " << chunk;
+    }
+  }
+}
+
+TEST(ChunkedFile, EmptyFile) {
+  const std::string in_path = "/tmp/chunked_empty.bin";
+  const std::string enc_path = "/tmp/chunked_empty_enc.bin";
+  const std::string dec_path = "/tmp/chunked_empty_dec.bin";
+  write_bytes(in_path, {});
+  auto ctx = make_context(SymmetricEncryptionMode::CBC, KEY, 0x21);
+  ctx.encrypt_file(in_path, enc_path, 1, 64).get();
+  ASSERT_EQ(read_bytes(enc_path).size(), 16u);
+  ctx.decrypt_file(enc_path, dec_path, 1, 64).get();
+  ASSERT_TRUE(read_bytes(dec_path).empty());
+}
+
+TEST(ChunkedFile, AeadModesMatchInMemory) {
+  const std::string in_path = "/tmp/chunked_aead_plain.bin";
+  const std::string enc_path = "/tmp/chunked_aead_enc.bin";
+  const std::string dec_path = "/tmp/chunked_aead_dec.bin";
+  Bytes plain = make_data(3000, 7, 1);
+  write_bytes(in_path, plain);
+  for (auto mode : {SymmetricEncryptionMode::GCM, SymmetricEncryptionMode::OCB}) {
+    auto ctx = make_context(mode, KEY, 0x01);
+    Bytes expected;
+    ctx.encrypt(plain, expected, 2);
+    for (auto backend : {crypto::FileBackend::Buffered, crypto::FileBackend::Mapped,
+                         crypto::FileBackend::Pipelined}) {
+      ctx.set_file_backend(backend);
+      ctx.encrypt_file(in_path, enc_path, 2, 256).get();
+      ASSERT_EQ(read_bytes(enc_path), expected)
+          << "mode " << static_cast<int>(mode) << " backend " << static_cast<int>(backend);
+      ctx.decrypt_file(enc_path, dec_path, 2, 256).get();
+      ASSERT_EQ(read_bytes(dec_path), plain);
+    }
+  }
+}
+
+TEST(ChunkedFile, TamperedAeadFileLeavesNoOutput) {
+  const std::string in_path = "/tmp/chunked_aead_bad.bin";
+  const std::string dec_path = "/tmp/chunked_aead_bad_dec.bin";
+  auto ctx = make_context(SymmetricEncryptionMode::GCM, KEY, 0x01);
+  Bytes enc;
+  ctx.encrypt(make_data(500, 7, 1), enc);
+  enc[10] ^= 0x01;
+  write_bytes(in_path, enc);
+  std::filesystem::remove(dec_path);
+  for (auto backend : {crypto::FileBackend::Buffered, crypto::FileBackend::Mapped,
+                       crypto::FileBackend::Pipelined}) {
+    ctx.set_file_backend(backend);
+    ASSERT_THROW(ctx.decrypt_file(in_path, dec_path, 1, 64).get(), std::invalid_argument);
+    ASSERT_FALSE(std::filesystem::exists(dec_path));
+  }
+  // nor a staging file next to it
+  for (const auto &entry : std::filesystem::directory_iterator("/tmp")) {
+    ASSERT_NE(entry.path().filename().string().rfind("chunked_aead_bad_dec.bin", 0), 0u);
+  }
+}
+
+TEST(ChunkedFile, ZerosPaddingAgreesOnEveryPath) {
+  const std::string enc_path = "/tmp/chunked_zeros_enc.bin";
+  const std::string dec_path = "/tmp/chunked_zeros_dec.bin";
+  auto ctx = make_context(SymmetricEncryptionMode::CBC, KEY, 0x21,
+                          SymmetricPaddingScheme::Zeros);
+  Bytes aligned = make_data(16, 7, 1);
+  aligned.back() = 0x00;
+  Bytes zero_blocks(48, 0x00);
+  zero_blocks[0] = 0x01;
+  Bytes partial = make_data(21, 7, 1);
+  partial[19] = partial[20] = 0x00;
+
+  for (const Bytes &plain : {aligned, zero_blocks, partial}) {
+    Bytes enc, expected;
+    ctx.encrypt(plain, enc);
+    ctx.decrypt(enc, expected);
+    // zeros before the final padded block belong to the plaintext
+    if (plain.size() % 16 == 0) ASSERT_EQ(expected, plain);
+    ASSERT_EQ(run_session(ctx.begin(CipherDirection::Decrypt), enc, {5, 16}), expected);
+
+    write_bytes(enc_path, enc);
+    for (auto backend : {crypto::FileBackend::Buffered, crypto::FileBackend::Mapped,
+                         crypto::FileBackend::Pipelined}) {
+      ctx.set_file_backend(backend);
+      ctx.decrypt_file(enc_path, dec_path, 1, 16).get();
+      ASSERT_EQ(read_bytes(dec_path), expected)
+          << "backend " << static_cast<int>(backend) << " length " << plain.size();
+    }
+  }
+}
+
+TEST(ChunkedFile, BadPaddingRemovesOutput) {
+  const std::string in_path = "/tmp/chunked_bad.bin";
+  const std::string dec_path = "/tmp/chunked_bad_dec.bin";
+  auto ctx = make_context(SymmetricEncryptionMode::ECB, KEY, 0x21);
+  Bytes enc;
+  ctx.encrypt(make_data(100, 7, 1), enc);
+  enc.back() ^= 0xFF;
+  write_bytes(in_path, enc);
+  ASSERT_THROW(ctx.decrypt_file(in_path, dec_path, 1, 32).get(), std::invalid_argument);
+  ASSERT_FALSE(std::filesystem::exists(dec_path));
+}
+
+TEST(ChunkedFile, ZeroChunkSizeThrows) {
+  auto ctx = make_context(SymmetricEncryptionMode::CBC, KEY, 0x21);
+  ASSERT_THROW(ctx.encrypt_file("/tmp/chunked_plain.bin", "/tmp/unused.bin", 1, 0).get(),
+               std::invalid_argument);
+}
+
+TEST(MappedFileBackend, MatchesBufferedBackend) {
+  const std::string in_path = "/tmp/mapped_plain.bin";
+  const std::string enc_path = "/tmp/mapped_enc.bin";
+  const std::string dec_path = "/tmp/mapped_dec.bin";
+  for (size_t len : {0u, 1u, 4096u, 70000u}) {
+    Bytes plain = make_data(len, 7, 1);
+    write_bytes(in_path, plain);
+    for (auto mode : {SymmetricEncryptionMode::ECB, SymmetricEncryptionMode::CBC,
+                      SymmetricEncryptionMode::CTR}) {
+      auto ctx = make_context(mode, KEY, 0x21);
+      Bytes expected;
+      ctx.encrypt(plain, expected);
+      ctx.set_file_backend(crypto::FileBackend::Mapped);
+      ctx.encrypt_file(in_path, enc_path, 4).get();
+      ASSERT_EQ(read_bytes(enc_path), expected) << "length " << len;
+      ctx.decrypt_file(enc_path, dec_path, 4).get();
+      ASSERT_EQ(read_bytes(dec_path), plain) << "length " << len;
+    }
+  }
+}
+
+TEST(MappedFileBackend, RandomDeltaParallelInterop) {
+  const std::string in_path = "/tmp/mapped_rd_plain.bin";
+  const std::string enc_path = "/tmp/mapped_rd_enc.bin";
+  const std::string dec_path = "/tmp/mapped_rd_dec.bin";
+  Bytes plain = make_data(50000, 7, 1);
+  write_bytes(in_path, plain);
+  auto ctx = make_context(SymmetricEncryptionMode::RD, KEY, 0x21);
+  ctx.set_file_backend(crypto::FileBackend::Mapped);
+  ctx.encrypt_file(in_path, enc_path, 4).get();
+  Bytes enc = read_bytes(enc_path);
+  Bytes one_shot;
+  ctx.decrypt(enc, one_shot);
+  ASSERT_EQ(one_shot, plain);
+  ctx.decrypt_file(enc_path, dec_path, 3).get();
+  ASSERT_EQ(read_bytes(dec_path), plain);
+}
+
+TEST(MappedFileBackend, BadPaddingRemovesOutput) {
+  const std::string in_path = "/tmp/mapped_bad.bin";
+  const std::string dec_path = "/tmp/mapped_bad_dec.bin";
+  auto ctx = make_context(SymmetricEncryptionMode::CBC, KEY, 0x21);
+  ctx.set_file_backend(crypto::FileBackend::Mapped);
+  Bytes enc;
+  ctx.encrypt(make_data(100, 7, 1), enc);
+  enc.back() ^= 0xFF;
+  write_bytes(in_path, enc);
+  ASSERT_THROW(ctx.decrypt_file(in_path, dec_path).get(), std::invalid_argument);
+  ASSERT_FALSE(std::filesystem::exists(dec_path));
+}
+
+TEST(MappedFileBackend, MissingInputThrows) {
+  auto ctx = make_context(SymmetricEncryptionMode::ECB, KEY, 0x21);
+  ctx.set_file_backend(crypto::FileBackend::Mapped);
+  ASSERT_THROW(ctx.encrypt_file("/tmp/does_not_exist.bin", "/tmp/unused.bin").get(),
+               std::runtime_error);
+}
+
+TEST(PipelinedFileBackend, MatchesBufferedBackend) {
+  const std::string in_path = "/tmp/pipe_plain.bin";
+  const std::string enc_path = "/tmp/pipe_enc.bin";
+  const std::string dec_path = "/tmp/pipe_dec.bin";
+  for (size_t len : {0u, 1u, 4096u, 70000u}) {
+    Bytes plain = make_data(len, 7, 1);
+    write_bytes(in_path, plain);
+    for (auto mode : {SymmetricEncryptionMode::ECB, SymmetricEncryptionMode::CBC,
+                      SymmetricEncryptionMode::CTR, SymmetricEncryptionMode::RD}) {
+      auto ctx = make_context(mode, KEY, 0x21);
+      ctx.set_file_backend(crypto::FileBackend::Pipelined);
+      for (size_t chunk : {16u, 1000u, 8192u}) {
+        ctx.encrypt_file(in_path, enc_path, 2, chunk).get();
+        Bytes enc = read_bytes(enc_path);
+        if (mode != SymmetricEncryptionMode::RD) {
+          Bytes expected;
+          ctx.encrypt(plain, expected);
+          ASSERT_EQ(enc, expected) << "length " << len << " chunk " << chunk;
+        }
+        ctx.decrypt_file(enc_path, dec_path, 2, chunk).get();
+        ASSERT_EQ(read_bytes(dec_path), plain) << "length " << len << " chunk " << chunk;
+      }
+    }
+  }
+}
+
+TEST(PipelinedFileBackend, DirectIoRoundtrip) {
+  const std::string in_path = "/tmp/pipe_direct_plain.bin";
+  const std::string enc_path = "/tmp/pipe_direct_enc.bin";
+  const std::string dec_path = "/tmp/pipe_direct_dec.bin";
+  Bytes plain = make_data(3 * 4096 + 123, 7, 1);
+  write_bytes(in_path, plain);
+  auto ctx = make_context(SymmetricEncryptionMode::CBC, KEY, 0x21);
+  ctx.set_file_backend(crypto::FileBackend::Pipelined);
+  ctx.set_direct_io(true);
+  ctx.encrypt_file(in_path, enc_path, 1, 5000).get();
+  Bytes expected;
+  ctx.encrypt(plain, expected);
+  ASSERT_EQ(read_bytes(enc_path), expected);
+  ctx.decrypt_file(enc_path, dec_path, 1, 5000).get();
+  ASSERT_EQ(read_bytes(dec_path), plain);
+}
+
+TEST(PipelinedFileBackend, BadPaddingRemovesOutput) {
+  const std::string in_path = "/tmp/pipe_bad.bin";
+  const std::string dec_path = "/tmp/pipe_bad_dec.bin";
+  auto ctx = make_context(SymmetricEncryptionMode::CBC, KEY, 0x21);
+  ctx.set_file_backend(crypto::FileBackend::Pipelined);
+  Bytes enc;
+  ctx.encrypt(make_data(100, 7, 1), enc);
+  enc.back() ^= 0xFF;
+  write_bytes(in_path, enc);
+  ASSERT_THROW(ctx.decrypt_file(in_path, dec_path).get(), std::invalid_argument);
+  ASSERT_FALSE(std::filesystem::exists(dec_path));
+}
+
+TEST(FilePipeline, ThreadAndUringEnginesAgree) {
+  const std::string in_path = "/tmp/pipe_engine_in.bin";
+  const std::string out_path = "/tmp/pipe_engine_out.bin";
+  Bytes data = make_data(100000, 7, 1);
+  write_bytes(in_path, data);
+  // reverses every chunk and appends its length byte, so order and chunk
+  // boundaries both show up in the output
+  auto transform = [](std::span<const Byte> in, std::span<Byte> out, bool last) {
+    std::reverse_copy(in.begin(), in.end(), out.begin());
+    out[in.size()] = static_cast<Byte>(in.size() & 0xFF);
+    if (last) out[in.size() + 1] = 0xEE;
+    return in.size() + (last ? 2 : 1);
+  };
+  crypto::internal::PipelineOptions options;
+  options.chunk_size = 4096;
+  options.output_capacity = 4096 + 2;
+
+  options.allow_io_uring = false;
+  ASSERT_EQ(crypto::internal::run_file_pipeline(in_path, out_path, options, transform),
+            crypto::internal::PipelineEngine::Threads);
+  Bytes threaded = read_bytes(out_path);
+
+  options.allow_io_uring = true;
+  const auto engine =
+      crypto::internal::run_file_pipeline(in_path, out_path, options, transform);
+  if (crypto::internal::io_uring_supported()) {
+    ASSERT_EQ(engine, crypto::internal::PipelineEngine::IoUring);
+  }
+  ASSERT_EQ(read_bytes(out_path), threaded);
+  ASSERT_EQ(threaded.size(), data.size() + (data.size() + 4095) / 4096 + 1);
+  ASSERT_EQ(threaded.back(), 0xEE);
+}
+
+TEST(FilePipeline, TransformErrorPropagates) {
+  const std::string in_path = "/tmp/pipe_throw_in.bin";
+  write_bytes(in_path, make_data(20000, 7, 1));
+  crypto::internal::PipelineOptions options;
+  options.chunk_size = 4096;
+  size_t calls = 0;
+  auto transform = [&](std::span<const Byte>, std::span<Byte>, bool) -> size_t {
+    if (++calls == 3) throw std::runtime_error("boom");
+    return 0;
+  };
+  for (bool uring : {false, true}) {
+    options.allow_io_uring = uring;
+    calls = 0;
+    ASSERT_THROW(crypto::internal::run_file_pipeline(in_path, "/tmp/pipe_throw_out.bin",
+                                                     options, transform),
+                 std::runtime_error);
+  }
+}
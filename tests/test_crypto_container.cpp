@@ -0,0 +1,262 @@
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include "crypto/symmetric/algorithms/des/des.hpp"
+#include "crypto/symmetric/algorithms/twofish/twofish.hpp"
+#include "crypto/symmetric/cipher_context.hpp"
+#include "crypto/symmetric/container.hpp"
+
+#include "common.hpp"
+
+using Bytes = crypto::Bytes;
+using crypto::ContainerReader;
+using crypto::SymmetricEncryptionMode;
+using crypto::SymmetricPaddingScheme;
+
+static const Bytes KEY(16, 0x5A);
+
+static crypto::SymmetricCipherContext container_context(SymmetricEncryptionMode mode) {
+  auto ctx = make_context(mode, KEY, 0x33);
+  ctx.set_file_format(crypto::FileFormat::Container);
+  return ctx;
+}
+
+TEST(Container, RoundtripEveryMode) {
+  const std::string in_path = "/tmp/container_plain.bin";
+  const std::string enc_path = "/tmp/container_enc.bin";
+  const std::string dec_path = "/tmp/container_dec.bin";
+  for (size_t len : {0u, 1u, 1024u, 5000u}) {
+    Bytes plain = make_data(len, 13, 5);
+    write_bytes(in_path, plain);
+    for (auto mode : {SymmetricEncryptionMode::ECB, SymmetricEncryptionMode::CBC,
+                      SymmetricEncryptionMode::PCBC, SymmetricEncryptionMode::CFB,
+                      SymmetricEncryptionMode::OFB, SymmetricEncryptionMode::CTR,
+                      SymmetricEncryptionMode::RD, SymmetricEncryptionMode::GCM,
+                      SymmetricEncryptionMode::XTS, SymmetricEncryptionMode::OCB}) {
+      auto ctx = container_context(mode);
+      if (mode == SymmetricEncryptionMode::XTS && len < 16) {
+        // XTS does not pad and needs at least one block
+        ASSERT_THROW(ctx.encrypt_file(in_path, enc_path, 3, 1024).get(), std::invalid_argument);
+        continue;
+      }
+      ctx.encrypt_file(in_path, enc_path, 3, 1024).get();
+      ctx.decrypt_file(enc_path, dec_path, 3).get();
+      ASSERT_EQ(read_bytes(dec_path), plain)
+          << "mode " << static_cast<int>(mode) << " length " << len;
+    }
+  }
+}
+
+TEST(Container, ParallelMatchesSerialForDeterministicModes) {
+  const std::string in_path = "/tmp/container_par_plain.bin";
+  const std::string enc1_path = "/tmp/container_par_enc1.bin";
+  const std::string enc4_path = "/tmp/container_par_enc4.bin";
+  write_bytes(in_path, make_data(10000, 13, 5));
+  auto ctx = container_context(SymmetricEncryptionMode::CBC);
+  ctx.encrypt_file(in_path, enc1_path, 1, 512).get();
+  ctx.encrypt_file(in_path, enc4_path, 4, 512).get();
+  ASSERT_EQ(read_bytes(enc1_path), read_bytes(enc4_path));
+}
+
+TEST(Container, ChunksUseDistinctIvs) {
+  const std::string in_path = "/tmp/container_iv_plain.bin";
+  const std::string enc_path = "/tmp/container_iv_enc.bin";
+  // identical chunks must not encrypt identically
+  write_bytes(in_path, Bytes(2048, 0xAB));
+  auto ctx = container_context(SymmetricEncryptionMode::CBC);
+  ctx.encrypt_file(in_path, enc_path, 1, 1024).get();
+  Bytes enc = read_bytes(enc_path);
+  const size_t h = crypto::container::HEADER_SIZE;
+  ASSERT_NE(Bytes(enc.begin() + h, enc.begin() + h + 1024),
+            Bytes(enc.begin() + h + 1024, enc.begin() + h + 2048));
+}
+
+TEST(Container, CtrChunksContinueTheCounter) {
+  const std::string in_path = "/tmp/container_ctr_plain.bin";
+  const std::string enc_path = "/tmp/container_ctr_enc.bin";
+  Bytes plain = make_data(4096, 13, 5);
+  write_bytes(in_path, plain);
+  auto ctx = container_context(SymmetricEncryptionMode::CTR);
+  ctx.encrypt_file(in_path, enc_path, 2, 1024).get();
+  Bytes one_shot;
+  ctx.encrypt(plain, one_shot);
+  Bytes enc = read_bytes(enc_path);
+  const size_t h = crypto::container::HEADER_SIZE;
+  ASSERT_EQ(Bytes(enc.begin() + h, enc.begin() + h + 4096),
+            Bytes(one_shot.begin(), one_shot.begin() + 4096));
+}
+
+TEST(Container, RandomAccessReads) {
+  const std::string in_path = "/tmp/container_ra_plain.bin";
+  const std::string enc_path = "/tmp/container_ra_enc.bin";
+  Bytes plain = make_data(10000, 13, 5);
+  write_bytes(in_path, plain);
+  auto ctx = container_context(SymmetricEncryptionMode::CBC);
+  ctx.encrypt_file(in_path, enc_path, 1, 1000).get();
+
+  ContainerReader reader(ctx, enc_path);
+  ASSERT_EQ(reader.size(), plain.size());
+  ASSERT_EQ(reader.chunk_size(), 1008u);
+  ASSERT_EQ(reader.chunk_count(), 10u);
+  for (auto [offset, length] : {std::pair<size_t, size_t>{0, 10}, {1000, 20},
+                                {1007, 2}, {3000, 4000}, {9990, 100}, {0, 10000}}) {
+    Bytes got = reader.read(offset, length, 3);
+    const size_t end = std::min(offset + length, plain.size());
+    ASSERT_EQ(got, Bytes(plain.begin() + offset, plain.begin() + end))
+        << "offset " << offset;
+  }
+  ASSERT_TRUE(reader.read(20000, 5).empty());
+}
+
+TEST(Container, RangeReadTouchesOnlyCoveringChunks) {
+  const std::string in_path = "/tmp/container_touch_plain.bin";
+  const std::string enc_path = "/tmp/container_touch_enc.bin";
+  Bytes plain = make_data(4096, 13, 5);
+  write_bytes(in_path, plain);
+  auto ctx = container_context(SymmetricEncryptionMode::CBC);
+  ctx.encrypt_file(in_path, enc_path, 1, 1024).get();
+
+  // corrupt the padding of the final chunk; the first three stay readable
+  Bytes enc = read_bytes(enc_path);
+  enc[crypto::container::HEADER_SIZE + 3 * 1024 + 1039] ^= 0xFF;
+  write_bytes(enc_path, enc);
+
+  ContainerReader reader(ctx, enc_path);
+  ASSERT_EQ(reader.read(100, 2900), Bytes(plain.begin() + 100, plain.begin() + 3000));
+  ASSERT_THROW(reader.read(4000, 96), std::invalid_argument);
+}
+
+TEST(Container, OverflowingHeaderAndIndexAreRejected) {
+  const std::string in_path = "/tmp/container_overflow_plain.bin";
+  const std::string enc_path = "/tmp/container_overflow_enc.bin";
+  write_bytes(in_path, make_data(100, 13, 5));
+  auto ctx = container_context(SymmetricEncryptionMode::CBC);
+  ctx.encrypt_file(in_path, enc_path, 1, 1024).get();
+  const Bytes good = read_bytes(enc_path);
+
+  auto store = [](Bytes &bytes, size_t at, uint64_t v) {
+    for (int i = 0; i < 8; ++i) bytes[at + i] = static_cast<uint8_t>(v >> (8 * i));
+  };
+  const size_t trailer = good.size() - crypto::container::TRAILER_SIZE;
+
+  // count * 8 wraps to 8, which would pass the size equation
+  Bytes enc = good;
+  const uint64_t count = (uint64_t{1} << 61) + 1;
+  store(enc, 8, 1);
+  store(enc, 16, count);
+  store(enc, trailer, trailer - 8);
+  store(enc, trailer + 8, count);
+  write_bytes(enc_path, enc);
+  ASSERT_THROW(ContainerReader(ctx, enc_path), std::invalid_argument);
+
+  // plaintext_size + chunk_size - 1 wraps in the chunk count
+  enc = good;
+  store(enc, 8, ~uint64_t{0});
+  store(enc, 16, ~uint64_t{0});
+  write_bytes(enc_path, enc);
+  ASSERT_THROW(ContainerReader(ctx, enc_path), std::invalid_argument);
+}
+
+TEST(Container, TamperedGcmChunkThrows) {
+  const std::string in_path = "/tmp/container_gcm_plain.bin";
+  const std::string enc_path = "/tmp/container_gcm_enc.bin";
+  const std::string dec_path = "/tmp/container_gcm_dec.bin";
+  write_bytes(in_path, make_data(3000, 13, 5));
+  auto ctx = container_context(SymmetricEncryptionMode::GCM);
+  ctx.encrypt_file(in_path, enc_path, 2, 1024).get();
+  Bytes enc = read_bytes(enc_path);
+  enc[crypto::container::HEADER_SIZE + 1500] ^= 0x01;
+  write_bytes(enc_path, enc);
+  ASSERT_THROW(ctx.decrypt_file(enc_path, dec_path, 2).get(), std::invalid_argument);
+  ASSERT_FALSE(std::filesystem::exists(dec_path));
+}
+
+TEST(Container, DroppedTrailingAeadChunksAreDetected) {
+  const std::string in_path = "/tmp/container_drop_plain.bin";
+  const std::string enc_path = "/tmp/container_drop_enc.bin";
+  const std::string dec_path = "/tmp/container_drop_dec.bin";
+  write_bytes(in_path, make_data(3000, 13, 5));
+  for (auto mode : {SymmetricEncryptionMode::GCM, SymmetricEncryptionMode::OCB}) {
+    auto ctx = container_context(mode);
+    ctx.encrypt_file(in_path, enc_path, 1, 1024).get();
+    const Bytes enc = read_bytes(enc_path);
+
+    // keep the first two chunks and rewrite the header and index to match
+    const size_t h = crypto::container::HEADER_SIZE;
+    const size_t chunk = 1024 + 16;
+    auto header = crypto::container::decode_header(Bytes(enc.begin(), enc.begin() + h));
+    header.plaintext_size = 2048;
+    Bytes cut = crypto::container::encode_header(header);
+    cut.insert(cut.end(), enc.begin() + h, enc.begin() + h + 2 * chunk);
+    const Bytes index = crypto::container::encode_index({h, h + chunk}, h + 2 * chunk);
+    cut.insert(cut.end(), index.begin(), index.end());
+    write_bytes(enc_path, cut);
+    ASSERT_THROW(ctx.decrypt_file(enc_path, dec_path, 1).get(), std::invalid_argument)
+        << "mode " << static_cast<int>(mode);
+  }
+}
+
+TEST(Container, FilesWithoutIvUseFreshBases) {
+  const std::string in_path = "/tmp/container_noiv_plain.bin";
+  const std::string enc1_path = "/tmp/container_noiv_enc1.bin";
+  const std::string enc2_path = "/tmp/container_noiv_enc2.bin";
+  const std::string dec_path = "/tmp/container_noiv_dec.bin";
+  const Bytes plain = make_data(3000, 13, 5);
+  write_bytes(in_path, plain);
+  for (auto mode : {SymmetricEncryptionMode::CBC, SymmetricEncryptionMode::PCBC,
+                    SymmetricEncryptionMode::CFB, SymmetricEncryptionMode::OFB,
+                    SymmetricEncryptionMode::CTR}) {
+    crypto::SymmetricCipherContext ctx(std::make_unique<crypto::twofish::Twofish>(), mode,
+                                       SymmetricPaddingScheme::PKCS7);
+    ctx.set_encryption_key(KEY);
+    ctx.set_decryption_key(KEY);
+    ctx.set_file_format(crypto::FileFormat::Container);
+    ctx.encrypt_file(in_path, enc1_path, 1, 1024).get();
+    ctx.encrypt_file(in_path, enc2_path, 1, 1024).get();
+
+    // same key, same data: the random bases keep the chunks apart
+    const size_t h = crypto::container::HEADER_SIZE;
+    const Bytes enc1 = read_bytes(enc1_path), enc2 = read_bytes(enc2_path);
+    ASSERT_NE(Bytes(enc1.begin() + h, enc1.begin() + h + 1024),
+              Bytes(enc2.begin() + h, enc2.begin() + h + 1024))
+        << "mode " << static_cast<int>(mode);
+    ctx.decrypt_file(enc2_path, dec_path, 2).get();
+    ASSERT_EQ(read_bytes(dec_path), plain) << "mode " << static_cast<int>(mode);
+  }
+}
+
+TEST(Container, EightByteBlockCipher) {
+  const std::string in_path = "/tmp/container_des_plain.bin";
+  const std::string enc_path = "/tmp/container_des_enc.bin";
+  const std::string dec_path = "/tmp/container_des_dec.bin";
+  Bytes plain = make_data(777, 13, 5);
+  write_bytes(in_path, plain);
+  crypto::SymmetricCipherContext ctx(std::make_unique<crypto::des::DES>(),
+                                     SymmetricEncryptionMode::OFB,
+                                     SymmetricPaddingScheme::PKCS7, Bytes(8, 0x01));
+  ctx.set_encryption_key(Bytes(8, 0x13));
+  ctx.set_file_format(crypto::FileFormat::Container);
+  ctx.encrypt_file(in_path, enc_path, 2, 100).get();
+  ctx.decrypt_file(enc_path, dec_path, 2).get();
+  ASSERT_EQ(read_bytes(dec_path), plain);
+}
+
+TEST(Container, RejectsNonContainerAndCts) {
+  const std::string path = "/tmp/container_bogus.bin";
+  write_bytes(path, make_data(100, 13, 5));
+  auto ctx = container_context(SymmetricEncryptionMode::CBC);
+  ASSERT_THROW(ContainerReader(ctx, path), std::invalid_argument);
+
+  crypto::SymmetricCipherContext cts(std::make_unique<crypto::twofish::Twofish>(),
+                                     SymmetricEncryptionMode::CTS,
+                                     SymmetricPaddingScheme::PKCS7);
+  cts.set_encryption_key(KEY);
+  cts.set_file_format(crypto::FileFormat::Container);
+  ASSERT_THROW(cts.encrypt_file(path, "/tmp/container_cts.bin").get(),
+               std::invalid_argument);
+}
@@ -0,0 +1,145 @@
+#include <memory>
+#include <string>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include "crypto/symmetric/algorithms/des/des.hpp"
+#include "crypto/symmetric/algorithms/twofish/twofish.hpp"
+#include "crypto/symmetric/cipher_context.hpp"
+#include "symmetric/mode/modes.hpp"
+
+#include "common.hpp"
+
+using Bytes = crypto::Bytes;
+
+static const Bytes KEY(16, 0x5C);
+static const Bytes IV(16, 0x0F);
+
+class CTSTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    cipher.set_encryption_key(KEY);
+    cipher.set_decryption_key(KEY);
+  }
+
+  crypto::twofish::Twofish cipher;
+};
+
+// CS3 is CBC over the zero-padded plaintext with the last two blocks swapped
+// and the (now last) penultimate block truncated to the plaintext tail
+static Bytes expected_cs3(crypto::core::SymmetricCipher &cipher, const Bytes &plain) {
+  const size_t bs = cipher.block_size();
+  Bytes padded = plain;
+  padded.resize((plain.size() + bs - 1) / bs * bs, 0);
+  Bytes cbc;
+  crypto::mode::CBC(IV).encrypt(cipher, padded, cbc, 1);
+  if (padded.size() == bs) return cbc;
+
+  const size_t last = padded.size() - bs;
+  Bytes out(cbc.begin(), cbc.begin() + last - bs);
+  out.insert(out.end(), cbc.begin() + last, cbc.end());
+  out.insert(out.end(), cbc.begin() + last - bs,
+             cbc.begin() + last - bs + (plain.size() - last));
+  return out;
+}
+
+TEST_F(CTSTest, MatchesSwappedCbcForAllTailLengths) {
+  crypto::mode::CTS cts(IV);
+  for (size_t len = 16; len <= 16 * 4; ++len) {
+    Bytes plain = make_data(len, 29, 3);
+    Bytes enc;
+    cts.encrypt(cipher, plain, enc, 1);
+    ASSERT_EQ(enc.size(), len);
+    ASSERT_EQ(enc, expected_cs3(cipher, plain)) << "length " << len;
+  }
+}
+
+TEST_F(CTSTest, RoundtripAllTailLengths) {
+  crypto::mode::CTS cts(IV);
+  for (size_t len = 16; len <= 16 * 5; ++len) {
+    Bytes plain = make_data(len, 29, 3);
+    Bytes enc, dec;
+    cts.encrypt(cipher, plain, enc, 1);
+    cts.decrypt(cipher, enc, dec, 3);
+    ASSERT_EQ(dec, plain) << "length " << len;
+  }
+}
+
+TEST_F(CTSTest, ParallelDecryptMatchesSequential) {
+  crypto::mode::CTS cts(IV);
+  Bytes plain = make_data(16 * 200 + 9, 29, 3);
+  Bytes enc, dec1, dec4;
+  cts.encrypt(cipher, plain, enc, 1);
+  cts.decrypt(cipher, enc, dec1, 1);
+  cts.decrypt(cipher, enc, dec4, 4);
+  ASSERT_EQ(dec1, plain);
+  ASSERT_EQ(dec4, plain);
+}
+
+TEST_F(CTSTest, ShorterThanBlockThrows) {
+  crypto::mode::CTS cts;
+  Bytes out;
+  ASSERT_THROW(cts.encrypt(cipher, make_data(15, 29, 3), out, 1), std::invalid_argument);
+  ASSERT_THROW(cts.decrypt(cipher, make_data(15, 29, 3), out, 1), std::invalid_argument);
+}
+
+TEST(CTS, DesEightByteBlocks) {
+  crypto::des::DES cipher;
+  Bytes key = make_data(8, 29, 3);
+  cipher.set_encryption_key(key);
+  cipher.set_decryption_key(key);
+  crypto::mode::CTS cts;
+  for (size_t len : {8u, 9u, 15u, 16u, 21u}) {
+    Bytes plain = make_data(len, 29, 3);
+    Bytes enc, dec;
+    cts.encrypt(cipher, plain, enc, 1);
+    ASSERT_EQ(enc.size(), len);
+    cts.decrypt(cipher, enc, dec, 2);
+    ASSERT_EQ(dec, plain);
+  }
+}
+
+TEST(CTS, ContextSkipsPadding) {
+  crypto::SymmetricCipherContext ctx(std::make_unique<crypto::twofish::Twofish>(),
+                                     crypto::SymmetricEncryptionMode::CTS,
+                                     crypto::SymmetricPaddingScheme::PKCS7, IV);
+  ctx.set_encryption_key(KEY);
+  ctx.set_decryption_key(KEY);
+  Bytes plain = make_data(1000, 29, 3);
+  Bytes enc, dec;
+  ctx.encrypt(plain, enc, 2);
+  ASSERT_EQ(enc.size(), plain.size());
+  ctx.decrypt(enc, dec, 2);
+  ASSERT_EQ(dec, plain);
+}
+
+TEST(CTS, FileRoundtripEveryBackend) {
+  const std::string in_path = "/tmp/cts_file_plain.bin";
+  const std::string enc_path = "/tmp/cts_file_enc.bin";
+  const std::string dec_path = "/tmp/cts_file_dec.bin";
+  crypto::SymmetricCipherContext ctx(std::make_unique<crypto::twofish::Twofish>(),
+                                     crypto::SymmetricEncryptionMode::CTS,
+                                     crypto::SymmetricPaddingScheme::PKCS7, IV);
+  ctx.set_encryption_key(KEY);
+  ctx.set_decryption_key(KEY);
+  for (auto backend : {crypto::FileBackend::Buffered, crypto::FileBackend::Mapped,
+                       crypto::FileBackend::Pipelined}) {
+    ctx.set_file_backend(backend);
+    // tails of every length, and files spanning many 64-byte chunks
+    for (size_t len : {16u, 17u, 31u, 32u, 33u, 48u, 63u, 64u, 65u, 80u, 1000u, 4099u}) {
+      const Bytes plain = make_data(len, 29, 3);
+      write_bytes(in_path, plain);
+      ctx.encrypt_file(in_path, enc_path, 2, 64).get();
+      Bytes expected;
+      ctx.encrypt(plain, expected);
+      ASSERT_EQ(read_bytes(enc_path), expected)
+          << "backend " << static_cast<int>(backend) << " length " << len;
+      ctx.decrypt_file(enc_path, dec_path, 2, 64).get();
+      ASSERT_EQ(read_bytes(dec_path), plain)
+          << "backend " << static_cast<int>(backend) << " length " << len;
+    }
+    write_bytes(in_path, make_data(15, 29, 3));
+    ASSERT_THROW(ctx.encrypt_file(in_path, enc_path).get(), std::invalid_argument);
+  }
+}
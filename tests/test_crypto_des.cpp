@@ -42,6 +42,18 @@ TEST(DES_tests, max_value_key_and_block) {
   EXPECT_EQ(block, dec) << "Decryption failed for all-0xFF block/key";
 }
 
+TEST(DES_tests, key_schedule_known_answer) {
+  // subkeys K1, K2 and K16 from the worked example in J. Orlin Grabbe,
+  // "The DES Algorithm Illustrated"
+  std::vector<uint8_t> key = {0x13, 0x34, 0x57, 0x79, 0x9B, 0xBC, 0xDF, 0xF1};
+  auto round_keys = DES::KeyExpansionDES().expand(key);
+
+  ASSERT_EQ(round_keys.size(), 16u);
+  EXPECT_EQ(vec_to_hex(round_keys[0]), "1b02effc7072");
+  EXPECT_EQ(vec_to_hex(round_keys[1]), "79aed9dbc9e5");
+  EXPECT_EQ(vec_to_hex(round_keys[15]), "cb3d8b0e17f5");
+}
+
 TEST(DES_tests, symmetric_encryption) {
   DES des;
   std::vector<uint8_t> key = {0x10, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF};
@@ -0,0 +1,156 @@
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include "crypto/symmetric/algorithms/twofish/twofish.hpp"
+#include "crypto/symmetric/cipher_context.hpp"
+#include "crypto/symmetric/file_scheduler.hpp"
+
+#include "common.hpp"
+
+namespace fs = std::filesystem;
+using Bytes = crypto::Bytes;
+using crypto::CipherDirection;
+using crypto::FileCryptoScheduler;
+using crypto::FileJob;
+
+static const Bytes KEY(16, 0x42);
+
+TEST(FileCryptoScheduler, ManyFilesRoundtrip) {
+  const fs::path dir = "/tmp/scheduler_many";
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+  auto ctx = make_context(crypto::SymmetricEncryptionMode::CBC, KEY, 0x09);
+
+  std::vector<FileJob> enc_jobs, dec_jobs;
+  std::vector<Bytes> plains;
+  for (size_t i = 0; i < 200; ++i) {
+    const std::string base = (dir / ("f" + std::to_string(i))).string();
+    plains.push_back(make_data((i * 97) % 3000, 11, i));
+    write_bytes(base, plains.back());
+    enc_jobs.push_back({base, base + ".enc"});
+    dec_jobs.push_back({base + ".enc", base + ".dec"});
+  }
+
+  FileCryptoScheduler scheduler(ctx, 4);
+  for (auto &f : scheduler.submit(enc_jobs, CipherDirection::Encrypt)) f.get();
+  auto dec = scheduler.submit(dec_jobs, CipherDirection::Decrypt);
+  scheduler.wait();
+  for (size_t i = 0; i < dec.size(); ++i) {
+    dec[i].get();
+    ASSERT_EQ(read_bytes(dec_jobs[i].output_path), plains[i]) << "file " << i;
+  }
+
+  const auto p = scheduler.progress();
+  ASSERT_EQ(p.files_total, 400u);
+  ASSERT_EQ(p.files_done, 400u);
+  ASSERT_EQ(p.files_failed, 0u);
+  ASSERT_EQ(p.bytes_done, p.bytes_total);
+}
+
+TEST(FileCryptoScheduler, DirectoryTree) {
+  const fs::path src = "/tmp/scheduler_tree_src";
+  const fs::path enc = "/tmp/scheduler_tree_enc";
+  const fs::path dec = "/tmp/scheduler_tree_dec";
+  for (const auto &d : {src, enc, dec}) fs::remove_all(d);
+  fs::create_directories(src / "a" / "b");
+  write_bytes((src / "top.bin").string(), make_data(100, 11, 1));
+  write_bytes((src / "a" / "mid.bin").string(), make_data(5000, 11, 2));
+  write_bytes((src / "a" / "b" / "deep.bin").string(), make_data(0, 11, 3));
+
+  auto ctx = make_context(crypto::SymmetricEncryptionMode::CBC, KEY, 0x09);
+  FileCryptoScheduler scheduler(ctx, 2);
+  auto enc_futures = scheduler.submit_directory(src.string(), enc.string(),
+                                                CipherDirection::Encrypt, ".enc");
+  ASSERT_EQ(enc_futures.size(), 3u);
+  for (auto &f : enc_futures) f.get();
+  ASSERT_TRUE(fs::exists(enc / "a" / "b" / "deep.bin.enc"));
+
+  for (auto &f : scheduler.submit_directory(enc.string(), dec.string(),
+                                            CipherDirection::Decrypt)) {
+    f.get();
+  }
+  ASSERT_EQ(read_bytes((dec / "a" / "mid.bin.enc").string()), make_data(5000, 11, 2));
+  ASSERT_EQ(read_bytes((dec / "top.bin.enc").string()), make_data(100, 11, 1));
+  ASSERT_TRUE(read_bytes((dec / "a" / "b" / "deep.bin.enc").string()).empty());
+}
+
+TEST(FileCryptoScheduler, FailuresAreReportedPerFile) {
+  const std::string good = "/tmp/scheduler_good.bin";
+  write_bytes(good, make_data(64, 11, 5));
+  auto ctx = make_context(crypto::SymmetricEncryptionMode::CBC, KEY, 0x09);
+  FileCryptoScheduler scheduler(ctx, 2);
+  auto futures = scheduler.submit({{"/tmp/scheduler_missing.bin", "/tmp/scheduler_missing.enc"},
+                                   {good, good + ".enc"}},
+                                  CipherDirection::Encrypt);
+  ASSERT_THROW(futures[0].get(), std::runtime_error);
+  ASSERT_NO_THROW(futures[1].get());
+  scheduler.wait();
+  ASSERT_EQ(scheduler.progress().files_failed, 1u);
+}
+
+TEST(FileCryptoScheduler, DestructorFinishesQueuedWork) {
+  const std::string in = "/tmp/scheduler_dtor.bin";
+  write_bytes(in, make_data(10000, 11, 7));
+  auto ctx = make_context(crypto::SymmetricEncryptionMode::CBC, KEY, 0x09);
+  std::vector<std::future<void>> futures;
+  {
+    FileCryptoScheduler scheduler(ctx, 1);
+    std::vector<FileJob> jobs;
+    for (int i = 0; i < 20; ++i) jobs.push_back({in, in + ".enc" + std::to_string(i)});
+    futures = scheduler.submit(jobs, CipherDirection::Encrypt);
+  }
+  for (auto &f : futures) ASSERT_NO_THROW(f.get());
+}
+
+TEST(FileCryptoScheduler, MissingDirectoryThrows) {
+  auto ctx = make_context(crypto::SymmetricEncryptionMode::CBC, KEY, 0x09);
+  FileCryptoScheduler scheduler(ctx, 1);
+  ASSERT_THROW(scheduler.submit_directory("/tmp/scheduler_no_such_dir", "/tmp/x",
+                                          CipherDirection::Encrypt),
+               std::invalid_argument);
+}
+
+TEST(FileCryptoScheduler, SmallFilesGoAheadOfLargeOnes) {
+  const fs::path dir = "/tmp/scheduler_order";
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+  std::vector<FileJob> jobs;
+  // large files are queued first
+  for (size_t i = 0; i < 2; ++i) {
+    const std::string path = (dir / ("large" + std::to_string(i))).string();
+    write_bytes(path, make_data(8192 + i, 11, i));
+    jobs.push_back({path, path + ".enc"});
+  }
+  for (size_t i = 0; i < 6; ++i) {
+    const std::string path = (dir / ("small" + std::to_string(i))).string();
+    write_bytes(path, make_data(100 + i, 11, i));
+    jobs.push_back({path, path + ".enc"});
+  }
+
+  auto ctx = make_context(crypto::SymmetricEncryptionMode::CBC, KEY, 0x09);
+  FileCryptoScheduler scheduler(ctx, 1, 1, crypto::SymmetricCipherContext::DEFAULT_FILE_CHUNK, 4096);
+  std::vector<std::string> done;
+  scheduler.on_file_done([&](const FileJob &job) {
+    done.push_back(fs::path(job.input_path).filename().string());
+  });
+  for (auto &f : scheduler.submit(jobs, CipherDirection::Encrypt)) f.get();
+  scheduler.wait();
+
+  // a burst of small files, then a large one, and so on
+  const std::vector<std::string> expected = {"small0", "small1", "small2", "small3",
+                                             "large0", "small4", "small5", "large1"};
+  ASSERT_EQ(done, expected);
+}
+
+TEST(FileCryptoScheduler, LargeFilesLeaveWorkersForSmallOnes) {
+  auto ctx = make_context(crypto::SymmetricEncryptionMode::CBC, KEY, 0x09);
+  ASSERT_EQ(FileCryptoScheduler(ctx, 1).large_slots(), 1u);
+  ASSERT_EQ(FileCryptoScheduler(ctx, 2).large_slots(), 1u);
+  ASSERT_EQ(FileCryptoScheduler(ctx, 3).large_slots(), 1u);
+  ASSERT_EQ(FileCryptoScheduler(ctx, 8).large_slots(), 4u);
+}
@@ -0,0 +1,215 @@
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "crypto/symmetric/algorithms/mars/mars.hpp"
+#include "crypto/symmetric/algorithms/twofish/twofish.hpp"
+#include "crypto/symmetric/cipher_context.hpp"
+#include "symmetric/mode/ghash.hpp"
+#include "symmetric/mode/modes.hpp"
+
+#include "common.hpp"
+
+using Bytes = crypto::Bytes;
+using crypto::mode::GHash;
+
+static GHash::Block block_from_hex(const std::string &hex) {
+  GHash::Block b{};
+  Bytes raw = from_hex(hex);
+  std::copy(raw.begin(), raw.end(), b.begin());
+  return b;
+}
+
+static const Bytes KEY = from_hex("000102030405060708090a0b0c0d0e0f");
+
+TEST(GHash, NistTestCase2TableBackend) {
+  // NIST GCM test case 2: GHASH(H, {}, C) = T ^ E(K, Y0)
+  GHash ghash(block_from_hex("66e94bd4ef8a2c3b884cfa59ca342b2e"), GHash::Backend::Table);
+  Bytes c = from_hex("0388dace60b6a392f328c2b971b2fe78");
+  GHash::Block y{};
+  ghash.absorb(y, c.data(), 1);
+  ghash.absorb_lengths(y, 0, c.size());
+  ASSERT_EQ(y, block_from_hex("f38cbb1ad69223dcc3457ae5b6b0f885"));
+}
+
+TEST(GHash, ClmulMatchesTableOnAggregatedBlocks) {
+  if (!GHash::clmul_supported()) {
+    GTEST_SKIP() << "PCLMULQDQ not available";
+  }
+  const auto h = block_from_hex("66e94bd4ef8a2c3b884cfa59ca342b2e");
+  Bytes data = from_hex(
+      "cd613e30d8f16adf91b7584a2265b1f51e2feb89414c343c1027c4d1c386bbc4"
+      "78e510617311d8a3c2ce6f447ed4d57b35bf992dc9e9c616612e7696a6cecc1b"
+      "e4b06ce60741c7a87ce42c8218072e8c9b810e766ec9d28663ca828dd5f4b3b2"
+      "b2221a58008a05a6c4647159c324c985cd447e35b8b6d8fe442e3d437204e52d"
+      "1a2b8f1ff1fd42a29755d4c13a90293105b6e6e307d4bedc51431193e6c3f339"
+      "025b413f8a9a021ea648a7dd06839eb9");
+  const auto expected = block_from_hex("d821d091457c8cbe968c736f92bd5a63");
+
+  GHash table(h, GHash::Backend::Table);
+  GHash clmul(h, GHash::Backend::Clmul);
+  GHash::Block y1{}, y2{};
+  table.absorb(y1, data.data(), 11);
+  clmul.absorb(y2, data.data(), 11);
+  ASSERT_EQ(y1, expected);
+  ASSERT_EQ(y2, expected);
+}
+
+TEST(GHash, PowerStitchesPartialAccumulators) {
+  GHash ghash(block_from_hex("b83b533708bf535d0aa6e52980d53b78"));
+  Bytes data = make_data(16 * 9, 31, 7);
+  GHash::Block whole{}, left{}, right{};
+  ghash.absorb(whole, data.data(), 9);
+  ghash.absorb(left, data.data(), 4);
+  ghash.absorb(right, data.data() + 64, 5);
+  GHash::Block stitched = GHash::multiply(left, ghash.power(5));
+  for (size_t i = 0; i < 16; ++i) stitched[i] ^= right[i];
+  ASSERT_EQ(stitched, whole);
+}
+
+TEST(GCM, TwofishRoundtrip) {
+  crypto::twofish::Twofish cipher;
+  cipher.set_encryption_key(KEY);
+  crypto::mode::GCM gcm(from_hex("cafebabefacedbaddecaf888"), from_hex("feedfacedeadbeef"));
+  Bytes plain = make_data(100, 31, 7);
+  Bytes enc, dec;
+  gcm.encrypt(cipher, plain, enc, 1);
+  ASSERT_EQ(enc.size(), plain.size() + crypto::mode::GCM::TAG_SIZE);
+  gcm.decrypt(cipher, enc, dec, 1);
+  ASSERT_EQ(dec, plain);
+}
+
+TEST(GCM, MarsRoundtripNonStandardIv) {
+  crypto::mars::MARS cipher;
+  cipher.set_encryption_key(KEY);
+  crypto::mode::GCM gcm(from_hex("9313225df88406e555909c5aff5269aa"));
+  Bytes plain = make_data(33, 31, 7);
+  Bytes enc, dec;
+  gcm.encrypt(cipher, plain, enc, 2);
+  gcm.decrypt(cipher, enc, dec, 2);
+  ASSERT_EQ(dec, plain);
+}
+
+TEST(GCM, ParallelMatchesSequential) {
+  crypto::twofish::Twofish cipher;
+  cipher.set_encryption_key(KEY);
+  crypto::mode::GCM gcm(Bytes(12, 0x42), from_hex("0102"));
+  Bytes plain = make_data(16 * 77 + 5, 31, 7);
+  Bytes enc1, enc4;
+  gcm.encrypt(cipher, plain, enc1, 1);
+  gcm.encrypt(cipher, plain, enc4, 4);
+  ASSERT_EQ(enc1, enc4);
+}
+
+TEST(GCM, TamperedCiphertextThrows) {
+  crypto::twofish::Twofish cipher;
+  cipher.set_encryption_key(KEY);
+  crypto::mode::GCM gcm(Bytes(12, 0x24));
+  Bytes plain = make_data(48, 31, 7);
+  Bytes enc, dec;
+  gcm.encrypt(cipher, plain, enc, 1);
+  enc[5] ^= 0x01;
+  ASSERT_THROW(gcm.decrypt(cipher, enc, dec, 1), std::invalid_argument);
+  ASSERT_TRUE(dec.empty());
+}
+
+TEST(GCM, WrongAadThrows) {
+  crypto::twofish::Twofish cipher;
+  cipher.set_encryption_key(KEY);
+  crypto::mode::GCM enc_mode(Bytes(12, 0x01), from_hex("aabb"));
+  crypto::mode::GCM dec_mode(Bytes(12, 0x01), from_hex("aabc"));
+  Bytes enc, dec;
+  enc_mode.encrypt(cipher, make_data(20, 31, 7), enc, 1);
+  ASSERT_THROW(dec_mode.decrypt(cipher, enc, dec, 1), std::invalid_argument);
+}
+
+TEST(GCM, EmptyPlaintextProducesTagOnly) {
+  crypto::mars::MARS cipher;
+  cipher.set_encryption_key(KEY);
+  crypto::mode::GCM gcm(Bytes(12, 0x24));
+  Bytes enc, dec;
+  gcm.encrypt(cipher, {}, enc, 1);
+  ASSERT_EQ(enc.size(), crypto::mode::GCM::TAG_SIZE);
+  gcm.decrypt(cipher, enc, dec, 1);
+  ASSERT_TRUE(dec.empty());
+}
+
+TEST(GCM, RejectsEightByteBlockCipher) {
+  crypto::mode::GCM gcm(Bytes(12, 0x24));
+  class Des8 final : public crypto::core::SymmetricCipher {
+  public:
+    void set_encryption_key(const Bytes &) override {}
+    void set_decryption_key(const Bytes &) override {}
+    Bytes encrypt_block(const Bytes &b) const override { return b; }
+    Bytes decrypt_block(const Bytes &b) const override { return b; }
+    size_t block_size() const override { return 8; }
+  } cipher;
+  Bytes out;
+  ASSERT_THROW(gcm.encrypt(cipher, Bytes(16, 0), out, 1), std::invalid_argument);
+}
+
+TEST(GCM, ContextRoundtrip) {
+  crypto::SymmetricCipherContext ctx(std::make_unique<crypto::twofish::Twofish>(),
+                                     crypto::SymmetricEncryptionMode::GCM,
+                                     crypto::SymmetricPaddingScheme::PKCS7,
+                                     Bytes(12, 0x07));
+  ctx.set_encryption_key(KEY);
+  Bytes plain = make_data(1000, 31, 7);
+  Bytes enc, dec;
+  ctx.encrypt(plain, enc, 3);
+  ctx.decrypt(enc, dec, 3);
+  ASSERT_EQ(dec, plain);
+}
+
+TEST(GCM, RequiresAnIv) {
+  ASSERT_THROW(crypto::mode::GCM(Bytes{}), std::invalid_argument);
+  ASSERT_THROW(crypto::SymmetricCipherContext(std::make_unique<crypto::twofish::Twofish>(),
+                                              crypto::SymmetricEncryptionMode::GCM,
+                                              crypto::SymmetricPaddingScheme::Zeros),
+               std::invalid_argument);
+}
+
+// NIST GCM test cases 1 and 3 (AES-128, no AAD) through the context: the
+// output is exactly ciphertext || tag, with no padding in between.
+TEST(GCM, ContextMatchesNistVectors) {
+  const Bytes iv = from_hex("cafebabefacedbaddecaf888");
+  crypto::SymmetricCipherContext ctx(std::make_unique<Aes128>(),
+                                     crypto::SymmetricEncryptionMode::GCM,
+                                     crypto::SymmetricPaddingScheme::PKCS7, iv);
+  ctx.set_encryption_key(from_hex("feffe9928665731c6d6a8f9467308308"));
+  const Bytes plain = from_hex(
+      "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+      "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255");
+  const Bytes expected = from_hex(
+      "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+      "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091473f5985"
+      "4d5c2af327cd64a62cf35abd2ba6fab4");
+  Bytes enc, dec;
+  ctx.encrypt(plain, enc, 2);
+  ASSERT_EQ(enc, expected);
+  ctx.decrypt(enc, dec, 2);
+  ASSERT_EQ(dec, plain);
+
+  crypto::SymmetricCipherContext zero(std::make_unique<Aes128>(),
+                                      crypto::SymmetricEncryptionMode::GCM,
+                                      crypto::SymmetricPaddingScheme::PKCS7, Bytes(12, 0x00));
+  zero.set_encryption_key(Bytes(16, 0x00));
+  zero.encrypt({}, enc, 1);
+  ASSERT_EQ(enc, from_hex("58e2fccefa7e3061367f1d57a4e7455a"));
+}
+
+TEST(GCM, ContextDoesNotPad) {
+  crypto::SymmetricCipherContext ctx(std::make_unique<crypto::twofish::Twofish>(),
+                                     crypto::SymmetricEncryptionMode::GCM,
+                                     crypto::SymmetricPaddingScheme::PKCS7,
+                                     Bytes(12, 0x07));
+  ctx.set_encryption_key(KEY);
+  Bytes plain = make_data(20, 31, 7);
+  Bytes enc, dec;
+  ctx.encrypt(plain, enc, 1);
+  ASSERT_EQ(enc.size(), plain.size() + crypto::mode::GCM::TAG_SIZE);
+  ctx.decrypt(enc, dec, 1);
+  ASSERT_EQ(dec, plain);
+}
@@ -0,0 +1,157 @@
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "crypto/symmetric/algorithms/des/des.hpp"
+#include "crypto/symmetric/algorithms/mars/mars.hpp"
+#include "crypto/symmetric/algorithms/twofish/twofish.hpp"
+#include "crypto/symmetric/cipher_context.hpp"
+#include "crypto/symmetric/key_schedule.hpp"
+#include "internal/secure_wipe.hpp"
+
+using Bytes = crypto::Bytes;
+using crypto::KeyScheduleCache;
+using crypto::SymmetricAlgorithm;
+
+static Bytes key_for(size_t i, size_t size = 16) {
+  Bytes key(size);
+  for (size_t j = 0; j < size; ++j) key[j] = static_cast<uint8_t>(i * 31 + j);
+  return key;
+}
+
+TEST(KeySchedule, MatchesDirectlyKeyedCipher) {
+  const Bytes key = key_for(1, 8);
+  auto schedule = crypto::make_key_schedule(SymmetricAlgorithm::DES, key);
+  crypto::des::DES des;
+  des.set_encryption_key(key);
+  des.set_decryption_key(key);
+  const Bytes block(8, 0x3C);
+  ASSERT_EQ(schedule->encrypt_block(block), des.encrypt_block(block));
+  ASSERT_EQ(schedule->decrypt_block(schedule->encrypt_block(block)), block);
+}
+
+TEST(KeySchedule, SharedByContexts) {
+  const Bytes key = key_for(2);
+  auto schedule = crypto::make_key_schedule(SymmetricAlgorithm::Twofish, key);
+  crypto::SymmetricCipherContext shared1(schedule, crypto::SymmetricEncryptionMode::CBC,
+                                         crypto::SymmetricPaddingScheme::PKCS7);
+  crypto::SymmetricCipherContext shared2(schedule, crypto::SymmetricEncryptionMode::CBC,
+                                         crypto::SymmetricPaddingScheme::PKCS7);
+  crypto::SymmetricCipherContext owned(std::make_unique<crypto::twofish::Twofish>(),
+                                       crypto::SymmetricEncryptionMode::CBC,
+                                       crypto::SymmetricPaddingScheme::PKCS7);
+  owned.set_encryption_key(key);
+
+  const Bytes plain(100, 0x11);
+  Bytes a, b, dec;
+  shared1.encrypt(plain, a);
+  owned.encrypt(plain, b);
+  ASSERT_EQ(a, b);
+  shared2.decrypt(a, dec);
+  ASSERT_EQ(dec, plain);
+  ASSERT_EQ(schedule.use_count(), 3);
+}
+
+TEST(KeySchedule, SharedContextRejectsRekeying) {
+  crypto::SymmetricCipherContext ctx(
+      crypto::make_key_schedule(SymmetricAlgorithm::MARS, key_for(3)),
+      crypto::SymmetricEncryptionMode::ECB, crypto::SymmetricPaddingScheme::PKCS7);
+  ASSERT_THROW(ctx.set_encryption_key(key_for(4)), std::logic_error);
+  ASSERT_THROW(ctx.set_decryption_key(key_for(4)), std::logic_error);
+}
+
+TEST(KeySchedule, SharedTweakSchedule) {
+  auto data_key = crypto::make_key_schedule(SymmetricAlgorithm::Twofish, key_for(5));
+  auto tweak_key = crypto::make_key_schedule(SymmetricAlgorithm::Twofish, key_for(6));
+  crypto::SymmetricCipherContext ctx(data_key, tweak_key, crypto::SymmetricEncryptionMode::XTS,
+                                     crypto::SymmetricPaddingScheme::PKCS7);
+  ASSERT_THROW(ctx.set_tweak_key(key_for(7)), std::logic_error);
+  const Bytes plain(1000, 0x42);
+  Bytes enc, dec;
+  ctx.encrypt(plain, enc);
+  ctx.decrypt(enc, dec);
+  ASSERT_EQ(dec, plain);
+}
+
+TEST(KeyScheduleCache, HitsMissesAndEviction) {
+  KeyScheduleCache cache(2);
+  auto a = cache.get(SymmetricAlgorithm::Twofish, key_for(1));
+  auto b = cache.get(SymmetricAlgorithm::Twofish, key_for(2));
+  ASSERT_EQ(cache.get(SymmetricAlgorithm::Twofish, key_for(1)), a);
+  // key 2 is now least recently used and goes first
+  auto c = cache.get(SymmetricAlgorithm::Twofish, key_for(3));
+  ASSERT_EQ(cache.get(SymmetricAlgorithm::Twofish, key_for(1)), a);
+  ASSERT_NE(cache.get(SymmetricAlgorithm::Twofish, key_for(2)), b);
+
+  const auto stats = cache.stats();
+  ASSERT_EQ(stats.hits, 2u);
+  ASSERT_EQ(stats.misses, 4u);
+  ASSERT_EQ(stats.evictions, 2u);
+  ASSERT_EQ(stats.size, 2u);
+
+  // evicted schedules stay valid for holders
+  const Bytes block(16, 0x01);
+  ASSERT_EQ(b->decrypt_block(b->encrypt_block(block)), block);
+}
+
+TEST(KeyScheduleCache, AlgorithmIsPartOfTheKey) {
+  KeyScheduleCache cache(4);
+  auto twofish = cache.get(SymmetricAlgorithm::Twofish, key_for(9));
+  auto mars = cache.get(SymmetricAlgorithm::MARS, key_for(9));
+  ASSERT_NE(twofish, mars);
+  ASSERT_EQ(cache.stats().misses, 2u);
+}
+
+TEST(KeyScheduleCache, ConcurrentLookups) {
+  KeyScheduleCache cache(8);
+  std::atomic<size_t> wrong{0};
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 8; ++t) {
+    threads.emplace_back([&, t]() {
+      for (size_t i = 0; i < 200; ++i) {
+        const Bytes key = key_for((i + t) % 12);
+        auto schedule = cache.get(SymmetricAlgorithm::Twofish, key);
+        crypto::twofish::Twofish direct;
+        direct.set_encryption_key(key);
+        const Bytes block(16, static_cast<uint8_t>(i));
+        if (schedule->encrypt_block(block) != direct.encrypt_block(block)) ++wrong;
+      }
+    });
+  }
+  for (auto &t : threads) t.join();
+  ASSERT_EQ(wrong.load(), 0u);
+  const auto stats = cache.stats();
+  ASSERT_EQ(stats.hits + stats.misses, 1600u);
+  ASSERT_LE(stats.size, 8u);
+}
+
+TEST(KeyScheduleCache, ZeroCapacityThrows) {
+  ASSERT_THROW(KeyScheduleCache(0), std::invalid_argument);
+}
+
+TEST(SecureWipe, ZeroesBuffers) {
+  Bytes key = key_for(1);
+  crypto::internal::secure_wipe(key);
+  ASSERT_EQ(key, Bytes(16, 0));
+  std::array<uint32_t, 4> words{1, 2, 3, 4};
+  crypto::internal::secure_wipe(words);
+  ASSERT_EQ(words, (std::array<uint32_t, 4>{}));
+}
+
+template <typename Cipher>
+static void expect_rejected_rekey_drops_old_schedule(size_t bad_key_size) {
+  Cipher keyed, fresh;
+  keyed.set_encryption_key(key_for(1));
+  ASSERT_THROW(keyed.set_encryption_key(Bytes(bad_key_size, 0x5A)), std::invalid_argument);
+  const Bytes block(16, 0x3C);
+  ASSERT_EQ(keyed.encrypt_block(block), fresh.encrypt_block(block));
+}
+
+TEST(SecureWipe, RejectedRekeyDropsOldSchedule) {
+  expect_rejected_rekey_drops_old_schedule<crypto::twofish::Twofish>(20);
+  expect_rejected_rekey_drops_old_schedule<crypto::mars::MARS>(15);
+}
@@ -0,0 +1,134 @@
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "crypto/symmetric/algorithms/mars/mars.hpp"
+#include "crypto/symmetric/algorithms/twofish/twofish.hpp"
+#include "symmetric/mac/macs.hpp"
+
+#include "common.hpp"
+
+using Bytes = crypto::Bytes;
+
+class XorCipher final : public crypto::core::SymmetricCipher {
+public:
+  explicit XorCipher(size_t bs = 16) : m_bs(bs) {}
+  void set_encryption_key(const Bytes &) override {}
+  void set_decryption_key(const Bytes &) override {}
+  Bytes encrypt_block(const Bytes &b) const override {
+    Bytes out(b);
+    for (auto &byte : out) byte ^= 0xAA;
+    return out;
+  }
+  Bytes decrypt_block(const Bytes &b) const override { return encrypt_block(b); }
+  size_t block_size() const override { return m_bs; }
+private:
+  size_t m_bs;
+};
+
+static const Bytes KEY(16, 0x3C);
+
+// RFC 4493, section 4: AES-128 CMAC
+TEST(CMAC, MatchesRfc4493) {
+  Aes128 cipher;
+  cipher.set_encryption_key(from_hex("2b7e151628aed2a6abf7158809cf4f3c"));
+  crypto::mac::CMAC cmac(cipher);
+  const Bytes msg = from_hex("6bc1bee22e409f96e93d7e117393172a"
+                             "ae2d8a571e03ac9c9eb76fac45af8e51"
+                             "30c81c46a35ce411e5fbc1191a0a52ef"
+                             "f69f2445df4f9b17ad2b417be66c3710");
+  ASSERT_EQ(cmac.compute({}), from_hex("bb1d6929e95937287fa37d129b756746"));
+  ASSERT_EQ(cmac.compute(Bytes(msg.begin(), msg.begin() + 16)),
+            from_hex("070a16b46b4d4144f79bdd9dd04a287c"));
+  ASSERT_EQ(cmac.compute(Bytes(msg.begin(), msg.begin() + 40)),
+            from_hex("dfa66747de9ae63030ca32611497c827"));
+  ASSERT_EQ(cmac.compute(msg), from_hex("51f0bebf7e3b9d92fc49741779363cfe"));
+}
+
+// PMAC1 reference vectors for AES-128 (Krovetz and Rogaway's pmac.c): key
+// and message are the byte sequences 00 01 02 ...
+TEST(PMAC, MatchesReferenceVectors) {
+  Aes128 cipher;
+  cipher.set_encryption_key(from_hex("000102030405060708090a0b0c0d0e0f"));
+  crypto::mac::PMAC pmac(cipher);
+  auto counting = [](size_t n) {
+    Bytes out(n);
+    for (size_t i = 0; i < n; ++i) out[i] = static_cast<uint8_t>(i);
+    return out;
+  };
+  ASSERT_EQ(pmac.compute({}), from_hex("4399572cd6ea5341b8d35876a7098af7"));
+  ASSERT_EQ(pmac.compute(counting(3)), from_hex("256ba5193c1b991b4df0c51f388a9e27"));
+  ASSERT_EQ(pmac.compute(counting(16)), from_hex("ebbd822fa458daf6dfdad7c27da76338"));
+  ASSERT_EQ(pmac.compute(counting(20)), from_hex("0412ca150bbf79058d8c75a58c993f55"));
+}
+
+TEST(CMAC, StreamingMatchesOneShot) {
+  crypto::twofish::Twofish cipher;
+  cipher.set_encryption_key(KEY);
+  crypto::mac::CMAC cmac(cipher);
+  Bytes msg = make_data(333, 7, 9);
+  for (size_t chunk : {1u, 5u, 16u, 17u, 64u, 333u}) {
+    for (size_t off = 0; off < msg.size(); off += chunk) {
+      cmac.update(msg.data() + off, std::min(chunk, msg.size() - off));
+    }
+    ASSERT_EQ(cmac.finalize(), cmac.compute(msg)) << "chunk " << chunk;
+  }
+}
+
+TEST(PMAC, StreamingMatchesOneShot) {
+  crypto::mars::MARS cipher;
+  cipher.set_encryption_key(KEY);
+  crypto::mac::PMAC pmac(cipher, 3);
+  Bytes msg = make_data(16 * 40, 11, 4);
+  for (size_t chunk : {1u, 15u, 16u, 48u, 100u, 640u}) {
+    for (size_t off = 0; off < msg.size(); off += chunk) {
+      pmac.update(msg.data() + off, std::min(chunk, msg.size() - off));
+    }
+    ASSERT_EQ(pmac.finalize(), pmac.compute(msg)) << "chunk " << chunk;
+  }
+}
+
+TEST(PMAC, ParallelMatchesSequential) {
+  crypto::twofish::Twofish cipher;
+  cipher.set_encryption_key(KEY);
+  crypto::mac::PMAC pmac(cipher);
+  Bytes msg = make_data(16 * 123 + 7, 13, 1);
+  ASSERT_EQ(pmac.compute(msg, 1), pmac.compute(msg, 4));
+}
+
+TEST(CMAC, RekeyAfterKeyChange) {
+  crypto::twofish::Twofish cipher;
+  cipher.set_encryption_key(KEY);
+  crypto::mac::CMAC cmac(cipher);
+  Bytes msg = make_data(40, 1, 0);
+  Bytes tag1 = cmac.compute(msg);
+  cipher.set_encryption_key(Bytes(16, 0x01));
+  cmac.rekey();
+  ASSERT_NE(cmac.compute(msg), tag1);
+}
+
+TEST(MAC, VerifyBatch) {
+  crypto::twofish::Twofish cipher;
+  cipher.set_encryption_key(KEY);
+  crypto::mac::CMAC cmac(cipher);
+  std::vector<Bytes> messages, tags;
+  for (size_t i = 0; i < 50; ++i) {
+    messages.push_back(make_data(i * 3, i, 1));
+    tags.push_back(cmac.compute(messages.back()));
+  }
+  tags[7][0] ^= 0x01;
+  tags[31].pop_back();
+
+  auto ok = cmac.verify_batch(messages, tags, 4);
+  ASSERT_EQ(ok.size(), messages.size());
+  for (size_t i = 0; i < ok.size(); ++i) {
+    ASSERT_EQ(ok[i], i != 7 && i != 31) << "message " << i;
+  }
+  ASSERT_THROW(cmac.verify_batch(messages, {}, 1), std::invalid_argument);
+}
+
+TEST(PMAC, RejectsEightByteBlockCipher) {
+  XorCipher cipher(8);
+  ASSERT_THROW(crypto::mac::PMAC pmac(cipher), std::invalid_argument);
+}
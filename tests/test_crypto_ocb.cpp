@@ -0,0 +1,173 @@
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "crypto/symmetric/algorithms/mars/mars.hpp"
+#include "crypto/symmetric/algorithms/twofish/twofish.hpp"
+#include "crypto/symmetric/cipher_context.hpp"
+#include "symmetric/mode/l_table.hpp"
+#include "symmetric/mode/modes.hpp"
+
+#include "common.hpp"
+
+using Bytes = crypto::Bytes;
+using crypto::mode::LTable;
+
+class XorCipher final : public crypto::core::SymmetricCipher {
+public:
+  void set_encryption_key(const Bytes &) override {}
+  void set_decryption_key(const Bytes &) override {}
+  Bytes encrypt_block(const Bytes &b) const override {
+    Bytes out(b);
+    for (auto &byte : out) byte ^= 0xAA;
+    return out;
+  }
+  Bytes decrypt_block(const Bytes &b) const override { return encrypt_block(b); }
+  size_t block_size() const override { return 16; }
+};
+
+static const Bytes KEY(16, 0x5C);
+
+TEST(LTable, HalveInvertsDouble) {
+  LTable::Block b{};
+  for (size_t i = 0; i < 16; ++i) b[i] = static_cast<uint8_t>(0xF0 + i);
+  ASSERT_EQ(LTable::halve(LTable::dbl(b)), b);
+  ASSERT_EQ(LTable::dbl(LTable::halve(b)), b);
+}
+
+TEST(LTable, GrayCodeOffsetMatchesIncremental) {
+  LTable::Block l0{};
+  l0[3] = 0x9D;
+  l0[15] = 0x41;
+  LTable table(l0);
+  LTable::Block offset{};
+  for (uint64_t i = 1; i <= 300; ++i) {
+    LTable::xor_into(offset, table[LTable::ntz(i)].data());
+    ASSERT_EQ(offset, table.offset(i)) << "block " << i;
+  }
+}
+
+TEST(OCB, MatchesReferenceWithPartialBlocks) {
+  // reference computed from the RFC 7253 pseudocode with E(x) = x ^ 0xAA..AA
+  XorCipher cipher;
+  crypto::mode::OCB ocb(from_hex("BBAA99887766554433221107"), make_data(40, 1, 0));
+  Bytes enc;
+  ocb.encrypt(cipher, make_data(40, 1, 0), enc, 1);
+  ASSERT_EQ(enc, from_hex("aaaba8a9aeafacada2a3a0a1a6a7a4a5babbb8b9bebfbcbdb2b3b0b1b6b7b4b5"
+                          "8a8b88545bc348b6555555888019916ee67ff74cc45dd718"));
+}
+
+TEST(OCB, MatchesReferenceTagManyBlocks) {
+  XorCipher cipher;
+  crypto::mode::OCB ocb(from_hex("BBAA99887766554433221107"));
+  Bytes enc;
+  ocb.encrypt(cipher, make_data(16 * 37, 7, 0), enc, 3);
+  ASSERT_EQ(Bytes(enc.end() - 16, enc.end()), from_hex("00070e08096feeca4bd5e4548513da96"));
+}
+
+TEST(OCB, TwofishRoundtrip) {
+  crypto::twofish::Twofish cipher;
+  cipher.set_encryption_key(KEY);
+  cipher.set_decryption_key(KEY);
+  crypto::mode::OCB ocb(Bytes(12, 0x01), make_data(7, 1, 0));
+  Bytes plain = make_data(16 * 9 + 3, 3, 0);
+  Bytes enc, dec;
+  ocb.encrypt(cipher, plain, enc, 1);
+  ASSERT_EQ(enc.size(), plain.size() + crypto::mode::OCB::TAG_SIZE);
+  ocb.decrypt(cipher, enc, dec, 1);
+  ASSERT_EQ(dec, plain);
+}
+
+TEST(OCB, ParallelMatchesSequential) {
+  crypto::mars::MARS cipher;
+  cipher.set_encryption_key(KEY);
+  cipher.set_decryption_key(KEY);
+  crypto::mode::OCB ocb(Bytes(15, 0x33));
+  Bytes plain = make_data(16 * 101 + 9, 5, 0);
+  Bytes enc1, enc4, dec;
+  ocb.encrypt(cipher, plain, enc1, 1);
+  ocb.encrypt(cipher, plain, enc4, 4);
+  ASSERT_EQ(enc1, enc4);
+  ocb.decrypt(cipher, enc4, dec, 4);
+  ASSERT_EQ(dec, plain);
+}
+
+TEST(OCB, TamperedTagThrows) {
+  crypto::twofish::Twofish cipher;
+  cipher.set_encryption_key(KEY);
+  cipher.set_decryption_key(KEY);
+  crypto::mode::OCB ocb(Bytes(12, 0x24));
+  Bytes enc, dec;
+  ocb.encrypt(cipher, make_data(32, 1, 0), enc, 1);
+  enc.back() ^= 0x80;
+  ASSERT_THROW(ocb.decrypt(cipher, enc, dec, 1), std::invalid_argument);
+  ASSERT_TRUE(dec.empty());
+}
+
+TEST(OCB, DifferentNonceGivesDifferentCiphertext) {
+  crypto::twofish::Twofish cipher;
+  cipher.set_encryption_key(KEY);
+  crypto::mode::OCB ocb1(Bytes(12, 0x00)), ocb2(Bytes(12, 0x01));
+  Bytes enc1, enc2;
+  ocb1.encrypt(cipher, make_data(48, 1, 0), enc1, 1);
+  ocb2.encrypt(cipher, make_data(48, 1, 0), enc2, 1);
+  ASSERT_NE(enc1, enc2);
+}
+
+TEST(OCB, NonceTooLongThrows) {
+  ASSERT_THROW(crypto::mode::OCB(Bytes(16, 0x00)), std::invalid_argument);
+}
+
+TEST(OCB, RequiresANonce) {
+  ASSERT_THROW(crypto::mode::OCB(Bytes{}), std::invalid_argument);
+  ASSERT_THROW(crypto::SymmetricCipherContext(std::make_unique<crypto::twofish::Twofish>(),
+                                              crypto::SymmetricEncryptionMode::OCB,
+                                              crypto::SymmetricPaddingScheme::Zeros),
+               std::invalid_argument);
+}
+
+TEST(OCB, ContextRoundtrip) {
+  crypto::SymmetricCipherContext ctx(std::make_unique<crypto::twofish::Twofish>(),
+                                     crypto::SymmetricEncryptionMode::OCB,
+                                     crypto::SymmetricPaddingScheme::PKCS7,
+                                     Bytes(12, 0x09));
+  ctx.set_encryption_key(KEY);
+  ctx.set_decryption_key(KEY);
+  Bytes plain = make_data(777, 11, 0);
+  Bytes enc, dec;
+  ctx.encrypt(plain, enc, 4);
+  ctx.decrypt(enc, dec, 4);
+  ASSERT_EQ(dec, plain);
+}
+
+// RFC 7253 appendix A, AES-128 with empty associated data, run through the
+// context: the output is exactly ciphertext || tag, with no padding.
+TEST(OCB, ContextMatchesRfc7253Vectors) {
+  const struct {
+    const char *nonce;
+    size_t length;
+    const char *ciphertext;
+  } vectors[] = {
+      {"BBAA99887766554433221100", 0, "785407BFFFC8AD9EDCC5520AC9111EE6"},
+      {"BBAA99887766554433221103", 8, "45DD69F8F5AAE72414054CD1F35D82760B2CD00D2F99BFA9"},
+      {"BBAA99887766554433221106", 16,
+       "5CE88EC2E0692706A915C00AEB8B2396F40E1C743F52436BDF06D8FA1ECA343D"},
+      {"BBAA99887766554433221109", 24,
+       "221BD0DE7FA6FE993ECCD769460A0AF2D6CDED0C395B1C3CE725F32494B9F914D85C0B1EB38357FF"},
+  };
+  for (const auto &v : vectors) {
+    crypto::SymmetricCipherContext ctx(std::make_unique<Aes128>(),
+                                       crypto::SymmetricEncryptionMode::OCB,
+                                       crypto::SymmetricPaddingScheme::PKCS7, from_hex(v.nonce));
+    ctx.set_encryption_key(from_hex("000102030405060708090A0B0C0D0E0F"));
+    ctx.set_decryption_key(from_hex("000102030405060708090A0B0C0D0E0F"));
+    const Bytes plain = make_data(v.length, 1, 0);
+    Bytes enc, dec;
+    ctx.encrypt(plain, enc, 2);
+    ASSERT_EQ(enc, from_hex(v.ciphertext)) << "nonce " << v.nonce;
+    ctx.decrypt(enc, dec, 2);
+    ASSERT_EQ(dec, plain);
+  }
+}
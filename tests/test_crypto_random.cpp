@@ -0,0 +1,99 @@
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "internal/random.hpp"
+
+using Bytes = crypto::Bytes;
+namespace internal = crypto::internal;
+
+TEST(Random, ConsecutiveCallsDiffer) {
+  std::set<Bytes> seen;
+  for (int i = 0; i < 64; ++i) {
+    ASSERT_TRUE(seen.insert(internal::random_bytes(16)).second);
+  }
+}
+
+TEST(Random, FillsAcrossBufferBoundaries) {
+  // odd sizes walk the read position over several refills
+  for (size_t n : {1u, 7u, 63u, 1000u, 1025u, 4096u, 70000u}) {
+    Bytes a = internal::random_bytes(n);
+    ASSERT_EQ(a.size(), n);
+    if (n >= 16) {
+      ASSERT_NE(a, Bytes(n, 0));
+      ASSERT_NE(a, internal::random_bytes(n));
+    }
+  }
+}
+
+TEST(Random, ByteValuesRoughlyUniform) {
+  Bytes data = internal::random_bytes(1 << 16);
+  std::vector<size_t> counts(256, 0);
+  for (uint8_t b : data) ++counts[b];
+  // expected 256 per value; a sound generator stays far inside these bounds
+  for (size_t c : counts) {
+    ASSERT_GT(c, 150u);
+    ASSERT_LT(c, 370u);
+  }
+}
+
+TEST(Random, RandomBelowStaysInRange) {
+  const mpz_class bound("1000000000000000000000007");
+  for (int i = 0; i < 200; ++i) {
+    mpz_class v = internal::random_below(bound);
+    ASSERT_GE(v, 0);
+    ASSERT_LT(v, bound);
+  }
+  for (int i = 0; i < 50; ++i) ASSERT_EQ(internal::random_below(1), 0);
+  ASSERT_THROW(internal::random_below(0), std::invalid_argument);
+}
+
+TEST(Random, RandomBitsWidth) {
+  bool top_seen = false;
+  for (int i = 0; i < 64; ++i) {
+    mpz_class v = internal::random_bits(521);
+    ASSERT_LE(mpz_sizeinbase(v.get_mpz_t(), 2), 521u);
+    top_seen |= mpz_tstbit(v.get_mpz_t(), 520) != 0;
+  }
+  ASSERT_TRUE(top_seen);
+  ASSERT_EQ(internal::random_bits(0), 0);
+}
+
+TEST(Random, ThreadsGetIndependentStreams) {
+  constexpr size_t N = 4;
+  std::vector<Bytes> out(N);
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < N; ++t) {
+    workers.emplace_back([&out, t] { out[t] = internal::random_bytes(64); });
+  }
+  for (auto &w : workers) w.join();
+  ASSERT_EQ(std::set<Bytes>(out.begin(), out.end()).size(), N);
+}
+
+TEST(Random, ForkedChildReseeds) {
+  internal::random_bytes(8); // make sure the parent generator exists
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  pid_t pid = fork();
+  ASSERT_NE(pid, -1);
+  if (pid == 0) {
+    Bytes child = internal::random_bytes(32);
+    ssize_t written = write(fds[1], child.data(), child.size());
+    _exit(written == 32 ? 0 : 1);
+  }
+  close(fds[1]);
+  Bytes parent = internal::random_bytes(32);
+  Bytes child(32);
+  ASSERT_EQ(read(fds[0], child.data(), child.size()), 32);
+  close(fds[0]);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  ASSERT_EQ(WEXITSTATUS(status), 0);
+  ASSERT_NE(parent, child);
+}
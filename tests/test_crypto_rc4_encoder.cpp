@@ -1,6 +1,10 @@
+#include "stream/algorithms/rc4/checkpoints.hpp"
 #include "stream/algorithms/rc4/encoder.hpp"
+#include "stream/algorithms/rc4/multi_encoder.hpp"
 #include <cstdint>
 #include <gtest/gtest.h>
+#include <span>
+#include <stdexcept>
 #include <vector>
 
 using namespace crypto::rc4;
@@ -51,3 +55,220 @@ TEST(rc4_test, different_keys) {
 
   EXPECT_NE(buf1, buf2);
 }
+
+TEST(rc4_test, known_answer) {
+  // "Key" / "Plaintext" from the classic RC4 test vectors
+  Encoder rc4({'K', 'e', 'y'});
+  std::vector<uint8_t> data = {'P', 'l', 'a', 'i', 'n', 't', 'e', 'x', 't'};
+  rc4.encode(data);
+  EXPECT_EQ(data, (std::vector<uint8_t>{0xBB, 0xF3, 0x16, 0xE8, 0xD9, 0x40,
+                                        0xAF, 0x0A, 0xD3}));
+}
+
+TEST(rc4_test, rfc6229_keystream) {
+  Encoder rc4({0x01, 0x02, 0x03, 0x04, 0x05});
+  std::vector<uint8_t> ks(16);
+  rc4.keystream(ks);
+  EXPECT_EQ(ks, (std::vector<uint8_t>{0xB2, 0x39, 0x63, 0x05, 0xF0, 0x3D,
+                                      0xC0, 0x27, 0xCC, 0xC3, 0x52, 0x4A,
+                                      0x0A, 0x11, 0x18, 0xA8}));
+}
+
+TEST(rc4_test, split_calls_match_one_call) {
+  std::vector<uint8_t> key = {9, 8, 7, 6};
+  std::vector<uint8_t> whole(5000);
+  for (size_t i = 0; i < whole.size(); ++i) whole[i] = static_cast<uint8_t>(i * 3);
+  std::vector<uint8_t> pieces = whole;
+
+  Encoder a(key);
+  a.encode(whole);
+
+  Encoder b(key);
+  size_t off = 0;
+  for (size_t len : {1u, 63u, 64u, 65u, 1023u, 1025u, 2759u}) {
+    b.encode(std::span<uint8_t>(pieces.data() + off, len));
+    off += len;
+  }
+  ASSERT_EQ(off, pieces.size());
+  EXPECT_EQ(pieces, whole);
+}
+
+TEST(rc4_test, span_out_of_place) {
+  std::vector<uint8_t> key = {1, 2, 3};
+  const std::vector<uint8_t> in(777, 0x5A);
+  std::vector<uint8_t> out(in.size());
+  std::vector<uint8_t> expected = in;
+
+  Encoder(key).encode(expected);
+  Encoder rc4(key);
+  rc4.encode(std::span<const uint8_t>(in), std::span<uint8_t>(out));
+  EXPECT_EQ(out, expected);
+
+  std::vector<uint8_t> short_out(10);
+  EXPECT_THROW(rc4.encode(std::span<const uint8_t>(in), std::span<uint8_t>(short_out)),
+               std::invalid_argument);
+}
+
+static std::vector<std::vector<uint8_t>> make_keys(size_t n) {
+  std::vector<std::vector<uint8_t>> keys(n);
+  for (size_t k = 0; k < n; ++k) {
+    keys[k].resize(5 + k % 11);
+    for (size_t i = 0; i < keys[k].size(); ++i) {
+      keys[k][i] = static_cast<uint8_t>(k * 7 + i * 13);
+    }
+  }
+  return keys;
+}
+
+TEST(rc4_multi_test, matches_single_streams) {
+  auto keys = make_keys(21);
+  std::vector<std::vector<uint8_t>> buffers(keys.size());
+  for (size_t k = 0; k < buffers.size(); ++k) {
+    buffers[k].assign((k * 37) % 300, static_cast<uint8_t>(k));
+  }
+  auto expected = buffers;
+  for (size_t k = 0; k < keys.size(); ++k) {
+    Encoder rc4(keys[k]);
+    rc4.encode(expected[k]);
+  }
+
+  MultiEncoder multi(keys);
+  ASSERT_EQ(multi.streams(), keys.size());
+  multi.encode(buffers, 3);
+  EXPECT_EQ(buffers, expected);
+}
+
+TEST(rc4_multi_test, keeps_position_across_calls) {
+  auto keys = make_keys(10);
+  std::vector<Encoder> singles;
+  for (const auto &key : keys) singles.emplace_back(key);
+  MultiEncoder multi(keys);
+
+  for (size_t round = 0; round < 3; ++round) {
+    std::vector<std::vector<uint8_t>> buffers(keys.size());
+    for (size_t k = 0; k < buffers.size(); ++k) {
+      buffers[k].assign(round * 50 + k, 0xA5);
+    }
+    auto expected = buffers;
+    for (size_t k = 0; k < keys.size(); ++k) singles[k].encode(expected[k]);
+    multi.encode(buffers);
+    ASSERT_EQ(buffers, expected);
+  }
+}
+
+TEST(rc4_multi_test, mutate_restarts_one_stream) {
+  auto keys = make_keys(3);
+  MultiEncoder multi(keys);
+  std::vector<std::vector<uint8_t>> buffers(3, std::vector<uint8_t>(16, 0));
+  multi.encode(buffers);
+  auto first = buffers;
+
+  multi.mutate(1, keys[1]);
+  buffers.assign(3, std::vector<uint8_t>(16, 0));
+  multi.encode(buffers);
+  EXPECT_EQ(buffers[1], first[1]);
+  EXPECT_NE(buffers[0], first[0]);
+  EXPECT_THROW(multi.mutate(3, keys[0]), std::out_of_range);
+}
+
+TEST(rc4_multi_test, drop_matches_single_streams) {
+  auto keys = make_keys(9);
+  std::vector<std::vector<uint8_t>> buffers(keys.size(), std::vector<uint8_t>(64, 0x3C));
+  auto expected = buffers;
+  for (size_t k = 0; k < keys.size(); ++k) {
+    Encoder rc4(keys[k], 3072);
+    rc4.encode(expected[k]);
+  }
+
+  MultiEncoder multi(keys, 3072);
+  multi.encode(buffers, 2);
+  EXPECT_EQ(buffers, expected);
+
+  multi.mutate(4, keys[4], 3072);
+  std::vector<std::vector<uint8_t>> again(keys.size(), std::vector<uint8_t>(64, 0x3C));
+  multi.encode(again);
+  EXPECT_EQ(again[4], expected[4]);
+}
+
+TEST(rc4_multi_test, rejects_mismatched_batch) {
+  MultiEncoder multi(make_keys(4));
+  std::vector<std::vector<uint8_t>> buffers(3);
+  EXPECT_THROW(multi.encode(buffers), std::invalid_argument);
+  std::vector<std::vector<uint8_t>> empty_key(1);
+  EXPECT_THROW(MultiEncoder{empty_key}, std::invalid_argument);
+}
+
+TEST(rc4_state_test, drop_matches_discarded_keystream) {
+  std::vector<uint8_t> key = {7, 7, 7};
+  Encoder plain(key);
+  std::vector<uint8_t> skipped(3072 + 32);
+  plain.keystream(skipped);
+
+  Encoder dropped(key, 3072);
+  std::vector<uint8_t> ks(32);
+  dropped.keystream(ks);
+  EXPECT_EQ(ks, std::vector<uint8_t>(skipped.end() - 32, skipped.end()));
+}
+
+TEST(rc4_state_test, state_roundtrip) {
+  Encoder rc4({1, 2, 3}, 500);
+  const State state = rc4.state();
+  EXPECT_EQ(State::deserialize(state.serialize()), state);
+
+  std::vector<uint8_t> a(40), b(40);
+  rc4.keystream(a);
+  Encoder resumed;
+  resumed.set_state(state);
+  resumed.keystream(b);
+  EXPECT_EQ(a, b);
+
+  std::vector<uint8_t> bad = state.serialize();
+  bad[0] = bad[1];
+  EXPECT_THROW(State::deserialize(bad), std::invalid_argument);
+}
+
+TEST(rc4_checkpoint_test, resume_matches_reference) {
+  std::vector<uint8_t> key = {0x10, 0x20, 0x30, 0x40};
+  const uint64_t length = 300000;
+  auto table = CheckpointTable::build(key, length, 65536, 768);
+  EXPECT_EQ(table.size(), 5u);
+
+  Encoder reference(key, 768);
+  std::vector<uint8_t> stream(length + 16);
+  reference.keystream(stream);
+
+  for (uint64_t offset : {0ull, 1ull, 65535ull, 65536ull, 200001ull, 300000ull}) {
+    Encoder rc4 = table.resume(offset);
+    std::vector<uint8_t> ks(16);
+    rc4.keystream(ks);
+    EXPECT_EQ(ks, std::vector<uint8_t>(stream.begin() + offset,
+                                       stream.begin() + offset + 16))
+        << "offset " << offset;
+  }
+}
+
+TEST(rc4_checkpoint_test, serialize_roundtrip) {
+  auto table = CheckpointTable::build({5, 6, 7}, 10000, 1000);
+  auto bytes = table.serialize();
+  auto loaded = CheckpointTable::deserialize(bytes);
+  ASSERT_EQ(loaded.size(), table.size());
+
+  std::vector<uint8_t> a(8), b(8);
+  table.resume(4321).keystream(a);
+  loaded.resume(4321).keystream(b);
+  EXPECT_EQ(a, b);
+
+  bytes.pop_back();
+  EXPECT_THROW(CheckpointTable::deserialize(bytes), std::invalid_argument);
+  bytes[0] = 'X';
+  EXPECT_THROW(CheckpointTable::deserialize(bytes), std::invalid_argument);
+}
+
+TEST(rc4_checkpoint_test, resume_before_first_checkpoint_throws) {
+  CheckpointTable table;
+  EXPECT_THROW(table.resume(0), std::out_of_range);
+  table.add(100, Encoder({1}).state());
+  EXPECT_THROW(table.resume(99), std::out_of_range);
+  EXPECT_NO_THROW(table.resume(100));
+  EXPECT_THROW(CheckpointTable::build({1}, 10, 0), std::invalid_argument);
+}
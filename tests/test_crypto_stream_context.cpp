@@ -0,0 +1,169 @@
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "crypto/stream/algorithms/rc4/encoder.hpp"
+#include "crypto/stream/stream_cipher_context.hpp"
+
+#include "common.hpp"
+
+using Bytes = crypto::Bytes;
+using crypto::FileBackend;
+using crypto::StreamCipherContext;
+
+static const Bytes KEY = {0x01, 0x02, 0x03, 0x04, 0x05};
+
+static StreamCipherContext make_rc4_context() {
+  StreamCipherContext ctx(std::make_unique<crypto::rc4::Encoder>());
+  ctx.set_key(KEY);
+  return ctx;
+}
+
+// keystream byte k is a function of k alone, so discard is O(1)
+class CounterCipher final : public crypto::core::StreamCipher {
+public:
+  void set_key(const Bytes &key) override {
+    m_seed = key.empty() ? 0 : key[0];
+    m_pos = 0;
+  }
+  void keystream(std::span<uint8_t> out) override {
+    for (auto &b : out) b = at(m_pos++);
+  }
+  void apply(std::span<const uint8_t> in, std::span<uint8_t> out) override {
+    for (size_t k = 0; k < in.size(); ++k) out[k] = in[k] ^ at(m_pos++);
+  }
+  void discard(uint64_t n) override { m_pos += n; }
+  bool seekable() const override { return true; }
+  Bytes snapshot() const override { return {static_cast<uint8_t>(m_pos)}; }
+  void restore(const Bytes &state) override { m_pos = state.at(0); }
+  std::unique_ptr<StreamCipher> clone() const override {
+    return std::make_unique<CounterCipher>(*this);
+  }
+
+private:
+  uint8_t at(uint64_t k) const {
+    return static_cast<uint8_t>((k * 7 + m_seed) ^ (k >> 8) ^ (k >> 16));
+  }
+  uint8_t m_seed = 0;
+  uint64_t m_pos = 0;
+};
+
+TEST(StreamCipherContext, Rc4MatchesEncoder) {
+  auto ctx = make_rc4_context();
+  const Bytes plain = make_data(1000, 13, 5);
+  Bytes expected = plain;
+  crypto::rc4::Encoder(KEY).encode(expected);
+
+  Bytes enc, enc_again, dec;
+  ctx.encrypt(plain, enc);
+  ctx.encrypt(plain, enc_again);
+  ctx.decrypt(enc, dec);
+  ASSERT_EQ(enc, expected);
+  // every message starts at the beginning of the keystream
+  ASSERT_EQ(enc_again, expected);
+  ASSERT_EQ(dec, plain);
+}
+
+TEST(StreamCipherContext, BeginGivesIncrementalPass) {
+  auto ctx = make_rc4_context();
+  const Bytes plain = make_data(777, 13, 5);
+  Bytes whole;
+  ctx.encrypt(plain, whole);
+
+  auto cipher = ctx.begin();
+  Bytes pieces(plain.size());
+  cipher->apply(std::span(plain).first(100), std::span(pieces).first(100));
+  cipher->apply(std::span(plain).subspan(100), std::span(pieces).subspan(100));
+  ASSERT_EQ(pieces, whole);
+}
+
+TEST(StreamCipherContext, SeekableCipherSplitsAcrossThreads) {
+  StreamCipherContext ctx(std::make_unique<CounterCipher>());
+  ctx.set_key({0x42});
+  const Bytes plain = make_data(200000, 13, 5);
+  Bytes one, four;
+  ctx.encrypt(plain, one, 1);
+  ctx.encrypt(plain, four, 4);
+  ASSERT_EQ(one, four);
+}
+
+TEST(StreamCipherContext, FileBackendsMatchInMemory) {
+  const auto dir = std::filesystem::temp_directory_path();
+  const std::string in_path = (dir / "stream_ctx_in.bin").string();
+  const std::string enc_path = (dir / "stream_ctx_enc.bin").string();
+  const std::string dec_path = (dir / "stream_ctx_dec.bin").string();
+  const Bytes plain = make_data(100003, 13, 5);
+  write_bytes(in_path, plain);
+
+  for (auto backend : {FileBackend::Buffered, FileBackend::Mapped, FileBackend::Pipelined}) {
+    auto ctx = make_rc4_context();
+    ctx.set_file_backend(backend);
+    Bytes expected;
+    ctx.encrypt(plain, expected);
+
+    ctx.encrypt_file(in_path, enc_path, 1, 4093).get();
+    ASSERT_EQ(read_bytes(enc_path), expected);
+    ctx.decrypt_file(enc_path, dec_path, 1, 4093).get();
+    ASSERT_EQ(read_bytes(dec_path), plain);
+  }
+
+  std::filesystem::remove(in_path);
+  std::filesystem::remove(enc_path);
+  std::filesystem::remove(dec_path);
+}
+
+TEST(StreamCipherContext, EmptyFile) {
+  const auto dir = std::filesystem::temp_directory_path();
+  const std::string in_path = (dir / "stream_ctx_empty.bin").string();
+  const std::string out_path = (dir / "stream_ctx_empty_out.bin").string();
+  write_bytes(in_path, {});
+  for (auto backend : {FileBackend::Buffered, FileBackend::Mapped, FileBackend::Pipelined}) {
+    auto ctx = make_rc4_context();
+    ctx.set_file_backend(backend);
+    ctx.encrypt_file(in_path, out_path).get();
+    ASSERT_TRUE(read_bytes(out_path).empty());
+  }
+  std::filesystem::remove(in_path);
+  std::filesystem::remove(out_path);
+}
+
+TEST(StreamCipherContext, MissingInputThrows) {
+  auto ctx = make_rc4_context();
+  ASSERT_THROW(ctx.encrypt_file("/nonexistent/stream_ctx.bin", "/tmp/stream_ctx_x.bin").get(),
+               std::runtime_error);
+  ASSERT_THROW(StreamCipherContext(nullptr), std::invalid_argument);
+}
+
+TEST(Rc4StreamCipher, SnapshotRestoreAndClone) {
+  crypto::rc4::Encoder rc4(KEY);
+  rc4.discard(1234);
+  const Bytes state = rc4.snapshot();
+  ASSERT_EQ(state.size(), crypto::rc4::Encoder::STATE_SIZE);
+
+  auto copy = rc4.clone();
+  Bytes a(64), b(64), c(64);
+  rc4.keystream(a);
+  copy->keystream(b);
+  ASSERT_EQ(a, b);
+
+  rc4.restore(state);
+  rc4.keystream(c);
+  ASSERT_EQ(c, a);
+
+  crypto::rc4::Encoder reference(KEY);
+  Bytes skipped(1234 + 64);
+  reference.keystream(skipped);
+  ASSERT_EQ(Bytes(skipped.end() - 64, skipped.end()), a);
+}
+
+TEST(Rc4StreamCipher, RestoreRejectsBadState) {
+  crypto::rc4::Encoder rc4(KEY);
+  ASSERT_THROW(rc4.restore(Bytes(10)), std::invalid_argument);
+  ASSERT_THROW(rc4.restore(Bytes(crypto::rc4::Encoder::STATE_SIZE, 0)), std::invalid_argument);
+  ASSERT_THROW(rc4.set_key({}), std::invalid_argument);
+}
@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "crypto/symmetric/algorithms/mars/mars.hpp"
+#include "crypto/symmetric/algorithms/twofish/twofish.hpp"
+#include "crypto/symmetric/cipher_context.hpp"
+#include "symmetric/mode/modes.hpp"
+
+#include "common.hpp"
+
+using Bytes = crypto::Bytes;
+
+static const Bytes KEY1(16, 0x11);
+static const Bytes KEY2(16, 0x22);
+
+// IEEE 1619-2007 XTS-AES-128: encrypts one data unit and checks it decrypts back
+static void check_ieee_vector(const std::string &key1, const std::string &key2,
+                              uint64_t data_unit, const std::string &ptx,
+                              const std::string &ctx) {
+  Aes128 cipher, tweak;
+  cipher.set_encryption_key(from_hex(key1));
+  tweak.set_encryption_key(from_hex(key2));
+  crypto::mode::XTS xts(tweak, 512, data_unit);
+  Bytes enc, dec;
+  xts.encrypt(cipher, from_hex(ptx), enc, 1);
+  ASSERT_EQ(enc, from_hex(ctx));
+  xts.decrypt(cipher, enc, dec, 1);
+  ASSERT_EQ(dec, from_hex(ptx));
+}
+
+TEST(XTSKnownAnswer, Ieee1619Vector1) {
+  check_ieee_vector("00000000000000000000000000000000", "00000000000000000000000000000000", 0,
+                    std::string(64, '0'),
+                    "917cf69ebd68b2ec9b9fe9a3eadda692cd43d2f59598ed858c02c2652fbf922e");
+}
+
+TEST(XTSKnownAnswer, Ieee1619Vector2) {
+  check_ieee_vector("11111111111111111111111111111111", "22222222222222222222222222222222",
+                    0x3333333333, std::string(64, '4'),
+                    "c454185e6a16936e39334038acef838bfb186fff7480adc4289382ecd6d394f0");
+}
+
+TEST(XTSKnownAnswer, Ieee1619Vector15CiphertextStealing) {
+  check_ieee_vector("fffefdfcfbfaf9f8f7f6f5f4f3f2f1f0", "bfbebdbcbbbab9b8b7b6b5b4b3b2b1b0",
+                    0x123456789a, "000102030405060708090a0b0c0d0e0f10",
+                    "6c1625db4671522d3d7599601de7ca09ed");
+}
+
+class XTSTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    cipher.set_encryption_key(KEY1);
+    cipher.set_decryption_key(KEY1);
+    tweak.set_encryption_key(KEY2);
+  }
+
+  crypto::twofish::Twofish cipher;
+  crypto::twofish::Twofish tweak;
+};
+
+TEST_F(XTSTest, RoundtripAligned) {
+  crypto::mode::XTS xts(tweak, 64);
+  Bytes plain = make_data(64 * 5, 13, 5);
+  Bytes enc, dec;
+  xts.encrypt(cipher, plain, enc, 1);
+  ASSERT_EQ(enc.size(), plain.size());
+  ASSERT_NE(enc, plain);
+  xts.decrypt(cipher, enc, dec, 1);
+  ASSERT_EQ(dec, plain);
+}
+
+TEST_F(XTSTest, CiphertextStealingPreservesLength) {
+  crypto::mode::XTS xts(tweak, 64);
+  for (size_t len : {17u, 31u, 63u, 64u + 20u, 64u * 3 + 47u}) {
+    Bytes plain = make_data(len, 13, 5);
+    Bytes enc, dec;
+    xts.encrypt(cipher, plain, enc, 2);
+    ASSERT_EQ(enc.size(), len);
+    xts.decrypt(cipher, enc, dec, 2);
+    ASSERT_EQ(dec, plain) << "length " << len;
+  }
+}
+
+TEST_F(XTSTest, ShorterThanBlockThrows) {
+  crypto::mode::XTS xts(tweak, 64);
+  Bytes out;
+  ASSERT_THROW(xts.encrypt(cipher, make_data(15, 13, 5), out, 1), std::invalid_argument);
+  ASSERT_THROW(xts.encrypt(cipher, make_data(64 + 8, 13, 5), out, 1), std::invalid_argument);
+}
+
+TEST_F(XTSTest, SectorsAreIndependentlyAddressable) {
+  crypto::mode::XTS xts(tweak, 32);
+  Bytes plain = make_data(32 * 8, 13, 5);
+  Bytes whole;
+  xts.encrypt_sectors(cipher, 100, plain, whole, 1);
+
+  Bytes slice(plain.begin() + 32 * 5, plain.begin() + 32 * 7);
+  Bytes part;
+  xts.encrypt_sectors(cipher, 105, slice, part, 1);
+  ASSERT_EQ(part, Bytes(whole.begin() + 32 * 5, whole.begin() + 32 * 7));
+
+  Bytes dec;
+  xts.decrypt_sectors(cipher, 105, part, dec, 1);
+  ASSERT_EQ(dec, slice);
+}
+
+TEST_F(XTSTest, SameDataDifferentSectorsDiffer) {
+  crypto::mode::XTS xts(tweak, 16);
+  Bytes plain(32, 0x00);
+  Bytes enc;
+  xts.encrypt(cipher, plain, enc, 1);
+  ASSERT_NE(Bytes(enc.begin(), enc.begin() + 16), Bytes(enc.begin() + 16, enc.end()));
+}
+
+TEST_F(XTSTest, ParallelMatchesSequential) {
+  crypto::mode::XTS xts(tweak, 48);
+  Bytes plain = make_data(48 * 21 + 30, 13, 5);
+  Bytes enc1, enc4;
+  xts.encrypt(cipher, plain, enc1, 1);
+  xts.encrypt(cipher, plain, enc4, 4);
+  ASSERT_EQ(enc1, enc4);
+}
+
+TEST_F(XTSTest, InvalidSectorSizeThrows) {
+  ASSERT_THROW(crypto::mode::XTS(tweak, 0), std::invalid_argument);
+  ASSERT_THROW(crypto::mode::XTS(tweak, 40), std::invalid_argument);
+}
+
+TEST(XTSContext, MarsRoundtrip) {
+  crypto::SymmetricCipherContext ctx(std::make_unique<crypto::mars::MARS>(),
+                                     std::make_unique<crypto::mars::MARS>(),
+                                     crypto::SymmetricEncryptionMode::XTS,
+                                     crypto::SymmetricPaddingScheme::PKCS7);
+  ctx.set_encryption_key(KEY1);
+  ctx.set_decryption_key(KEY1);
+  ctx.set_tweak_key(KEY2);
+  Bytes plain = make_data(2000, 13, 5);
+  Bytes enc, dec;
+  ctx.encrypt(plain, enc, 3);
+  ctx.decrypt(enc, dec, 3);
+  ASSERT_EQ(dec, plain);
+}
+
+// Partial final blocks go through ciphertext stealing on every context path:
+// one-shot, file (all three backends) and a session fed odd-sized pieces.
+TEST(XTSContext, CiphertextStealingThroughContext) {
+  const std::string in_path = "/tmp/xts_cts_plain.bin";
+  const std::string enc_path = "/tmp/xts_cts_enc.bin";
+  const std::string dec_path = "/tmp/xts_cts_dec.bin";
+  auto ctx = make_context(crypto::SymmetricEncryptionMode::XTS, KEY1, 0);
+  crypto::twofish::Twofish cipher, tweak;
+  cipher.set_encryption_key(KEY1);
+  tweak.set_encryption_key(Bytes(16, 0x77));
+  const crypto::mode::XTS xts(tweak);
+
+  for (size_t len : {16u, 17u, 31u, 512u + 100u, 512u * 3 + 47u}) {
+    const Bytes plain = make_data(len, 13, 5);
+    Bytes expected, enc, dec;
+    xts.encrypt(cipher, plain, expected, 1);
+    ctx.encrypt(plain, enc, 2);
+    ASSERT_EQ(enc, expected) << "length " << len;
+    ctx.decrypt(enc, dec, 2);
+    ASSERT_EQ(dec, plain) << "length " << len;
+
+    write_bytes(in_path, plain);
+    for (auto backend : {crypto::FileBackend::Buffered, crypto::FileBackend::Mapped,
+                         crypto::FileBackend::Pipelined}) {
+      ctx.set_file_backend(backend);
+      ctx.encrypt_file(in_path, enc_path, 2, 64).get();
+      ASSERT_EQ(read_bytes(enc_path), expected)
+          << "length " << len << " backend " << static_cast<int>(backend);
+      ctx.decrypt_file(enc_path, dec_path, 2, 64).get();
+      ASSERT_EQ(read_bytes(dec_path), plain)
+          << "length " << len << " backend " << static_cast<int>(backend);
+    }
+    ctx.set_file_backend(crypto::FileBackend::Buffered);
+
+    auto session = ctx.begin(crypto::CipherDirection::Encrypt);
+    Bytes streamed(session.output_bound(len));
+    size_t written = 0;
+    for (size_t off = 0; off < len; off += 7) {
+      const size_t n = std::min<size_t>(7, len - off);
+      written += session.update(std::span(plain.data() + off, n),
+                                std::span(streamed).subspan(written));
+    }
+    written += session.finalize(std::span(streamed).subspan(written));
+    streamed.resize(written);
+    ASSERT_EQ(streamed, expected) << "length " << len;
+  }
+  std::filesystem::remove(in_path);
+  std::filesystem::remove(enc_path);
+  std::filesystem::remove(dec_path);
+}
+
+TEST(XTSContext, ShorterThanBlockThrows) {
+  auto ctx = make_context(crypto::SymmetricEncryptionMode::XTS, KEY1, 0);
+  Bytes out;
+  ASSERT_THROW(ctx.encrypt(make_data(15, 13, 5), out), std::invalid_argument);
+  ASSERT_THROW(ctx.encrypt({}, out), std::invalid_argument);
+  ASSERT_THROW(ctx.encrypt(make_data(512 + 8, 13, 5), out), std::invalid_argument);
+}
+
+TEST(XTSContext, MissingTweakCipherThrows) {
+  ASSERT_THROW(crypto::SymmetricCipherContext(std::make_unique<crypto::mars::MARS>(),
+                                              crypto::SymmetricEncryptionMode::XTS,
+                                              crypto::SymmetricPaddingScheme::PKCS7),
+               std::invalid_argument);
+}